@@ -13,8 +13,16 @@ HEADERS += \
     src/params/Transitions.hpp \
     src/params/CDF.hpp \
     src/kernel/Aggregator.hpp \
+    src/kernel/BlockKernel.hpp \
+    src/kernel/FlatPortfolio.hpp \
     src/kernel/MonteCarlo.hpp \
+    src/kernel/SemiAnalytic.hpp \
+    src/kernel/Statistics.hpp \
+    src/kernel/Convergence.hpp \
+    src/kernel/Shard.hpp \
+    src/kernel/Instrumentation.hpp \
     src/kernel/SimulationThread.hpp \
+    src/kernel/WriterThread.hpp \
     src/kernel/Inverse.hpp \
     src/kernel/Input.hpp \
     src/kernel/InputData.hpp \
@@ -27,6 +35,12 @@ HEADERS += \
     src/utils/PowMatrix.hpp \
     src/utils/Utils.hpp \
     src/utils/Thread.hpp \
+    src/utils/CsvFile.hpp \
+    src/utils/RingBuffer.hpp \
+    src/utils/BatchRng.hpp \
+    src/utils/Sobol.hpp \
+    src/utils/TDigest.hpp \
+    src/utils/Checkpoint.hpp \
     src/utils/Parser.hpp \
     src/utils/Logger.hpp \
     src/utils/MacrosBuffer.hpp \
@@ -47,8 +61,16 @@ SOURCES += \
     src/params/Transitions.cpp \
     src/params/CDF.cpp \
     src/kernel/Aggregator.cpp \
+    src/kernel/BlockKernel.cpp \
+    src/kernel/FlatPortfolio.cpp \
     src/kernel/MonteCarlo.cpp \
+    src/kernel/SemiAnalytic.cpp \
+    src/kernel/Statistics.cpp \
+    src/kernel/Convergence.cpp \
+    src/kernel/Shard.cpp \
+    src/kernel/Instrumentation.cpp \
     src/kernel/SimulationThread.cpp \
+    src/kernel/WriterThread.cpp \
     src/kernel/Inverse.cpp \
     src/kernel/Input.cpp \
     src/kernel/InputData.cpp \
@@ -60,7 +82,12 @@ SOURCES += \
     src/portfolio/Asset.cpp \
     src/utils/PowMatrix.cpp \
     src/utils/Utils.cpp \
+    src/utils/BatchRng.cpp \
+    src/utils/Sobol.cpp \
+    src/utils/TDigest.cpp \
+    src/utils/Checkpoint.cpp \
     src/utils/Thread.cpp \
+    src/utils/CsvFile.cpp \
     src/utils/Parser.cpp \
     src/utils/Logger.cpp \
     src/utils/MacrosBuffer.cpp \
@@ -84,8 +111,9 @@ CONFIG(release, debug|release) {
   DEFINES += NDEBUG
 }
 
-QMAKE_CXXFLAGS += -Wall -Wextra -Wshadow -Wpedantic
+QMAKE_CXXFLAGS += -fopenmp -Wall -Wextra -Wshadow -Wpedantic
 QMAKE_CXXFLAGS_RELEASE -= -g
+QMAKE_LFLAGS *= -fopenmp
 
 OBJECTS_DIR = $$PWD/build
 DESTDIR = $$PWD/build
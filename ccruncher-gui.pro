@@ -37,9 +37,16 @@ HEADERS += \
     src/kernel/InputData.hpp \
     src/kernel/XmlInputData.hpp \
     src/kernel/Aggregator.hpp \
+    src/kernel/BlockKernel.hpp \
+    src/kernel/FlatPortfolio.hpp \
     src/kernel/MonteCarlo.hpp \
     src/kernel/SimulationThread.hpp \
+    src/kernel/WriterThread.hpp \
     src/kernel/Inverse.hpp \
+    src/kernel/Statistics.hpp \
+    src/kernel/Convergence.hpp \
+    src/kernel/Shard.hpp \
+    src/kernel/Instrumentation.hpp \
     src/kernel/Input.hpp \
     src/portfolio/LGD.hpp \
     src/portfolio/Obligor.hpp \
@@ -49,6 +56,11 @@ HEADERS += \
     src/utils/PowMatrix.hpp \
     src/utils/Utils.hpp \
     src/utils/Thread.hpp \
+    src/utils/RingBuffer.hpp \
+    src/utils/BatchRng.hpp \
+    src/utils/Sobol.hpp \
+    src/utils/TDigest.hpp \
+    src/utils/Checkpoint.hpp \
     src/utils/Parser.hpp \
     src/utils/Logger.hpp \
     src/utils/MacrosBuffer.hpp \
@@ -87,9 +99,16 @@ SOURCES += \
     src/kernel/InputData.cpp \
     src/kernel/XmlInputData.cpp \
     src/kernel/Aggregator.cpp \
+    src/kernel/BlockKernel.cpp \
+    src/kernel/FlatPortfolio.cpp \
     src/kernel/MonteCarlo.cpp \
     src/kernel/SimulationThread.cpp \
+    src/kernel/WriterThread.cpp \
     src/kernel/Inverse.cpp \
+    src/kernel/Statistics.cpp \
+    src/kernel/Convergence.cpp \
+    src/kernel/Shard.cpp \
+    src/kernel/Instrumentation.cpp \
     src/portfolio/LGD.cpp \
     src/portfolio/Obligor.cpp \
     src/portfolio/EAD.cpp \
@@ -97,6 +116,10 @@ SOURCES += \
     src/portfolio/Asset.cpp \
     src/utils/PowMatrix.cpp \
     src/utils/Utils.cpp \
+    src/utils/BatchRng.cpp \
+    src/utils/Sobol.cpp \
+    src/utils/TDigest.cpp \
+    src/utils/Checkpoint.cpp \
     src/utils/Thread.cpp \
     src/utils/Parser.cpp \
     src/utils/Logger.cpp \
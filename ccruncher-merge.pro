@@ -0,0 +1,36 @@
+QT -= core gui
+TARGET = ccruncher-merge
+CONFIG -= qt
+CONFIG += c++14 console
+VERSION = 2.6.1
+
+HEADERS += \
+    src/kernel/Shard.hpp \
+    src/kernel/ShardMerger.hpp \
+    src/utils/Exception.hpp \
+    src/utils/Utils.hpp \
+    src/utils/CsvFile.hpp
+
+SOURCES += \
+    src/ccruncher-merge.cpp \
+    src/kernel/Shard.cpp \
+    src/kernel/ShardMerger.cpp \
+    src/utils/Exception.cpp \
+    src/utils/Utils.cpp \
+    src/utils/CsvFile.cpp
+
+INCLUDEPATH += \
+    $$PWD/src
+
+LIBS += \
+    -lm
+
+CONFIG(release, debug|release) {
+  DEFINES += NDEBUG
+}
+
+QMAKE_CXXFLAGS += -Wall -Wextra -Wshadow -Wpedantic
+QMAKE_CXXFLAGS_RELEASE -= -g
+
+OBJECTS_DIR = $$PWD/build
+DESTDIR = $$PWD/build
@@ -0,0 +1,126 @@
+QT -= core gui
+TARGET = ccruncher-scale
+CONFIG -= qt
+CONFIG += c++14 console thread
+VERSION = 2.6.1
+
+HEADERS += \
+    src/bench/Benchmark.hpp \
+    src/bench/Generator.hpp \
+    src/bench/Scaling.hpp \
+    src/params/Params.hpp \
+    src/params/Interest.hpp \
+    src/params/Rating.hpp \
+    src/params/Factor.hpp \
+    src/params/Segmentation.hpp \
+    src/params/Transitions.hpp \
+    src/params/CDF.hpp \
+    src/kernel/Aggregator.hpp \
+    src/kernel/BlockKernel.hpp \
+    src/kernel/FlatPortfolio.hpp \
+    src/kernel/MonteCarlo.hpp \
+    src/kernel/SemiAnalytic.hpp \
+    src/kernel/Statistics.hpp \
+    src/kernel/Convergence.hpp \
+    src/kernel/Shard.hpp \
+    src/kernel/Instrumentation.hpp \
+    src/kernel/SimulationThread.hpp \
+    src/kernel/WriterThread.hpp \
+    src/kernel/Inverse.hpp \
+    src/kernel/Input.hpp \
+    src/kernel/InputData.hpp \
+    src/kernel/XmlInputData.hpp \
+    src/portfolio/LGD.hpp \
+    src/portfolio/Obligor.hpp \
+    src/portfolio/EAD.hpp \
+    src/portfolio/DateValues.hpp \
+    src/portfolio/Asset.hpp \
+    src/utils/PowMatrix.hpp \
+    src/utils/Utils.hpp \
+    src/utils/Thread.hpp \
+    src/utils/CsvFile.hpp \
+    src/utils/RingBuffer.hpp \
+    src/utils/BatchRng.hpp \
+    src/utils/Sobol.hpp \
+    src/utils/TDigest.hpp \
+    src/utils/Checkpoint.hpp \
+    src/utils/Parser.hpp \
+    src/utils/Logger.hpp \
+    src/utils/MacrosBuffer.hpp \
+    src/utils/ExpatParser.hpp \
+    src/utils/ExpatHandlers.hpp \
+    src/utils/Exception.hpp \
+    src/utils/Date.hpp \
+    src/utils/Expr.hpp \
+    src/utils/config.h
+
+SOURCES += \
+    src/ccruncher-scale.cpp \
+    src/bench/Benchmark.cpp \
+    src/bench/Generator.cpp \
+    src/bench/Scaling.cpp \
+    src/params/Params.cpp \
+    src/params/Interest.cpp \
+    src/params/Rating.cpp \
+    src/params/Factor.cpp \
+    src/params/Segmentation.cpp \
+    src/params/Transitions.cpp \
+    src/params/CDF.cpp \
+    src/kernel/Aggregator.cpp \
+    src/kernel/BlockKernel.cpp \
+    src/kernel/FlatPortfolio.cpp \
+    src/kernel/MonteCarlo.cpp \
+    src/kernel/SemiAnalytic.cpp \
+    src/kernel/Statistics.cpp \
+    src/kernel/Convergence.cpp \
+    src/kernel/Shard.cpp \
+    src/kernel/Instrumentation.cpp \
+    src/kernel/SimulationThread.cpp \
+    src/kernel/WriterThread.cpp \
+    src/kernel/Inverse.cpp \
+    src/kernel/Input.cpp \
+    src/kernel/InputData.cpp \
+    src/kernel/XmlInputData.cpp \
+    src/portfolio/LGD.cpp \
+    src/portfolio/Obligor.cpp \
+    src/portfolio/EAD.cpp \
+    src/portfolio/DateValues.cpp \
+    src/portfolio/Asset.cpp \
+    src/utils/PowMatrix.cpp \
+    src/utils/Utils.cpp \
+    src/utils/BatchRng.cpp \
+    src/utils/Sobol.cpp \
+    src/utils/TDigest.cpp \
+    src/utils/Checkpoint.cpp \
+    src/utils/Thread.cpp \
+    src/utils/CsvFile.cpp \
+    src/utils/Parser.cpp \
+    src/utils/Logger.cpp \
+    src/utils/MacrosBuffer.cpp \
+    src/utils/ExpatParser.cpp \
+    src/utils/ExpatHandlers.cpp \
+    src/utils/Exception.cpp \
+    src/utils/Date.cpp \
+    src/utils/Expr.cpp
+
+INCLUDEPATH += \
+    $$PWD/src
+
+LIBS += \
+    -lm \
+    -lz \
+    -lgsl \
+    -lgslcblas \
+    -lexpat
+
+CONFIG(release, debug|release) {
+  DEFINES += NDEBUG
+}
+
+QMAKE_CXXFLAGS += -fopenmp -Wall -Wextra -Wshadow -Wpedantic
+QMAKE_CXXFLAGS_RELEASE -= -g
+QMAKE_LFLAGS *= -fopenmp
+
+OBJECTS_DIR = $$PWD/build
+DESTDIR = $$PWD/build
+
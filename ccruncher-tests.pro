@@ -18,10 +18,31 @@ HEADERS += \
     src/params/InterestTest.hpp \
     src/params/CDFTest.hpp \
     src/kernel/Aggregator.hpp \
+    src/kernel/BlockKernel.hpp \
+    src/kernel/FlatPortfolio.hpp \
     src/kernel/MonteCarlo.hpp \
+    src/kernel/SemiAnalytic.hpp \
+    src/kernel/Statistics.hpp \
+    src/kernel/Convergence.hpp \
+    src/kernel/Shard.hpp \
+    src/kernel/Instrumentation.hpp \
+    src/kernel/ShardMerger.hpp \
+    src/bench/Generator.hpp \
+    src/bench/Scaling.hpp \
     src/kernel/SimulationThread.hpp \
+    src/kernel/WriterThread.hpp \
     src/kernel/Inverse.hpp \
     src/kernel/InverseTest.hpp \
+    src/kernel/AggregatorTest.hpp \
+    src/kernel/FlatPortfolioTest.hpp \
+    src/kernel/BlockKernelTest.hpp \
+    src/kernel/MonteCarloTest.hpp \
+    src/kernel/SemiAnalyticTest.hpp \
+    src/kernel/StatisticsTest.hpp \
+    src/kernel/ConvergenceTest.hpp \
+    src/kernel/ShardMergerTest.hpp \
+    src/bench/GeneratorTest.hpp \
+    src/bench/ScalingTest.hpp \
     src/kernel/Input.hpp \
     src/kernel/InputTest.hpp \
     src/kernel/InputData.hpp \
@@ -41,6 +62,12 @@ HEADERS += \
     src/utils/PowMatrixTest.hpp \
     src/utils/Utils.hpp \
     src/utils/Thread.hpp \
+    src/utils/CsvFile.hpp \
+    src/utils/RingBuffer.hpp \
+    src/utils/BatchRng.hpp \
+    src/utils/Sobol.hpp \
+    src/utils/TDigest.hpp \
+    src/utils/Checkpoint.hpp \
     src/utils/Parser.hpp \
     src/utils/Logger.hpp \
     src/utils/MacrosBuffer.hpp \
@@ -51,6 +78,11 @@ HEADERS += \
     src/utils/Expr.hpp \
     src/utils/config.h \
     src/utils/UtilsTest.hpp \
+    src/utils/RingBufferTest.hpp \
+    src/utils/BatchRngTest.hpp \
+    src/utils/SobolTest.hpp \
+    src/utils/TDigestTest.hpp \
+    src/utils/CheckpointTest.hpp \
     src/utils/ParserTest.hpp \
     src/utils/MacrosBufferTest.hpp \
     src/utils/ExceptionTest.hpp \
@@ -73,10 +105,31 @@ SOURCES += \
     src/params/InterestTest.cpp \
     src/params/CDFTest.cpp \
     src/kernel/Aggregator.cpp \
+    src/kernel/BlockKernel.cpp \
+    src/kernel/FlatPortfolio.cpp \
     src/kernel/MonteCarlo.cpp \
+    src/kernel/SemiAnalytic.cpp \
+    src/kernel/Statistics.cpp \
+    src/kernel/Convergence.cpp \
+    src/kernel/Shard.cpp \
+    src/kernel/Instrumentation.cpp \
+    src/kernel/ShardMerger.cpp \
+    src/bench/Generator.cpp \
+    src/bench/Scaling.cpp \
     src/kernel/SimulationThread.cpp \
+    src/kernel/WriterThread.cpp \
     src/kernel/Inverse.cpp \
     src/kernel/InverseTest.cpp \
+    src/kernel/AggregatorTest.cpp \
+    src/kernel/FlatPortfolioTest.cpp \
+    src/kernel/BlockKernelTest.cpp \
+    src/kernel/MonteCarloTest.cpp \
+    src/kernel/SemiAnalyticTest.cpp \
+    src/kernel/StatisticsTest.cpp \
+    src/kernel/ConvergenceTest.cpp \
+    src/kernel/ShardMergerTest.cpp \
+    src/bench/GeneratorTest.cpp \
+    src/bench/ScalingTest.cpp \
     src/kernel/Input.cpp \
     src/kernel/InputTest.cpp \
     src/kernel/InputData.cpp \
@@ -95,7 +148,12 @@ SOURCES += \
     src/utils/PowMatrix.cpp \
     src/utils/PowMatrixTest.cpp \
     src/utils/Utils.cpp \
+    src/utils/BatchRng.cpp \
+    src/utils/Sobol.cpp \
+    src/utils/TDigest.cpp \
+    src/utils/Checkpoint.cpp \
     src/utils/Thread.cpp \
+    src/utils/CsvFile.cpp \
     src/utils/Parser.cpp \
     src/utils/Logger.cpp \
     src/utils/MacrosBuffer.cpp \
@@ -105,6 +163,11 @@ SOURCES += \
     src/utils/Date.cpp \
     src/utils/Expr.cpp \
     src/utils/UtilsTest.cpp \
+    src/utils/RingBufferTest.cpp \
+    src/utils/BatchRngTest.cpp \
+    src/utils/SobolTest.cpp \
+    src/utils/TDigestTest.cpp \
+    src/utils/CheckpointTest.cpp \
     src/utils/ParserTest.cpp \
     src/utils/MacrosBufferTest.cpp \
     src/utils/ExceptionTest.cpp \
@@ -126,7 +189,8 @@ CONFIG(release, debug|release) {
   DEFINES += NDEBUG
 }
 
-QMAKE_CXXFLAGS += -Wall -Wextra -Wshadow -Wpedantic
+QMAKE_CXXFLAGS += -fopenmp -Wall -Wextra -Wshadow -Wpedantic
+QMAKE_LFLAGS *= -fopenmp
 
 OBJECTS_DIR = $$PWD/build
 DESTDIR = $$PWD/build
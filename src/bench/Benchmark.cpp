@@ -0,0 +1,379 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <fstream>
+#include <iomanip>
+#include <cassert>
+#include "bench/Benchmark.hpp"
+#include "kernel/MonteCarlo.hpp"
+#include "kernel/SimulationThread.hpp"
+#include "kernel/XmlInputData.hpp"
+#include "kernel/Aggregator.hpp"
+#include "params/Segmentation.hpp"
+#include "utils/BatchRng.hpp"
+#include "utils/CsvFile.hpp"
+#include "utils/Utils.hpp"
+#include "utils/Exception.hpp"
+#include "utils/config.h"
+
+// batch size of micro-benchmarks
+#define BATCHSIZE 4096
+// number of rows of the file read by CsvFile benchmark
+#define CSVROWS 100000
+
+using namespace std;
+
+/**************************************************************************//**
+ * @param[in] generator Synthetic portfolio parameters.
+ * @param[in] path Working directory (output files are written here).
+ * @param[in] mintime Minimum time by micro-benchmark (in seconds).
+ * @throw Exception Invalid parameters.
+ */
+ccruncher::Benchmark::Benchmark(const Generator &generator, const string &path, double mintime) :
+  mGenerator(generator), mPath(path), mMinTime(mintime), mSink(0.0)
+{
+  if (!Utils::existDir(path)) {
+    throw Exception("directory '" + path + "' not found");
+  }
+  if (mintime <= 0.0) {
+    throw Exception("benchmark time out of range");
+  }
+  mXml = mGenerator.getXml();
+}
+
+/**************************************************************************//**
+ * @details Calls the batch function repeatedly until the elapsed time
+ *          exceeds the minimum time. Batch returns the number of units
+ *          done.
+ * @param[in] name Benchmark name.
+ * @param[in] unit Measured unit.
+ * @param[in] batch Function to benchmark.
+ */
+void ccruncher::Benchmark::measure(const string &name, const string &unit, const function<size_t()> &batch)
+{
+  size_t count = 0;
+  auto t0 = chrono::steady_clock::now();
+  double seconds = 0.0;
+  do {
+    count += batch();
+    seconds = chrono::duration<double>(chrono::steady_clock::now()-t0).count();
+  }
+  while(seconds < mMinTime);
+  mResults.push_back(Result{name, unit, 1, count, seconds});
+}
+
+/**************************************************************************//**
+ * @details Evaluates the inverse functions of all non-default ratings
+ *          with values below the non-default threshold (ie. values that
+ *          require the spline or table evaluation).
+ */
+void ccruncher::Benchmark::runInverse()
+{
+  XmlInputData data;
+  data.readString(mXml);
+  MonteCarlo montecarlo;
+  montecarlo.init(data, mPath, 'w');
+  const vector<Inverse> &inverses = montecarlo.inverses;
+
+  mt19937_64 rng(mGenerator.seed);
+  vector<double> values(BATCHSIZE);
+  vector<size_t> ratings;
+  for(size_t i=0; i<inverses.size(); i++) {
+    if (inverses[i].size() > 0) ratings.push_back(i);
+  }
+  assert(!ratings.empty());
+
+  measure("inverse.evalue", "evaluations", [&]() {
+    size_t irating = ratings[rng()%ratings.size()];
+    double threshold = inverses[irating].getThreshold();
+    for(size_t i=0; i<values.size(); i++) {
+      values[i] = threshold - 3.0*static_cast<double>(rng()>>11)/9007199254740992.0;
+    }
+    double sum = 0.0;
+    for(size_t i=0; i<values.size(); i++) {
+      sum += inverses[irating].evalue(values[i]);
+    }
+    mSink += sum;
+    return values.size();
+  });
+}
+
+/**************************************************************************//**
+ * @details Samples all the portfolio date-values exposures and losses
+ *          given default (fixed values and random variables, according
+ *          to the generator mix).
+ */
+void ccruncher::Benchmark::runExposures()
+{
+  XmlInputData data;
+  data.readString(mXml);
+  MonteCarlo montecarlo;
+  montecarlo.init(data, mPath, 'w');
+  const FlatPortfolio &portfolio = montecarlo.portfolio;
+  BatchRng random(mGenerator.seed);
+
+  measure("ead.getValue", "samples", [&]() {
+    double sum = 0.0;
+    for(size_t i=0; i<portfolio.eads.size(); i++) {
+      sum += portfolio.eads[i].getValue(random.getRng());
+    }
+    mSink += sum;
+    return portfolio.eads.size();
+  });
+
+  measure("lgd.getValue", "samples", [&]() {
+    double sum = 0.0;
+    for(size_t i=0; i<portfolio.lgds.size(); i++) {
+      double lgd = portfolio.lgds[i].getValue(random.getRng());
+      if (!std::isnan(lgd)) sum += lgd;
+    }
+    mSink += sum;
+    return portfolio.lgds.size();
+  });
+}
+
+/**************************************************************************//**
+ * @details Simulates the loss of every obligor at a random default time
+ *          in the simulation interval.
+ */
+void ccruncher::Benchmark::runObligorLoss()
+{
+  XmlInputData data;
+  data.readString(mXml);
+  MonteCarlo montecarlo;
+  montecarlo.init(data, mPath, 'w');
+  SimulationThread thread(montecarlo, mGenerator.seed);
+
+  size_t numobligors = montecarlo.portfolio.size();
+  vector<Date> dtimes(numobligors);
+  mt19937_64 rng(mGenerator.seed);
+  long days = montecarlo.timeT - montecarlo.time0;
+  for(size_t i=0; i<numobligors; i++) {
+    dtimes[i] = montecarlo.time0 + static_cast<long>(rng()%static_cast<uint64_t>(days+1));
+  }
+  vector<double> losses(montecarlo.numsegments, 0.0);
+  bool fixed = (montecarlo.portfolio.getValuesKind() == FlatPortfolio::ValuesKind::Fixed);
+
+  measure("simulationthread.simuleObligorLoss", "obligors", [&]() {
+    for(size_t i=0; i<numobligors; i++) {
+      if (fixed) {
+        thread.simuleObligorLoss<FlatPortfolio::ValuesKind::Fixed>(i, dtimes[i], losses.data());
+      }
+      else {
+        thread.simuleObligorLoss<FlatPortfolio::ValuesKind::Random>(i, dtimes[i], losses.data());
+      }
+    }
+    mSink += losses[0];
+    return numobligors;
+  });
+}
+
+/**************************************************************************//**
+ * @details Appends random rows to a segmentation file (CSV and binary).
+ *          Segmentation has the generator number of segments.
+ */
+void ccruncher::Benchmark::runAggregator()
+{
+  Segmentation segmentation("bench");
+  for(size_t i=1; i<mGenerator.numsegments; i++) {
+    segmentation.addSegment("S" + to_string(i));
+  }
+  unsigned short numsegments = segmentation.size();
+  vector<double> exposures(numsegments, 1000.0);
+
+  mt19937_64 rng(mGenerator.seed);
+  vector<double> rows(BATCHSIZE*numsegments);
+  for(size_t i=0; i<rows.size(); i++) {
+    rows[i] = static_cast<double>(rng()%100000000) / 1000.0;
+  }
+
+  const Aggregator::Format formats[] = {Aggregator::Format::Csv, Aggregator::Format::Float64};
+  for(Aggregator::Format format : formats)
+  {
+    string filename = mPath + Utils::pathSeparator + "bench" + Aggregator::getExtension(format);
+    Aggregator aggregator(filename, 'w', numsegments, format);
+    aggregator.printHeader(segmentation, exposures);
+    string name = "aggregator.append." + Aggregator::getExtension(format).substr(1);
+    measure(name, "rows", [&]() {
+      for(size_t i=0; i<BATCHSIZE; i++) {
+        aggregator.append(rows.data() + i*numsegments);
+      }
+      return BATCHSIZE;
+    });
+    aggregator.flush();
+  }
+}
+
+/**************************************************************************//**
+ * @details Reads the first column of a CSV segmentation file with
+ *          CSVROWS rows.
+ */
+void ccruncher::Benchmark::runCsvFile()
+{
+  Segmentation segmentation("bench");
+  for(size_t i=1; i<mGenerator.numsegments; i++) {
+    segmentation.addSegment("S" + to_string(i));
+  }
+  unsigned short numsegments = segmentation.size();
+  string filename = mPath + Utils::pathSeparator + "bench-read.csv";
+
+  {
+    Aggregator aggregator(filename, 'w', numsegments);
+    aggregator.printHeader(segmentation, vector<double>(numsegments, 1000.0));
+    mt19937_64 rng(mGenerator.seed);
+    vector<double> row(numsegments);
+    for(size_t i=0; i<CSVROWS; i++) {
+      for(size_t j=0; j<row.size(); j++) {
+        row[j] = static_cast<double>(rng()%100000000) / 1000.0;
+      }
+      aggregator.append(row.data());
+    }
+  }
+
+  CsvFile csv(filename);
+  vector<double> values;
+  measure("csvfile.getColumn", "rows", [&]() {
+    csv.getColumn(0, values);
+    mSink += values.back();
+    return values.size();
+  });
+}
+
+/**************************************************************************//**
+ * @details Parses the synthetic input file (including the portfolio).
+ */
+void ccruncher::Benchmark::runXmlParser()
+{
+  measure("xmlinputdata.readString", "obligors", [&]() {
+    XmlInputData data;
+    data.readString(mXml);
+    return data.getPortfolio().size();
+  });
+}
+
+/**************************************************************************/
+void ccruncher::Benchmark::runMicro()
+{
+  runInverse();
+  runExposures();
+  runObligorLoss();
+  runAggregator();
+  runCsvFile();
+  runXmlParser();
+}
+
+/**************************************************************************//**
+ * @details Runs the Monte Carlo simulation of the synthetic portfolio
+ *          (generator number of simulations). Elapsed time doesn't
+ *          include the input file parsing nor the initialization.
+ * @param[in] numthreads Number of threads.
+ * @return Benchmark result.
+ */
+const ccruncher::Benchmark::Result& ccruncher::Benchmark::runSimulation(unsigned int numthreads)
+{
+  if (numthreads == 0 || 255 < numthreads) {
+    throw Exception("number of threads out of range [1,255]");
+  }
+
+  XmlInputData data;
+  data.readString(mXml);
+  MonteCarlo montecarlo;
+  montecarlo.init(data, mPath, 'w');
+
+  auto t0 = chrono::steady_clock::now();
+  montecarlo.run(static_cast<unsigned char>(numthreads));
+  double seconds = chrono::duration<double>(chrono::steady_clock::now()-t0).count();
+
+  mResults.push_back(Result{"montecarlo.run", "simulations", numthreads, montecarlo.getNumIterations(), seconds});
+  return mResults.back();
+}
+
+/**************************************************************************//**
+ * @param[in] os Output stream.
+ */
+void ccruncher::Benchmark::print(ostream &os) const
+{
+  ios::fmtflags flags = os.flags();
+  os << left << setw(36) << "benchmark" << right << setw(8) << "threads" <<
+        setw(14) << "count" << setw(10) << "seconds" << setw(16) << "rate" << "  unit" << "\n";
+  for(const Result &result : mResults) {
+    os << left << setw(36) << result.name << right << setw(8) << result.numthreads <<
+          setw(14) << result.count << setw(10) << fixed << setprecision(3) << result.seconds <<
+          setw(16) << setprecision(0) << static_cast<double>(result.count)/result.seconds <<
+          "  " << result.unit << "/s\n";
+  }
+  os.flags(flags);
+  os.flush();
+}
+
+/**************************************************************************//**
+ * @details File contains the program version, the synthetic portfolio
+ *          parameters and the benchmark results.
+ * @param[in] filename File name.
+ * @throw Exception Error writing file.
+ */
+void ccruncher::Benchmark::write(const string &filename) const
+{
+  try
+  {
+    ofstream file;
+    file.exceptions(ios::failbit | ios::badbit);
+    file.open(filename.c_str(), ios::out|ios::trunc);
+    file.precision(9);
+    file << "{\n";
+    file << "  \"version\": \"" << Utils::jsonEscape(string(PACKAGE_VERSION) + " (" + GIT_VERSION + ")") << "\",\n";
+    file << "  \"options\": \"" << Utils::jsonEscape(Utils::getCompilationOptions()) << "\",\n";
+    file << "  \"timestamp\": \"" << Utils::jsonEscape(Utils::timestamp()) << "\",\n";
+    file << "  \"cores\": " << Utils::getNumCores() << ",\n";
+    file << "  \"model\": {\n";
+    file << "    \"obligors\": " << mGenerator.numobligors << ",\n";
+    file << "    \"assets\": " << mGenerator.numassets << ",\n";
+    file << "    \"dates\": " << mGenerator.numdates << ",\n";
+    file << "    \"values\": " << mGenerator.numvalues << ",\n";
+    file << "    \"factors\": " << mGenerator.numfactors << ",\n";
+    file << "    \"ratings\": " << mGenerator.numratings << ",\n";
+    file << "    \"segmentations\": " << mGenerator.numsegmentations << ",\n";
+    file << "    \"segments\": " << mGenerator.numsegments << ",\n";
+    file << "    \"eadmix\": " << mGenerator.eadmix << ",\n";
+    file << "    \"lgdmix\": " << mGenerator.lgdmix << ",\n";
+    file << "    \"years\": " << mGenerator.years << ",\n";
+    file << "    \"simulations\": " << mGenerator.numsims << ",\n";
+    file << "    \"seed\": " << mGenerator.seed << "\n";
+    file << "  },\n";
+    file << "  \"results\": [";
+    for(size_t i=0; i<mResults.size(); i++) {
+      const Result &result = mResults[i];
+      file << (i>0?",":"") << "\n    {\"name\": \"" << Utils::jsonEscape(result.name) << "\", \"unit\": \"" << Utils::jsonEscape(result.unit) <<
+              "\", \"threads\": " << result.numthreads << ", \"count\": " << result.count <<
+              ", \"seconds\": " << result.seconds << ", \"rate\": " << static_cast<double>(result.count)/result.seconds << "}";
+    }
+    file << "\n  ]\n";
+    file << "}\n";
+    file.close();
+  }
+  catch(std::exception &e) {
+    throw Exception(e, "error writing file '" + filename + "'");
+  }
+}
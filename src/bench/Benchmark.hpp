@@ -0,0 +1,117 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <functional>
+#include "bench/Generator.hpp"
+
+namespace ccruncher {
+
+/**************************************************************************//**
+ * @brief Micro and macro benchmarks.
+ *
+ * @details Micro-benchmarks measure the hot functions of the simulation
+ *          (inverse evaluation, EAD and LGD sampling, obligor loss,
+ *          losses aggregation and reading) and the input file parsing
+ *          using a synthetic portfolio (see Generator). Each one is
+ *          repeated until the minimum time is reached. Macro-benchmarks
+ *          measure the simulations per second of the whole Monte Carlo
+ *          (including output files) with a given number of threads.
+ *          Results are written in JSON format, so they can be compared
+ *          between releases.
+ *
+ * @see Generator
+ */
+class Benchmark
+{
+
+  public:
+
+    //! Benchmark result
+    struct Result
+    {
+      //! Benchmark name
+      std::string name;
+      //! Measured unit (eg. evaluations)
+      std::string unit;
+      //! Number of threads
+      unsigned int numthreads;
+      //! Number of units done
+      size_t count;
+      //! Elapsed time (in seconds)
+      double seconds;
+    };
+
+  private:
+
+    //! Synthetic portfolio parameters
+    Generator mGenerator;
+    //! Input file content
+    std::string mXml;
+    //! Working directory
+    std::string mPath;
+    //! Minimum time by micro-benchmark (in seconds)
+    double mMinTime;
+    //! Benchmark results
+    std::vector<Result> mResults;
+    //! Accumulated values (avoids dead code elimination)
+    double mSink;
+
+  private:
+
+    //! Repeats a batch until the minimum time is reached
+    void measure(const std::string &name, const std::string &unit, const std::function<size_t()> &batch);
+
+  public:
+
+    //! Constructor
+    Benchmark(const Generator &generator, const std::string &path, double mintime=0.5);
+    //! Inverse::evalue()
+    void runInverse();
+    //! EAD::getValue() and LGD::getValue()
+    void runExposures();
+    //! SimulationThread::simuleObligorLoss()
+    void runObligorLoss();
+    //! Aggregator::append()
+    void runAggregator();
+    //! CsvFile::getColumn()
+    void runCsvFile();
+    //! XmlInputData::readString()
+    void runXmlParser();
+    //! All micro-benchmarks
+    void runMicro();
+    //! MonteCarlo::run()
+    const Result& runSimulation(unsigned int numthreads);
+    //! Returns benchmark results
+    const std::vector<Result>& getResults() const { return mResults; }
+    //! Prints results
+    void print(std::ostream &os) const;
+    //! Writes results (JSON)
+    void write(const std::string &filename) const;
+
+};
+
+} // namespace
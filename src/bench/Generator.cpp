@@ -0,0 +1,304 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#include <cmath>
+#include <vector>
+#include <sstream>
+#include <fstream>
+#include <cassert>
+#include "bench/Generator.hpp"
+#include "utils/Date.hpp"
+#include "utils/Exception.hpp"
+
+using namespace std;
+
+/**************************************************************************//**
+ * @details Default parameters define a small portfolio (1000 obligors).
+ */
+ccruncher::Generator::Generator() :
+  numobligors(1000), numassets(2), numdates(24), numvalues(12),
+  numfactors(4), numratings(7), numsegmentations(3), numsegments(10),
+  eadmix(0.0), lgdmix(0.0), years(2), numsims(100000), seed(1UL)
+{
+  // nothing to do
+}
+
+/**************************************************************************//**
+ * @throw Exception Invalid parameters.
+ */
+void ccruncher::Generator::validate() const
+{
+  if (numobligors == 0) {
+    throw Exception("number of obligors out of range");
+  }
+  if (numassets == 0) {
+    throw Exception("number of assets out of range");
+  }
+  if (numdates == 0) {
+    throw Exception("number of dates out of range");
+  }
+  if (numvalues == 0 || numdates < numvalues) {
+    throw Exception("number of date-values out of range [1," + to_string(numdates) + "]");
+  }
+  if (numfactors == 0 || 255 < numfactors) {
+    throw Exception("number of factors out of range [1,255]");
+  }
+  if (numratings == 0 || 254 < numratings) {
+    throw Exception("number of ratings out of range [1,254]");
+  }
+  if (numsegmentations == 0 || numsegments == 0 || 65535 < numsegmentations*(numsegments+1)) {
+    throw Exception("number of segments out of range");
+  }
+  if (eadmix < 0.0 || 1.0 < eadmix || std::isnan(eadmix)) {
+    throw Exception("ead mix out of range [0,1]");
+  }
+  if (lgdmix < 0.0 || 1.0 < lgdmix || std::isnan(lgdmix)) {
+    throw Exception("lgd mix out of range [0,1]");
+  }
+  if (years <= 0 || 100 < years) {
+    throw Exception("time horizon out of range [1,100]");
+  }
+  if (numsims == 0) {
+    throw Exception("number of simulations out of range");
+  }
+}
+
+/**************************************************************************//**
+ * @details Uses the 53 upper bits of the generated value, so the sequence
+ *          doesn't depend on the standard library implementation.
+ * @return Value in [0,1).
+ */
+double ccruncher::Generator::uniform()
+{
+  return static_cast<double>(rng() >> 11) * (1.0/9007199254740992.0);
+}
+
+/**************************************************************************//**
+ * @details A fraction eadmix of exposures are random variables with
+ *          expected value x. Distributions are chosen cyclically.
+ * @param[in] x Exposure expected value.
+ * @return EAD definition.
+ */
+string ccruncher::Generator::getEAD(double x)
+{
+  ostringstream oss;
+  oss.precision(6);
+  if (eadmix <= uniform()) {
+    oss << x;
+    return oss.str();
+  }
+  switch(rng()%5)
+  {
+    case 0: // E = exp(mu+sigma^2/2)
+      oss << "lognormal(" << log(x)-0.5*0.25*0.25 << ",0.25)";
+      break;
+    case 1:
+      oss << "exponential(" << x << ")";
+      break;
+    case 2:
+      oss << "uniform(" << 0.5*x << "," << 1.5*x << ")";
+      break;
+    case 3: // E = k·theta
+      oss << "gamma(4," << x/4.0 << ")";
+      break;
+    default:
+      oss << "normal(" << x << "," << 0.2*x << ")";
+      break;
+  }
+  return oss.str();
+}
+
+/**************************************************************************//**
+ * @details A fraction lgdmix of losses given default are random variables.
+ *          Distributions are chosen cyclically.
+ * @return LGD definition.
+ */
+string ccruncher::Generator::getLGD()
+{
+  ostringstream oss;
+  if (lgdmix <= uniform()) {
+    oss << 10*(1+rng()%9) << "%";
+  }
+  else if (rng()%2 == 0) {
+    oss << "uniform(20%,80%)";
+  }
+  else {
+    oss << "beta(2,3)";
+  }
+  return oss.str();
+}
+
+/**************************************************************************//**
+ * @details Ratings are named R1,...,Rn (from best to worst) and D
+ *          (default). One-year default probabilities grow geometrically
+ *          from 0.05% to 25%. Factors are named F1,...,Fn, with loadings
+ *          in [20%,40%] and constant correlation 10%. The first
+ *          segmentation is 'portfolio', the remaining ones have numsegments
+ *          segments each and are assigned alternately at obligor level
+ *          and asset level. Date-values of each asset are a random sorted
+ *          subset of the distinct dates, with decreasing exposure.
+ * @return Input file content.
+ * @throw Exception Invalid parameters.
+ */
+string ccruncher::Generator::getXml()
+{
+  validate();
+  rng.seed(seed);
+
+  Date time0(1, 1, 2025);
+  Date timeT(1, 1, 2025+years);
+
+  // distinct dates in (time0, timeT]
+  vector<Date> dates(numdates);
+  for(size_t i=0; i<numdates; i++) {
+    dates[i] = time0 + static_cast<long>(ceil(static_cast<double>(i+1)*(timeT-time0)/static_cast<double>(numdates)));
+  }
+
+  ostringstream oss;
+  oss.precision(6);
+  oss << "<?xml version='1.0' encoding='UTF-8'?>\n";
+  oss << "<ccruncher>\n";
+  oss << "  <title>synthetic portfolio</title>\n";
+  oss << "  <description>obligors=" << numobligors << ", assets=" << numassets <<
+         ", dates=" << numdates << ", values=" << numvalues << ", factors=" << numfactors <<
+         ", ratings=" << numratings << ", segmentations=" << numsegmentations <<
+         ", segments=" << numsegments << ", eadmix=" << eadmix << ", lgdmix=" << lgdmix <<
+         ", seed=" << seed << "</description>\n";
+
+  oss << "  <parameters>\n";
+  oss << "    <parameter name='time.0' value='" << time0.toString() << "'/>\n";
+  oss << "    <parameter name='time.T' value='" << timeT.toString() << "'/>\n";
+  oss << "    <parameter name='maxiterations' value='" << numsims << "'/>\n";
+  oss << "    <parameter name='maxseconds' value='86400'/>\n";
+  oss << "    <parameter name='copula' value='t(5)'/>\n";
+  oss << "    <parameter name='rng.seed' value='" << seed << "'/>\n";
+  oss << "    <parameter name='antithetic' value='true'/>\n";
+  oss << "    <parameter name='blocksize' value='128'/>\n";
+  oss << "  </parameters>\n";
+
+  oss << "  <interest type='compound'>\n";
+  oss << "    <rate t='0D' r='0%'/>\n";
+  oss << "    <rate t='" << years << "Y' r='3%'/>\n";
+  oss << "  </interest>\n";
+
+  oss << "  <ratings>\n";
+  for(size_t i=0; i<numratings; i++) {
+    oss << "    <rating name='R" << i+1 << "'/>\n";
+  }
+  oss << "    <rating name='D' description='default'/>\n";
+  oss << "  </ratings>\n";
+
+  oss << "  <dprobs>\n";
+  for(size_t i=0; i<numratings; i++) {
+    double x = (numratings==1 ? 0.5 : static_cast<double>(i)/static_cast<double>(numratings-1));
+    double pd = 0.0005 * pow(0.25/0.0005, x);
+    oss << "    <dprob rating='R" << i+1 << "' t='0M' value='0'/>\n";
+    for(int y=1; y<=years; y++) {
+      oss << "    <dprob rating='R" << i+1 << "' t='" << y << "Y' value='" << 1.0-pow(1.0-pd, y) << "'/>\n";
+    }
+  }
+  oss << "    <dprob rating='D' t='0M' value='1'/>\n";
+  oss << "    <dprob rating='D' t='" << years << "Y' value='1'/>\n";
+  oss << "  </dprobs>\n";
+
+  oss << "  <factors>\n";
+  for(size_t i=0; i<numfactors; i++) {
+    double x = (numfactors==1 ? 0.5 : static_cast<double>(i)/static_cast<double>(numfactors-1));
+    oss << "    <factor name='F" << i+1 << "' loading='" << 0.2+0.2*x << "'/>\n";
+  }
+  oss << "  </factors>\n";
+
+  oss << "  <correlations>\n";
+  for(size_t i=0; i<numfactors; i++) {
+    for(size_t j=i+1; j<numfactors; j++) {
+      oss << "    <correlation factor1='F" << i+1 << "' factor2='F" << j+1 << "' value='0.1'/>\n";
+    }
+  }
+  oss << "  </correlations>\n";
+
+  oss << "  <segmentations>\n";
+  oss << "    <segmentation name='portfolio'/>\n";
+  for(size_t i=1; i<numsegmentations; i++) {
+    oss << "    <segmentation name='segmentation" << i << "'>\n";
+    for(size_t j=0; j<numsegments; j++) {
+      oss << "      <segment name='S" << j+1 << "'/>\n";
+    }
+    oss << "    </segmentation>\n";
+  }
+  oss << "  </segmentations>\n";
+
+  oss << "  <portfolio>\n";
+  for(size_t i=0; i<numobligors; i++)
+  {
+    oss << "    <obligor id='O" << i+1 << "' rating='R" << 1+rng()%numratings <<
+           "' factor='F" << 1+rng()%numfactors << "' lgd='" << getLGD() << "'>\n";
+    for(size_t k=2; k<=numsegmentations; k+=2) {
+      oss << "      <belongs-to segmentation='segmentation" << k-1 << "' segment='S" << 1+rng()%numsegments << "'/>\n";
+    }
+    for(size_t j=0; j<numassets; j++)
+    {
+      oss << "      <asset id='O" << i+1 << "-A" << j+1 << "' date='" << add(time0, -1, 'Y').toString() << "'>\n";
+      for(size_t k=3; k<=numsegmentations; k+=2) {
+        oss << "        <belongs-to segmentation='segmentation" << k-1 << "' segment='S" << 1+rng()%numsegments << "'/>\n";
+      }
+      oss << "        <data>\n";
+      // selection sampling (sorted subset of numvalues dates)
+      double x = 100.0 + 9900.0*pow(uniform(), 2);
+      size_t num = 0;
+      for(size_t k=0; k<numdates && num<numvalues; k++) {
+        if (static_cast<double>(numdates-k)*uniform() < static_cast<double>(numvalues-num)) {
+          double ead = x * (1.0 - static_cast<double>(num)/static_cast<double>(numvalues+1));
+          oss << "          <values t='" << dates[k].toString() << "' ead='" << getEAD(ead) << "'";
+          if (rng()%2 == 0) oss << " lgd='" << getLGD() << "'";
+          oss << "/>\n";
+          num++;
+        }
+      }
+      assert(num == numvalues);
+      oss << "        </data>\n";
+      oss << "      </asset>\n";
+    }
+    oss << "    </obligor>\n";
+  }
+  oss << "  </portfolio>\n";
+  oss << "</ccruncher>\n";
+
+  return oss.str();
+}
+
+/**************************************************************************//**
+ * @param[in] filename Output file name.
+ * @throw Exception Error writing file.
+ */
+void ccruncher::Generator::write(const string &filename)
+{
+  string content = getXml();
+  ofstream file(filename.c_str(), ios::out|ios::trunc);
+  if (!file.is_open()) {
+    throw Exception("error opening file '" + filename + "'");
+  }
+  file << content;
+  file.close();
+  if (file.fail()) {
+    throw Exception("error writing file '" + filename + "'");
+  }
+}
@@ -0,0 +1,104 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <random>
+
+namespace ccruncher {
+
+/**************************************************************************//**
+ * @brief Synthetic portfolio generator.
+ *
+ * @details Creates a valid ccruncher input file (xml) with the given
+ *          dimensions: obligors, assets by obligor, distinct dates,
+ *          date-values by asset, factors, ratings and segmentations.
+ *          A fraction of EADs and LGDs are random variables (the
+ *          remaining ones are fixed values), cycling through all the
+ *          supported distributions. Content depends only on the
+ *          parameters and the seed, so benchmarks done with the same
+ *          parameters are comparable between releases.
+ *
+ * @see Benchmark
+ */
+class Generator
+{
+
+  public:
+
+    //! Number of obligors
+    size_t numobligors;
+    //! Number of assets by obligor
+    size_t numassets;
+    //! Number of distinct dates in portfolio
+    size_t numdates;
+    //! Number of date-values by asset
+    size_t numvalues;
+    //! Number of factors
+    size_t numfactors;
+    //! Number of ratings (excluding default)
+    size_t numratings;
+    //! Number of segmentations (including 'portfolio')
+    size_t numsegmentations;
+    //! Number of segments by segmentation
+    size_t numsegments;
+    //! Fraction of random EADs
+    double eadmix;
+    //! Fraction of random LGDs
+    double lgdmix;
+    //! Simulation horizon (in years)
+    int years;
+    //! Number of simulations
+    size_t numsims;
+    //! Generator seed
+    uint64_t seed;
+
+  private:
+
+    //! Random number generator
+    std::mt19937_64 rng;
+
+  private:
+
+    //! Uniform random value in [0,1)
+    double uniform();
+    //! Random EAD
+    std::string getEAD(double x);
+    //! Random LGD
+    std::string getLGD();
+
+  public:
+
+    //! Constructor
+    Generator();
+    //! Check parameters
+    void validate() const;
+    //! Returns the input file content
+    std::string getXml();
+    //! Writes the input file
+    void write(const std::string &filename);
+
+};
+
+} // namespace
@@ -0,0 +1,113 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#include <string>
+#include <vector>
+#include "bench/Generator.hpp"
+#include "bench/GeneratorTest.hpp"
+#include "kernel/XmlInputData.hpp"
+
+using namespace std;
+using namespace ccruncher;
+
+//===========================================================================
+// test1
+// generated input file is valid and has the requested dimensions
+//===========================================================================
+void ccruncher_test::GeneratorTest::test1()
+{
+  Generator generator;
+  generator.numobligors = 50;
+  generator.numassets = 3;
+  generator.numdates = 10;
+  generator.numvalues = 4;
+  generator.numfactors = 3;
+  generator.numratings = 5;
+  generator.numsegmentations = 4;
+  generator.numsegments = 2;
+  generator.eadmix = 0.5;
+  generator.lgdmix = 0.5;
+  generator.numsims = 10000;
+
+  XmlInputData data;
+  ASSERT_NO_THROW(data.readString(generator.getXml()));
+  ASSERT_EQUALS((size_t)3, data.getFactors().size());
+  ASSERT_EQUALS((size_t)6, data.getRatings().size());
+  ASSERT_EQUALS((size_t)4, data.getSegmentations().size());
+  ASSERT_EQUALS((size_t)10000, data.getParams().getMaxIterations());
+
+  const vector<Obligor> &obligors = data.getPortfolio();
+  ASSERT_EQUALS((size_t)50, obligors.size());
+  bool random = false;
+  for(const Obligor &obligor : obligors) {
+    ASSERT_EQUALS((size_t)3, obligor.assets.size());
+    for(const Asset &asset : obligor.assets) {
+      ASSERT_EQUALS((size_t)4, asset.values.size());
+      for(const DateValues &values : asset.values) {
+        if (values.ead.getType() != EAD::Type::Fixed) random = true;
+      }
+    }
+  }
+  ASSERT(random);
+}
+
+//===========================================================================
+// test2
+// content depends only on parameters and seed
+//===========================================================================
+void ccruncher_test::GeneratorTest::test2()
+{
+  Generator generator1;
+  generator1.numobligors = 20;
+  generator1.eadmix = 0.3;
+  Generator generator2 = generator1;
+
+  string xml = generator1.getXml();
+  ASSERT(xml == generator1.getXml());
+  ASSERT(xml == generator2.getXml());
+  generator2.seed = 2;
+  ASSERT(xml != generator2.getXml());
+}
+
+//===========================================================================
+// test3
+// invalid parameters
+//===========================================================================
+void ccruncher_test::GeneratorTest::test3()
+{
+  Generator generator;
+  ASSERT_NO_THROW(generator.validate());
+
+  generator.numvalues = generator.numdates + 1;
+  ASSERT_THROW(generator.validate());
+  generator.numvalues = generator.numdates;
+  ASSERT_NO_THROW(generator.validate());
+
+  generator.numfactors = 0;
+  ASSERT_THROW(generator.getXml());
+  generator.numfactors = 256;
+  ASSERT_THROW(generator.getXml());
+  generator.numfactors = 4;
+
+  generator.eadmix = 1.5;
+  ASSERT_THROW(generator.validate());
+}
@@ -0,0 +1,287 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#include <cmath>
+#include <cstdlib>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <cassert>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+#include "bench/Scaling.hpp"
+#include "kernel/MonteCarlo.hpp"
+#include "kernel/XmlInputData.hpp"
+#include "kernel/Instrumentation.hpp"
+#include "utils/Utils.hpp"
+#include "utils/Exception.hpp"
+#include "utils/config.h"
+
+using namespace std;
+
+/**************************************************************************//**
+ * @param[in] path Working directory (output files are written here).
+ * @throw Exception Directory not found.
+ */
+ccruncher::Scaling::Scaling(const string &path) : mPath(path)
+{
+  if (!Utils::existDir(path)) {
+    throw Exception("directory '" + path + "' not found");
+  }
+}
+
+/**************************************************************************//**
+ * @param[in] filename Input file name.
+ * @param[in] defines User defined macros.
+ */
+void ccruncher::Scaling::setInputFile(const string &filename, const map<string,string> &defines)
+{
+  mFilename = filename;
+  mDefines = defines;
+  mXml.clear();
+}
+
+/**************************************************************************//**
+ * @param[in] xml Input file content (eg. see Generator).
+ */
+void ccruncher::Scaling::setInputXml(const string &xml)
+{
+  mFilename.clear();
+  mDefines.clear();
+  mXml = xml;
+}
+
+/**************************************************************************//**
+ * @details On Linux writing 5 to /proc/self/clear_refs resets the peak
+ *          resident memory (VmHWM). Elsewhere does nothing.
+ */
+void ccruncher::Scaling::resetPeakMemory()
+{
+#ifdef __linux__
+  ofstream file("/proc/self/clear_refs");
+  if (file.is_open()) {
+    file << "5";
+  }
+#endif
+}
+
+/**************************************************************************//**
+ * @return Peak resident memory in bytes (0 = unknown).
+ */
+size_t ccruncher::Scaling::getPeakMemory()
+{
+#if defined(_WIN32)
+  return 0;
+#elif defined(__linux__)
+  ifstream file("/proc/self/status");
+  string line;
+  while(getline(file, line)) {
+    if (line.compare(0, 6, "VmHWM:") == 0) {
+      return static_cast<size_t>(atol(line.c_str()+6)) * 1024;
+    }
+  }
+  return 0;
+#else
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+  return static_cast<size_t>(usage.ru_maxrss);
+#else
+  return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+/**************************************************************************//**
+ * @details Parses the input file, initializes the simulation and runs it.
+ *          Elapsed time doesn't include the input file parsing nor the
+ *          initialization, but peak memory includes both. The row
+ *          reports the threads actually used (MonteCarlo doesn't use more
+ *          threads than blocks to simulate).
+ * @param[in] numthreads Number of threads.
+ * @return Report row.
+ * @throw Exception Error parsing input file or running simulation.
+ */
+const ccruncher::Scaling::Row& ccruncher::Scaling::run(unsigned int numthreads)
+{
+  if (numthreads == 0 || 255 < numthreads) {
+    throw Exception("number of threads out of range [1,255]");
+  }
+
+  resetPeakMemory();
+
+  XmlInputData data;
+  if (mFilename.empty()) {
+    data.readString(mXml);
+  }
+  else {
+    data.readFile(mFilename, mDefines);
+  }
+
+  MonteCarlo montecarlo;
+  montecarlo.init(data, mPath, 'w');
+
+  auto t0 = chrono::steady_clock::now();
+  montecarlo.run(static_cast<unsigned char>(numthreads));
+  double seconds = chrono::duration<double>(chrono::steady_clock::now()-t0).count();
+
+  Row row;
+  row.numthreads = montecarlo.getNumThreads();
+  row.numsims = montecarlo.getNumIterations();
+  row.seconds = seconds;
+  row.publishwait = NAN;
+  row.drainwait = NAN;
+  row.writerwait = NAN;
+  if (Instrumentation::isEnabled()) {
+    const Instrumentation &instrumentation = montecarlo.getInstrumentation();
+    row.publishwait = instrumentation.getSeconds(Instrumentation::Phase::PublishWait);
+    row.drainwait = instrumentation.getSeconds(Instrumentation::Phase::DrainWait);
+    row.writerwait = instrumentation.getSeconds(Instrumentation::Phase::WriterWait);
+  }
+  row.peakrss = getPeakMemory();
+
+  mRows.push_back(row);
+  return mRows.back();
+}
+
+/**************************************************************************//**
+ * @param[in] i Row index.
+ * @return Simulations per second.
+ */
+double ccruncher::Scaling::getRate(size_t i) const
+{
+  assert(i < mRows.size());
+  return static_cast<double>(mRows[i].numsims) / mRows[i].seconds;
+}
+
+/**************************************************************************//**
+ * @details Efficiency of row i is rate(i)/rate(0) · threads(0)/threads(i).
+ *          A perfect scaling has efficiency 1.
+ * @param[in] i Row index.
+ * @return Parallel efficiency.
+ */
+double ccruncher::Scaling::getEfficiency(size_t i) const
+{
+  assert(i < mRows.size());
+  return getRate(i)/getRate(0) * static_cast<double>(mRows[0].numthreads)/static_cast<double>(mRows[i].numthreads);
+}
+
+/**************************************************************************//**
+ * @details Unknown values are displayed as '-'.
+ * @param[in] os Output stream.
+ */
+void ccruncher::Scaling::print(ostream &os) const
+{
+  ios::fmtflags flags = os.flags();
+  os << setw(8) << "threads" << setw(12) << "sims" << setw(10) << "seconds" << setw(12) << "sims/s" <<
+        setw(11) << "efficiency" << setw(10) << "publish" << setw(10) << "drain" << setw(10) << "writer" <<
+        setw(10) << "rss(MB)" << "\n";
+  os << fixed;
+  for(size_t i=0; i<mRows.size(); i++)
+  {
+    const Row &row = mRows[i];
+    os << setw(8) << row.numthreads << setw(12) << row.numsims << setw(10) << setprecision(3) << row.seconds <<
+          setw(12) << setprecision(0) << getRate(i) << setw(11) << setprecision(3) << getEfficiency(i);
+    for(double wait : {row.publishwait, row.drainwait, row.writerwait}) {
+      if (std::isnan(wait)) os << setw(10) << "-";
+      else os << setw(10) << wait;
+    }
+    if (row.peakrss == 0) os << setw(10) << "-";
+    else os << setw(10) << setprecision(1) << static_cast<double>(row.peakrss)/(1024.0*1024.0);
+    os << "\n";
+  }
+  os.flags(flags);
+  os.flush();
+}
+
+/**************************************************************************//**
+ * @details Files with extension '.csv' are written in CSV format (one
+ *          row by run, unknown values are empty). Otherwise the file is
+ *          written in JSON format (unknown values are null).
+ * @param[in] filename File name.
+ * @throw Exception Error writing file.
+ */
+void ccruncher::Scaling::write(const string &filename) const
+{
+  bool csv = (filename.size() >= 4 && Utils::lowercase(filename.substr(filename.size()-4)) == ".csv");
+
+  try
+  {
+    ofstream file;
+    file.exceptions(ios::failbit | ios::badbit);
+    file.open(filename.c_str(), ios::out|ios::trunc);
+    file.precision(9);
+
+    if (csv)
+    {
+      file << "\"threads\", \"simulations\", \"seconds\", \"rate\", \"efficiency\", "
+              "\"publish_wait\", \"drain_wait\", \"writer_wait\", \"peak_rss\"\n";
+      for(size_t i=0; i<mRows.size(); i++) {
+        const Row &row = mRows[i];
+        file << row.numthreads << ", " << row.numsims << ", " << row.seconds << ", " <<
+                getRate(i) << ", " << getEfficiency(i);
+        for(double wait : {row.publishwait, row.drainwait, row.writerwait}) {
+          file << ", ";
+          if (!std::isnan(wait)) file << wait;
+        }
+        file << ", ";
+        if (row.peakrss > 0) file << row.peakrss;
+        file << "\n";
+      }
+    }
+    else
+    {
+      file << "{\n";
+      file << "  \"version\": \"" << Utils::jsonEscape(string(PACKAGE_VERSION) + " (" + GIT_VERSION + ")") << "\",\n";
+      file << "  \"options\": \"" << Utils::jsonEscape(Utils::getCompilationOptions()) << "\",\n";
+      file << "  \"timestamp\": \"" << Utils::jsonEscape(Utils::timestamp()) << "\",\n";
+      file << "  \"cores\": " << Utils::getNumCores() << ",\n";
+      string input = (mFilename.empty() ? "synthetic" : mFilename);
+      file << "  \"input\": \"" << Utils::jsonEscape(input) << "\",\n";
+      file << "  \"runs\": [";
+      for(size_t i=0; i<mRows.size(); i++) {
+        const Row &row = mRows[i];
+        file << (i>0?",":"") << "\n    {\"threads\": " << row.numthreads << ", \"simulations\": " << row.numsims <<
+                ", \"seconds\": " << row.seconds << ", \"rate\": " << getRate(i) <<
+                ", \"efficiency\": " << getEfficiency(i);
+        const char *names[] = {"publish_wait", "drain_wait", "writer_wait"};
+        const double waits[] = {row.publishwait, row.drainwait, row.writerwait};
+        for(size_t j=0; j<3; j++) {
+          file << ", \"" << names[j] << "\": ";
+          if (std::isnan(waits[j])) file << "null";
+          else file << waits[j];
+        }
+        file << ", \"peak_rss\": ";
+        if (row.peakrss == 0) file << "null";
+        else file << row.peakrss;
+        file << "}";
+      }
+      file << "\n  ]\n";
+      file << "}\n";
+    }
+    file.close();
+  }
+  catch(std::exception &e) {
+    throw Exception(e, "error writing file '" + filename + "'");
+  }
+}
@@ -0,0 +1,117 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include <ostream>
+
+namespace ccruncher {
+
+/**************************************************************************//**
+ * @brief Threads scaling report of the Monte Carlo simulation.
+ *
+ * @details Runs the simulation of the same model with distinct number
+ *          of threads and reports, for each run, the simulations per
+ *          second, the parallel efficiency (relative to the first run),
+ *          the synchronization waits and the peak resident memory.
+ *          Simulated blocks are passed through lock-free ring buffers,
+ *          so the lock waits are reported as the time spent by simulation threads waiting a free block
+ *          (publish), by the main thread waiting the next block
+ *          (drain), and by the main thread waiting the writer thread
+ *          (writer). Waits are only available if compiled with
+ *          instrumentation (see Instrumentation). Peak memory is reset
+ *          before each run where the operating system allows it (Linux),
+ *          otherwise it is the process peak up to the run.
+ *
+ * @see Benchmark
+ */
+class Scaling
+{
+
+  public:
+
+    //! Scaling report row
+    struct Row
+    {
+      //! Number of threads
+      unsigned int numthreads;
+      //! Number of simulations done
+      size_t numsims;
+      //! Elapsed time (in seconds)
+      double seconds;
+      //! Simulation threads waiting a free block (in seconds)
+      double publishwait;
+      //! Main thread waiting the next block (in seconds)
+      double drainwait;
+      //! Main thread waiting the writer thread (in seconds)
+      double writerwait;
+      //! Peak resident memory (in bytes, 0 = unknown)
+      size_t peakrss;
+    };
+
+  private:
+
+    //! Input file name (empty = xml content)
+    std::string mFilename;
+    //! Input file content
+    std::string mXml;
+    //! User defined macros
+    std::map<std::string,std::string> mDefines;
+    //! Working directory
+    std::string mPath;
+    //! Report rows
+    std::vector<Row> mRows;
+
+  private:
+
+    //! Resets the peak resident memory
+    static void resetPeakMemory();
+    //! Returns the peak resident memory
+    static size_t getPeakMemory();
+
+  public:
+
+    //! Constructor
+    Scaling(const std::string &path);
+    //! Set the input file
+    void setInputFile(const std::string &filename, const std::map<std::string,std::string> &defines);
+    //! Set the input file content
+    void setInputXml(const std::string &xml);
+    //! Runs the simulation with the given number of threads
+    const Row& run(unsigned int numthreads);
+    //! Returns the report rows
+    const std::vector<Row>& getRows() const { return mRows; }
+    //! Simulations per second of a row
+    double getRate(size_t i) const;
+    //! Parallel efficiency of a row
+    double getEfficiency(size_t i) const;
+    //! Prints the report
+    void print(std::ostream &os) const;
+    //! Writes the report (CSV or JSON, by file extension)
+    void write(const std::string &filename) const;
+
+};
+
+} // namespace
@@ -0,0 +1,91 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#include <string>
+#include <fstream>
+#include "bench/Generator.hpp"
+#include "bench/Scaling.hpp"
+#include "bench/ScalingTest.hpp"
+#include "utils/Utils.hpp"
+
+#define FILENAME "scaling.csv"
+
+using namespace std;
+using namespace ccruncher;
+
+//===========================================================================
+// setUp
+//===========================================================================
+void ccruncher_test::ScalingTest::setUp()
+{
+  workdir = Utils::makeTempDir("ccruncher-scalingtest.");
+}
+
+//===========================================================================
+// tearDown
+//===========================================================================
+void ccruncher_test::ScalingTest::tearDown()
+{
+  Utils::removeDir(workdir);
+}
+
+//===========================================================================
+// test1
+// runs a synthetic portfolio with 1 and 2 threads
+//===========================================================================
+void ccruncher_test::ScalingTest::test1()
+{
+  Generator generator;
+  generator.numobligors = 20;
+  generator.numsims = 1000;
+
+  Scaling scaling(workdir);
+  scaling.setInputXml(generator.getXml());
+  ASSERT_NO_THROW(scaling.run(1));
+  ASSERT_NO_THROW(scaling.run(2));
+  ASSERT_THROW(scaling.run(0));
+
+  ASSERT_EQUALS((size_t)2, scaling.getRows().size());
+  for(size_t i=0; i<2; i++) {
+    const Scaling::Row &row = scaling.getRows()[i];
+    ASSERT_EQUALS(i+1, (size_t)row.numthreads);
+    ASSERT_EQUALS((size_t)1000, row.numsims);
+    ASSERT(row.seconds > 0.0);
+  }
+  ASSERT_EQUALS_EPSILON(1.0, scaling.getEfficiency(0), 1e-12);
+
+  // threads are limited by the number of blocks (1000 simulations = 8 blocks of 128)
+  Scaling scaling2(workdir);
+  scaling2.setInputXml(generator.getXml());
+  ASSERT_NO_THROW(scaling2.run(255));
+  ASSERT_EQUALS(8U, scaling2.getRows()[0].numthreads);
+  ASSERT_EQUALS_EPSILON(scaling.getRate(1)/scaling.getRate(0)/2.0, scaling.getEfficiency(1), 1e-12);
+
+  string filename = workdir + Utils::pathSeparator + FILENAME;
+  ASSERT_NO_THROW(scaling.write(filename));
+  ifstream file(filename);
+  string line;
+  size_t numlines = 0;
+  while(getline(file, line)) numlines++;
+  ASSERT_EQUALS((size_t)3, numlines);
+  file.close();
+}
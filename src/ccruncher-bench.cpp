@@ -0,0 +1,412 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <exception>
+#include <getopt.h>
+#include "bench/Benchmark.hpp"
+#include "bench/Generator.hpp"
+#include "utils/Parser.hpp"
+#include "utils/Utils.hpp"
+#include "utils/Exception.hpp"
+#include "utils/config.h"
+
+using namespace std;
+using namespace ccruncher;
+
+// functions declaration
+void help();
+void version();
+bool parseSize(const char *str, size_t &val);
+
+/**************************************************************************//**
+ * @details Catch uncaught exceptions thrown by program.
+ */
+[[noreturn]]
+void exception_handler()
+{
+  cerr << endl <<
+      "unexpected error. please report this bug sending input files, \n"
+      "ccruncher version and arguments to gtorrent@ccruncher.net\n" << endl;
+  exit(EXIT_FAILURE);
+}
+
+/**************************************************************************//**
+ * @brief ccruncher-bench main procedure.
+ */
+int main(int argc, char *argv[])
+{
+  // short options
+  const char* const options1 = "ho:" ;
+
+  // long options (name + has_arg + flag + val)
+  const struct option options2[] = {
+      { "help",          0,  nullptr,  'h' },
+      { "output",        1,  nullptr,  'o' },
+      { "version",       0,  nullptr,  301 },
+      { "obligors",      1,  nullptr,  302 },
+      { "assets",        1,  nullptr,  303 },
+      { "dates",         1,  nullptr,  304 },
+      { "values",        1,  nullptr,  305 },
+      { "factors",       1,  nullptr,  306 },
+      { "ratings",       1,  nullptr,  307 },
+      { "segmentations", 1,  nullptr,  308 },
+      { "segments",      1,  nullptr,  309 },
+      { "ead-mix",       1,  nullptr,  310 },
+      { "lgd-mix",       1,  nullptr,  311 },
+      { "years",         1,  nullptr,  312 },
+      { "numsims",       1,  nullptr,  313 },
+      { "seed",          1,  nullptr,  314 },
+      { "threads",       1,  nullptr,  315 },
+      { "time",          1,  nullptr,  316 },
+      { "suite",         1,  nullptr,  317 },
+      { "workdir",       1,  nullptr,  318 },
+      { "generate",      1,  nullptr,  319 },
+      { nullptr,         0,  nullptr,   0  }
+  };
+
+  Generator generator;
+  string sfilename = "";
+  string sworkdir = "";
+  string sgenerate = "";
+  string ssuite = "all";
+  double dtime = 0.5;
+  vector<unsigned int> threads;
+  size_t *sizes[] = {
+      &generator.numobligors, &generator.numassets, &generator.numdates,
+      &generator.numvalues, &generator.numfactors, &generator.numratings,
+      &generator.numsegmentations, &generator.numsegments
+  };
+
+  // uncaught exceptions manager
+  set_terminate(exception_handler);
+
+  // parsing options
+  while (1)
+  {
+    int curropt = getopt_long(argc, argv, options1, options2, nullptr);
+
+    if (curropt == -1) {
+      // no more options. exit while
+      break;
+    }
+
+    switch(curropt)
+    {
+      case '?': // invalid option
+          cerr << "error parsing arguments" << endl;
+          cerr << "use --help option for more information" << endl;
+          return EXIT_FAILURE;
+
+      case 'h': // -h or --help (show help and exit)
+          help();
+          return EXIT_SUCCESS;
+
+      case 'o': // -o file, --output=file (set results file)
+          sfilename = string(optarg);
+          break;
+
+      case 301: // --version (show version and exit)
+          version();
+          return EXIT_SUCCESS;
+
+      case 302: // --obligors=num
+      case 303: // --assets=num
+      case 304: // --dates=num
+      case 305: // --values=num
+      case 306: // --factors=num
+      case 307: // --ratings=num
+      case 308: // --segmentations=num
+      case 309: // --segments=num
+          if (!parseSize(optarg, *sizes[curropt-302])) {
+            cerr << "error: invalid " << options2[curropt-299].name << " value" << endl;
+            return EXIT_FAILURE;
+          }
+          break;
+
+      case 310: // --ead-mix=frac (fraction of random EADs)
+      case 311: // --lgd-mix=frac (fraction of random LGDs)
+          try {
+            double val = Parser::doubleValue(string(optarg));
+            if (val < 0.0 || 1.0 < val) {
+              throw Exception();
+            }
+            (curropt==310 ? generator.eadmix : generator.lgdmix) = val;
+          }
+          catch(Exception &) {
+            cerr << "error: invalid " << options2[curropt-299].name << " value" << endl;
+            return EXIT_FAILURE;
+          }
+          break;
+
+      case 312: // --years=num (simulation horizon)
+          try {
+            generator.years = Parser::intValue(string(optarg));
+            if (generator.years <= 0) {
+              throw Exception();
+            }
+          }
+          catch(Exception &) {
+            cerr << "error: invalid years value" << endl;
+            return EXIT_FAILURE;
+          }
+          break;
+
+      case 313: // --numsims=num (number of simulations)
+          if (!parseSize(optarg, generator.numsims)) {
+            cerr << "error: invalid numsims value" << endl;
+            return EXIT_FAILURE;
+          }
+          break;
+
+      case 314: // --seed=num (generator and simulation seed)
+          try {
+            generator.seed = Parser::ulongValue(string(optarg));
+          }
+          catch(Exception &) {
+            cerr << "error: invalid seed value" << endl;
+            return EXIT_FAILURE;
+          }
+          break;
+
+      case 315: // --threads=list (comma separated number of threads)
+          try {
+            vector<string> tokens;
+            Utils::tokenize(string(optarg), tokens, ",", true);
+            threads.clear();
+            for(const string &token : tokens) {
+              int num = Parser::intValue(token);
+              if (num <= 0 || 255 < num) {
+                throw Exception();
+              }
+              threads.push_back(static_cast<unsigned int>(num));
+            }
+            if (threads.empty()) {
+              throw Exception();
+            }
+          }
+          catch(Exception &) {
+            cerr << "error: invalid threads value" << endl;
+            return EXIT_FAILURE;
+          }
+          break;
+
+      case 316: // --time=secs (minimum time by micro-benchmark)
+          try {
+            dtime = Parser::doubleValue(string(optarg));
+            if (dtime <= 0.0) {
+              throw Exception();
+            }
+          }
+          catch(Exception &) {
+            cerr << "error: invalid time value" << endl;
+            return EXIT_FAILURE;
+          }
+          break;
+
+      case 317: // --suite=name (benchmarks to run)
+          ssuite = string(optarg);
+          if (ssuite != "all" && ssuite != "micro" && ssuite != "macro") {
+            cerr << "error: invalid suite value" << endl;
+            return EXIT_FAILURE;
+          }
+          break;
+
+      case 318: // --workdir=dir (directory for temporary files)
+          sworkdir = string(optarg);
+          if (!Utils::existDir(sworkdir)) {
+            cerr << "error: directory '" << sworkdir << "' does not exist" << endl;
+            return EXIT_FAILURE;
+          }
+          break;
+
+      case 319: // --generate=file (write input file and exit)
+          sgenerate = string(optarg);
+          break;
+
+      default: // unexpected error
+          cerr <<
+            "unexpected error parsing arguments. Please report this bug sending input\n"
+            "files, ccruncher version and arguments to gtorrent@ccruncher.net\n" << endl;
+          return EXIT_FAILURE;
+    }
+  }
+
+  if (argc != optind) {
+    cerr << "error: unexpected arguments" << endl;
+    cerr << "use --help option for more information" << endl;
+    return EXIT_FAILURE;
+  }
+
+  // default threads list (1, 2, 4, ..., numcores)
+  if (threads.empty()) {
+    unsigned int numcores = static_cast<unsigned int>(Utils::getNumCores());
+    for(unsigned int num=1; num<numcores; num*=2) {
+      threads.push_back(num);
+    }
+    threads.push_back(min(numcores, 255U));
+  }
+
+  string swork = sworkdir;
+
+  try
+  {
+    generator.validate();
+
+    if (!sgenerate.empty()) {
+      generator.write(sgenerate);
+      return EXIT_SUCCESS;
+    }
+
+    if (swork.empty()) {
+      swork = Utils::makeTempDir("ccruncher-bench.");
+    }
+
+    Benchmark benchmark(generator, swork, dtime);
+    if (ssuite != "macro") {
+      benchmark.runMicro();
+    }
+    if (ssuite != "micro") {
+      for(unsigned int num : threads) {
+        benchmark.runSimulation(num);
+      }
+    }
+
+    benchmark.print(cout);
+    if (!sfilename.empty()) {
+      benchmark.write(sfilename);
+    }
+
+    if (sworkdir.empty()) {
+      Utils::removeDir(swork);
+    }
+    return EXIT_SUCCESS;
+  }
+  catch(std::exception &e) {
+    cerr << e.what() << endl;
+    if (sworkdir.empty() && !swork.empty()) {
+      Utils::removeDir(swork);
+    }
+    return EXIT_FAILURE;
+  }
+  catch(...) {
+    exception_handler();
+    return EXIT_FAILURE;
+  }
+}
+
+/**************************************************************************//**
+ * @param[in] str String to parse.
+ * @param[out] val Parsed value (positive integer).
+ * @return true = valid value, false = otherwise.
+ */
+bool parseSize(const char *str, size_t &val)
+{
+  try {
+    unsigned long num = Parser::ulongValue(string(str));
+    if (num == 0) return false;
+    val = static_cast<size_t>(num);
+    return true;
+  }
+  catch(Exception &) {
+    return false;
+  }
+}
+
+/**************************************************************************//**
+ * @brief Displays program help.
+ * @details Follows POSIX guidelines. You can create man pages using help2man.
+ * @see http://www.gnu.org/prep/standards/standards.html#Command_002dLine-Interfaces
+ * @see http://www.gnu.org/software/help2man/
+ */
+void help()
+{
+  cout <<
+  "Usage: ccruncher-bench [OPTION]...\n"
+  "\n"
+  "Benchmark the ccruncher simulation using a synthetic portfolio. Micro\n"
+  "benchmarks measure the hot functions (inverse evaluation, EAD and LGD\n"
+  "sampling, obligor loss, losses aggregation, CSV reading and input file\n"
+  "parsing). Macro benchmarks measure the simulations per second of the\n"
+  "whole Monte Carlo for each number of threads. Results can be written in\n"
+  "JSON format to track performance regressions between releases.\n"
+  "More info at http://www.ccruncher.net.\n"
+  "\n"
+  "Mandatory arguments to long options are mandatory for short options too.\n"
+  "\n"
+  "  -o, --output=FILE       write results to FILE (JSON)\n"
+  "      --suite=NAME        benchmarks to run: all, micro, macro (default=all)\n"
+  "      --threads=LIST      comma separated number of threads of the macro\n"
+  "                          benchmarks (default=1,2,4,...,number of cores)\n"
+  "      --time=SECS         minimum time by micro benchmark (default=0.5)\n"
+  "      --workdir=DIR       directory for temporary files (default=new\n"
+  "                          directory in TMPDIR, removed at exit)\n"
+  "      --generate=FILE     write the synthetic input file and exit\n"
+  "      --obligors=NUM      number of obligors (default=1000)\n"
+  "      --assets=NUM        number of assets by obligor (default=2)\n"
+  "      --dates=NUM         number of distinct dates (default=24)\n"
+  "      --values=NUM        number of date-values by asset (default=12)\n"
+  "      --factors=NUM       number of factors (default=4)\n"
+  "      --ratings=NUM       number of non-default ratings (default=7)\n"
+  "      --segmentations=NUM number of segmentations (default=3)\n"
+  "      --segments=NUM      number of segments by segmentation (default=10)\n"
+  "      --ead-mix=FRAC      fraction of random EADs (default=0)\n"
+  "      --lgd-mix=FRAC      fraction of random LGDs (default=0)\n"
+  "      --years=NUM         simulation horizon in years (default=2)\n"
+  "      --numsims=NUM       number of simulations (default=100000)\n"
+  "      --seed=NUM          portfolio and simulation seed (default=1)\n"
+  "  -h, --help              show this message and exit\n"
+  "      --version           show version and exit\n"
+  "\n"
+  "Exit status:\n"
+  "  0   finished without errors\n"
+  "  1   finished with errors\n"
+  "\n"
+  "Examples:\n"
+  "  all benchmarks      ccruncher-bench -o bench.json\n"
+  "  large portfolio     ccruncher-bench --suite=macro --obligors=100000 --ead-mix=0.5\n"
+  "  input file          ccruncher-bench --obligors=5000 --generate=synthetic.xml\n"
+  "\n"
+  "Report bugs to gtorrent@ccruncher.net.\n"
+  << endl;
+}
+
+/**************************************************************************//**
+ * @brief Displays program version.
+ * @details Follows POSIX guidelines. You can create man pages using help2man.
+ * @see http://www.gnu.org/prep/standards/standards.html#Command_002dLine-Interfaces
+ * @see http://www.gnu.org/software/help2man/
+ */
+void version()
+{
+  cout <<
+  "ccruncher-bench " << PACKAGE_VERSION << " (" << GIT_VERSION << ")\n"
+  "Copyright (c) 2025 Gerard Torrent.\n"
+  "License GPLv2: GNU GPL version 2 <http://gnu.org/licenses/gpl-2.0.html>.\n"
+  "This program is distributed in the hope that it will be useful, but WITHOUT ANY\n"
+  "WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A\n"
+  "PARTICULAR PURPOSE. See the GNU General Public License for more details."
+  << endl;
+}
@@ -39,6 +39,7 @@
 #include <expat.h>
 #include <zlib.h>
 #include "kernel/MonteCarlo.hpp"
+#include "kernel/SemiAnalytic.hpp"
 #include "kernel/XmlInputData.hpp"
 #include "utils/Utils.hpp"
 #include "utils/Logger.hpp"
@@ -60,9 +61,18 @@ void run();
 string sfilename = "";
 string spath = "";
 char cmode = 'c';
+Aggregator::Format cformat = Aggregator::Format::Csv;
+string sengine = "montecarlo";
 int inice = -999;
 size_t ihash = 1000;
 unsigned char ithreads = 0;
+size_t ibuffer = 64;
+bool bbuffer = false;
+size_t icheckpoint = 0;
+size_t ishard = 0;
+size_t nshards = 1;
+bool bstats = false;
+string sstats = "";
 map<string,string> defines;
 bool stop = false;
 
@@ -124,6 +134,13 @@ int main(int argc, char *argv[])
       { "hash",         1,  nullptr,  303 },
       { "threads",      1,  nullptr,  304 },
       { "info",         0,  nullptr,  305 },
+      { "buffer",       1,  nullptr,  306 },
+      { "format",       1,  nullptr,  307 },
+      { "engine",       1,  nullptr,  308 },
+      { "checkpoint",   1,  nullptr,  309 },
+      { "resume",       0,  nullptr,  310 },
+      { "shard",        1,  nullptr,  311 },
+      { "stats",        2,  nullptr,  312 },
       { nullptr,        0,  nullptr,   0  }
   };
 
@@ -175,11 +192,12 @@ int main(int argc, char *argv[])
 
       case 'a': // -a --append
       case 'w': // -w --overwrite
+      case 310: // --resume
           if (cmode != 'c') {
             cerr << "error: found more than one output files mode" << endl;
             return EXIT_FAILURE;
           }
-          cmode = curropt;
+          cmode = (curropt == 310 ? 'r' : curropt);
           break;
 
       case 'o': // -o dir, --output=dir (set output files path)
@@ -237,6 +255,82 @@ int main(int argc, char *argv[])
           info();
           return EXIT_SUCCESS;
 
+      case 306: // --buffer=val (set output buffer size in MB)
+          try {
+            string sbuffer = string(optarg);
+            int num = Parser::intValue(sbuffer);
+            if (num <= 0) {
+              throw Exception();
+            }
+            else {
+              ibuffer = (size_t)(num);
+              bbuffer = true;
+            }
+          }
+          catch(Exception &) {
+            cerr << "error: invalid buffer value" << endl;
+            return EXIT_FAILURE;
+          }
+          break;
+
+      case 307: // --format=val (set output file format)
+          try {
+            cformat = Aggregator::getFormat(string(optarg));
+          }
+          catch(Exception &) {
+            cerr << "error: invalid format value" << endl;
+            return EXIT_FAILURE;
+          }
+          break;
+
+      case 308: // --engine=val (set loss distribution engine)
+          sengine = string(optarg);
+          if (sengine != "montecarlo" && sengine != "analytic") {
+            cerr << "error: invalid engine value" << endl;
+            return EXIT_FAILURE;
+          }
+          break;
+
+      case 309: // --checkpoint=val (set seconds between checkpoints)
+          try {
+            string scheckpoint = string(optarg);
+            int num = Parser::intValue(scheckpoint);
+            if (num <= 0) {
+              throw Exception();
+            }
+            else {
+              icheckpoint = (size_t)(num);
+            }
+          }
+          catch(Exception &) {
+            cerr << "error: invalid checkpoint value" << endl;
+            return EXIT_FAILURE;
+          }
+          break;
+
+      case 311: // --shard=i/n (simulate the i-th shard of n)
+          {
+            size_t i = 0, n = 0;
+            int len = 0;
+            if (sscanf(optarg, "%zu/%zu%n", &i, &n, &len) != 2 || optarg[len] != '\0' ||
+                i == 0 || n == 0 || i > n) {
+              cerr << "error: invalid shard value" << endl;
+              return EXIT_FAILURE;
+            }
+            ishard = i-1;
+            nshards = n;
+          }
+          break;
+
+      case 312: // --stats[=file] (print or write simulation timers)
+          if (!Instrumentation::isEnabled()) {
+            cerr << "error: stats not available (build configured without --enable-instrumentation)" << endl;
+            return EXIT_FAILURE;
+          }
+          bstats = true;
+          sstats = (optarg != nullptr ? string(optarg) : "");
+          break;
+
       default: // unexpected error
           cerr << 
             "unexpected error parsing arguments. Please report this bug sending input\n"
@@ -245,6 +339,31 @@ int main(int argc, char *argv[])
     }
   }
 
+  if (cmode == 'r' && sengine != "montecarlo") {
+    cerr << "error: resume is only supported by the montecarlo engine" << endl;
+    return EXIT_FAILURE;
+  }
+
+  if (nshards > 1 && sengine != "montecarlo") {
+    cerr << "error: shards are only supported by the montecarlo engine" << endl;
+    return EXIT_FAILURE;
+  }
+
+  if (icheckpoint > 0 && sengine != "montecarlo") {
+    cerr << "error: checkpoints are only supported by the montecarlo engine" << endl;
+    return EXIT_FAILURE;
+  }
+
+  if (bbuffer && sengine != "montecarlo") {
+    cerr << "error: buffer is only supported by the montecarlo engine" << endl;
+    return EXIT_FAILURE;
+  }
+
+  if (bstats && sengine != "montecarlo") {
+    cerr << "error: stats are only supported by the montecarlo engine" << endl;
+    return EXIT_FAILURE;
+  }
+
   // retrieving input filename
   if (argc == optind) 
   {
@@ -322,12 +441,34 @@ void run()
   }
   if (stop) throw Exception("parser stopped");
 
-  // creating simulation object
-  MonteCarlo montecarlo(cout.rdbuf());
-  montecarlo.init(idata, spath, cmode);
+  if (sengine == "analytic")
+  {
+    // computing semi-analytic distributions
+    SemiAnalytic analytic(cout.rdbuf());
+    analytic.init(idata, spath, cmode, cformat);
+    analytic.run(ithreads, ihash, &stop);
+  }
+  else
+  {
+    // creating simulation object
+    MonteCarlo montecarlo(cout.rdbuf());
+    montecarlo.setShard(ishard, nshards);
+    montecarlo.init(idata, spath, cmode, cformat);
 
-  // running simulation
-  montecarlo.run(ithreads, ihash, &stop);
+    // running simulation
+    montecarlo.setBufferSize(ibuffer*1024*1024);
+    montecarlo.setCheckpoint(icheckpoint);
+    montecarlo.run(ithreads, ihash, &stop);
+
+    // simulation timers
+    if (bstats && sstats.empty()) {
+      montecarlo.getInstrumentation().print(log);
+      log << endl;
+    }
+    else if (bstats) {
+      montecarlo.getInstrumentation().write(sstats);
+    }
+  }
 
   // footer
   auto t2 = steady_clock::now();
@@ -384,11 +525,19 @@ void help()
   "  -a, --append            output data is appended to existing files\n"
   "  -w, --overwrite         existing output files are overwritten\n"
   "  -o, --output=DIRECTORY  place output files in DIRECTORY (default=current dir)\n"
+  "      --format=FORMAT     output files format: csv, float64, float32 (default=csv)\n"
+  "      --engine=ENGINE     loss engine: montecarlo, analytic (default=montecarlo)\n"
 #if !defined(_WIN32)
   "      --nice=NICEVAL      set process priority to NICEVAL (see nice command)\n"
 #endif
   "      --threads=NTHREADS  number of threads to use (default=number of cores)\n"
   "      --hash=HASHNUM      print '.' for each HASHNUM simulations (default=" + to_string(ihash) + ")\n"
+  "      --buffer=SIZE       memory (in MB) used to buffer output data (default=" + to_string(ibuffer) + ")\n"
+  "      --checkpoint=SECS   save simulation state every SECS seconds\n"
+  "      --resume            continue the simulation saved in the output directory\n"
+  "      --shard=I/N         simulate the I-th of N parts of the run (see ccruncher-merge)\n"
+  "      --stats[=FILE]      print simulation timers, or write them to FILE (JSON)\n"
+  "                          (requires a build with --enable-instrumentation)\n"
   "      --info              show build parameters and exit\n"
   "  -h, --help              show this message and exit\n"
   "      --version           show version and exit\n"
@@ -401,6 +550,8 @@ void help()
   "  basic example      ccruncher-cmd -o data/ samples/test04.xml\n"
   "  forcing overwrite  ccruncher-cmd -w -o data/ samples/test100.xml\n"
   "  redefining values  ccruncher-cmd -w -o data/ -D ndf=8 samples/sample.xml\n"
+  "  resuming a run     ccruncher-cmd --resume --checkpoint=600 -o data/ samples/test100.xml\n"
+  "  sharding a run     ccruncher-cmd --shard=2/4 -o data2/ samples/test100.xml\n"
   "\n"
   "Report bugs to gtorrent@ccruncher.net. Please include the output of\n"
   "'ccruncher-cmd --info' in the body of your report and attach the input\n"
@@ -0,0 +1,199 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <exception>
+#include <getopt.h>
+#include "kernel/ShardMerger.hpp"
+#include "utils/Exception.hpp"
+#include "utils/config.h"
+
+using namespace std;
+using namespace ccruncher;
+
+// functions declaration
+void help();
+void version();
+
+/**************************************************************************//**
+ * @details Catch uncaught exceptions thrown by program.
+ */
+[[noreturn]]
+void exception_handler()
+{
+  cerr << endl <<
+      "unexpected error. please report this bug sending input files, \n"
+      "ccruncher version and arguments to gtorrent@ccruncher.net\n" << endl;
+  exit(EXIT_FAILURE);
+}
+
+/**************************************************************************//**
+ * @brief ccruncher-merge main procedure.
+ */
+int main(int argc, char *argv[])
+{
+  // short options
+  const char* const options1 = "hwo:" ;
+
+  // long options (name + has_arg + flag + val)
+  const struct option options2[] = {
+      { "help",         0,  nullptr,  'h' },
+      { "overwrite",    0,  nullptr,  'w' },
+      { "output",       1,  nullptr,  'o' },
+      { "version",      0,  nullptr,  301 },
+      { nullptr,        0,  nullptr,   0  }
+  };
+
+  string sfilename = "";
+  char cmode = 'c';
+
+  // uncaught exceptions manager
+  set_terminate(exception_handler);
+
+  // parsing options
+  while (1)
+  {
+    int curropt = getopt_long(argc, argv, options1, options2, nullptr);
+
+    if (curropt == -1) {
+      // no more options. exit while
+      break;
+    }
+
+    switch(curropt)
+    {
+      case '?': // invalid option
+          cerr << "error parsing arguments" << endl;
+          cerr << "use --help option for more information" << endl;
+          return EXIT_FAILURE;
+
+      case 'h': // -h or --help (show help and exit)
+          help();
+          return EXIT_SUCCESS;
+
+      case 'w': // -w --overwrite
+          cmode = 'w';
+          break;
+
+      case 'o': // -o file, --output=file (set merged file)
+          sfilename = string(optarg);
+          break;
+
+      case 301: // --version (show version and exit)
+          version();
+          return EXIT_SUCCESS;
+
+      default: // unexpected error
+          cerr <<
+            "unexpected error parsing arguments. Please report this bug sending input\n"
+            "files, ccruncher version and arguments to gtorrent@ccruncher.net\n" << endl;
+          return EXIT_FAILURE;
+    }
+  }
+
+  if (sfilename.empty()) {
+    cerr << "error: output file not set" << endl;
+    cerr << "use --help option for more information" << endl;
+    return EXIT_FAILURE;
+  }
+
+  // retrieving shard files
+  if (argc == optind) {
+    cerr << "error: there are no input files" << endl;
+    cerr << "use --help option for more information" << endl;
+    return EXIT_FAILURE;
+  }
+  vector<string> filenames(argv+optind, argv+argc);
+
+  try
+  {
+    ShardMerger merger(filenames);
+    merger.write(sfilename, cmode);
+    cout << "merged " << merger.getNumShards() << " shards (seed " << merger.getSeed() << ", "
+         << merger.getNumRows() << " simulations) into '" << sfilename << "'" << endl;
+    return EXIT_SUCCESS;
+  }
+  catch(std::exception &e) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+  catch(...) {
+    exception_handler();
+    return EXIT_FAILURE;
+  }
+}
+
+/**************************************************************************//**
+ * @brief Displays program help.
+ * @details Follows POSIX guidelines. You can create man pages using help2man.
+ * @see http://www.gnu.org/prep/standards/standards.html#Command_002dLine-Interfaces
+ * @see http://www.gnu.org/software/help2man/
+ */
+void help()
+{
+  cout <<
+  "Usage: ccruncher-merge [OPTION]... -o OUTFILE FILE...\n"
+  "\n"
+  "Merge the segmentation files (CSV or binary) created by the shards of a\n"
+  "ccruncher-cmd run (see --shard option). Files must have the same segments,\n"
+  "exposures and seed, and all the shards must be present and complete. The\n"
+  "merged file is identical to the one created by a single process run.\n"
+  "More info at http://www.ccruncher.net.\n"
+  "\n"
+  "Mandatory arguments to long options are mandatory for short options too.\n"
+  "\n"
+  "  -o, --output=OUTFILE    merged file name\n"
+  "  -w, --overwrite         existing merged file is overwritten\n"
+  "  -h, --help              show this message and exit\n"
+  "      --version           show version and exit\n"
+  "\n"
+  "Exit status:\n"
+  "  0   finished without errors\n"
+  "  1   finished with errors\n"
+  "\n"
+  "Examples:\n"
+  "  merging 2 shards   ccruncher-merge -o data/portfolio.csv data1/portfolio.csv data2/portfolio.csv\n"
+  "\n"
+  "Report bugs to gtorrent@ccruncher.net.\n"
+  << endl;
+}
+
+/**************************************************************************//**
+ * @brief Displays program version.
+ * @details Follows POSIX guidelines. You can create man pages using help2man.
+ * @see http://www.gnu.org/prep/standards/standards.html#Command_002dLine-Interfaces
+ * @see http://www.gnu.org/software/help2man/
+ */
+void version()
+{
+  cout <<
+  "ccruncher-merge " << PACKAGE_VERSION << " (" << GIT_VERSION << ")\n"
+  "Copyright (c) 2025 Gerard Torrent.\n"
+  "License GPLv2: GNU GPL version 2 <http://gnu.org/licenses/gpl-2.0.html>.\n"
+  "This program is distributed in the hope that it will be useful, but WITHOUT ANY\n"
+  "WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A\n"
+  "PARTICULAR PURPOSE. See the GNU General Public License for more details."
+  << endl;
+}
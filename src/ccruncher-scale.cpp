@@ -0,0 +1,321 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#include <map>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <exception>
+#include <getopt.h>
+#include "bench/Generator.hpp"
+#include "bench/Scaling.hpp"
+#include "utils/Parser.hpp"
+#include "utils/Utils.hpp"
+#include "utils/Exception.hpp"
+#include "utils/config.h"
+
+using namespace std;
+using namespace ccruncher;
+
+// functions declaration
+void help();
+void version();
+
+/**************************************************************************//**
+ * @details Catch uncaught exceptions thrown by program.
+ */
+[[noreturn]]
+void exception_handler()
+{
+  cerr << endl <<
+      "unexpected error. please report this bug sending input files, \n"
+      "ccruncher version and arguments to gtorrent@ccruncher.net\n" << endl;
+  exit(EXIT_FAILURE);
+}
+
+/**************************************************************************//**
+ * @brief ccruncher-scale main procedure.
+ */
+int main(int argc, char *argv[])
+{
+  // short options
+  const char* const options1 = "hD:o:" ;
+
+  // long options (name + has_arg + flag + val)
+  const struct option options2[] = {
+      { "help",         0,  nullptr,  'h' },
+      { "define",       1,  nullptr,  'D' },
+      { "output",       1,  nullptr,  'o' },
+      { "version",      0,  nullptr,  301 },
+      { "threads",      1,  nullptr,  302 },
+      { "workdir",      1,  nullptr,  303 },
+      { "obligors",     1,  nullptr,  304 },
+      { "numsims",      1,  nullptr,  305 },
+      { nullptr,        0,  nullptr,   0  }
+  };
+
+  Generator generator;
+  map<string,string> defines;
+  string sfilename = "";
+  string sworkdir = "";
+  vector<unsigned int> threads;
+
+  // uncaught exceptions manager
+  set_terminate(exception_handler);
+
+  // parsing options
+  while (1)
+  {
+    int curropt = getopt_long(argc, argv, options1, options2, nullptr);
+
+    if (curropt == -1) {
+      // no more options. exit while
+      break;
+    }
+
+    switch(curropt)
+    {
+      case '?': // invalid option
+          cerr << "error parsing arguments" << endl;
+          cerr << "use --help option for more information" << endl;
+          return EXIT_FAILURE;
+
+      case 'h': // -h or --help (show help and exit)
+          help();
+          return EXIT_SUCCESS;
+
+      case 'D': // -D key=val (define)
+          {
+            string str(optarg);
+            size_t pos = str.find('=');
+            if (pos == string::npos || pos == 0 || pos == str.length()-1 ) {
+              cerr << "error parsing arguments (define with invalid format)" << endl;
+              cerr << "use --help option for more information" << endl;
+              return EXIT_FAILURE;
+            }
+            string key = Utils::trim(str.substr(0, pos));
+            string value = Utils::trim(str.substr(pos+1));
+            if (key.length() == 0 || value.length() == 0) {
+              cerr << "error parsing arguments (define with invalid format)" << endl;
+              cerr << "use --help option for more information" << endl;
+              return EXIT_FAILURE;
+            }
+            defines[key] = value;
+          }
+          break;
+
+      case 'o': // -o file, --output=file (set report file)
+          sfilename = string(optarg);
+          break;
+
+      case 301: // --version (show version and exit)
+          version();
+          return EXIT_SUCCESS;
+
+      case 302: // --threads=list (comma separated number of threads)
+          try {
+            vector<string> tokens;
+            Utils::tokenize(string(optarg), tokens, ",", true);
+            threads.clear();
+            for(const string &token : tokens) {
+              int num = Parser::intValue(token);
+              if (num <= 0 || 255 < num) {
+                throw Exception();
+              }
+              threads.push_back(static_cast<unsigned int>(num));
+            }
+            if (threads.empty()) {
+              throw Exception();
+            }
+          }
+          catch(Exception &) {
+            cerr << "error: invalid threads value" << endl;
+            return EXIT_FAILURE;
+          }
+          break;
+
+      case 303: // --workdir=dir (directory for temporary files)
+          sworkdir = string(optarg);
+          if (!Utils::existDir(sworkdir)) {
+            cerr << "error: directory '" << sworkdir << "' does not exist" << endl;
+            return EXIT_FAILURE;
+          }
+          break;
+
+      case 304: // --obligors=num (synthetic portfolio size)
+      case 305: // --numsims=num (synthetic portfolio simulations)
+          try {
+            unsigned long num = Parser::ulongValue(string(optarg));
+            if (num == 0) {
+              throw Exception();
+            }
+            (curropt==304 ? generator.numobligors : generator.numsims) = static_cast<size_t>(num);
+          }
+          catch(Exception &) {
+            cerr << "error: invalid " << options2[curropt-298].name << " value" << endl;
+            return EXIT_FAILURE;
+          }
+          break;
+
+      default: // unexpected error
+          cerr <<
+            "unexpected error parsing arguments. Please report this bug sending input\n"
+            "files, ccruncher version and arguments to gtorrent@ccruncher.net\n" << endl;
+          return EXIT_FAILURE;
+    }
+  }
+
+  // retrieving input filename (synthetic portfolio if not given)
+  string sinput = "";
+  if (argc - optind > 1)
+  {
+    cerr << "error: there is more than one input file" << endl;
+    cerr << "use --help option for more information" << endl;
+    return EXIT_FAILURE;
+  }
+  else if (argc - optind == 1)
+  {
+    try {
+      sinput = string(argv[argc-1]);
+      Utils::checkFile(sinput, "r");
+    }
+    catch(Exception &) {
+      cerr << "error: can't open file '" << sinput << "'" << endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // default threads list (1, 2, 4, ..., numcores)
+  if (threads.empty()) {
+    unsigned int numcores = static_cast<unsigned int>(Utils::getNumCores());
+    for(unsigned int num=1; num<numcores; num*=2) {
+      threads.push_back(num);
+    }
+    threads.push_back(min(numcores, 255U));
+  }
+
+  string swork = sworkdir;
+
+  try
+  {
+    if (swork.empty()) {
+      swork = Utils::makeTempDir("ccruncher-scale.");
+    }
+
+    Scaling scaling(swork);
+    if (sinput.empty()) {
+      scaling.setInputXml(generator.getXml());
+    }
+    else {
+      scaling.setInputFile(sinput, defines);
+    }
+
+    for(unsigned int num : threads) {
+      scaling.run(num);
+    }
+
+    scaling.print(cout);
+    if (!sfilename.empty()) {
+      scaling.write(sfilename);
+    }
+
+    if (sworkdir.empty()) {
+      Utils::removeDir(swork);
+    }
+    return EXIT_SUCCESS;
+  }
+  catch(std::exception &e) {
+    cerr << e.what() << endl;
+    if (sworkdir.empty() && !swork.empty()) {
+      Utils::removeDir(swork);
+    }
+    return EXIT_FAILURE;
+  }
+  catch(...) {
+    exception_handler();
+    return EXIT_FAILURE;
+  }
+}
+
+/**************************************************************************//**
+ * @brief Displays program help.
+ * @details Follows POSIX guidelines. You can create man pages using help2man.
+ * @see http://www.gnu.org/prep/standards/standards.html#Command_002dLine-Interfaces
+ * @see http://www.gnu.org/software/help2man/
+ */
+void help()
+{
+  cout <<
+  "Usage: ccruncher-scale [OPTION]... [FILE]\n"
+  "\n"
+  "Run the Monte Carlo simulation of FILE (or a synthetic portfolio if FILE is\n"
+  "not given, see ccruncher-bench) with an increasing number of threads, and\n"
+  "report simulations per second, parallel efficiency, synchronization waits\n"
+  "and peak resident memory of each run. Waits are only available if built\n"
+  "with --enable-instrumentation. Simulation output files are written to a\n"
+  "temporary directory.\n"
+  "More info at http://www.ccruncher.net.\n"
+  "\n"
+  "Mandatory arguments to long options are mandatory for short options too.\n"
+  "\n"
+  "  -o, --output=FILE       write report to FILE (CSV if extension is .csv,\n"
+  "                          JSON otherwise)\n"
+  "  -D, --define=KEY=VAL    replace '$KEY' strings by 'VAL' in input file\n"
+  "      --threads=LIST      comma separated number of threads\n"
+  "                          (default=1,2,4,...,number of cores)\n"
+  "      --workdir=DIR       directory for temporary files (default=new\n"
+  "                          directory in TMPDIR, removed at exit)\n"
+  "      --obligors=NUM      synthetic portfolio obligors (default=1000)\n"
+  "      --numsims=NUM       synthetic portfolio simulations (default=100000)\n"
+  "  -h, --help              show this message and exit\n"
+  "      --version           show version and exit\n"
+  "\n"
+  "Exit status:\n"
+  "  0   finished without errors\n"
+  "  1   finished with errors\n"
+  "\n"
+  "Examples:\n"
+  "  synthetic portfolio  ccruncher-scale --obligors=10000 -o scaling.json\n"
+  "  input file           ccruncher-scale --threads=1,2,4,8 -D numsims=100000 samples/test100.xml\n"
+  "\n"
+  "Report bugs to gtorrent@ccruncher.net.\n"
+  << endl;
+}
+
+/**************************************************************************//**
+ * @brief Displays program version.
+ * @details Follows POSIX guidelines. You can create man pages using help2man.
+ * @see http://www.gnu.org/prep/standards/standards.html#Command_002dLine-Interfaces
+ * @see http://www.gnu.org/software/help2man/
+ */
+void version()
+{
+  cout <<
+  "ccruncher-scale " << PACKAGE_VERSION << " (" << GIT_VERSION << ")\n"
+  "Copyright (c) 2025 Gerard Torrent.\n"
+  "License GPLv2: GNU GPL version 2 <http://gnu.org/licenses/gpl-2.0.html>.\n"
+  "This program is distributed in the hope that it will be useful, but WITHOUT ANY\n"
+  "WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A\n"
+  "PARTICULAR PURPOSE. See the GNU General Public License for more details."
+  << endl;
+}
@@ -23,7 +23,10 @@
 #include <cmath>
 #include <algorithm>
 #include <clocale>
+#include <numeric>
 #include <cassert>
+#include <QFileInfo>
+#include <QDir>
 #include <gsl/gsl_sf_gamma.h>
 #include "gui/AnalysisTask.hpp"
 
@@ -32,6 +35,8 @@ using namespace ccruncher;
 using namespace ccruncher_gui;
 
 #define MJ_EPSILON 1e-12
+// number of batches used to estimate the weighted VaR and ES std_err
+#define NUM_BATCHES 10
 
 /**************************************************************************/
 ccruncher_gui::AnalysisTask::AnalysisTask() : QThread(), hist(nullptr)
@@ -54,12 +59,24 @@ ccruncher_gui::AnalysisTask::~AnalysisTask()
 }
 
 /**************************************************************************//**
+ * @details If the directory contains the importance sampling weights file
+ *          (see MonteCarlo::setSegmentations()), simulations are weighted
+ *          by their likelihood ratio. The weights file is validated by its
+ *          header when read (see readWeights()).
  * @param[in] filename CSV filename.
  * @throw Exception Error opening file.
  */
 void ccruncher_gui::AnalysisTask::setFilename(const QString &filename)
 {
   csv.open(filename.toStdString());
+
+  QFileInfo info(filename);
+  QString suffix = (info.suffix().isEmpty() ? "" : "." + info.suffix());
+  QFileInfo winfo(info.dir(), "weights" + suffix);
+  wfilename.clear();
+  if (winfo.exists() && winfo.absoluteFilePath() != info.absoluteFilePath()) {
+    wfilename = winfo.absoluteFilePath().toStdString();
+  }
 }
 
 /**************************************************************************//**
@@ -197,6 +214,45 @@ void ccruncher_gui::AnalysisTask::readData(std::vector<std::vector<double>> &con
   }
 }
 
+/**************************************************************************//**
+ * @details Reads the importance sampling weights (if any). Files can be
+ *          in writing, so only the rows present in both files are used.
+ * @param[in] numrows Number of data rows.
+ * @return Number of rows to use.
+ * @throw Exception Error reading weights.
+ * @throw StopException Read has been interrupted by user (using stop).
+ */
+size_t ccruncher_gui::AnalysisTask::readWeights(size_t numrows)
+{
+  weights.clear();
+  if (wfilename.empty()) {
+    return numrows;
+  }
+
+  try {
+    CsvFile file(wfilename);
+    const vector<string> &headers = file.getHeaders();
+    if (headers.size() != 1 || headers[0] != "weight") {
+      throw Exception("file '" + wfilename + "' is not an importance sampling weights file");
+    }
+    file.getColumn(0, weights, &stop_);
+    if (stop_) throw StopException();
+  }
+  catch(Exception &e) {
+    if (weights.size() > 100) {
+      // we assume that is caused because ccruncher is
+      // running and file content is not flushed
+      msgerr += (msgerr.empty()?"":"\n") + e.toString();
+    }
+    else {
+      throw;
+    }
+  }
+
+  weights.resize(std::min(weights.size(), numrows));
+  return weights.size();
+}
+
 /**************************************************************************//**
  * @details Execute data analysis.
  */
@@ -216,36 +272,44 @@ void ccruncher_gui::AnalysisTask::run()
       case mode::histogram: {
         vector<double> values;
         readData(isegment, values);
+        values.resize(readWeights(values.size()));
         runHistogram(values);
         break;
       }
       case mode::evolution_el: {
         vector<double> values;
         readData(isegment, values);
+        values.resize(readWeights(values.size()));
         runEvolutionEL(values);
         break;
       }
       case mode::evolution_var: {
         vector<double> values;
         readData(isegment, values);
+        values.resize(readWeights(values.size()));
         runEvolutionVAR(values);
         break;
       }
       case mode::evolution_es: {
         vector<double> values;
         readData(isegment, values);
+        values.resize(readWeights(values.size()));
         runEvolutionES(values);
         break;
       }
       case mode::contribution_el: {
         vector<vector<double>> content;
         readData(content);
+        size_t numrows = readWeights(content.empty() ? 0 : content[0].size());
+        for(vector<double> &column : content) column.resize(numrows);
         runContributionEL(content);
         break;
       }
       case mode::contribution_es: {
         vector<vector<double>> content;
         readData(content);
+        size_t numrows = readWeights(content.empty() ? 0 : content[0].size());
+        for(vector<double> &column : content) column.resize(numrows);
         runContributionES(content);
         break;
       }
@@ -308,7 +372,7 @@ void ccruncher_gui::AnalysisTask::runHistogram(const std::vector<double> &values
 
   for(size_t i=0; i<values.size(); i++)
   {
-    gsl_histogram_increment(hist, values[i]);
+    gsl_histogram_accumulate(hist, values[i], weight(i));
     if (i%100 == 0 || stop_) {
       progress = 100.0f*(float)(i+1)/(float)(values.size());
     }
@@ -338,8 +402,9 @@ void ccruncher_gui::AnalysisTask::runEvolutionEL(const std::vector<double> &valu
     double x = (i+1)*step;
 
     while(n < (size_t)(x+0.5)) {
-      sum1.add(values[n]);
-      sum2.add(values[n]*values[n]);
+      double y = weight(n)*values[n];
+      sum1.add(y);
+      sum2.add(y*y);
       n++;
     }
 
@@ -375,17 +440,23 @@ void ccruncher_gui::AnalysisTask::runEvolutionVAR(std::vector<double> &values)
   statvals.reserve(numpoints);
 
   // negate values (used in partial_sort)
-  for(auto &value : values) {
-    value = -value;
+  if (weights.empty()) {
+    for(auto &value : values) {
+      value = -value;
+    }
   }
 
   for(size_t i=0; i<numpoints; i++)
   {
     int n = (int)((i+1)*step+0.5);
-    statval var = valueAtRisk(1.0-percentile, values.begin(), values.begin()+n);
-    var.value = -var.value;
-
-    statvals.push_back(var);
+    if (weights.empty()) {
+      statval var = valueAtRisk(1.0-percentile, values.begin(), values.begin()+n);
+      var.value = -var.value;
+      statvals.push_back(var);
+    }
+    else {
+      statvals.push_back(weightedRisk(false, percentile, values, n));
+    }
     progress = 100.0f*(float)(i+1)/(float)(numpoints);
     if (stop_) throw StopException();
   }
@@ -507,16 +578,23 @@ void ccruncher_gui::AnalysisTask::runEvolutionES(std::vector<double> &values)
   statvals.reserve(numpoints);
 
   // negate values (used in partial_sort)
-  for(auto &value : values) {
-    value = -value;
+  if (weights.empty()) {
+    for(auto &value : values) {
+      value = -value;
+    }
   }
 
   for(size_t i=0; i<numpoints; i++)
   {
     int n = (int)((i+1)*step+0.5);
-    statval es = expectedShortfall(1.0-percentile, values.begin(), values.begin()+n);
-    es.value = -es.value;
-    statvals.push_back(es);
+    if (weights.empty()) {
+      statval es = expectedShortfall(1.0-percentile, values.begin(), values.begin()+n);
+      es.value = -es.value;
+      statvals.push_back(es);
+    }
+    else {
+      statvals.push_back(weightedRisk(true, percentile, values, n));
+    }
     progress = 100.0f*(float)(i+1)/(float)(numpoints);
     if (stop_) throw StopException();
   }
@@ -565,6 +643,79 @@ statval ccruncher_gui::AnalysisTask::expectedShortfall(double percentile,
   return statval(n, mean, std_err);
 }
 
+/**************************************************************************//**
+ * @details Importance sampling estimators (see Statistics). The VaR is the
+ *          lowest loss whose weighted exceedance probability is less than
+ *          1-level. The ES is the weighted mean of the losses in the tail
+ *          of probability 1-level.
+ * @param[in] es Compute ES (true) or VaR (false).
+ * @param[in] level Confidence level in (0,1).
+ * @param[in] values Simulated losses.
+ * @param[in] weights Simulation weights.
+ * @param[in] n Number of simulations.
+ * @return VaR or ES value.
+ */
+double ccruncher_gui::AnalysisTask::weightedRisk(bool es, double level, const double *values,
+    const double *weights, size_t n)
+{
+  assert(0.0 < level && level < 1.0);
+  if (n == 0) return NAN;
+
+  vector<size_t> order(n);
+  iota(order.begin(), order.end(), 0);
+  sort(order.begin(), order.end(), [values](size_t a, size_t b) { return values[a] > values[b]; });
+
+  double tail = (1.0-level)*n;
+  kahan cum, sum;
+  for(size_t k=0; k<n; k++) {
+    size_t i = order[k];
+    double w = std::min(weights[i], tail-cum.value());
+    cum.add(w);
+    sum.add(w*values[i]);
+    if (cum.value() >= tail) {
+      return (es ? sum.value()/tail : values[i]);
+    }
+  }
+
+  // total weight below the tail probability
+  return (es && cum.value() > 0.0 ? sum.value()/cum.value() : values[order.back()]);
+}
+
+/**************************************************************************//**
+ * @details The standard error is estimated by batch means: simulations
+ *          are split in NUM_BATCHES consecutive batches, and the standard
+ *          error is the standard deviation of the batch values divided by
+ *          sqrt(NUM_BATCHES). It is 0 if batches are too small to contain
+ *          the tail.
+ * @param[in] es Compute ES (true) or VaR (false).
+ * @param[in] level Confidence level in (0,1).
+ * @param[in] values Simulated losses (weights are the member ones).
+ * @param[in] n Number of simulations to consider.
+ * @return VaR or ES value.
+ */
+statval ccruncher_gui::AnalysisTask::weightedRisk(bool es, double level, const vector<double> &values, size_t n) const
+{
+  assert(n <= values.size() && n <= weights.size());
+  double value = weightedRisk(es, level, values.data(), weights.data(), n);
+
+  double std_err = 0.0;
+  size_t len = n/NUM_BATCHES;
+  if ((1.0-level)*len >= 1.0)
+  {
+    kahan sum1, sum2;
+    for(size_t i=0; i<NUM_BATCHES; i++) {
+      double x = weightedRisk(es, level, values.data()+i*len, weights.data()+i*len, len);
+      sum1.add(x);
+      sum2.add(x*x);
+    }
+    double mean = sum1.value()/NUM_BATCHES;
+    double var = (sum2.value()/NUM_BATCHES - mean*mean) * NUM_BATCHES/(NUM_BATCHES-1.0);
+    std_err = sqrt(std::max(var, 0.0)/NUM_BATCHES);
+  }
+
+  return statval(n, value, std_err);
+}
+
 /**************************************************************************//**
  * @details Compute risk contribution. Let result in variable contribs.
  * @param[in] content Csv data (columns = segments).
@@ -594,8 +745,9 @@ void ccruncher_gui::AnalysisTask::runContributionEL(const std::vector<std::vecto
   // compute portfolio EL
   kahan sum1, sum2;
   for(size_t i=0; i<nrows; i++) {
-    sum1.add(portfolio[i]);
-    sum2.add(portfolio[i]*portfolio[i]);
+    double y = weight(i)*portfolio[i];
+    sum1.add(y);
+    sum2.add(y*y);
   }
   int n = nrows;
   double s1 = sum1.value();
@@ -614,7 +766,7 @@ void ccruncher_gui::AnalysisTask::runContributionEL(const std::vector<std::vecto
   for(size_t i=0; i<nrows; i++)
   {
     for(size_t j=0; j<ncols; j++) {
-      sums[j].add(content[j][i]);
+      sums[j].add(weight(i)*content[j][i]);
     }
 
     if (i%100 == 0 || stop_ || i==(nrows-1)) {
@@ -658,29 +810,41 @@ void ccruncher_gui::AnalysisTask::runContributionES(std::vector<std::vector<doub
     aux[i] = -portfolio[i];
   }
 
-  // compute portfolio VaR
-  statval var = valueAtRisk(1.0-percentile, aux.begin(), aux.end());
-  var.value = -var.value;
+  double var = 0.0;
+  if (weights.empty())
+  {
+    // compute portfolio VaR
+    statval aux1 = valueAtRisk(1.0-percentile, aux.begin(), aux.end());
+    var = -aux1.value;
 
-  // compute portfolio ES
-  for(size_t i=0; i<nrows; i++) {
-    aux[i] = -portfolio[i];
+    // compute portfolio ES
+    for(size_t i=0; i<nrows; i++) {
+      aux[i] = -portfolio[i];
+    }
+    statval es = expectedShortfall(1.0-percentile, aux.begin(), aux.end());
+    es.value = -es.value;
+    statvals.push_back(es);
+  }
+  else
+  {
+    // compute portfolio weighted VaR and ES
+    var = weightedRisk(false, percentile, portfolio.data(), weights.data(), nrows);
+    statvals.push_back(weightedRisk(true, percentile, portfolio, nrows));
   }
-  statval es = expectedShortfall(1.0-percentile, aux.begin(), aux.end());
-  es.value = -es.value;
-  statvals.push_back(es);
 
   // select rows bigger than VaR
   size_t n = 0;
   for(size_t i=0; i<nrows; i++) {
-    if (portfolio[i] >= var.value) {
+    if (portfolio[i] >= var) {
       for(size_t j=0; j<ncols; j++) {
         content[j][n] = content[j][i];
       }
+      if (!weights.empty()) weights[n] = weights[i];
       n++;
     }
   }
   content.resize(n);
+  if (!weights.empty()) weights.resize(n);
 
   // compute contributions
   contribs.resize(ncols);
@@ -689,15 +853,17 @@ void ccruncher_gui::AnalysisTask::runContributionES(std::vector<std::vector<doub
     contribs[j].value = 0.0;
   }
   vector<kahan> sums(ncols);
+  kahan sumw;
   for(size_t i=0; i<n; i++)
   {
     for(size_t j=0; j<ncols; j++) {
-      sums[j].add(content[j][i]);
+      sums[j].add(weight(i)*content[j][i]);
     }
+    sumw.add(weight(i));
 
     if (i%100 == 0 || stop_ || i==(n-1)) {
       for(size_t j=0; j<ncols; j++) {
-        contribs[j].value = sums[j].value()/(i+1.0);
+        contribs[j].value = sums[j].value()/sumw.value();
       }
       progress = 100.0f*(float)(i+1)/(float)(n);
     }
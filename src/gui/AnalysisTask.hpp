@@ -130,6 +130,10 @@ class AnalysisTask : public QThread
 
     //! Csv file
     ccruncher::CsvFile csv;
+    //! Importance sampling weights file (empty if none)
+    std::string wfilename;
+    //! Importance sampling weights (empty if unweighted)
+    std::vector<double> weights;
     //! Segment index (-1 means rowSums)
     int isegment;
     //! Number of bins (hist)
@@ -159,11 +163,19 @@ class AnalysisTask : public QThread
     static statval valueAtRisk(double percentile, std::vector<double>::iterator first, std::vector<double>::iterator last);
     //! Expected shortfall
     static statval expectedShortfall(double percentile, std::vector<double>::iterator first, std::vector<double>::iterator last);
+    //! Weighted VaR or ES value
+    static double weightedRisk(bool es, double level, const double *values, const double *weights, size_t n);
+    //! Weighted VaR or ES (importance sampling)
+    statval weightedRisk(bool es, double level, const std::vector<double> &values, size_t n) const;
+    //! Simulation weight
+    double weight(size_t i) const { return (weights.empty() ? 1.0 : weights[i]); }
 
     //! Read csv data
     void readData(int col, std::vector<double> &ret);
     //! Read csv data
     void readData(std::vector<std::vector<double>> &ret);
+    //! Read importance sampling weights
+    size_t readWeights(size_t numrows);
     //! Set status
     void setStatus(status);
     //! Compute histogram
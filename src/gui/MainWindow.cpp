@@ -226,9 +226,9 @@ void ccruncher_gui::MainWindow::selectFile()
               this,
               tr("Open File ..."),
               "",
-              tr("ccruncher files (*.xml *.gz *.csv);;"
+              tr("ccruncher files (*.xml *.gz *.csv *.bin);;"
                  "input files (*.xml *.gz);;"
-                 "output files (*.csv);;All files (*.*)")
+                 "output files (*.csv *.bin);;All files (*.*)")
             );
 
   if (!filename.isEmpty()) {
@@ -248,6 +248,7 @@ void ccruncher_gui::MainWindow::selectFile()
  *          - file://dirpath -> opens directory in a file browser.
  *          - file://filepath opened in a mdi-window -> active mdi-window
  *          - file://file.csv -> opens analysis window
+ *          - file://file.bin -> opens analysis window
  *          - file://file.xml -> opens xml editor
  *          - exec://filepath -> opens simulation window
  * @param[in] url Url to open.
@@ -281,7 +282,7 @@ void ccruncher_gui::MainWindow::openFile(const QUrl &url)
         child = new SimulationWidget(filename, this);
         connect(child, SIGNAL(anchorClicked(const QUrl &)), this, SLOT(openFile(const QUrl &)));
       }
-      else if (!filename.toLower().endsWith("csv")) {
+      else if (!filename.toLower().endsWith("csv") && !filename.toLower().endsWith("bin")) {
         child = new XmlEditWidget(filename, this);
         connect(child, SIGNAL(anchorClicked(const QUrl &)), this, SLOT(openFile(const QUrl &)));
       }
@@ -21,8 +21,10 @@
 //===========================================================================
 
 #include <cassert>
+#include <cstdint>
 #include <unistd.h>
 #include "kernel/Aggregator.hpp"
+#include "utils/CsvFile.hpp"
 #include "utils/Exception.hpp"
 #include "utils/Utils.hpp"
 #include "utils/config.h"
@@ -40,9 +42,11 @@ using namespace std;
  * @param[in] filename Filename.
  * @param[in] mode a=append, w=overwrite, c=create
  * @param[in] numSegments Number of segments.
+ * @param[in] format File format.
  * @throw Exception Error creating file.
  */
-ccruncher::Aggregator::Aggregator(const std::string &filename, char mode, unsigned short numSegments)
+ccruncher::Aggregator::Aggregator(const std::string &filename, char mode,
+    unsigned short numSegments, Format format) : mFormat(format)
 {
   if (numSegments == 0) {
     throw Exception("trying to aggregate 0 segments");
@@ -60,8 +64,13 @@ ccruncher::Aggregator::Aggregator(const std::string &filename, char mode, unsign
   }
 
   try {
+    ios::openmode flags = ios::out|(mMode=='a'?(ios::app):(ios::trunc));
+    if (mFormat != Format::Csv) {
+      flags |= ios::binary;
+      mBuffer.resize(mNumSegments*sizeof(double));
+    }
     mFile.exceptions(ios::failbit | ios::badbit);
-    mFile.open(filename.c_str(), ios::out|(mMode=='a'?(ios::app):(ios::trunc)));
+    mFile.open(filename.c_str(), flags);
     mFile.setf(ios::fixed);
     mFile.setf(ios::showpoint);
     mFile.precision(2);
@@ -84,29 +93,144 @@ ccruncher::Aggregator::~Aggregator()
 }
 
 /**************************************************************************//**
+ * @details Header is printed only if file is empty. When appending data
+ *          to an existing binary file, its header is checked.
  * @param[in] segmentation Segmentation of this aggregator.
  * @param[in] exposures Segment exposures.
+ * @param[in] shard Shard description (empty if not a shard, see Shard).
  * @throw Exception Error printing header.
  */
-void ccruncher::Aggregator::printHeader(const Segmentation &segmentation, const vector<double> &exposures)
+void ccruncher::Aggregator::printHeader(const Segmentation &segmentation, const vector<double> &exposures,
+    const string &shard)
 {
   if (mNumSegments != segmentation.size() || mNumSegments != exposures.size()) {
     throw Exception("invalid aggregator header");
   }
 
   if (mMode != 'a' || Utils::filesize(mFilename) == 0) {
-    mFile << "#==========================================================" << endl;
-    mFile << "# file generated by ccruncher-" << PACKAGE_VERSION << endl;
-    mFile << "# exposure: ";
-    for(size_t i=0; i<exposures.size(); i++) {
-      mFile << exposures[i] << (i<exposures.size()-1?", ":"");
+    if (mFormat == Format::Csv) {
+      printCsvHeader(segmentation, exposures, shard);
+    }
+    else {
+      printBinaryHeader(segmentation, exposures, shard);
     }
-    mFile << endl;
-    mFile << "#==========================================================" << endl;
-    for(unsigned short i=0; i<segmentation.size(); i++) {
-      mFile << "\"" << segmentation.getSegment(i) << "\"" << (i<segmentation.size()-1?", ":"");
+  }
+  else if (mFormat != Format::Csv) {
+    checkBinaryHeader(segmentation);
+  }
+}
+
+/**************************************************************************//**
+ * @param[in] segmentation Segmentation of this aggregator.
+ * @param[in] exposures Segment exposures.
+ * @param[in] shard Shard description (written as a comment line).
+ * @throw Exception Error printing header.
+ */
+void ccruncher::Aggregator::printCsvHeader(const Segmentation &segmentation, const vector<double> &exposures,
+    const string &shard)
+{
+  mFile << "#==========================================================" << endl;
+  mFile << "# file generated by ccruncher-" << PACKAGE_VERSION << endl;
+  mFile << "# exposure: ";
+  for(size_t i=0; i<exposures.size(); i++) {
+    mFile << exposures[i] << (i<exposures.size()-1?", ":"");
+  }
+  mFile << endl;
+  if (!shard.empty()) {
+    mFile << "# " << shard << endl;
+  }
+  mFile << "#==========================================================" << endl;
+  for(unsigned short i=0; i<segmentation.size(); i++) {
+    mFile << "\"" << segmentation.getSegment(i) << "\"" << (i<segmentation.size()-1?", ":"");
+  }
+  mFile << endl;
+}
+
+/**************************************************************************//**
+ * @details Binary header layout (integers are 32-bit unsigned, strings
+ *          are prefixed by its length, all values are little-endian):
+ *          magic, version, value size (in bytes), number of segments,
+ *          header size (in bytes), generator, segment names, exposures
+ *          (double). Data rows follow the header. The shard description
+ *          is appended to the generator (separated by '; ').
+ * @see CsvFile
+ * @param[in] segmentation Segmentation of this aggregator.
+ * @param[in] exposures Segment exposures.
+ * @param[in] shard Shard description.
+ * @throw Exception Error printing header.
+ */
+void ccruncher::Aggregator::printBinaryHeader(const Segmentation &segmentation, const vector<double> &exposures,
+    const string &shard)
+{
+  string generator = string("ccruncher-") + PACKAGE_VERSION;
+  if (!shard.empty()) {
+    generator += "; " + shard;
+  }
+  uint32_t values[5];
+  values[0] = CsvFile::BINARY_VERSION;
+  values[1] = (mFormat==Format::Float32?sizeof(float):sizeof(double));
+  values[2] = mNumSegments;
+  values[3] = sizeof(CsvFile::BINARY_MAGIC) + 5*sizeof(uint32_t) + generator.size();
+  for(unsigned short i=0; i<segmentation.size(); i++) {
+    values[3] += sizeof(uint32_t) + segmentation.getSegment(i).size();
+  }
+  values[3] += mNumSegments*sizeof(double);
+  values[4] = generator.size();
+
+  mFile.write(CsvFile::BINARY_MAGIC, sizeof(CsvFile::BINARY_MAGIC));
+  write(values, sizeof(uint32_t), 5);
+  mFile.write(generator.c_str(), generator.size());
+  for(unsigned short i=0; i<segmentation.size(); i++) {
+    const string &name = segmentation.getSegment(i);
+    uint32_t len = name.size();
+    write(&len, sizeof(uint32_t));
+    mFile.write(name.c_str(), name.size());
+  }
+  write(exposures.data(), sizeof(double), exposures.size());
+  mFile.flush();
+}
+
+/**************************************************************************//**
+ * @details Data can be appended to a binary file only if it has the
+ *          same format and segments.
+ * @param[in] segmentation Segmentation of this aggregator.
+ * @throw Exception Existing file has a distinct format.
+ */
+void ccruncher::Aggregator::checkBinaryHeader(const Segmentation &segmentation)
+{
+  CsvFile file(mFilename);
+  size_t size = (mFormat==Format::Float32?sizeof(float):sizeof(double));
+  if (file.getValueSize() != size) {
+    throw Exception("file '" + mFilename + "' has a distinct format");
+  }
+
+  const vector<string> &headers = file.getHeaders();
+  if (headers.size() != mNumSegments) {
+    throw Exception("file '" + mFilename + "' has distinct segments");
+  }
+  for(unsigned short i=0; i<mNumSegments; i++) {
+    if (headers[i] != segmentation.getSegment(i)) {
+      throw Exception("file '" + mFilename + "' has distinct segments");
     }
-    mFile << endl;
+  }
+}
+
+/**************************************************************************//**
+ * @details Values are converted to little-endian if required.
+ * @param[in] ptr Values to write.
+ * @param[in] size Size of each value (in bytes).
+ * @param[in] num Number of values.
+ */
+void ccruncher::Aggregator::write(const void *ptr, size_t size, size_t num)
+{
+  const char *bytes = static_cast<const char *>(ptr);
+  if (Utils::isLittleEndian()) {
+    mFile.write(bytes, size*num);
+  }
+  else {
+    vector<char> aux(bytes, bytes+size*num);
+    Utils::swapBytes(aux.data(), size, num);
+    mFile.write(aux.data(), aux.size());
   }
 }
 
@@ -121,17 +245,44 @@ void ccruncher::Aggregator::append(const double *losses)
   assert(mNumSegments > 0);
 
   try {
-    for(int i=0; i<mNumSegments-1; i++) {
-      mFile << losses[i] << ", ";
+    if (mFormat == Format::Float64) {
+      write(losses, sizeof(double), mNumSegments);
+    }
+    else if (mFormat == Format::Float32) {
+      float *values = reinterpret_cast<float *>(mBuffer.data());
+      for(unsigned short i=0; i<mNumSegments; i++) {
+        values[i] = static_cast<float>(losses[i]);
+      }
+      write(values, sizeof(float), mNumSegments);
+    }
+    else {
+      for(int i=0; i<mNumSegments-1; i++) {
+        mFile << losses[i] << ", ";
+      }
+      // endl not used because flush
+      mFile << losses[mNumSegments-1] << "\n";
     }
-    // endl not used because flush
-    mFile << losses[mNumSegments-1] << "\n";
   }
   catch(std::exception &e) {
     throw Exception(e, "error writing in '" + mFilename + "'");
   }
 }
 
+/**************************************************************************//**
+ * @details By default CSV values are amounts written with 2 decimals.
+ *          This method switches to scientific notation with the given
+ *          number of significant digits (eg. likelihood ratios). Binary
+ *          formats are not affected.
+ * @param[in] digits Number of significant digits (>0).
+ */
+void ccruncher::Aggregator::setPrecision(int digits)
+{
+  assert(digits > 0);
+  mFile.unsetf(ios::fixed);
+  mFile.setf(ios::scientific);
+  mFile.precision(digits-1);
+}
+
 /**************************************************************************//**
  * @details Synchronizes disk file and the associated stream buffer.
  * @throw Exception Error writing data to file.
@@ -145,3 +296,39 @@ void ccruncher::Aggregator::flush()
     throw Exception(e, "error writing in '" + mFilename + "'");
   }
 }
+
+/**************************************************************************//**
+ * @param[in] format File format.
+ * @return File extension (including the dot).
+ */
+string ccruncher::Aggregator::getExtension(Format format)
+{
+  if (format == Format::Csv) {
+    return ".csv";
+  }
+  else {
+    return ".bin";
+  }
+}
+
+/**************************************************************************//**
+ * @param[in] name Format name (csv, float64, float32).
+ * @return File format.
+ * @throw Exception Invalid format name.
+ */
+ccruncher::Aggregator::Format ccruncher::Aggregator::getFormat(const std::string &name)
+{
+  string str = Utils::lowercase(Utils::trim(name));
+  if (str == "csv") {
+    return Format::Csv;
+  }
+  else if (str == "float64") {
+    return Format::Float64;
+  }
+  else if (str == "float32") {
+    return Format::Float32;
+  }
+  else {
+    throw Exception("invalid output format '" + name + "'");
+  }
+}
@@ -32,16 +32,28 @@ namespace ccruncher {
 /**************************************************************************//**
  * @brief Simulated values of a segmentation.
  *
- * @details Manages the CSV file containing the simulated values for a
- *          given segmentation. First line contains columns header (segment
- *          names). Every row corresponds to the simulated losses of a
- *          segmentation.
+ * @details Manages the file containing the simulated values for a
+ *          given segmentation. In CSV format, first line contains columns
+ *          header (segment names) and every row corresponds to the
+ *          simulated losses of a segmentation. Binary formats contain a
+ *          header (segment names, exposures, version, value size)
+ *          followed by raw little-endian rows (see CsvFile).
  *
  * @see http://ccruncher.net/ofileref.html#segmentation
  */
 class Aggregator
 {
 
+  public:
+
+    //! Output file format
+    enum class Format
+    {
+      Csv=0,     //!< CSV text file
+      Float64=1, //!< Binary file (double precision values)
+      Float32=2  //!< Binary file (single precision values)
+    };
+
   private:
 
     //! File name
@@ -52,11 +64,26 @@ class Aggregator
     unsigned short mNumSegments;
     //! Open file mode
     char mMode;
+    //! File format
+    Format mFormat;
+    //! Conversion buffer (binary formats)
+    std::vector<char> mBuffer;
+
+  private:
+
+    //! Write little-endian values
+    void write(const void *ptr, size_t size, size_t num=1);
+    //! Print CSV header
+    void printCsvHeader(const Segmentation &segmentation, const std::vector<double> &exposures, const std::string &shard);
+    //! Print binary header
+    void printBinaryHeader(const Segmentation &segmentation, const std::vector<double> &exposures, const std::string &shard);
+    //! Check binary header of an existing file
+    void checkBinaryHeader(const Segmentation &segmentation);
 
   public:
 
     //! Constructor
-    Aggregator(const std::string &mFilename, char mode, unsigned short numSegments);
+    Aggregator(const std::string &mFilename, char mode, unsigned short numSegments, Format format=Format::Csv);
     //! Non-copyable class
     Aggregator(const Aggregator &) = delete;
     //! Non-copyable class
@@ -64,13 +91,22 @@ class Aggregator
     //! Destructor
     ~Aggregator();
     //! Set header info
-    void printHeader(const Segmentation &segmentation, const std::vector<double> &exposures);
+    void printHeader(const Segmentation &segmentation, const std::vector<double> &exposures,
+                     const std::string &shard="");
     //! Append data to aggregator
     void append(const double *);
+    //! Set CSV values precision (significant digits)
+    void setPrecision(int digits);
     //! Force flush data to disk
     void flush();
     //! Return file name
     const std::string &getFilename() const { return mFilename; }
+    //! Return file format
+    Format getFormat() const { return mFormat; }
+    //! Return file extension of the given format
+    static std::string getExtension(Format format);
+    //! Parse a format name
+    static Format getFormat(const std::string &name);
 
 };
 
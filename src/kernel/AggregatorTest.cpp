@@ -0,0 +1,177 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#include <vector>
+#include "kernel/Aggregator.hpp"
+#include "kernel/AggregatorTest.hpp"
+#include "params/Segmentation.hpp"
+#include "utils/CsvFile.hpp"
+#include "utils/Utils.hpp"
+
+#define FILENAME "ccruncher-aggregatortest"
+#define NUMROWS 1000
+
+using namespace std;
+using namespace ccruncher;
+
+//===========================================================================
+// setUp
+//===========================================================================
+void ccruncher_test::AggregatorTest::setUp()
+{
+  workdir = Utils::makeTempDir("ccruncher-aggregatortest.");
+}
+
+//===========================================================================
+// tearDown
+//===========================================================================
+void ccruncher_test::AggregatorTest::tearDown()
+{
+  Utils::removeDir(workdir);
+}
+
+//===========================================================================
+// check
+// writes a file and reads it using CsvFile
+//===========================================================================
+void ccruncher_test::AggregatorTest::check(Aggregator::Format format, double epsilon)
+{
+  string filename = workdir + Utils::pathSeparator + FILENAME + Aggregator::getExtension(format);
+
+  Segmentation segmentation("sectors", true);
+  segmentation.addSegment("S1");
+  segmentation.addSegment("S2");
+  segmentation.addSegment("S3");
+  vector<double> exposures = { 0.0, 100.0, 200.0, 300.0 };
+  unsigned short numsegments = segmentation.size();
+
+  // writing data
+  {
+    Aggregator aggregator(filename, 'c', numsegments, format);
+    aggregator.printHeader(segmentation, exposures);
+    vector<double> losses(numsegments);
+    for(size_t i=0; i<NUMROWS; i++) {
+      for(unsigned short j=0; j<numsegments; j++) {
+        losses[j] = i + j/8.0;
+      }
+      aggregator.append(losses.data());
+    }
+  }
+
+  // reading data
+  CsvFile csv(filename);
+  size_t valuesize = (format==Aggregator::Format::Csv?0:(format==Aggregator::Format::Float32?4:8));
+  ASSERT_EQUALS(valuesize, csv.getValueSize());
+
+  const vector<string> &headers = csv.getHeaders();
+  ASSERT_EQUALS((size_t)numsegments, headers.size());
+  for(unsigned short j=0; j<numsegments; j++) {
+    ASSERT_EQUALS(segmentation.getSegment(j), headers[j]);
+  }
+
+  vector<double> values;
+  csv.getColumn(2, values);
+  ASSERT_EQUALS((size_t)NUMROWS, values.size());
+  for(size_t i=0; i<NUMROWS; i++) {
+    ASSERT_EQUALS_EPSILON(i+2/8.0, values[i], epsilon);
+  }
+
+  csv.getColumn(-1, values);
+  ASSERT_EQUALS((size_t)NUMROWS, values.size());
+  for(size_t i=0; i<NUMROWS; i++) {
+    ASSERT_EQUALS_EPSILON(numsegments*i+(0+1+2+3)/8.0, values[i], numsegments*epsilon);
+  }
+
+  vector<vector<double>> table;
+  csv.getColumns(table);
+  ASSERT_EQUALS((size_t)numsegments, table.size());
+  for(unsigned short j=0; j<numsegments; j++) {
+    ASSERT_EQUALS((size_t)NUMROWS, table[j].size());
+    ASSERT_EQUALS_EPSILON(NUMROWS-1+j/8.0, table[j][NUMROWS-1], epsilon);
+  }
+
+  csv.close();
+}
+
+//===========================================================================
+// test1. csv format
+//===========================================================================
+void ccruncher_test::AggregatorTest::test1()
+{
+  check(Aggregator::Format::Csv, 0.005);
+}
+
+//===========================================================================
+// test2. binary format (double)
+//===========================================================================
+void ccruncher_test::AggregatorTest::test2()
+{
+  check(Aggregator::Format::Float64, 1e-12);
+}
+
+//===========================================================================
+// test3. binary format (float)
+//===========================================================================
+void ccruncher_test::AggregatorTest::test3()
+{
+  check(Aggregator::Format::Float32, 1e-4);
+}
+
+//===========================================================================
+// test4. appending to binary files
+//===========================================================================
+void ccruncher_test::AggregatorTest::test4()
+{
+  string filename = workdir + Utils::pathSeparator + FILENAME + ".bin";
+
+  Segmentation segmentation("portfolio");
+  vector<double> exposures = { 1000.0 };
+  double loss = 1.0;
+
+  // writing 1 row two times
+  for(int i=0; i<2; i++) {
+    Aggregator aggregator(filename, 'a', 1, Aggregator::Format::Float64);
+    aggregator.printHeader(segmentation, exposures);
+    aggregator.append(&loss);
+  }
+
+  CsvFile csv(filename);
+  ASSERT_EQUALS((size_t)3, csv.getNumLines());
+  csv.close();
+
+  // distinct format
+  {
+    Aggregator aggregator(filename, 'a', 1, Aggregator::Format::Float32);
+    ASSERT_THROW(aggregator.printHeader(segmentation, exposures));
+  }
+
+  // distinct segments
+  {
+    Segmentation other("other");
+    Aggregator aggregator(filename, 'a', 1, Aggregator::Format::Float64);
+    ASSERT_THROW(aggregator.printHeader(other, exposures));
+  }
+
+  // invalid format names
+  ASSERT(Aggregator::getFormat("float32") == Aggregator::Format::Float32);
+  ASSERT_THROW(Aggregator::getFormat("xml"));
+}
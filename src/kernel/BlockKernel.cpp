@@ -0,0 +1,299 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#include <cassert>
+#include "kernel/BlockKernel.hpp"
+#include "utils/Exception.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CCRUNCHER_X86_SIMD
+#include <immintrin.h>
+#endif
+
+using namespace std;
+using namespace ccruncher;
+
+/**************************************************************************//**
+ * @details Spreads the bits of a byte to the even positions of a word
+ *          (bit i goes to bit 2i).
+ * @param[in] m Bits to spread (8 bits max).
+ * @return Spreaded bits.
+ */
+static inline unsigned int spread(unsigned int m)
+{
+  m = (m | (m << 4)) & 0x0F0Fu;
+  m = (m | (m << 2)) & 0x3333u;
+  m = (m | (m << 1)) & 0x5555u;
+  return m;
+}
+
+/**************************************************************************//**
+ * @details Appends the simulations flagged in mask to the candidates list.
+ *          When antithetic, bit 2k refers to -x[i0+k] and bit 2k+1 to
+ *          +x[i0+k]. Otherwise bit k refers to x[i0+k].
+ * @param[in] x Latent values.
+ * @param[in] i0 Index of the first latent value covered by mask.
+ * @param[in] mask Flagged simulations.
+ * @param[in] antithetic Antithetic mode flag.
+ * @param[out] events Simulations indexes.
+ * @param[out] values Simulations values.
+ * @param[in,out] num Number of candidates.
+ */
+static inline void append(const double *x, size_t i0, unsigned int mask, bool antithetic,
+                          unsigned short *events, double *values, size_t &num)
+{
+  for(unsigned int b=0; mask!=0; b++, mask>>=1) {
+    if (!(mask & 1u)) {
+      continue;
+    }
+    else if (antithetic) {
+      size_t i = i0 + b/2;
+      events[num] = static_cast<unsigned short>(2*i + b%2);
+      values[num] = (b%2 ? +x[i] : -x[i]);
+    }
+    else {
+      events[num] = static_cast<unsigned short>(i0 + b);
+      values[num] = x[i0 + b];
+    }
+    num++;
+  }
+}
+
+/**************************************************************************//**
+ * @details Scalar candidates detection of latent values [i0,n).
+ * @see eventsScalar()
+ */
+static inline void eventsRange(const double *x, size_t i0, size_t n, bool antithetic, double threshold,
+                               unsigned short *events, double *values, size_t &num)
+{
+  for(size_t i=i0; i<n; i++) {
+    if (antithetic) {
+      unsigned int mask = (-x[i] <= threshold ? 1u : 0u) | (x[i] <= threshold ? 2u : 0u);
+      append(x, i, mask, true, events, values, num);
+    }
+    else if (x[i] <= threshold) {
+      append(x, i, 1u, false, events, values, num);
+    }
+  }
+}
+
+/**************************************************************************//**
+ * @param[in,out] x Latent values (input: epsilons, output: t-student values).
+ * @param[in] z Factor values (already multiplied by factor loading).
+ * @param[in] s Chi-square scaling values.
+ * @param[in] w Idiosyncratic loading [sqrt(1-w_i^2)].
+ * @param[in] n Number of values.
+ */
+static void latentScalar(double *x, const double *z, const double *s, double w, size_t n)
+{
+  for(size_t j=0; j<n; j++) {
+    x[j] = s[j] * (z[j] + w*x[j]);
+  }
+}
+
+/**************************************************************************//**
+ * @details When antithetic the block has 2n simulations, the 2i-th
+ *          simulation has value -x[i] and the (2i+1)-th has +x[i].
+ *          Candidates are reported in increasing order of simulation.
+ * @param[in] x Latent values.
+ * @param[in] n Number of latent values.
+ * @param[in] antithetic Antithetic mode flag.
+ * @param[in] threshold Non-default threshold.
+ * @param[out] events Simulations indexes (size >= blocksize).
+ * @param[out] values Simulations values (size >= blocksize).
+ * @return Number of candidates.
+ */
+static size_t eventsScalar(const double *x, size_t n, bool antithetic, double threshold,
+                           unsigned short *events, double *values)
+{
+  size_t num = 0;
+  eventsRange(x, 0, n, antithetic, threshold, events, values, num);
+  return num;
+}
+
+#ifdef CCRUNCHER_X86_SIMD
+
+/**************************************************************************//**
+ * @details Uses mul+add (not fma) to preserve the scalar rounding.
+ * @see latentScalar()
+ */
+__attribute__((target("avx2")))
+static void latentAvx2(double *x, const double *z, const double *s, double w, size_t n)
+{
+  __m256d vw = _mm256_set1_pd(w);
+  size_t j = 0;
+  for(; j+4<=n; j+=4) {
+    __m256d vx = _mm256_mul_pd(vw, _mm256_loadu_pd(x+j));
+    vx = _mm256_add_pd(_mm256_loadu_pd(z+j), vx);
+    vx = _mm256_mul_pd(_mm256_loadu_pd(s+j), vx);
+    _mm256_storeu_pd(x+j, vx);
+  }
+  latentScalar(x+j, z+j, s+j, w, n-j);
+}
+
+/**************************************************************************//**
+ * @see eventsScalar()
+ */
+__attribute__((target("avx2")))
+static size_t eventsAvx2(const double *x, size_t n, bool antithetic, double threshold,
+                         unsigned short *events, double *values)
+{
+  __m256d vt = _mm256_set1_pd(threshold);
+  __m256d vsign = _mm256_set1_pd(-0.0);
+  size_t num = 0;
+  size_t i = 0;
+  for(; i+4<=n; i+=4) {
+    __m256d vx = _mm256_loadu_pd(x+i);
+    unsigned int mpos = static_cast<unsigned int>(_mm256_movemask_pd(_mm256_cmp_pd(vx, vt, _CMP_LE_OQ)));
+    if (antithetic) {
+      __m256d vn = _mm256_xor_pd(vx, vsign);
+      unsigned int mneg = static_cast<unsigned int>(_mm256_movemask_pd(_mm256_cmp_pd(vn, vt, _CMP_LE_OQ)));
+      append(x, i, spread(mneg) | (spread(mpos) << 1), true, events, values, num);
+    }
+    else {
+      append(x, i, mpos, false, events, values, num);
+    }
+  }
+  eventsRange(x, i, n, antithetic, threshold, events, values, num);
+  return num;
+}
+
+/**************************************************************************//**
+ * @details Uses mul+add (not fma) to preserve the scalar rounding.
+ * @see latentScalar()
+ */
+__attribute__((target("avx512f")))
+static void latentAvx512(double *x, const double *z, const double *s, double w, size_t n)
+{
+  __m512d vw = _mm512_set1_pd(w);
+  size_t j = 0;
+  for(; j+8<=n; j+=8) {
+    __m512d vx = _mm512_mul_pd(vw, _mm512_loadu_pd(x+j));
+    vx = _mm512_add_pd(_mm512_loadu_pd(z+j), vx);
+    vx = _mm512_mul_pd(_mm512_loadu_pd(s+j), vx);
+    _mm512_storeu_pd(x+j, vx);
+  }
+  latentScalar(x+j, z+j, s+j, w, n-j);
+}
+
+/**************************************************************************//**
+ * @see eventsScalar()
+ */
+__attribute__((target("avx512f")))
+static size_t eventsAvx512(const double *x, size_t n, bool antithetic, double threshold,
+                           unsigned short *events, double *values)
+{
+  __m512d vt = _mm512_set1_pd(threshold);
+  size_t num = 0;
+  size_t i = 0;
+  for(; i+8<=n; i+=8) {
+    __m512d vx = _mm512_loadu_pd(x+i);
+    unsigned int mpos = _mm512_cmp_pd_mask(vx, vt, _CMP_LE_OQ);
+    if (antithetic) {
+      __m512d vn = _mm512_sub_pd(_mm512_setzero_pd(), vx);
+      unsigned int mneg = _mm512_cmp_pd_mask(vn, vt, _CMP_LE_OQ);
+      append(x, i, spread(mneg) | (spread(mpos) << 1), true, events, values, num);
+    }
+    else {
+      append(x, i, mpos, false, events, values, num);
+    }
+  }
+  eventsRange(x, i, n, antithetic, threshold, events, values, num);
+  return num;
+}
+
+#endif
+
+/**************************************************************************//**
+ * @param[in] isa Instruction set.
+ * @throw Exception Instruction set not supported by cpu.
+ */
+ccruncher::BlockKernel::BlockKernel(Isa isa) : mIsa(isa), mLatent(latentScalar), mEvents(eventsScalar)
+{
+  if (!isSupported(isa)) {
+    throw Exception("instruction set " + toString(isa) + " not supported");
+  }
+
+#ifdef CCRUNCHER_X86_SIMD
+  if (isa == Isa::Avx2) {
+    mLatent = latentAvx2;
+    mEvents = eventsAvx2;
+  }
+  else if (isa == Isa::Avx512) {
+    mLatent = latentAvx512;
+    mEvents = eventsAvx512;
+  }
+#endif
+}
+
+/**************************************************************************//**
+ * @return The widest instruction set supported.
+ */
+BlockKernel::Isa ccruncher::BlockKernel::getIsa()
+{
+  if (isSupported(Isa::Avx512)) return Isa::Avx512;
+  else if (isSupported(Isa::Avx2)) return Isa::Avx2;
+  else return Isa::Scalar;
+}
+
+/**************************************************************************//**
+ * @param[in] isa Instruction set.
+ * @return true if the cpu (and OS) supports it, false otherwise.
+ */
+bool ccruncher::BlockKernel::isSupported(Isa isa)
+{
+  switch(isa)
+  {
+    case Isa::Scalar:
+      return true;
+#ifdef CCRUNCHER_X86_SIMD
+    case Isa::Avx2:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx2");
+    case Isa::Avx512:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx512f");
+#endif
+    default:
+      return false;
+  }
+}
+
+/**************************************************************************//**
+ * @param[in] isa Instruction set.
+ * @return Instruction set name.
+ */
+string ccruncher::BlockKernel::toString(Isa isa)
+{
+  switch(isa)
+  {
+    case Isa::Scalar:
+      return "scalar";
+    case Isa::Avx2:
+      return "avx2";
+    case Isa::Avx512:
+      return "avx512";
+    default:
+      assert(false);
+      return "unknown";
+  }
+}
@@ -0,0 +1,93 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#pragma once
+
+#include <string>
+
+namespace ccruncher {
+
+/**************************************************************************//**
+ * @brief Vectorized block operations of the simulation kernel.
+ *
+ * @details Implements the per-obligor loops over the simulations of a
+ *          block: latent variable construction and default candidates
+ *          detection (antithetic mirror and threshold comparison). Each
+ *          operation has a scalar implementation and, on x86 platforms,
+ *          AVX2 and AVX-512 implementations. The instruction set is
+ *          selected at runtime checking the cpu capabilities. All the
+ *          implementations do the same floating point operations in the
+ *          same order, so results are identical whatever instruction set
+ *          is used.
+ *
+ * @see SimulationThread
+ */
+class BlockKernel
+{
+
+  public:
+
+    //! Instruction sets
+    enum class Isa
+    {
+      Scalar=0, //!< Portable scalar code
+      Avx2=1,   //!< AVX2 (4 doubles)
+      Avx512=2  //!< AVX-512F (8 doubles)
+    };
+
+  private:
+
+    //! Latent values function type
+    typedef void (*LatentFunc)(double *, const double *, const double *, double, size_t);
+    //! Candidates detection function type
+    typedef size_t (*EventsFunc)(const double *, size_t, bool, double, unsigned short *, double *);
+
+  private:
+
+    //! Instruction set
+    Isa mIsa;
+    //! Latent values implementation
+    LatentFunc mLatent;
+    //! Candidates detection implementation
+    EventsFunc mEvents;
+
+  public:
+
+    //! Constructor
+    BlockKernel(Isa isa=getIsa());
+    //! Instruction set used
+    Isa getIsaType() const { return mIsa; }
+    //! Latent values x[j] = s[j]*(z[j]+w*x[j])
+    void latent(double *x, const double *z, const double *s, double w, size_t n) const { mLatent(x, z, s, w, n); }
+    //! Default candidates (simulations with value <= threshold)
+    size_t events(const double *x, size_t n, bool antithetic, double threshold, unsigned short *events, double *values) const { return mEvents(x, n, antithetic, threshold, events, values); }
+
+    //! Best instruction set supported by the cpu
+    static Isa getIsa();
+    //! Checks if the cpu supports the given instruction set
+    static bool isSupported(Isa isa);
+    //! Instruction set name
+    static std::string toString(Isa isa);
+
+};
+
+} // namespace
@@ -0,0 +1,127 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#include <vector>
+#include <gsl/gsl_rng.h>
+#include <gsl/gsl_randist.h>
+#include "kernel/BlockKernel.hpp"
+#include "kernel/BlockKernelTest.hpp"
+
+using namespace std;
+using namespace ccruncher;
+
+//===========================================================================
+// test1 (scalar)
+//===========================================================================
+void ccruncher_test::BlockKernelTest::test1()
+{
+  BlockKernel kernel(BlockKernel::Isa::Scalar);
+  ASSERT(BlockKernel::isSupported(BlockKernel::Isa::Scalar));
+  ASSERT_EQUALS("scalar", BlockKernel::toString(kernel.getIsaType()));
+
+  vector<double> x = { 1.0, -2.0, 0.5 };
+  vector<double> z = { 0.5, 0.25, -1.0 };
+  vector<double> s = { 1.0, 2.0, 0.5 };
+  kernel.latent(x.data(), z.data(), s.data(), 0.5, x.size());
+  ASSERT_EQUALS(1.0, x[0]);
+  ASSERT_EQUALS(-1.5, x[1]);
+  ASSERT_EQUALS(-0.375, x[2]);
+
+  vector<unsigned short> events(6, 0);
+  vector<double> values(6, 0.0);
+
+  // non-antithetic
+  size_t num = kernel.events(x.data(), x.size(), false, -0.375, events.data(), values.data());
+  ASSERT_EQUALS((size_t)2, num);
+  ASSERT_EQUALS(1, (int)events[0]);
+  ASSERT_EQUALS(-1.5, values[0]);
+  ASSERT_EQUALS(2, (int)events[1]);
+  ASSERT_EQUALS(-0.375, values[1]);
+
+  // antithetic (simulation 2i = -x[i], 2i+1 = +x[i])
+  num = kernel.events(x.data(), x.size(), true, -0.375, events.data(), values.data());
+  ASSERT_EQUALS((size_t)3, num);
+  ASSERT_EQUALS(0, (int)events[0]);
+  ASSERT_EQUALS(-1.0, values[0]);
+  ASSERT_EQUALS(3, (int)events[1]);
+  ASSERT_EQUALS(-1.5, values[1]);
+  ASSERT_EQUALS(5, (int)events[2]);
+  ASSERT_EQUALS(-0.375, values[2]);
+}
+
+//===========================================================================
+// test2 (vectorized versions give same results than scalar)
+//===========================================================================
+void ccruncher_test::BlockKernelTest::test2()
+{
+  BlockKernel scalar(BlockKernel::Isa::Scalar);
+  vector<BlockKernel::Isa> isas = { BlockKernel::Isa::Avx2, BlockKernel::Isa::Avx512 };
+
+  gsl_rng *rng = gsl_rng_alloc(gsl_rng_mt19937);
+  gsl_rng_set(rng, 1234UL);
+
+  for(BlockKernel::Isa isa : isas)
+  {
+    if (!BlockKernel::isSupported(isa)) {
+      ASSERT_THROW(BlockKernel{isa});
+      continue;
+    }
+
+    BlockKernel kernel(isa);
+
+    for(size_t n : {0, 1, 3, 4, 7, 8, 9, 31, 64, 127})
+    {
+      vector<double> x(n), z(n), s(n);
+      for(size_t j=0; j<n; j++) {
+        x[j] = gsl_ran_gaussian(rng, 1.0);
+        z[j] = gsl_ran_gaussian(rng, 0.5);
+        s[j] = 0.5 + gsl_rng_uniform(rng);
+      }
+
+      vector<double> x1 = x;
+      vector<double> x2 = x;
+      scalar.latent(x1.data(), z.data(), s.data(), 0.8, n);
+      kernel.latent(x2.data(), z.data(), s.data(), 0.8, n);
+      for(size_t j=0; j<n; j++) {
+        ASSERT_EQUALS(x1[j], x2[j]);
+      }
+
+      for(bool antithetic : {false, true})
+      {
+        for(double threshold : {-1.0, 0.0, 0.5, 10.0})
+        {
+          vector<unsigned short> events1(2*n+1), events2(2*n+1);
+          vector<double> values1(2*n+1), values2(2*n+1);
+          size_t num1 = scalar.events(x1.data(), n, antithetic, threshold, events1.data(), values1.data());
+          size_t num2 = kernel.events(x1.data(), n, antithetic, threshold, events2.data(), values2.data());
+          ASSERT_EQUALS(num1, num2);
+          for(size_t k=0; k<num1; k++) {
+            ASSERT_EQUALS(events1[k], events2[k]);
+            ASSERT_EQUALS(values1[k], values2[k]);
+          }
+        }
+      }
+    }
+  }
+
+  gsl_rng_free(rng);
+}
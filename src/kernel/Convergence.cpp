@@ -0,0 +1,161 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#include <cmath>
+#include <algorithm>
+#include "kernel/Convergence.hpp"
+#include "utils/Exception.hpp"
+
+// minimum number of simulations above the VaR by batch
+#define MIN_TAIL 10
+// minimum number of simulations by batch
+#define MIN_BATCH_SIZE 1000
+// minimum number of batches to estimate the standard error
+#define MIN_BATCHES 20
+
+using namespace std;
+using namespace ccruncher;
+
+/**************************************************************************//**
+ * @param[in] level VaR confidence level.
+ * @param[in] precision Relative standard error targeted.
+ * @throw Exception Invalid level or precision.
+ */
+ccruncher::Convergence::Convergence(double level, double precision) :
+    mLevel(level), mPrecision(precision)
+{
+  if (!(0.0 < level && level < 1.0)) {
+    throw Exception("convergence level out of range (0,1)");
+  }
+  if (!(0.0 < precision)) {
+    throw Exception("convergence precision must be positive");
+  }
+  mBatchSize = static_cast<size_t>(ceil(MIN_TAIL/(1.0-level)));
+  mBatchSize = std::max(mBatchSize, static_cast<size_t>(MIN_BATCH_SIZE));
+  mBatch.reserve(mBatchSize);
+}
+
+/**************************************************************************//**
+ * @details When the current batch is completed computes its VaR, the
+ *          loss whose exceedance weight divided by the batch size is
+ *          1-level.
+ * @param[in] loss Simulated loss.
+ * @param[in] weight Likelihood ratio of the simulation.
+ * @return true=targeted precision achieved, false=otherwise.
+ */
+bool ccruncher::Convergence::append(double loss, double weight)
+{
+  mBatch.push_back(make_pair(loss, weight));
+  if (mBatch.size() < mBatchSize) return false;
+
+  sort(mBatch.begin(), mBatch.end(),
+       [](const pair<double,double> &a, const pair<double,double> &b) -> bool {
+         return a.first > b.first;
+       });
+
+  double cumprob = 0.0;
+  size_t pos = 0;
+  for(; pos+1<mBatch.size(); pos++) {
+    cumprob += mBatch[pos].second/mBatchSize;
+    if (cumprob >= 1.0-mLevel) break;
+  }
+  mVaRs.push_back(mBatch[pos].first);
+  mBatch.clear();
+
+  return isConverged();
+}
+
+/**************************************************************************//**
+ * @return Mean of the batch VaRs (NAN if no batches).
+ */
+double ccruncher::Convergence::getVaR() const
+{
+  if (mVaRs.empty()) return NAN;
+  double sum = 0.0;
+  for(double x : mVaRs) sum += x;
+  return sum/mVaRs.size();
+}
+
+/**************************************************************************//**
+ * @return Standard error of the VaR estimate (NAN if less than 2 batches).
+ */
+double ccruncher::Convergence::getStdErr() const
+{
+  size_t n = mVaRs.size();
+  if (n < 2) return NAN;
+  double mean = getVaR();
+  double sum = 0.0;
+  for(double x : mVaRs) sum += (x-mean)*(x-mean);
+  return sqrt(sum/(n-1)/n);
+}
+
+/**************************************************************************//**
+ * @return Standard error divided by the VaR (NAN if undefined).
+ */
+double ccruncher::Convergence::getRelErr() const
+{
+  double var = getVaR();
+  if (!(var > 0.0)) return NAN;
+  return getStdErr()/var;
+}
+
+/**************************************************************************//**
+ * @details The standard error is not trusted until MIN_BATCHES batches
+ *          have been completed. A null VaR never converges.
+ * @return true=targeted precision achieved, false=otherwise.
+ */
+bool ccruncher::Convergence::isConverged() const
+{
+  if (mVaRs.size() < MIN_BATCHES) return false;
+  double err = getRelErr();
+  return (!std::isnan(err) && err <= mPrecision);
+}
+
+/**************************************************************************//**
+ * @param[in,out] checkpoint Archive where the state is appended.
+ */
+void ccruncher::Convergence::save(Checkpoint &checkpoint) const
+{
+  checkpoint.put(static_cast<uint64_t>(mBatchSize));
+  checkpoint.put(mVaRs);
+  checkpoint.put(mBatch);
+}
+
+/**************************************************************************//**
+ * @details The confidence level can't change, but the precision can.
+ * @param[in,out] checkpoint Archive where the state is read from.
+ * @throw Exception Invalid state.
+ */
+void ccruncher::Convergence::restore(Checkpoint &checkpoint)
+{
+  uint64_t batchsize = 0;
+  checkpoint.get(batchsize);
+  if (batchsize != mBatchSize) {
+    throw Exception("convergence batch size mismatch");
+  }
+  checkpoint.get(mVaRs);
+  checkpoint.get(mBatch);
+  if (mBatch.size() >= mBatchSize) {
+    throw Exception("invalid convergence batch");
+  }
+  mBatch.reserve(mBatchSize);
+}
@@ -0,0 +1,90 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#pragma once
+
+#include <utility>
+#include <vector>
+#include "utils/Checkpoint.hpp"
+
+namespace ccruncher {
+
+/**************************************************************************//**
+ * @brief Batch means estimator of the VaR standard error.
+ *
+ * @details Used to stop the simulation when the VaR of a segmentation
+ *          is known with the requested precision. Simulated losses are
+ *          grouped in consecutive batches. The VaR of each batch is the
+ *          corresponding order statistic (weighted by the importance
+ *          sampling likelihood ratio, if any). The VaR estimate is the
+ *          mean of the batch VaRs, and its standard error is their
+ *          standard deviation divided by the square root of the number
+ *          of batches. The batch size is chosen so that each batch has
+ *          at least MIN_TAIL simulations above the VaR. The criterion is
+ *          only evaluated at the end of each batch, so the number of
+ *          simulations doesn't depend on the number of threads.
+ *
+ * @see Seila. A batching approach to quantile estimation in regenerative
+ *      simulations. Management Science 28(5), 1982.
+ */
+class Convergence
+{
+
+  private:
+
+    //! Confidence level
+    double mLevel;
+    //! Relative standard error targeted
+    double mPrecision;
+    //! Number of simulations by batch
+    size_t mBatchSize;
+    //! Current batch (loss, weight)
+    std::vector<std::pair<double,double>> mBatch;
+    //! VaR of completed batches
+    std::vector<double> mVaRs;
+
+  public:
+
+    //! Constructor
+    Convergence(double level, double precision);
+    //! Append a simulated loss
+    bool append(double loss, double weight=1.0);
+    //! Returns the number of simulations by batch
+    size_t getBatchSize() const { return mBatchSize; }
+    //! Returns the number of completed batches
+    size_t getNumBatches() const { return mVaRs.size(); }
+    //! Returns the VaR estimate
+    double getVaR() const;
+    //! Returns the standard error of the VaR estimate
+    double getStdErr() const;
+    //! Returns the relative standard error of the VaR estimate
+    double getRelErr() const;
+    //! Indicates if the targeted precision has been achieved
+    bool isConverged() const;
+    //! Save the estimator state
+    void save(Checkpoint &checkpoint) const;
+    //! Restore the estimator state
+    void restore(Checkpoint &checkpoint);
+
+};
+
+} // namespace
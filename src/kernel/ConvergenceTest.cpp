@@ -0,0 +1,109 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#include <cmath>
+#include "kernel/Convergence.hpp"
+#include "kernel/ConvergenceTest.hpp"
+#include "utils/Exception.hpp"
+
+using namespace std;
+using namespace ccruncher;
+
+//===========================================================================
+// test1 (uniform losses)
+//===========================================================================
+void ccruncher_test::ConvergenceTest::test1()
+{
+  Convergence convergence(0.99, 0.01);
+  ASSERT_EQUALS((size_t)1000, convergence.getBatchSize());
+  ASSERT(std::isnan(convergence.getVaR()));
+  ASSERT(std::isnan(convergence.getStdErr()));
+
+  // stratified uniform losses (all batches have the same VaR)
+  size_t num = 0;
+  bool converged = false;
+  while(!converged && num < 100000) {
+    double u = ((num*7919)%1000 + 0.5)/1000.0;
+    converged = convergence.append(u);
+    num++;
+  }
+
+  ASSERT(converged);
+  ASSERT(convergence.isConverged());
+  ASSERT_EQUALS((size_t)20000, num);
+  ASSERT_EQUALS((size_t)20, convergence.getNumBatches());
+  ASSERT_EQUALS_EPSILON(0.99, convergence.getVaR(), 0.001);
+  ASSERT_EQUALS_EPSILON(0.0, convergence.getStdErr(), 1e-12);
+}
+
+//===========================================================================
+// test2 (batch size and unreachable precision)
+//===========================================================================
+void ccruncher_test::ConvergenceTest::test2()
+{
+  ASSERT_THROW(Convergence(0.0, 0.01));
+  ASSERT_THROW(Convergence(1.0, 0.01));
+  ASSERT_THROW(Convergence(0.99, 0.0));
+
+  Convergence convergence(0.999, 1e-6);
+  ASSERT_EQUALS((size_t)10000, convergence.getBatchSize());
+
+  // pseudo-random losses (lcg)
+  unsigned long x = 1;
+  for(size_t i=0; i<30*convergence.getBatchSize(); i++) {
+    x = (x*6364136223846793005UL + 1442695040888963407UL);
+    double u = (x >> 11)*(1.0/9007199254740992.0);
+    ASSERT(!convergence.append(-log(1.0-u)));
+  }
+
+  // exponential distribution VaR = -log(1-level)
+  ASSERT_EQUALS((size_t)30, convergence.getNumBatches());
+  ASSERT_EQUALS_EPSILON(-log(0.001), convergence.getVaR(), 0.3);
+  ASSERT(convergence.getStdErr() > 0.0);
+  ASSERT(convergence.getRelErr() < 0.05);
+  ASSERT(!convergence.isConverged());
+}
+
+//===========================================================================
+// test3 (weighted losses and null VaR)
+//===========================================================================
+void ccruncher_test::ConvergenceTest::test3()
+{
+  // 1% of simulations with loss 1 and weight 0.5 -> exceedance 0.5%
+  Convergence convergence1(0.99, 0.01);
+  for(size_t i=0; i<20000; i++) {
+    if (i%100 == 0) convergence1.append(1.0, 0.5);
+    else convergence1.append(0.0, 1.0);
+  }
+  ASSERT_EQUALS_EPSILON(0.0, convergence1.getVaR(), 1e-12);
+  ASSERT(!convergence1.isConverged());
+
+  // same simulations weighted by 2 -> exceedance 2%
+  Convergence convergence2(0.99, 0.01);
+  bool converged = false;
+  for(size_t i=0; i<20000; i++) {
+    if (i%100 == 0) converged = convergence2.append(1.0, 2.0);
+    else converged = convergence2.append(0.0, 1.0);
+  }
+  ASSERT_EQUALS_EPSILON(1.0, convergence2.getVaR(), 1e-12);
+  ASSERT(converged);
+}
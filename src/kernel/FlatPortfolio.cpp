@@ -0,0 +1,415 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#include <map>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <cstring>
+#include <cassert>
+#include "kernel/FlatPortfolio.hpp"
+#include "utils/Exception.hpp"
+
+// maximum loss tables entries by date-values and segmentation
+#define LOSS_TABLES_RATIO 16
+
+using namespace std;
+using namespace ccruncher;
+
+/**************************************************************************//**
+ * @details Encodes the obligor's attributes that determine its default
+ *          time distribution and its losses. Two obligors with the same
+ *          profile are exchangeable. Values are encoded bitwise, so NaN
+ *          values (eg. non-defined lgd) are compared properly.
+ * @param[in] obligor Obligor.
+ * @return Obligor profile.
+ */
+vector<uint64_t> ccruncher::FlatPortfolio::getProfile(const Obligor &obligor)
+{
+  vector<uint64_t> ret;
+  auto add = [&ret](double x) {
+    uint64_t bits = 0;
+    memcpy(&bits, &x, sizeof(double));
+    ret.push_back(bits);
+  };
+
+  ret.push_back(obligor.ifactor);
+  ret.push_back(obligor.irating);
+  ret.push_back(static_cast<uint64_t>(obligor.lgd.getType()));
+  add(obligor.lgd.getValue1());
+  add(obligor.lgd.getValue2());
+  ret.push_back(obligor.assets.size());
+  for(const Asset &asset : obligor.assets) {
+    ret.insert(ret.end(), asset.segments.begin(), asset.segments.end());
+    ret.push_back(asset.values.size());
+    for(const DateValues &value : asset.values) {
+      ret.push_back(static_cast<uint64_t>(value.date - Date()));
+      ret.push_back(static_cast<uint64_t>(value.ead.getType()));
+      add(value.ead.getValue1());
+      add(value.ead.getValue2());
+      ret.push_back(static_cast<uint64_t>(value.lgd.getType()));
+      add(value.lgd.getValue1());
+      add(value.lgd.getValue2());
+    }
+  }
+  return ret;
+}
+
+/**************************************************************************//**
+ * @details Obligors order is preserved. Segment indexes are converted
+ *          to column indexes in the losses row, where segmentations are
+ *          placed consecutively. When minPoolSize > 1, obligors having
+ *          the same profile are collapsed into a single obligor (the
+ *          first one) if there are at least minPoolSize of them.
+ * @param[in] obligors List of obligors (validated).
+ * @param[in] numSegmentsBySegmentation Number of segments of each segmentation.
+ * @param[in] minPoolSize Minimum pool size (0 or 1 = pools disabled).
+ * @throw Exception Portfolio too large.
+ */
+void ccruncher::FlatPortfolio::init(const std::vector<Obligor> &obligors,
+    const std::vector<unsigned short> &numSegmentsBySegmentation, size_t minPoolSize)
+{
+  clear();
+
+  numsegmentations = numSegmentsBySegmentation.size();
+
+  if (obligors.size() >= numeric_limits<uint32_t>::max()) {
+    throw Exception("portfolio too large");
+  }
+
+  // grouping obligors by profile (first = representative obligor)
+  vector<uint32_t> first(obligors.size(), 0);
+  vector<uint32_t> counts(obligors.size(), 0);
+  if (minPoolSize > 1) {
+    map<vector<uint64_t>,uint32_t> profiles;
+    for(size_t i=0; i<obligors.size(); i++) {
+      auto it = profiles.emplace(getProfile(obligors[i]), static_cast<uint32_t>(i)).first;
+      first[i] = it->second;
+      counts[it->second]++;
+    }
+  }
+  else {
+    for(size_t i=0; i<obligors.size(); i++) {
+      first[i] = static_cast<uint32_t>(i);
+      counts[i] = 1;
+    }
+  }
+
+  size_t numassets = 0;
+  size_t numvalues = 0;
+  for(const Obligor &obligor : obligors) {
+    numassets += obligor.assets.size();
+    for(const Asset &asset : obligor.assets) {
+      numvalues += asset.values.size();
+    }
+  }
+
+  if (numassets >= numeric_limits<uint32_t>::max() ||
+      numvalues >= numeric_limits<uint32_t>::max() ||
+      numassets*numsegmentations >= numeric_limits<uint32_t>::max()) {
+    throw Exception("portfolio too large");
+  }
+
+  // first column of each segmentation
+  vector<uint32_t> offsets(numsegmentations, 0);
+  for(size_t i=1; i<numsegmentations; i++) {
+    offsets[i] = offsets[i-1] + numSegmentsBySegmentation[i-1];
+  }
+
+  ifactors.reserve(obligors.size());
+  iratings.reserve(obligors.size());
+  obligorLgds.reserve(obligors.size());
+  poolSizes.reserve(obligors.size());
+  assetOffsets.reserve(obligors.size()+1);
+  valueOffsets.reserve(numassets+1);
+  columns.reserve(numassets*numsegmentations);
+  dates.reserve(numvalues);
+  eads.reserve(numvalues);
+  lgds.reserve(numvalues);
+
+  assetOffsets.push_back(0);
+  valueOffsets.push_back(0);
+
+  for(size_t iobligor=0; iobligor<obligors.size(); iobligor++)
+  {
+    const Obligor &obligor = obligors[iobligor];
+    uint32_t poolsize = counts[first[iobligor]];
+
+    if (poolsize < minPoolSize) {
+      poolsize = 1;
+    }
+    else if (first[iobligor] != iobligor) {
+      continue; // included in a pool
+    }
+
+    ifactors.push_back(obligor.ifactor);
+    iratings.push_back(obligor.irating);
+    obligorLgds.push_back(obligor.lgd);
+    poolSizes.push_back(poolsize);
+
+    for(const Asset &asset : obligor.assets)
+    {
+      assert(!asset.values.empty());
+      assert(asset.segments.size() == numsegmentations);
+
+      for(size_t i=0; i<numsegmentations; i++) {
+        assert(asset.segments[i] < numSegmentsBySegmentation[i]);
+        columns.push_back(offsets[i] + asset.segments[i]);
+      }
+
+      for(const DateValues &value : asset.values) {
+        dates.push_back(value.date);
+        eads.push_back(value.ead);
+        lgds.push_back(value.lgd);
+      }
+
+      valueOffsets.push_back(static_cast<uint32_t>(dates.size()));
+    }
+
+    assetOffsets.push_back(static_cast<uint32_t>(valueOffsets.size()-1));
+  }
+
+  initHierarchy(numSegmentsBySegmentation, offsets);
+  initLosses();
+}
+
+/**************************************************************************//**
+ * @details A segmentation is derived from another one (the base) when the
+ *          segment of each asset in the derived segmentation is a function
+ *          of its segment in the base segmentation (eg. region derived
+ *          from country, or the single-segment portfolio derived from
+ *          anything). Segmentations are checked from finer to coarser
+ *          (ties by index) against the base segmentations found so far.
+ *          The losses of a derived segmentation are obtained from the
+ *          base losses, adding row[reduceSources[k]] to
+ *          row[reduceTargets[k]]. Base segments without assets are not
+ *          reduced (their loss is always 0).
+ * @param[in] numSegmentsBySegmentation Number of segments of each segmentation.
+ * @param[in] offsets First column of each segmentation.
+ */
+void ccruncher::FlatPortfolio::initHierarchy(const std::vector<unsigned short> &numSegmentsBySegmentation,
+    const std::vector<uint32_t> &offsets)
+{
+  size_t numassets = getNumAssets();
+  assert(columns.size() == numassets*numsegmentations);
+
+  // segmentations from finer to coarser
+  vector<size_t> order(numsegmentations, 0);
+  for(size_t i=0; i<numsegmentations; i++) order[i] = i;
+  stable_sort(order.begin(), order.end(), [&numSegmentsBySegmentation](size_t a, size_t b) {
+    return numSegmentsBySegmentation[a] > numSegmentsBySegmentation[b];
+  });
+
+  vector<int> segments;
+  for(size_t iderived : order)
+  {
+    bool derived = false;
+
+    for(size_t ibase : baseSegmentations)
+    {
+      // segment in the derived segmentation of each base segment (-1 = unused)
+      segments.assign(numSegmentsBySegmentation[ibase], -1);
+      derived = true;
+      for(size_t iasset=0; iasset<numassets && derived; iasset++) {
+        uint32_t sbase = columns[iasset*numsegmentations+ibase] - offsets[ibase];
+        int sderived = static_cast<int>(columns[iasset*numsegmentations+iderived] - offsets[iderived]);
+        if (segments[sbase] < 0) segments[sbase] = sderived;
+        else if (segments[sbase] != sderived) derived = false;
+      }
+
+      if (derived) {
+        for(size_t i=0; i<segments.size(); i++) {
+          if (segments[i] < 0) continue;
+          reduceSources.push_back(offsets[ibase] + static_cast<uint32_t>(i));
+          reduceTargets.push_back(offsets[iderived] + static_cast<uint32_t>(segments[i]));
+        }
+        break;
+      }
+    }
+
+    if (!derived) {
+      baseSegmentations.push_back(static_cast<uint32_t>(iderived));
+    }
+  }
+
+  // assets losses are scattered in segmentations order
+  sort(baseSegmentations.begin(), baseSegmentations.end());
+}
+
+/**************************************************************************//**
+ * @details Checks if all the exposures and losses given default are fixed
+ *          values. Non-defined asset lgds are replaced by the obligor's
+ *          lgd. In this case the loss of each date-values is computed
+ *          once, ead·lgd. Otherwise losses is left empty. Values kind is
+ *          set to random until the loss tables are created.
+ */
+void ccruncher::FlatPortfolio::initLosses()
+{
+  mValuesKind = ValuesKind::Random;
+  losses.resize(eads.size(), 0.0);
+
+  for(size_t iobligor=0; iobligor<size(); iobligor++)
+  {
+    for(size_t iasset=assetOffsets[iobligor]; iasset<assetOffsets[iobligor+1]; iasset++)
+    {
+      for(size_t ivalue=valueOffsets[iasset]; ivalue<valueOffsets[iasset+1]; ivalue++)
+      {
+        const EAD &ead = eads[ivalue];
+        const LGD &lgd = (std::isnan(lgds[ivalue].getValue1()) ? obligorLgds[iobligor] : lgds[ivalue]);
+
+        if (ead.getType() != EAD::Type::Fixed || lgd.getType() != LGD::Type::Fixed ||
+            std::isnan(lgd.getValue1())) {
+          vector<double>().swap(losses);
+          return;
+        }
+
+        losses[ivalue] = ead.getValue1() * lgd.getValue1();
+      }
+    }
+  }
+}
+
+/**************************************************************************//**
+ * @details Compiles the precomputed losses of each obligor into a step
+ *          function of the default day. Step limits are the obligor's
+ *          date-values dates up to the first one not before timeT.
+ *          Assets are evaluated at the step last day like the generic
+ *          kernel does (first date-values not before the default date),
+ *          and its non-zero losses are stored in asset and segmentation
+ *          order (base segmentations only), so aggregated losses are
+ *          identical to the generic kernel. Tables are not created if some value is not fixed or
+ *          they are too large (more than LOSS_TABLES_RATIO entries per
+ *          date-values and segmentation). If created, values kind is
+ *          set to fixed.
+ * @param[in] time0 Starting simulation date.
+ * @param[in] timeT Ending simulation date.
+ * @return true if tables were created, false otherwise.
+ */
+bool ccruncher::FlatPortfolio::initLossTables(const Date &time0, const Date &timeT)
+{
+  clearLossTables();
+
+  if (losses.size() != eads.size()) {
+    return false;
+  }
+
+  long horizon = timeT - time0;
+  size_t maxentries = LOSS_TABLES_RATIO*std::max(dates.size(),(size_t)1)*std::max(numsegmentations,(size_t)1);
+  vector<long> days;
+
+  stepOffsets.push_back(0);
+  entryOffsets.push_back(0);
+
+  for(size_t iobligor=0; iobligor<size(); iobligor++)
+  {
+    // step limits (sorted obligor dates up to the first one >= horizon)
+    days.clear();
+    for(size_t ivalue=valueOffsets[assetOffsets[iobligor]]; ivalue<valueOffsets[assetOffsets[iobligor+1]]; ivalue++) {
+      days.push_back(dates[ivalue] - time0);
+    }
+    sort(days.begin(), days.end());
+    days.erase(unique(days.begin(), days.end()), days.end());
+    auto last = lower_bound(days.begin(), days.end(), horizon);
+    if (last != days.end()) ++last;
+    days.erase(last, days.end());
+
+    for(long day : days)
+    {
+      Date date = time0 + day;
+
+      for(size_t iasset=assetOffsets[iobligor]; iasset<assetOffsets[iobligor+1]; iasset++)
+      {
+        const Date *first = dates.data() + valueOffsets[iasset];
+        const Date *end = dates.data() + valueOffsets[iasset+1];
+        if (*(end-1) < date) continue;
+
+        size_t ivalue = lower_bound(first, end, date) - dates.data();
+        if (losses[ivalue] == 0.0) continue;
+
+        for(uint32_t i : baseSegmentations) {
+          entryColumns.push_back(columns[iasset*numsegmentations+i]);
+          entryLosses.push_back(losses[ivalue]);
+        }
+      }
+
+      if (entryLosses.size() > maxentries) {
+        // too large, generic kernel is used
+        clearLossTables();
+        return false;
+      }
+
+      assert(numeric_limits<int32_t>::min() <= day && day <= numeric_limits<int32_t>::max());
+      stepDays.push_back(static_cast<int32_t>(day));
+      entryOffsets.push_back(static_cast<uint32_t>(entryLosses.size()));
+    }
+
+    stepOffsets.push_back(static_cast<uint32_t>(stepDays.size()));
+  }
+
+  mValuesKind = ValuesKind::Fixed;
+  return true;
+}
+
+/**************************************************************************//**
+ * @details Deallocates the loss tables and sets values kind to random.
+ */
+void ccruncher::FlatPortfolio::clearLossTables()
+{
+  vector<uint32_t>().swap(stepOffsets);
+  vector<int32_t>().swap(stepDays);
+  vector<uint32_t>().swap(entryOffsets);
+  vector<uint32_t>().swap(entryColumns);
+  vector<double>().swap(entryLosses);
+  mValuesKind = ValuesKind::Random;
+}
+
+/**************************************************************************/
+void ccruncher::FlatPortfolio::clear()
+{
+  // swap trick to release memory
+  vector<unsigned char>().swap(ifactors);
+  vector<unsigned char>().swap(iratings);
+  vector<LGD>().swap(obligorLgds);
+  vector<uint32_t>().swap(poolSizes);
+  vector<uint32_t>().swap(assetOffsets);
+  vector<uint32_t>().swap(valueOffsets);
+  vector<uint32_t>().swap(columns);
+  vector<Date>().swap(dates);
+  vector<EAD>().swap(eads);
+  vector<LGD>().swap(lgds);
+  vector<double>().swap(losses);
+  vector<uint32_t>().swap(baseSegmentations);
+  vector<uint32_t>().swap(reduceSources);
+  vector<uint32_t>().swap(reduceTargets);
+  clearLossTables();
+  numsegmentations = 0;
+}
+
+/**************************************************************************/
+size_t ccruncher::FlatPortfolio::getNumPools() const
+{
+  size_t ret = 0;
+  for(uint32_t num : poolSizes) {
+    if (num > 1) ret++;
+  }
+  return ret;
+}
@@ -0,0 +1,164 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include "portfolio/Obligor.hpp"
+#include "portfolio/EAD.hpp"
+#include "portfolio/LGD.hpp"
+#include "utils/Date.hpp"
+
+namespace ccruncher {
+
+/**************************************************************************//**
+ * @brief Portfolio compiled to contiguous arrays.
+ *
+ * @details Obligors, assets and date-values are stored in flat arrays
+ *          (structure of arrays) linked by offsets (CSR style). The
+ *          assets of the i-th obligor are [assetOffsets[i],
+ *          assetOffsets[i+1]), and the date-values of the k-th asset
+ *          are [valueOffsets[k], valueOffsets[k+1]). Asset segments are
+ *          stored as column indexes of the simulated losses row (see
+ *          MonteCarlo::append()). This layout avoids the pointer chasing
+ *          of the nested vectors in the simulation kernel.
+ *          Optionally, obligors with identical profile (factor, rating,
+ *          lgd, assets, segments and values) are collapsed into a pool
+ *          represented by its first obligor. Pool sizes are stored in
+ *          poolSizes (1 = single obligor).
+ *          Segmentations that are a coarsening of another one (the
+ *          segment of each asset is a function of its segment in the
+ *          other) are derived. Asset losses are only added to the base
+ *          segmentations, and derived losses are reduced from the base
+ *          losses once per simulation (see initHierarchy()).
+ *          When all exposures and losses given default are fixed values
+ *          (lgd inheritance included), the date-values losses (ead·lgd)
+ *          are precomputed. Then, initLossTables() compiles the losses
+ *          of each obligor into a step function of the default day
+ *          (days from time0): the k-th step covers the days in
+ *          (stepDays[k-1], stepDays[k]] and its losses are the entries
+ *          [entryOffsets[k], entryOffsets[k+1]), already scattered to
+ *          the losses row columns. The steps of the i-th obligor are
+ *          [stepOffsets[i], stepOffsets[i+1]). The simulation kernel
+ *          specialized for fixed values uses these tables (see
+ *          getValuesKind()).
+ *
+ * @see SimulationThread
+ */
+class FlatPortfolio
+{
+
+  public:
+
+    //! Kinds of date-values (selects the simulation kernel)
+    enum class ValuesKind
+    {
+      Fixed=0, //!< All eads and lgds are fixed (see loss tables)
+      Random=1 //!< Some ead or lgd is a distribution
+    };
+
+  public:
+
+    //! Obligors' factor index
+    std::vector<unsigned char> ifactors;
+    //! Obligors' rating index
+    std::vector<unsigned char> iratings;
+    //! Obligors' lgd
+    std::vector<LGD> obligorLgds;
+    //! Number of obligors represented by each obligor (pool size)
+    std::vector<uint32_t> poolSizes;
+    //! First asset of each obligor (numobligors+1 values)
+    std::vector<uint32_t> assetOffsets;
+    //! First date-values of each asset (numassets+1 values)
+    std::vector<uint32_t> valueOffsets;
+    //! Losses columns of each asset (numsegmentations values per asset)
+    std::vector<uint32_t> columns;
+    //! Base segmentations indexes (not derived from another one)
+    std::vector<uint32_t> baseSegmentations;
+    //! Derived segmentations reduction, source columns
+    std::vector<uint32_t> reduceSources;
+    //! Derived segmentations reduction, target columns
+    std::vector<uint32_t> reduceTargets;
+    //! Date-values dates
+    std::vector<Date> dates;
+    //! Date-values exposures
+    std::vector<EAD> eads;
+    //! Date-values losses given default
+    std::vector<LGD> lgds;
+    //! Date-values losses, ead·lgd (empty if some value is not fixed)
+    std::vector<double> losses;
+    //! First loss step of each obligor (numobligors+1 values)
+    std::vector<uint32_t> stepOffsets;
+    //! Loss steps last day (days from time0)
+    std::vector<int32_t> stepDays;
+    //! First loss entry of each step (numsteps+1 values)
+    std::vector<uint32_t> entryOffsets;
+    //! Loss entries column
+    std::vector<uint32_t> entryColumns;
+    //! Loss entries value
+    std::vector<double> entryLosses;
+
+  private:
+
+    //! Number of segmentations
+    size_t numsegmentations;
+    //! Kind of date-values
+    ValuesKind mValuesKind;
+
+  private:
+
+    //! Obligor profile (identical profiles can be pooled)
+    static std::vector<uint64_t> getProfile(const Obligor &obligor);
+    //! Detects the derived segmentations
+    void initHierarchy(const std::vector<unsigned short> &numSegmentsBySegmentation,
+                       const std::vector<uint32_t> &offsets);
+    //! Precomputes the losses if all values are fixed
+    void initLosses();
+    //! Deallocate loss tables
+    void clearLossTables();
+
+  public:
+
+    //! Constructor
+    FlatPortfolio() : numsegmentations(0), mValuesKind(ValuesKind::Random) {}
+    //! Compile the given obligors
+    void init(const std::vector<Obligor> &obligors, const std::vector<unsigned short> &numSegmentsBySegmentation,
+              size_t minPoolSize=0);
+    //! Compile the fixed losses into day-indexed tables
+    bool initLossTables(const Date &time0, const Date &timeT);
+    //! Deallocate memory
+    void clear();
+    //! Number of obligors
+    size_t size() const { return ifactors.size(); }
+    //! Number of assets
+    size_t getNumAssets() const { return valueOffsets.empty()?0:valueOffsets.size()-1; }
+    //! Number of segmentations
+    size_t getNumSegmentations() const { return numsegmentations; }
+    //! Number of pools (obligors with pool size > 1)
+    size_t getNumPools() const;
+    //! Kind of date-values
+    ValuesKind getValuesKind() const { return mValuesKind; }
+
+};
+
+} // namespace
@@ -0,0 +1,256 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#include <vector>
+#include "kernel/FlatPortfolio.hpp"
+#include "kernel/FlatPortfolioTest.hpp"
+
+using namespace std;
+using namespace ccruncher;
+
+//===========================================================================
+// test1
+//===========================================================================
+void ccruncher_test::FlatPortfolioTest::test1()
+{
+  // 2 segmentations with 3 and 2 segments
+  vector<unsigned short> numSegmentsBySegmentation = { 3, 2 };
+  vector<Obligor> obligors;
+
+  // obligor with 2 assets
+  obligors.push_back(Obligor(1, 2));
+  obligors.back().lgd = LGD(0.5);
+  obligors.back().assets.push_back(Asset(vector<unsigned short>{2, 1}));
+  obligors.back().assets.back().values.push_back(DateValues(Date("01/01/2014"), 0.0, 0.0));
+  obligors.back().assets.back().values.push_back(DateValues(Date("01/07/2014"), 100.0, 0.9));
+  obligors.back().assets.push_back(Asset(vector<unsigned short>{0, 0}));
+  obligors.back().assets.back().values.push_back(DateValues(Date("01/01/2015"), 200.0, LGD()));
+
+  // obligor with 1 asset
+  obligors.push_back(Obligor(0, 3));
+  obligors.back().assets.push_back(Asset(vector<unsigned short>{1, 1}));
+  obligors.back().assets.back().values.push_back(DateValues(Date("01/01/2016"), 300.0, 0.7));
+
+  FlatPortfolio portfolio;
+  portfolio.init(obligors, numSegmentsBySegmentation);
+
+  ASSERT_EQUALS((size_t)2, portfolio.size());
+  ASSERT_EQUALS((size_t)3, portfolio.getNumAssets());
+  ASSERT_EQUALS((size_t)2, portfolio.getNumSegmentations());
+
+  ASSERT_EQUALS(1, (int)portfolio.ifactors[0]);
+  ASSERT_EQUALS(2, (int)portfolio.iratings[0]);
+  ASSERT_EQUALS(0, (int)portfolio.ifactors[1]);
+  ASSERT_EQUALS(3, (int)portfolio.iratings[1]);
+  ASSERT(portfolio.obligorLgds[0] == LGD(0.5));
+
+  vector<uint32_t> assetOffsets = { 0, 2, 3 };
+  ASSERT(portfolio.assetOffsets == assetOffsets);
+  vector<uint32_t> valueOffsets = { 0, 2, 3, 4 };
+  ASSERT(portfolio.valueOffsets == valueOffsets);
+
+  // columns = segmentation offset + segment index
+  vector<uint32_t> columns = { 2, 4, 0, 3, 1, 4 };
+  ASSERT(portfolio.columns == columns);
+
+  ASSERT(portfolio.dates[1] == Date("01/07/2014"));
+  ASSERT(portfolio.dates[3] == Date("01/01/2016"));
+  ASSERT_EQUALS_EPSILON(200.0, portfolio.eads[2].getValue(), 1e-12);
+  ASSERT(std::isnan(portfolio.lgds[2].getValue()));
+  ASSERT_EQUALS_EPSILON(0.7, portfolio.lgds[3].getValue(), 1e-12);
+
+  portfolio.clear();
+  ASSERT_EQUALS((size_t)0, portfolio.size());
+  ASSERT_EQUALS((size_t)0, portfolio.getNumAssets());
+}
+
+//===========================================================================
+// test2. empty portfolio
+//===========================================================================
+void ccruncher_test::FlatPortfolioTest::test2()
+{
+  vector<unsigned short> numSegmentsBySegmentation = { 1 };
+  vector<Obligor> obligors;
+
+  FlatPortfolio portfolio;
+  portfolio.init(obligors, numSegmentsBySegmentation);
+  ASSERT_EQUALS((size_t)0, portfolio.size());
+  ASSERT_EQUALS((size_t)0, portfolio.getNumAssets());
+  ASSERT_EQUALS((size_t)1, portfolio.assetOffsets.size());
+}
+
+//===========================================================================
+// test3. obligor pools
+//===========================================================================
+void ccruncher_test::FlatPortfolioTest::test3()
+{
+  vector<unsigned short> numSegmentsBySegmentation = { 2 };
+  vector<Obligor> obligors;
+
+  // 3 identical obligors (0, 2, 4), 2 identical obligors (1, 3) and obligor 5
+  for(int i=0; i<6; i++) {
+    bool odd = (i%2 == 1);
+    obligors.push_back(Obligor(0, (odd?1:0)));
+    obligors.back().assets.push_back(Asset(vector<unsigned short>{(unsigned short)(odd?1:0)}));
+    obligors.back().assets.back().values.push_back(DateValues(Date("01/01/2015"), 10.0, LGD()));
+  }
+  obligors.back().lgd = LGD(0.5);
+
+  FlatPortfolio portfolio;
+
+  // pools disabled
+  portfolio.init(obligors, numSegmentsBySegmentation);
+  ASSERT_EQUALS((size_t)6, portfolio.size());
+  ASSERT_EQUALS((size_t)0, portfolio.getNumPools());
+
+  // pools with 3 or more obligors
+  portfolio.init(obligors, numSegmentsBySegmentation, 3);
+  ASSERT_EQUALS((size_t)4, portfolio.size());
+  ASSERT_EQUALS((size_t)4, portfolio.getNumAssets());
+  ASSERT_EQUALS((size_t)1, portfolio.getNumPools());
+  vector<uint32_t> poolSizes = { 3, 1, 1, 1 };
+  ASSERT(portfolio.poolSizes == poolSizes);
+  vector<unsigned char> iratings = { 0, 1, 1, 1 };
+  ASSERT(portfolio.iratings == iratings);
+  ASSERT(portfolio.obligorLgds[3] == LGD(0.5));
+
+  // pools with 2 or more obligors
+  portfolio.init(obligors, numSegmentsBySegmentation, 2);
+  ASSERT_EQUALS((size_t)3, portfolio.size());
+  ASSERT_EQUALS((size_t)2, portfolio.getNumPools());
+  poolSizes = { 3, 2, 1 };
+  ASSERT(portfolio.poolSizes == poolSizes);
+  vector<uint32_t> columns = { 0, 1, 1 };
+  ASSERT(portfolio.columns == columns);
+}
+
+//===========================================================================
+// test4. values kind and loss tables
+//===========================================================================
+void ccruncher_test::FlatPortfolioTest::test4()
+{
+  vector<unsigned short> numSegmentsBySegmentation = { 1, 2 };
+  vector<Obligor> obligors;
+  Date time0("01/01/2015");
+  Date timeT("01/01/2017");
+
+  // fixed values (asset2 inherits obligor lgd)
+  obligors.push_back(Obligor(0, 0));
+  obligors.back().lgd = LGD(0.5);
+  obligors.back().assets.push_back(Asset(vector<unsigned short>{0, 1}));
+  obligors.back().assets.back().values.push_back(DateValues(Date("11/01/2015"), 100.0, 0.2));
+  obligors.back().assets.back().values.push_back(DateValues(Date("21/01/2015"), 0.0, 0.2));
+  obligors.back().assets.back().values.push_back(DateValues(Date("31/01/2015"), 50.0, 0.2));
+  obligors.back().assets.push_back(Asset(vector<unsigned short>{0, 0}));
+  obligors.back().assets.back().values.push_back(DateValues(Date("21/01/2015"), 200.0, LGD()));
+  obligors.back().assets.back().values.push_back(DateValues(Date("01/01/2020"), 300.0, LGD()));
+  obligors.back().assets.back().values.push_back(DateValues(Date("01/01/2021"), 400.0, LGD()));
+
+  FlatPortfolio portfolio;
+  portfolio.init(obligors, numSegmentsBySegmentation);
+  ASSERT(portfolio.getValuesKind() == FlatPortfolio::ValuesKind::Random);
+  ASSERT_EQUALS((size_t)6, portfolio.losses.size());
+  ASSERT_EQUALS_EPSILON(20.0, portfolio.losses[0], 1e-12);
+  ASSERT_EQUALS_EPSILON(100.0, portfolio.losses[3], 1e-12);
+
+  ASSERT(portfolio.initLossTables(time0, timeT));
+  ASSERT(portfolio.getValuesKind() == FlatPortfolio::ValuesKind::Fixed);
+
+  // steps: day 10, 20, 30 and first date after timeT
+  vector<uint32_t> stepOffsets = { 0, 4 };
+  ASSERT(portfolio.stepOffsets == stepOffsets);
+  vector<int32_t> stepDays = { 10, 20, 30, static_cast<int32_t>(Date("01/01/2020")-time0) };
+  ASSERT(portfolio.stepDays == stepDays);
+
+  // zero losses are not stored, first segmentation is derived
+  vector<uint32_t> entryOffsets = { 0, 2, 3, 5, 6 };
+  ASSERT(portfolio.entryOffsets == entryOffsets);
+  vector<uint32_t> entryColumns = { 2, 1, 1, 2, 1, 1 };
+  ASSERT(portfolio.entryColumns == entryColumns);
+  vector<double> entryLosses = { 20.0, 100.0, 100.0, 10.0, 150.0, 150.0 };
+  ASSERT_EQUALS(entryLosses.size(), portfolio.entryLosses.size());
+  for(size_t i=0; i<entryLosses.size(); i++) {
+    ASSERT_EQUALS_EPSILON(entryLosses[i], portfolio.entryLosses[i], 1e-12);
+  }
+
+  // inherited random lgd
+  obligors.back().lgd = LGD(LGD::Type::Beta, 2.0, 5.0);
+  portfolio.init(obligors, numSegmentsBySegmentation);
+  ASSERT(portfolio.losses.empty());
+  ASSERT(!portfolio.initLossTables(time0, timeT));
+  ASSERT(portfolio.getValuesKind() == FlatPortfolio::ValuesKind::Random);
+  ASSERT(portfolio.stepOffsets.empty());
+
+  // random ead
+  obligors.back().lgd = LGD(0.5);
+  obligors.back().assets.back().values.back().ead = EAD(EAD::Type::Uniform, 100.0, 200.0);
+  portfolio.init(obligors, numSegmentsBySegmentation);
+  ASSERT(portfolio.losses.empty());
+  ASSERT(!portfolio.initLossTables(time0, timeT));
+  ASSERT(portfolio.getValuesKind() == FlatPortfolio::ValuesKind::Random);
+}
+
+//===========================================================================
+// test5. derived segmentations
+//===========================================================================
+void ccruncher_test::FlatPortfolioTest::test5()
+{
+  // portfolio (1 segment), country (4), region (2), sector (3), country (4)
+  vector<unsigned short> numSegmentsBySegmentation = { 1, 4, 2, 3, 4 };
+  vector<Obligor> obligors;
+  vector<vector<unsigned short>> segments = {
+    { 0, 0, 0, 2, 0 },
+    { 0, 1, 0, 1, 1 },
+    { 0, 3, 1, 1, 3 },
+    { 0, 0, 0, 0, 0 }
+  };
+
+  for(size_t i=0; i<segments.size(); i++) {
+    obligors.push_back(Obligor(0, 0));
+    obligors.back().assets.push_back(Asset(segments[i]));
+    obligors.back().assets.back().values.push_back(DateValues(Date("01/01/2015"), 10.0, 0.5));
+  }
+
+  FlatPortfolio portfolio;
+  portfolio.init(obligors, numSegmentsBySegmentation);
+
+  // first country and sector are base segmentations (country 2 is unused)
+  vector<uint32_t> baseSegmentations = { 1, 3 };
+  ASSERT(portfolio.baseSegmentations == baseSegmentations);
+
+  // columns: portfolio 0, country 1-4, region 5-6, sector 7-9, country 10-13
+  vector<uint32_t> reduceSources = { 1, 2, 4, 1, 2, 4, 1, 2, 4 };
+  vector<uint32_t> reduceTargets = { 10, 11, 13, 5, 5, 6, 0, 0, 0 };
+  ASSERT(portfolio.reduceSources == reduceSources);
+  ASSERT(portfolio.reduceTargets == reduceTargets);
+
+  // sector becomes derived if it is a function of country
+  obligors[3].assets[0].segments[3] = 2;
+  portfolio.init(obligors, numSegmentsBySegmentation);
+  baseSegmentations = { 1 };
+  ASSERT(portfolio.baseSegmentations == baseSegmentations);
+  ASSERT_EQUALS((size_t)12, portfolio.reduceSources.size());
+
+  portfolio.clear();
+  ASSERT(portfolio.baseSegmentations.empty());
+  ASSERT(portfolio.reduceSources.empty());
+}
@@ -0,0 +1,179 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#include <cstdio>
+#include <algorithm>
+#include <fstream>
+#include "kernel/Instrumentation.hpp"
+#include "utils/Exception.hpp"
+
+using namespace std;
+using namespace ccruncher;
+
+/**************************************************************************/
+ccruncher::Instrumentation::Instrumentation() : mNumThreads(1), mElapsed(0.0)
+{
+  mNanos.fill(0);
+  mCounters.fill(0);
+  mLast = chrono::steady_clock::now();
+}
+
+/**************************************************************************//**
+ * @param[in] other Object to add (eg. another thread timers).
+ */
+void ccruncher::Instrumentation::merge(const Instrumentation &other)
+{
+  for(size_t i=0; i<mNanos.size(); i++) {
+    mNanos[i] += other.mNanos[i];
+  }
+  for(size_t i=0; i<mCounters.size(); i++) {
+    mCounters[i] += other.mCounters[i];
+  }
+}
+
+/**************************************************************************//**
+ * @details Used to compute the fraction of time spent in each phase.
+ * @param[in] numthreads Number of simulation threads.
+ * @param[in] elapsed Run elapsed time (in seconds).
+ */
+void ccruncher::Instrumentation::setRun(size_t numthreads, double elapsed)
+{
+  mNumThreads = std::max(numthreads, size_t(1));
+  mElapsed = elapsed;
+}
+
+/**************************************************************************//**
+ * @details Phases of the simulation threads are summed over threads
+ *          (thread-seconds).
+ * @param[in] phase Phase.
+ * @return Elapsed time in seconds.
+ */
+double ccruncher::Instrumentation::getSeconds(Phase phase) const
+{
+  return mNanos[static_cast<size_t>(phase)]*1e-9;
+}
+
+/**************************************************************************//**
+ * @details Prints the time of each phase and its percentage respect to
+ *          the available time (elapsed time multiplied by the number of
+ *          threads in simulation threads phases).
+ * @param[in] logger Trace where the report is written.
+ */
+void ccruncher::Instrumentation::print(Logger &logger) const
+{
+  logger << "instrumentation" << flood('*') << endl;
+  logger << indent(+1);
+  logger << "elapsed time (seconds)" << split << mElapsed << endl;
+  logger << "number of threads" << split << mNumThreads << endl;
+  for(size_t i=0; i<mNanos.size(); i++) {
+    Phase phase = static_cast<Phase>(i);
+    double secs = getSeconds(phase);
+    double total = mElapsed*(phase <= Phase::PublishWait ? mNumThreads : 1);
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.3f (%.1f%%)", secs, (total > 0.0 ? 100.0*secs/total : 0.0));
+    logger << string(getName(phase)) + " (seconds)" << split << buf << endl;
+  }
+  for(size_t i=0; i<mCounters.size(); i++) {
+    Counter counter = static_cast<Counter>(i);
+    logger << getName(counter) << split << getCount(counter) << endl;
+  }
+  size_t numblocks = getCount(Counter::Blocks);
+  if (numblocks > 0) {
+    logger << "defaults by block" << split << double(getCount(Counter::Defaults))/numblocks << endl;
+  }
+  logger << indent(-1);
+}
+
+/**************************************************************************//**
+ * @details Report contains the number of threads, the elapsed time, the
+ *          seconds by phase and the counters.
+ * @param[in] filename Output file name (overwritten if exist).
+ * @throw Exception Error writing file.
+ */
+void ccruncher::Instrumentation::write(const string &filename) const
+{
+  try
+  {
+    ofstream file;
+    file.exceptions(ios::failbit | ios::badbit);
+    file.open(filename.c_str(), ios::out|ios::trunc);
+    file.precision(9);
+    file << "{\n";
+    file << "  \"threads\": " << mNumThreads << ",\n";
+    file << "  \"elapsed\": " << mElapsed << ",\n";
+    file << "  \"phases\": {";
+    for(size_t i=0; i<mNanos.size(); i++) {
+      Phase phase = static_cast<Phase>(i);
+      file << (i>0?",":"") << "\n    \"" << getName(phase) << "\": " << getSeconds(phase);
+    }
+    file << "\n  },\n";
+    file << "  \"counters\": {";
+    for(size_t i=0; i<mCounters.size(); i++) {
+      Counter counter = static_cast<Counter>(i);
+      file << (i>0?",":"") << "\n    \"" << getName(counter) << "\": " << getCount(counter);
+    }
+    file << "\n  }\n";
+    file << "}\n";
+    file.close();
+  }
+  catch(std::exception &e) {
+    throw Exception(e, "error writing file '" + filename + "'");
+  }
+}
+
+/**************************************************************************//**
+ * @param[in] phase Phase.
+ * @return Phase name.
+ */
+const char* ccruncher::Instrumentation::getName(Phase phase)
+{
+  switch(phase) {
+    case Phase::Factors: return "factors";
+    case Phase::ChiSquare: return "chisq";
+    case Phase::Epsilons: return "epsilons";
+    case Phase::Latent: return "latent";
+    case Phase::Inverse: return "inverse";
+    case Phase::Losses: return "losses";
+    case Phase::Pools: return "pools";
+    case Phase::PublishWait: return "publish_wait";
+    case Phase::DrainWait: return "drain_wait";
+    case Phase::Append: return "append";
+    case Phase::WriterWait: return "writer_wait";
+    case Phase::Checkpoint: return "checkpoint";
+    case Phase::Output: return "output";
+    default: return "unknown";
+  }
+}
+
+/**************************************************************************//**
+ * @param[in] counter Counter.
+ * @return Counter name.
+ */
+const char* ccruncher::Instrumentation::getName(Counter counter)
+{
+  switch(counter) {
+    case Counter::Blocks: return "blocks";
+    case Counter::Candidates: return "candidates";
+    case Counter::Defaults: return "defaults";
+    default: return "unknown";
+  }
+}
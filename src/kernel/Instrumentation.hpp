@@ -0,0 +1,170 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include "utils/Logger.hpp"
+#include "utils/config.h"
+
+namespace ccruncher {
+
+/**************************************************************************//**
+ * @brief Hot-path timers and counters of the Monte Carlo simulation.
+ *
+ * @details Each thread owns an object (no synchronization) and MonteCarlo
+ *          merges them at the end of the run. Timers are laps: lap(phase)
+ *          adds the time elapsed since the previous lap to the given
+ *          phase, so consecutive phases cost a single clock read each.
+ *          Scope timers measure a nested interval without breaking the
+ *          current lap sequence. Timers and counters are only updated when
+ *          compiled with INSTRUMENTATION defined (configure option
+ *          --enable-instrumentation). Otherwise INSTRUMENT_* macros expand
+ *          to nothing (counter increments are evaluated and discarded)
+ *          and the simulation doesn't pay anything for them.
+ *
+ * @see MonteCarlo
+ */
+class Instrumentation
+{
+
+  public:
+
+    //! Measured phases
+    enum class Phase
+    {
+      Factors=0,     //!< Factors random generation (simulation threads)
+      ChiSquare,     //!< Chi-square random generation (simulation threads)
+      Epsilons,      //!< Obligors' N(0,1) random generation (simulation threads)
+      Latent,        //!< Latent values and default candidates (simulation threads)
+      Inverse,       //!< Default times evaluation (simulation threads)
+      Losses,        //!< Losses evaluation and aggregation (simulation threads)
+      Pools,         //!< Obligors pools simulation (simulation threads)
+      PublishWait,   //!< Waiting for a free ring buffer slot (simulation threads)
+      DrainWait,     //!< Waiting for the next block (main thread)
+      Append,        //!< Appending blocks, stop criteria (main thread)
+      WriterWait,    //!< Waiting for the output writer (main thread, included in Append)
+      Checkpoint,    //!< Saving checkpoints (main thread)
+      Output,        //!< Writing output files and statistics (writer thread)
+      Size           //!< Number of phases
+    };
+
+    //! Counters
+    enum class Counter
+    {
+      Blocks=0,      //!< Simulated blocks
+      Candidates,    //!< Default candidates (latent value below threshold)
+      Defaults,      //!< Defaults before timeT
+      Size           //!< Number of counters
+    };
+
+    //! Scope timer (adds its lifetime to a phase)
+    class Scope
+    {
+      private:
+        //! Instrumentation object
+        Instrumentation &instrumentation;
+        //! Measured phase
+        Phase phase;
+        //! Starting time
+        std::chrono::steady_clock::time_point t0;
+      public:
+        //! Constructor
+        Scope(Instrumentation &obj, Phase p) : instrumentation(obj), phase(p), t0(std::chrono::steady_clock::now()) {}
+        //! Destructor
+        ~Scope() { instrumentation.add(phase, std::chrono::steady_clock::now()-t0); }
+    };
+
+  private:
+
+    //! Elapsed time by phase (nanoseconds)
+    std::array<int64_t,static_cast<size_t>(Phase::Size)> mNanos;
+    //! Counter values
+    std::array<uint64_t,static_cast<size_t>(Counter::Size)> mCounters;
+    //! Last lap time
+    std::chrono::steady_clock::time_point mLast;
+    //! Number of simulation threads
+    size_t mNumThreads;
+    //! Run elapsed time (seconds)
+    double mElapsed;
+
+  public:
+
+    //! Constructor
+    Instrumentation();
+    //! Starts the lap sequence
+    void start() { mLast = std::chrono::steady_clock::now(); }
+    //! Adds the time since the previous lap to a phase
+    void lap(Phase phase) {
+      auto t = std::chrono::steady_clock::now();
+      add(phase, t-mLast);
+      mLast = t;
+    }
+    //! Adds an interval to a phase
+    void add(Phase phase, std::chrono::steady_clock::duration d) {
+      mNanos[static_cast<size_t>(phase)] += std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+    }
+    //! Increments a counter
+    void count(Counter counter, uint64_t n=1) { mCounters[static_cast<size_t>(counter)] += n; }
+    //! Adds the values of another object
+    void merge(const Instrumentation &other);
+    //! Set run info
+    void setRun(size_t numthreads, double elapsed);
+    //! Returns the elapsed time of a phase (seconds)
+    double getSeconds(Phase phase) const;
+    //! Returns a counter value
+    uint64_t getCount(Counter counter) const { return mCounters[static_cast<size_t>(counter)]; }
+    //! Prints a report in the trace
+    void print(Logger &logger) const;
+    //! Writes a report in JSON format
+    void write(const std::string &filename) const;
+    //! Returns the phase name
+    static const char* getName(Phase phase);
+    //! Returns the counter name
+    static const char* getName(Counter counter);
+    //! Indicates if instrumentation is compiled
+    static constexpr bool isEnabled() {
+#ifdef INSTRUMENTATION
+      return true;
+#else
+      return false;
+#endif
+    }
+
+};
+
+} // namespace
+
+#ifdef INSTRUMENTATION
+  #define INSTRUMENT_START(obj) (obj).start()
+  #define INSTRUMENT_LAP(obj, phase) (obj).lap(ccruncher::Instrumentation::Phase::phase)
+  #define INSTRUMENT_SCOPE(obj, phase) ccruncher::Instrumentation::Scope instrument_scope_(obj, ccruncher::Instrumentation::Phase::phase)
+  #define INSTRUMENT_COUNT(obj, counter, n) (obj).count(ccruncher::Instrumentation::Counter::counter, n)
+#else
+  #define INSTRUMENT_START(obj) ((void)0)
+  #define INSTRUMENT_LAP(obj, phase) ((void)0)
+  #define INSTRUMENT_SCOPE(obj, phase) ((void)0)
+  #define INSTRUMENT_COUNT(obj, counter, n) ((void)(n))
+#endif
@@ -33,6 +33,10 @@ using namespace ccruncher;
 #define EPSILON 1e-10
 // maximum error = 1 hour
 #define MAX_ERROR 1.0/24.0
+// lookup table initial size
+#define MIN_TABLE_SIZE 257
+// lookup table maximum size
+#define MAX_TABLE_SIZE (1024*1024+1)
 
 /**************************************************************************/
 ccruncher::Inverse::Inverse()
@@ -40,6 +44,8 @@ ccruncher::Inverse::Inverse()
   mNdf = NAN;
   mMaxT = NAN;
   mSpline = nullptr;
+  mTableScale = NAN;
+  mTableError = NAN;
 }
 
 /**************************************************************************//**
@@ -48,14 +54,17 @@ ccruncher::Inverse::Inverse()
  * @param[in] maxt Maximum time (in days from starting date).
  * @param[in] cdf Default probability cdf.
  * @param[in] nodes Days from starting date where asset events ocurres.
+ * @param[in] table Use a lookup table instead of the spline.
  * @throw Exception Error creating inverse function.
  */
-ccruncher::Inverse::Inverse(double ndf, double maxt, const CDF &cdf, const std::vector<int> &nodes)
+ccruncher::Inverse::Inverse(double ndf, double maxt, const CDF &cdf, const std::vector<int> &nodes, bool table)
 {
   mNdf = NAN;
   mMaxT = NAN;
   mSpline = nullptr;
-  init(ndf, maxt, cdf, nodes);
+  mTableScale = NAN;
+  mTableError = NAN;
+  init(ndf, maxt, cdf, nodes, table);
 }
 
 /**************************************************************************//**
@@ -80,6 +89,9 @@ Inverse & ccruncher::Inverse::operator=(const Inverse &o)
 {
   mMaxT = o.mMaxT;
   mNdf = o.mNdf;
+  mTable = o.mTable;
+  mTableScale = o.mTableScale;
+  mTableError = o.mTableError;
 
   gsl_spline_free(mSpline);
   mSpline = nullptr;
@@ -106,9 +118,10 @@ size_t ccruncher::Inverse::size() const
  * @param[in] maxt Maximum time (in days from starting date).
  * @param[in] cdf Default probability cdf.
  * @param[in] nodes Days from starting date where asset events ocurres.
+ * @param[in] table Use a lookup table instead of the spline.
  * @throw Exception Error creating inverse function.
  */
-void ccruncher::Inverse::init(double ndf, double maxt, const CDF &cdf, const vector<int> &nodes)
+void ccruncher::Inverse::init(double ndf, double maxt, const CDF &cdf, const vector<int> &nodes, bool table)
 {
   if (std::isnan(ndf) || ndf < 2.0) {
     throw Exception("degrees of freedom out of range (ndf < 2)");
@@ -119,8 +132,15 @@ void ccruncher::Inverse::init(double ndf, double maxt, const CDF &cdf, const vec
 
   mNdf = ndf;
   mMaxT = maxt;
+  mTable.clear();
+  mTableScale = NAN;
+  mTableError = NAN;
 
   setSpline(cdf, nodes);
+
+  if (table) {
+    setTable();
+  }
 }
 
 /**************************************************************************//**
@@ -312,3 +332,79 @@ bool ccruncher::Inverse::isIncreasing(const gsl_spline *spline)
   return true;
 }
 
+/**************************************************************************//**
+ * @details Creates a lookup table uniformly spaced in [x0,xn] (the spline
+ *          range) doubling its size until the maximum error respect to
+ *          the spline is less than MAX_ERROR. Error is checked at three
+ *          interior points of each table interval. If the spline range is
+ *          not finite or the accuracy can not be achieved then the spline
+ *          is used.
+ */
+void ccruncher::Inverse::setTable()
+{
+  mTable.clear();
+  mTableScale = NAN;
+  mTableError = NAN;
+
+  if (mSpline == nullptr) {
+    return; // default rating
+  }
+
+  double x0 = mSpline->x[0];
+  double x1 = mSpline->x[mSpline->size-1];
+  if (!std::isfinite(x0) || !std::isfinite(x1) || x1 <= x0) {
+    return;
+  }
+
+  for(size_t size=MIN_TABLE_SIZE; size<=MAX_TABLE_SIZE; size=2*size-1) {
+    double err = setTable(size);
+    if (err <= MAX_ERROR) {
+      mTableError = err;
+      return;
+    }
+  }
+
+  // accuracy not achieved
+  mTable.clear();
+  mTableScale = NAN;
+}
+
+/**************************************************************************//**
+ * @details Table values are the spline values at the table points. A
+ *          cumulative maximum ensures that the table is monotone.
+ * @param[in] size Number of table points (>=2).
+ * @return Maximum error (in days) respect to the spline.
+ */
+double ccruncher::Inverse::setTable(size_t size)
+{
+  assert(mSpline != nullptr);
+  assert(size >= 2);
+
+  double x0 = mSpline->x[0];
+  double x1 = mSpline->x[mSpline->size-1];
+  double step = (x1 - x0) / static_cast<double>(size-1);
+
+  mTable.clear();
+  mTable.resize(size, 0.0);
+  mTableScale = NAN;
+  mTable[0] = mSpline->y[0];
+  for(size_t i=1; i<size-1; i++) {
+    double y = gsl_spline_eval(mSpline, x0 + i*step, nullptr);
+    mTable[i] = std::max(y, mTable[i-1]);
+  }
+  mTable[size-1] = std::max(mSpline->y[mSpline->size-1], mTable[size-2]);
+  mTableScale = 1.0 / step;
+
+  // maximum error respect to spline
+  double err = 0.0;
+  for(size_t i=0; i<size-1; i++) {
+    for(double w : {0.25, 0.5, 0.75}) {
+      double x = std::min(x0 + (i+w)*step, x1);
+      double y1 = gsl_spline_eval(mSpline, x, nullptr);
+      double y2 = mTable[i] + w * (mTable[i+1] - mTable[i]);
+      err = std::max(err, fabs(y1-y2));
+    }
+  }
+
+  return err;
+}
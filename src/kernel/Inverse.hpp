@@ -23,8 +23,10 @@
 #pragma once
 
 #include <map>
+#include <cmath>
 #include <vector>
 #include <cassert>
+#include <algorithm>
 #include <gsl/gsl_spline.h>
 #include "params/CDF.hpp"
 
@@ -42,7 +44,10 @@ namespace ccruncher {
  *            variable.
  *          the evaluation of this function is expensive. For this
  *          reason we compose it, and create a spline function in order to
- *          speed-up the evaluation.
+ *          speed-up the evaluation. Optionally, the spline can be replaced
+ *          by a monotone lookup table uniformly spaced in x, evaluated by
+ *          direct indexing and linear interpolation. Its cost doesn't
+ *          depend on the number of spline nodes.
  *
  * @see CCruncher's Technical Document. (section Simulation internals).
  */
@@ -57,6 +62,12 @@ class Inverse
     double mNdf;
     //! Spline function
     gsl_spline *mSpline;
+    //! Lookup table (empty = not used)
+    std::vector<double> mTable;
+    //! Lookup table inverse of step size
+    double mTableScale;
+    //! Lookup table maximum error (in days)
+    double mTableError;
 
   private:
 
@@ -72,13 +83,17 @@ class Inverse
     int getWorstDay(const std::vector<int> &nodes, const std::map<int, double> &cache) const;
     //! Check if spline is an monotonically increasing function
     static bool isIncreasing(const gsl_spline *spline);
+    //! Set lookup table
+    void setTable();
+    //! Set lookup table of the given size
+    double setTable(size_t size);
 
   public:
 
     //! Default constructor
     Inverse();
     //! Constructor
-    Inverse(double ndf, double maxt, const CDF &cdf, const std::vector<int> &nodes);
+    Inverse(double ndf, double maxt, const CDF &cdf, const std::vector<int> &nodes, bool table=false);
     //! Copy constructor
     Inverse(const Inverse &);
     //! Destructor
@@ -86,13 +101,19 @@ class Inverse
     //! Assignment operator
     Inverse & operator=(const Inverse &);
     //! Initialize
-    void init(double ndf, double maxt, const CDF &cdf, const std::vector<int> &nodes);
+    void init(double ndf, double maxt, const CDF &cdf, const std::vector<int> &nodes, bool table=false);
     //! Evalue (return days from t0)
     double evalue(double val) const;
+    //! Values above this threshold don't default before maxt
+    double getThreshold() const;
     //! Returns interpolation type (l=linear, c=cubic, n=none)
     std::string getInterpolationType() const;
     //! Number of interpolation nodes
     size_t size() const;
+    //! Number of lookup table points (0 = not used)
+    size_t getTableSize() const { return mTable.size(); }
+    //! Lookup table maximum error (in days)
+    double getTableError() const { return mTableError; }
 
 };
 
@@ -123,6 +144,14 @@ inline double ccruncher::Inverse::evalue(double val) const
     // default in less than 1 day (or minday)
     return mSpline->y[0];
   }
+  else if (!mTable.empty())
+  {
+    // direct index and linear interpolation
+    double pos = (val - mSpline->x[0]) * mTableScale;
+    size_t i = std::min(static_cast<size_t>(pos), mTable.size()-2);
+    double w = pos - static_cast<double>(i);
+    return mTable[i] + w * (mTable[i+1] - mTable[i]);
+  }
   else
   {
     // we don't use accel because values are random
@@ -130,4 +159,22 @@ inline double ccruncher::Inverse::evalue(double val) const
   }
 }
 
+/**************************************************************************//**
+ * @details Values greater than the returned threshold are evaluated as
+ *          'maxt + 100 days' (see Inverse::evalue()). This allows to
+ *          reject non-defaults with a single comparison. Values less or
+ *          equal than threshold must be evaluated.
+ * @return Threshold (+inf if all values default).
+ */
+inline double ccruncher::Inverse::getThreshold() const
+{
+  if (mSpline == nullptr) {
+    // default rating
+    return +INFINITY;
+  }
+  else {
+    return mSpline->x[mSpline->size-1];
+  }
+}
+
 } // namespace
@@ -194,3 +194,79 @@ void ccruncher_test::InverseTest::test7()
   ASSERT(inverse.getInterpolationType() == "linear");
 }
 
+
+//===========================================================================
+// test8
+// threshold of non-defaults
+//===========================================================================
+void ccruncher_test::InverseTest::test8()
+{
+  double ndf = 3.0;
+  CDF cdf(0.0, +INFINITY);
+  cdf.add(365.0, 0.02);
+  cdf.add(730.0, 0.05);
+
+  vector<int> nodes = {100, 365, 500, 730};
+
+  Inverse inverse(ndf, 365.0, cdf, nodes);
+  double threshold = inverse.getThreshold();
+  ASSERT_EQUALS_EPSILON(gsl_cdf_tdist_Pinv(cdf.evalue(365.0), ndf), threshold, 1e-12);
+
+  // values above threshold don't default
+  for(int i=1; i<=1000; i++) {
+    double x = threshold + i*1e-3;
+    ASSERT(365.0 < inverse.evalue(x));
+  }
+
+  // values bellow threshold default
+  for(int i=0; i<1000; i++) {
+    double x = threshold - i*1e-3;
+    ASSERT(ceil(inverse.evalue(x)) <= 365.0);
+  }
+
+  // default rating (all values default)
+  CDF cdf0(0.0, +INFINITY);
+  cdf0.add(0.0, 1.0);
+  cdf0.add(365.0, 1.0);
+  Inverse inverse0(ndf, 365.0, cdf0, nodes);
+  ASSERT(std::isinf(inverse0.getThreshold()));
+  ASSERT_EQUALS(0.0, inverse0.evalue(1e10));
+}
+
+//===========================================================================
+// test9 (lookup table)
+//===========================================================================
+void ccruncher_test::InverseTest::test9()
+{
+  CDF cdf(0.0, +INFINITY);
+  cdf.add(365.0, 0.05);
+  cdf.add(730.0, 0.12);
+  cdf.add(1825.0, 0.25);
+
+  vector<int> nodes;
+  for(int i=1; i<=60; i++) {
+    nodes.push_back(30*i);
+  }
+
+  for(double ndf : {double(INFINITY), 3.0}) {
+    Inverse spline(ndf, 1800.0, cdf, nodes);
+    Inverse table(ndf, 1800.0, cdf, nodes, true);
+    ASSERT_EQUALS((size_t)0, spline.getTableSize());
+    ASSERT(table.getTableSize() > 0);
+    ASSERT(table.getTableError() <= 1.0/24.0);
+    ASSERT_EQUALS(spline.getThreshold(), table.getThreshold());
+
+    // compare lookup table against spline (max error = 1 hour)
+    Inverse copy = table;
+    double x1 = table.getThreshold() + 0.1;
+    double prev = table.evalue(-10.0);
+    for(int i=0; i<=100000; i++) {
+      double x = -10.0 + i*(x1+10.0)/100000.0;
+      double y = table.evalue(x);
+      ASSERT_EQUALS_EPSILON(spline.evalue(x), y, 1.0/24.0+1e-9);
+      ASSERT_EQUALS(y, copy.evalue(x));
+      ASSERT(prev <= y);
+      prev = y;
+    }
+  }
+}
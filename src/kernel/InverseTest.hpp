@@ -38,6 +38,8 @@ class InverseTest : public TestFixture<InverseTest>
     void test5();
     void test6();
     void test7();
+    void test8();
+    void test9();
 
   public:
 
@@ -50,6 +52,8 @@ class InverseTest : public TestFixture<InverseTest>
       TEST_CASE(test5);
       TEST_CASE(test6);
       TEST_CASE(test7);
+      TEST_CASE(test8);
+      TEST_CASE(test9);
     }
 
 };
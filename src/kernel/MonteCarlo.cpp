@@ -22,21 +22,45 @@
 
 #include <set>
 #include <cmath>
+#include <cstdio>
 #include <cfloat>
 #include <cstdlib>
 #include <cstring>
+#include <thread>
+#include <numeric>
 #include <algorithm>
+#include <gsl/gsl_cdf.h>
 #include <gsl/gsl_linalg.h>
 #include <cassert>
 #include "kernel/MonteCarlo.hpp"
-#include "kernel/Aggregator.hpp"
 #include "kernel/SimulationThread.hpp"
+#include "kernel/WriterThread.hpp"
 #include "portfolio/Asset.hpp"
 #include "portfolio/DateValues.hpp"
 #include "params/Params.hpp"
 #include "utils/Utils.hpp"
+#include "utils/BatchRng.hpp"
 #include "utils/Exception.hpp"
 
+// default output buffer size (bytes)
+#define DEFAULT_BUFFER_SIZE (64*1024*1024)
+// random stream id used to scramble Sobol sequences
+#define STREAM_QMC 0xFFFFFFFFu
+// random stream id used by the importance sampling pilot
+#define STREAM_PILOT 0xFFFFFFFEu
+// importance sampling pilot: samples by iteration
+#define PILOT_SIZE 10000
+// importance sampling pilot: fraction of samples defining the tail
+#define PILOT_RHO 0.1
+// importance sampling pilot: maximum number of iterations
+#define PILOT_MAXITER 50
+// importance sampling weights file name
+#define WEIGHTS_NAME "weights"
+// streaming statistics summary file name
+#define SUMMARY_NAME "summary"
+// checkpoint file name
+#define CHECKPOINT_FILE "ccruncher.ckp"
+
 using namespace std;
 using namespace std::chrono;
 using namespace ccruncher;
@@ -45,16 +69,32 @@ using namespace ccruncher;
  * @param[in] s Streambuf where the trace will be written.
  */
 ccruncher::MonteCarlo::MonteCarlo(std::streambuf *s) :
-    logger(s), chol(nullptr), mStop(nullptr), mStatus(status::fresh)
+    logger(s), writer(nullptr), statistics(nullptr), convergence(nullptr), chol(nullptr), mMore(false), mNumBlocks(0), mMaxBlocks(0), mStop(nullptr), mStatus(status::fresh)
 {
   maxseconds = 0UL;
   numiterations = 0UL;
   maxiterations = 0UL;
   antithetic = false;
   blocksize = 1;
+  isa = BlockKernel::getIsa();
+  invtables = false;
   seed = 0UL;
+  qmc = "none";
+  qmcreplicates = 1;
+  importance = false;
+  importanceLevel = 0.999;
+  poolminsize = 0;
+  stats = "none";
+  stopLevel = 0.999;
+  stopPrecision = 0.0;
+  stopOffset = 0UL;
+  stopSize = 0UL;
   mHash = 0UL;
-  nfthreads = 0UL;
+  mNumThreads = 0;
+  mBufferSize = DEFAULT_BUFFER_SIZE;
+  mCheckpoint = 0UL;
+  mResumed = 0UL;
+  mDigest = 0UL;
   time0 = NAD;
   timeT = NAD;
   ndf = NAN;
@@ -77,6 +117,12 @@ void ccruncher::MonteCarlo::freeMemory()
   }
   threads.clear();
 
+  // removing writer
+  if (writer != nullptr) {
+    delete writer;
+    writer = nullptr;
+  }
+
   // dropping aggregators
   for(Aggregator *aggregator : aggregators) {
     delete aggregator;
@@ -84,6 +130,18 @@ void ccruncher::MonteCarlo::freeMemory()
   }
   aggregators.clear();
 
+  // dropping statistics
+  if (statistics != nullptr) {
+    delete statistics;
+    statistics = nullptr;
+  }
+
+  // dropping convergence criterion
+  if (convergence != nullptr) {
+    delete convergence;
+    convergence = nullptr;
+  }
+
   // deallocating cholesky matrix
   gsl_matrix_free(chol);
   chol = nullptr;
@@ -91,19 +149,26 @@ void ccruncher::MonteCarlo::freeMemory()
   // flushing remaining objects
   numSegmentsBySegmentation.clear();
   obligors.clear();
+  portfolio.clear();
   inverses.clear();
+  sobols.clear();
+  ishift.clear();
   floadings1.clear();
   floadings2.clear();
 }
 
 /**************************************************************************//**
  * @details Calls MonteCarlo::setXXX() methods using Input content.
+ *          In resume mode ('r') the simulation continues from the
+ *          checkpoint file found in the output directory.
  * @param[in] data CCruncher input file.
  * @param[in] path Directory path where output files will be put.
- * @param[in] mode Output file open mode.
+ * @param[in] mode Output file open mode: a (append), w (overwrite),
+ *            c (create), r (resume).
+ * @param[in] format Output file format.
  * @throw Exception Error initializing object.
  */
-void ccruncher::MonteCarlo::init(Input &data, const string &path, char mode)
+void ccruncher::MonteCarlo::init(Input &data, const string &path, char mode, Aggregator::Format format)
 {
   if (mStatus != status::fresh) {
     throw Exception("trying to re-initialize a MonteCarlo object");
@@ -112,13 +177,25 @@ void ccruncher::MonteCarlo::init(Input &data, const string &path, char mode)
   try
   {
     mStatus = status::running;
+    mCheckpointFile = Utils::realpath(path) + Utils::pathSeparator + CHECKPOINT_FILE;
+    Checkpoint checkpoint;
+    if (mode == 'r') {
+      checkpoint.load(mCheckpointFile);
+    }
     setParams(data.getParams());
     setDefaultProbabilities(data.getCDFs());
     setFactorLoadings(data.getFactorLoadings());
     setCorrelations(data.getCorrelations());
     setObligors(data.getPortfolio(), data.getSegmentations());
+    mDigest = getDigest();
+    if (mode == 'r') {
+      setResume(checkpoint);
+    }
     setInverses();
-    setSegmentations(data.getSegmentations(), path, mode);
+    setSobols();
+    setImportance();
+    setSegmentations(data.getSegmentations(), path, mode, format, checkpoint);
+    setPortfolio();
     mStatus = status::initialized;
   }
   catch(std::exception &e)
@@ -147,8 +224,32 @@ void ccruncher::MonteCarlo::setParams(const Params &params)
   timeT = params.getTimeT();
   antithetic = params.getAntithetic();
   blocksize = params.getBlockSize();
+  invtables = (params.getInverse() == "lut");
   ndf = params.getNdf();
   seed = params.getRngSeed();
+  qmc = params.getQmc();
+  qmcreplicates = params.getQmcReplicates();
+  importance = params.getImportance();
+  importanceLevel = params.getImportanceLevel();
+  poolminsize = params.getPoolMinSize();
+  stats = params.getStats();
+  statsLevels = params.getStatsLevels();
+  stopSegmentation = params.getStopSegmentation();
+  stopLevel = params.getStopLevel();
+  stopPrecision = params.getStopPrecision();
+
+  // shard simulations range (maxiterations becomes the shard size)
+  if (mShard.count > 1) {
+    if (seed == 0UL) {
+      throw Exception("shards require a fixed rng.seed");
+    }
+    if (stopPrecision > 0.0) {
+      throw Exception("shards can't use the stop.precision criterion");
+    }
+    mShard.seed = seed;
+    mShard.setRange(maxiterations, blocksize);
+    maxiterations = mShard.size();
+  }
 
   // seed based on clock (if not set)
   if (seed == 0UL) {
@@ -214,6 +315,177 @@ void ccruncher::MonteCarlo::setCorrelations(const vector<vector<double>> &correl
   }
 }
 
+/**************************************************************************//**
+ * @details Creates one scrambled Sobol sequence by replicate. Dimensions
+ *          are the factors and, if qmc=all and copula is a t-student,
+ *          the chi-square. Replicate r is scrambled using the random
+ *          stream (r, STREAM_QMC), so sequences depend only on the seed.
+ * @see http://www.ccruncher.net/ifileref.html#parameters
+ * @throw Exception Too many factors.
+ */
+void ccruncher::MonteCarlo::setSobols()
+{
+  assert(chol != nullptr);
+  sobols.clear();
+  if (qmc == "none") return;
+
+  size_t dim = chol->size1 + (qmc == "all" && std::isfinite(ndf) ? 1 : 0);
+  if (dim > Sobol::MAXDIM) {
+    throw Exception("qmc dimension (" + to_string(dim) + ") bigger than " + to_string(Sobol::MAXDIM));
+  }
+
+  BatchRng rng(seed);
+  sobols.assign(qmcreplicates, Sobol(dim));
+  for(size_t r=0; r<sobols.size(); r++) {
+    rng.setStream(r, STREAM_QMC);
+    sobols[r].scramble(rng.getRng());
+  }
+}
+
+/**************************************************************************//**
+ * @details Computes the mean shift of the independent gaussian factors
+ *          used by the importance sampling. The shift is obtained with the
+ *          cross-entropy method applied to the large portfolio
+ *          approximation of the loss conditioned to the factors (obligors
+ *          are replaced by their expected loss given default, and the
+ *          t-student scaling is ignored). Each iteration draws PILOT_SIZE
+ *          factor values around the current shift and moves the shift to
+ *          the likelihood weighted mean of the worst PILOT_RHO scenarios,
+ *          until they reach the loss quantile of the target confidence
+ *          level. Pilot values are drawn from the random streams
+ *          (iteration, STREAM_PILOT). The approximation only affects the
+ *          efficiency, the simulated values are weighted by the exact
+ *          likelihood ratio.
+ * @see Rubinstein, Kroese. The cross-entropy method. Springer, 2004.
+ * @see Glasserman, Li. Importance sampling for portfolio credit risk.
+ *      Management Science 51(11), 2005.
+ */
+void ccruncher::MonteCarlo::setImportance()
+{
+  assert(chol != nullptr);
+  ishift.clear();
+  if (!importance) return;
+
+  size_t numfactors = chol->size1;
+  size_t numratings = dprobs.size();
+  double numdays = timeT - time0;
+
+  // expected loss given default by factor and rating
+  vector<double> exposures(numfactors*numratings, 0.0);
+  for(const Obligor &obligor : obligors) {
+    double sum = 0.0;
+    for(const Asset &asset : obligor.assets) {
+      Date prevt = time0;
+      for(const DateValues &values : asset.values) {
+        if (prevt >= timeT) break;
+        double weight = (std::min(values.date,timeT) - prevt)/numdays;
+        const LGD &lgd = (LGD::isValid(values.lgd) ? values.lgd : obligor.lgd);
+        sum += weight * values.ead.getExpected() * lgd.getExpected();
+        prevt = values.date;
+      }
+    }
+    exposures[obligor.ifactor*numratings+obligor.irating] += sum;
+  }
+
+  // gaussian non-default thresholds at time T
+  vector<double> thresholds(numratings, 0.0);
+  for(size_t r=0; r<numratings; r++) {
+    thresholds[r] = gsl_cdf_ugaussian_Pinv(dprobs[r].evalue(numdays));
+  }
+
+  // conditional expected loss given the independent factors
+  vector<double> z(numfactors, 0.0);
+  auto loss = [&](const double *x) -> double {
+    for(size_t i=0; i<numfactors; i++) {
+      z[i] = 0.0;
+      for(size_t j=0; j<=i; j++) {
+        z[i] += gsl_matrix_get(chol, i, j) * x[j];
+      }
+    }
+    double ret = 0.0;
+    for(size_t i=0; i<numfactors; i++) {
+      for(size_t r=0; r<numratings; r++) {
+        double exposure = exposures[i*numratings+r];
+        if (exposure <= 0.0) continue;
+        double p = 0.0;
+        if (floadings2[i] > 0.0) {
+          p = gsl_cdf_ugaussian_P((thresholds[r]-z[i])/floadings2[i]);
+        }
+        else {
+          p = (z[i] <= thresholds[r] ? 1.0 : 0.0);
+        }
+        ret += exposure * p;
+      }
+    }
+    return ret;
+  };
+
+  BatchRng rng(seed);
+  vector<double> mu(numfactors, 0.0);
+  vector<double> x(PILOT_SIZE*numfactors, 0.0);
+  vector<double> losses(PILOT_SIZE, 0.0);
+  vector<double> weights(PILOT_SIZE, 0.0);
+  vector<size_t> order(PILOT_SIZE, 0);
+  size_t numtail = static_cast<size_t>(PILOT_RHO*PILOT_SIZE);
+
+  for(size_t iter=0; iter<PILOT_MAXITER; iter++)
+  {
+    // drawing scenarios around the current shift
+    rng.setStream(iter, STREAM_PILOT);
+    rng.gaussian(x.data(), x.size());
+    double mu2 = inner_product(mu.begin(), mu.end(), mu.begin(), 0.0);
+    for(size_t k=0; k<PILOT_SIZE; k++) {
+      double *xk = x.data() + k*numfactors;
+      double dot = 0.0;
+      for(size_t i=0; i<numfactors; i++) {
+        xk[i] += mu[i];
+        dot += mu[i]*xk[i];
+      }
+      weights[k] = exp(-dot + 0.5*mu2);
+      losses[k] = loss(xk);
+    }
+
+    // sorting scenarios by decreasing loss
+    iota(order.begin(), order.end(), 0);
+    sort(order.begin(), order.end(),
+         [&losses](size_t a, size_t b) -> bool {
+           return losses[a] > losses[b];
+         });
+
+    // loss quantile at target level (likelihood weighted)
+    double cumprob = 0.0;
+    size_t pos = 0;
+    for(; pos+1<PILOT_SIZE; pos++) {
+      cumprob += weights[order[pos]]/PILOT_SIZE;
+      if (cumprob >= 1.0-importanceLevel) break;
+    }
+    double target = losses[order[pos]];
+
+    // tail of current scenarios
+    double gamma = losses[order[numtail-1]];
+    bool last = (gamma >= target);
+    if (last) gamma = target;
+
+    // likelihood weighted mean of tail scenarios
+    double sumw = 0.0;
+    fill(mu.begin(), mu.end(), 0.0);
+    for(size_t k=0; k<PILOT_SIZE && losses[order[k]] >= gamma; k++) {
+      const double *xk = x.data() + order[k]*numfactors;
+      for(size_t i=0; i<numfactors; i++) {
+        mu[i] += weights[order[k]]*xk[i];
+      }
+      sumw += weights[order[k]];
+    }
+    for(size_t i=0; i<numfactors; i++) {
+      mu[i] /= sumw;
+    }
+
+    if (last) break;
+  }
+
+  ishift = mu;
+}
+
 /**************************************************************************//**
  * @details Computes the Cholesky decomposition, L,  of the correlation
  *          matrix M. That is, M = L·L', where L is a lower triangular
@@ -249,19 +521,19 @@ gsl_matrix * ccruncher::MonteCarlo::cholesky(const std::vector<std::vector<doubl
 }
 
 /**************************************************************************//**
- * @details Imports portfolio obligors (portfolio returns empty)
- * @param[in] obligors List of obligors.
+ * @details Imports portfolio obligors (list returns empty)
+ * @param[in] list List of obligors.
  * @param[in] segmentations List of segmentations.
  * @throw Exception Empty list or exists an invalid obligor.
  */
-void ccruncher::MonteCarlo::setObligors(vector<Obligor> &portfolio, const std::vector<Segmentation> &segmentations)
+void ccruncher::MonteCarlo::setObligors(vector<Obligor> &list, const std::vector<Segmentation> &segmentations)
 {
   assert(chol != nullptr);
   size_t numFactors = chol->size1;
   size_t numRatings = dprobs.size();
-  Input::validatePortfolio(portfolio, numFactors, numRatings, segmentations, time0, timeT, true);
+  Input::validatePortfolio(list, numFactors, numRatings, segmentations, time0, timeT, true);
   obligors.clear();
-  obligors.swap(portfolio);
+  obligors.swap(list);
   sort(obligors.begin(), obligors.end(),
        [](const Obligor &a, const Obligor &b) -> bool {
          return a.irating < b.irating;
@@ -269,18 +541,142 @@ void ccruncher::MonteCarlo::setObligors(vector<Obligor> &portfolio, const std::v
 
 }
 
+/**************************************************************************//**
+ * @details Serializes the values that determine the simulated losses
+ *          (dates relative to time0, copula, default probabilities,
+ *          factors and obligors) and returns their checksum. Parameters
+ *          like maxiterations or the rng seed are not included. Obligors
+ *          must be set.
+ * @return Input digest.
+ */
+unsigned long ccruncher::MonteCarlo::getDigest() const
+{
+  assert(chol != nullptr);
+  Checkpoint archive;
+
+  archive.put(static_cast<int64_t>(timeT - time0));
+  archive.put(ndf);
+  for(const CDF &cdf : dprobs) {
+    archive.put(cdf.getPoints());
+  }
+  archive.put(floadings1);
+  for(size_t i=0; i<chol->size1; i++) {
+    for(size_t j=0; j<=i; j++) {
+      archive.put(gsl_matrix_get(chol, i, j));
+    }
+  }
+
+  auto putLGD = [&archive](const LGD &lgd) {
+    archive.put(static_cast<int32_t>(lgd.getType()));
+    archive.put(lgd.getValue1());
+    archive.put(lgd.getValue2());
+  };
+
+  archive.put(static_cast<uint64_t>(obligors.size()));
+  for(const Obligor &obligor : obligors) {
+    archive.put(obligor.ifactor);
+    archive.put(obligor.irating);
+    putLGD(obligor.lgd);
+    archive.put(static_cast<uint64_t>(obligor.assets.size()));
+    for(const Asset &asset : obligor.assets) {
+      archive.put(asset.segments);
+      archive.put(static_cast<uint64_t>(asset.values.size()));
+      for(const DateValues &values : asset.values) {
+        archive.put(static_cast<int64_t>(values.date - time0));
+        archive.put(static_cast<int32_t>(values.ead.getType()));
+        archive.put(values.ead.getValue1());
+        archive.put(values.ead.getValue2());
+        putLGD(values.lgd);
+      }
+    }
+  }
+
+  return archive.getChecksum();
+}
+
+/**************************************************************************//**
+ * @details Restores the seed and the number of simulations done from the
+ *          checkpoint. The input values that determine the simulated
+ *          losses (see getDigest()) and the parameters that change the
+ *          simulated values or the restored states (block size,
+ *          antithetic, qmc, qmc.replicates, inverse, pool.minsize,
+ *          importance, importance.level, stats.levels and stop.level)
+ *          must be the same. Other parameters (eg. maxiterations) can
+ *          change.
+ * @param[in,out] checkpoint Loaded checkpoint.
+ * @throw Exception Checkpoint doesn't match current parameters.
+ */
+void ccruncher::MonteCarlo::setResume(Checkpoint &checkpoint)
+{
+  unsigned long ckpseed = 0UL;
+  unsigned short ckpblocksize = 0;
+  bool ckpantithetic = false;
+  string ckpqmc;
+  unsigned short ckpqmcreplicates = 0;
+  bool ckpinvtables = false;
+  uint64_t ckppoolminsize = 0;
+  bool ckpimportance = false;
+  double ckpimportanceLevel = NAN;
+  vector<double> ckpstatsLevels;
+  double ckpstopLevel = NAN;
+  vector<uint64_t> ckpshard;
+  unsigned long ckpdigest = 0UL;
+  uint64_t ckpiterations = 0;
+
+  checkpoint.get(ckpseed);
+  checkpoint.get(ckpblocksize);
+  checkpoint.get(ckpantithetic);
+  checkpoint.get(ckpqmc);
+  checkpoint.get(ckpqmcreplicates);
+  checkpoint.get(ckpinvtables);
+  checkpoint.get(ckppoolminsize);
+  checkpoint.get(ckpimportance);
+  checkpoint.get(ckpimportanceLevel);
+  checkpoint.get(ckpstatsLevels);
+  checkpoint.get(ckpstopLevel);
+  checkpoint.get(ckpshard);
+  checkpoint.get(ckpdigest);
+  checkpoint.get(ckpiterations);
+
+  if (ckpblocksize != blocksize || ckpantithetic != antithetic ||
+      ckpqmc != qmc || ckpqmcreplicates != qmcreplicates ||
+      ckpinvtables != invtables || ckppoolminsize != poolminsize ||
+      ckpimportance != importance || ckpimportanceLevel != importanceLevel ||
+      ckpstatsLevels != statsLevels || ckpstopLevel != stopLevel) {
+    throw Exception("checkpoint doesn't match current parameters");
+  }
+  vector<uint64_t> shard = {mShard.index, mShard.count, mShard.seed, mShard.first, mShard.last};
+  if (ckpshard != shard) {
+    throw Exception("checkpoint doesn't match current shard");
+  }
+  if (ckpdigest != mDigest) {
+    throw Exception("checkpoint doesn't match current input");
+  }
+  if (ckpiterations%blocksize != 0) {
+    throw Exception("invalid checkpoint (incomplete block)");
+  }
+
+  seed = ckpseed;
+  mResumed = ckpiterations;
+}
+
 /**************************************************************************//**
  * @details Creates the list of simulated assets. This initialization stage
  *          sets SimulatedObligor::ref to the simulated asset.
  * @param[in] segmentations List of segmentations.
  * @param[in] path Directory path where output will be placed.
- * @param[in] mode File creation mode: a (append), w (overwrite), c (create)
+ * @param[in] mode File creation mode: a (append), w (overwrite), c (create),
+ *            r (resume, files are truncated to the checkpointed size).
+ * @param[in] format Output file format.
+ * @param[in,out] checkpoint Loaded checkpoint (only used if mode is r).
  * @throw Exception Error initializing object.
  */
-void ccruncher::MonteCarlo::setSegmentations(const vector<Segmentation> &segmentations, const string &path, char mode)
+void ccruncher::MonteCarlo::setSegmentations(const vector<Segmentation> &segmentations,
+    const string &path, char mode, Aggregator::Format format, Checkpoint &checkpoint)
 {
   Input::validateSegmentations(segmentations, true);
 
+  bool resume = (mode == 'r');
   numsegments = 0UL;
   numSegmentsBySegmentation.assign(segmentations.size(), 0);
 
@@ -290,13 +686,134 @@ void ccruncher::MonteCarlo::setSegmentations(const vector<Segmentation> &segment
     numsegments += numSegmentsBySegmentation[i];
   }
 
-  // allocating and initializing aggregators
-  aggregators.assign(segmentations.size(), nullptr);
+  // importance sampling weights are written in its own file (last column)
+  Segmentation weights(WEIGHTS_NAME, true, false);
+  for(const Segmentation &segmentation : segmentations) {
+    if (segmentation.getName() == weights.getName()) {
+      throw Exception("segmentation name '" WEIGHTS_NAME "' is reserved");
+    }
+  }
+  if (importance) {
+    weights.addSegment("weight");
+  }
+  if (mode == 'w' && (!importance || stats == "only")) {
+    // removing stale weights from a previous run (see ccruncher-gui)
+    remove(weights.getFilename(path, Aggregator::getExtension(format)).c_str());
+  }
+
+  // summary file name can't be a segmentation file name
+  if (stats != "none") {
+    for(const Segmentation &segmentation : segmentations) {
+      if (segmentation.getName() == SUMMARY_NAME) {
+        throw Exception("segmentation name '" SUMMARY_NAME "' is reserved when streaming statistics are enabled");
+      }
+    }
+  }
+
+  vector<vector<double>> exposures(segmentations.size());
   for(size_t i=0; i<segmentations.size(); i++) {
+    exposures[i] = getExposures(i);
+  }
+
+  // output files (empty name if not written)
+  vector<string> ofiles(segmentations.size() + (importance?1:0));
+  for(size_t i=0; i<ofiles.size() && stats != "only"; i++) {
+    const Segmentation &segmentation = (i < segmentations.size() ? segmentations[i] : weights);
+    ofiles[i] = segmentation.getFilename(path, Aggregator::getExtension(format));
+  }
+
+  // resume: discarding data written after the checkpoint
+  if (resume) {
+    uint64_t numfiles = 0;
+    checkpoint.get(numfiles);
+    if (numfiles != ofiles.size()) {
+      throw Exception("checkpoint doesn't match current output files");
+    }
+    for(const string &ofile : ofiles) {
+      string filename;
+      uint64_t filesize = 0;
+      checkpoint.get(filename);
+      checkpoint.get(filesize);
+      if (filename != ofile) {
+        throw Exception("checkpoint doesn't match current output files");
+      }
+      if (!ofile.empty()) {
+        if (Utils::filesize(ofile) < filesize) {
+          throw Exception("file '" + ofile + "' is smaller than expected by checkpoint");
+        }
+        Utils::truncate(ofile, filesize);
+      }
+    }
+    mode = 'a';
+  }
+
+  // shard description written in the output files header
+  string shard = (mShard.count > 1 ? mShard.toString() : "");
+
+  // allocating and initializing aggregators (null if not written)
+  aggregators.assign(segmentations.size(), nullptr);
+  for(size_t i=0; i<segmentations.size() && stats != "only"; i++) {
     const Segmentation &segmentation = segmentations[i];
-    string ofile = segmentation.getFilename(path);
-    aggregators[i] = new Aggregator(ofile, mode, segmentation.size());
-    aggregators[i]->printHeader(segmentation, getExposures(i));
+    aggregators[i] = new Aggregator(ofiles[i], mode, segmentation.size(), format);
+    aggregators[i]->printHeader(segmentation, exposures[i], shard);
+  }
+
+  if (importance) {
+    aggregators.push_back(nullptr);
+    if (stats != "only") {
+      aggregators.back() = new Aggregator(ofiles.back(), mode, weights.size(), format);
+      aggregators.back()->printHeader(weights, vector<double>(weights.size(), 0.0), shard);
+      aggregators.back()->setPrecision(17);
+    }
+    numSegmentsBySegmentation.push_back(weights.size());
+    numsegments += weights.size();
+  }
+
+  // streaming statistics
+  if (stats != "none") {
+    string ofile = Segmentation(SUMMARY_NAME).getFilename(path, ".csv");
+    statistics = new Statistics(ofile, mode, segmentations, exposures, importance, statsLevels);
+    if (qmc != "none") {
+      statistics->setReplicates(qmcreplicates, blocksize, mShard.getFirstBlock(blocksize));
+    }
+  }
+
+  // convergence criterion (VaR of the segmentation total loss)
+  if (stopPrecision > 0.0) {
+    size_t isegmentation = 0;
+    if (!stopSegmentation.empty()) {
+      isegmentation = segmentations.size();
+      for(size_t i=0; i<segmentations.size(); i++) {
+        if (segmentations[i].getName() == stopSegmentation) isegmentation = i;
+      }
+      if (isegmentation == segmentations.size()) {
+        throw Exception("stop.segmentation '" + stopSegmentation + "' not found");
+      }
+    }
+    stopSegmentation = segmentations[isegmentation].getName();
+    stopOffset = accumulate(numSegmentsBySegmentation.begin(), numSegmentsBySegmentation.begin()+isegmentation, size_t(0));
+    stopSize = numSegmentsBySegmentation[isegmentation];
+    convergence = new Convergence(stopLevel, stopPrecision);
+  }
+
+  // resume: restoring statistics and convergence states
+  if (resume) {
+    bool hasStatistics = false;
+    bool hasConvergence = false;
+    checkpoint.get(hasStatistics);
+    if (hasStatistics != (statistics != nullptr)) {
+      throw Exception("checkpoint doesn't match current statistics");
+    }
+    if (statistics != nullptr) {
+      statistics->restore(checkpoint);
+    }
+    checkpoint.get(hasConvergence);
+    if (hasConvergence != (convergence != nullptr)) {
+      throw Exception("checkpoint doesn't match current convergence criterion");
+    }
+    if (convergence != nullptr) {
+      convergence->restore(checkpoint);
+    }
   }
 
   // tracing log info
@@ -304,9 +821,18 @@ void ccruncher::MonteCarlo::setSegmentations(const vector<Segmentation> &segment
   logger << "output files" << flood('*') << endl;
   logger << indent(+1);
   logger << "directory" << split << "[" + Utils::realpath(path) + "]" << endl;
-  for(size_t i=0; i<aggregators.size(); i++) {
+  for(size_t i=0; i<segmentations.size() && stats != "only"; i++) {
     logger << "segmentation" << split << "[" + aggregators[i]->getFilename() + "]" << endl;
   }
+  if (importance && stats != "only") {
+    logger << "importance sampling weights" << split << "[" + aggregators.back()->getFilename() + "]" << endl;
+  }
+  if (statistics != nullptr) {
+    logger << "statistics summary" << split << "[" + statistics->getFilename() + "]" << endl;
+  }
+  if (resume) {
+    logger << "resumed from checkpoint" << split << "[" + mCheckpointFile + "]" << endl;
+  }
   logger << indent(-1);
 
 }
@@ -338,14 +864,139 @@ void ccruncher::MonteCarlo::setInverses()
   // create PDinv(t(x)) splines
   inverses.resize(dprobs.size());
   for(size_t i=0; i<dprobs.size(); i++) {
-    inverses[i].init(ndf, timeT-time0, dprobs[i], nodes);
+    inverses[i].init(ndf, timeT-time0, dprobs[i], nodes, invtables);
   }
 }
 
 /**************************************************************************//**
- * @details Starts the simulation procedure. If there is only 1 thread,
- *          then uses the current thread (simplifies debug), otherwise
- *          creates one simulation per thread.
+ * @details Simulated values are written by a dedicated thread using two
+ *          buffers sharing the given memory budget. The simulation waits
+ *          for the writer only when both buffers are full.
+ * @param[in] numbytes Memory used by the output buffers (in bytes).
+ */
+void ccruncher::MonteCarlo::setBufferSize(size_t numbytes)
+{
+  mBufferSize = numbytes;
+}
+
+/**************************************************************************//**
+ * @details The simulation state is saved periodically in the checkpoint
+ *          file placed in the output directory. The checkpoint contains
+ *          the seed, the input digest, the number of simulations done,
+ *          the size of the output files, and the streaming statistics and
+ *          convergence states. Output files are flushed before saving it.
+ *          It is also saved at the end of the simulation (if it ends at
+ *          a block boundary), so an interrupted or finished run can be
+ *          continued using the resume mode.
+ * @param[in] secs Seconds between checkpoints (0 = disabled).
+ */
+void ccruncher::MonteCarlo::setCheckpoint(size_t secs)
+{
+  mCheckpoint = secs;
+}
+
+/**************************************************************************//**
+ * @details Splits the run in count shards simulated by independent
+ *          processes and selects the one simulated by this object. Each
+ *          shard simulates a contiguous range of blocks, so its random
+ *          values are disjoint from the other shards ones. Requires a
+ *          fixed seed and a maximum number of iterations, and the
+ *          convergence criterion can't be used. Shard files can be merged
+ *          using ShardMerger (ccruncher-merge). Must be called before
+ *          init().
+ * @see Shard
+ * @param[in] index Shard index (0-based).
+ * @param[in] count Number of shards.
+ * @throw Exception Invalid shard or object already initialized.
+ */
+void ccruncher::MonteCarlo::setShard(size_t index, size_t count)
+{
+  if (mStatus != status::fresh) {
+    throw Exception("shard must be set before initialization");
+  }
+  mShard = Shard(index, count);
+}
+
+/**************************************************************************//**
+ * @details Waits until the writer has written and flushed all the appended
+ *          simulations, then saves the state. Simulations must be appended
+ *          by complete blocks. Random values depend only on the seed and
+ *          the block index, so the number of simulations done is enough
+ *          to continue the same stream.
+ * @throw Exception Error writing checkpoint.
+ */
+void ccruncher::MonteCarlo::saveCheckpoint()
+{
+  assert(numiterations%blocksize == 0);
+
+  if (writer != nullptr) {
+    writer->sync();
+  }
+
+  Checkpoint checkpoint;
+  checkpoint.put(seed);
+  checkpoint.put(blocksize);
+  checkpoint.put(antithetic);
+  checkpoint.put(qmc);
+  checkpoint.put(qmcreplicates);
+  checkpoint.put(invtables);
+  checkpoint.put(static_cast<uint64_t>(poolminsize));
+  checkpoint.put(importance);
+  checkpoint.put(importanceLevel);
+  checkpoint.put(statsLevels);
+  checkpoint.put(stopLevel);
+  checkpoint.put(vector<uint64_t>{mShard.index, mShard.count, mShard.seed, mShard.first, mShard.last});
+  checkpoint.put(mDigest);
+  checkpoint.put(static_cast<uint64_t>(numiterations));
+
+  checkpoint.put(static_cast<uint64_t>(aggregators.size()));
+  for(const Aggregator *aggregator : aggregators) {
+    if (aggregator == nullptr) {
+      checkpoint.put(string());
+      checkpoint.put(uint64_t(0));
+    }
+    else {
+      checkpoint.put(aggregator->getFilename());
+      checkpoint.put(static_cast<uint64_t>(Utils::filesize(aggregator->getFilename())));
+    }
+  }
+
+  checkpoint.put(statistics != nullptr);
+  if (statistics != nullptr) {
+    statistics->save(checkpoint);
+  }
+  checkpoint.put(convergence != nullptr);
+  if (convergence != nullptr) {
+    convergence->save(checkpoint);
+  }
+
+  checkpoint.save(mCheckpointFile);
+  mLastCheckpoint = steady_clock::now();
+}
+
+/**************************************************************************//**
+ * @details Compiles the obligors into the flat layout used by the
+ *          simulation threads. Obligors with identical profile are
+ *          collapsed into pools if there are at least poolminsize of
+ *          them. If all exposures and lgds are fixed, the losses of each
+ *          obligor are precomputed as a function of the default day.
+ *          Obligors are released because they are no longer needed.
+ *          Segmentations and simulation dates must be set.
+ * @throw Exception Error compiling portfolio.
+ */
+void ccruncher::MonteCarlo::setPortfolio()
+{
+  // importance sampling weights column is not a portfolio segmentation
+  vector<unsigned short> nsegments(numSegmentsBySegmentation.begin(),
+      numSegmentsBySegmentation.end() - (importance?1:0));
+  portfolio.init(obligors, nsegments, poolminsize);
+  portfolio.initLossTables(time0, timeT);
+  vector<Obligor>().swap(obligors);
+}
+
+/**************************************************************************//**
+ * @details Starts the simulation procedure. Creates the simulation threads
+ *          and uses the current thread to consume the simulated blocks.
  * @param[in] numthreads Number of threads to use (0 = num cores).
  * @param[in] nhash Number of simulations per hash (0 = no hashes).
  * @param[in] stop Variable to stop process from outside.
@@ -372,6 +1023,7 @@ void ccruncher::MonteCarlo::run(unsigned char numthreads, size_t nhash, bool *st
   if (maxiterations > 0 && numthreads*blocksize > maxiterations) {
     numthreads = ceil(double(maxiterations)/blocksize);
   }
+  mNumThreads = numthreads;
 
   // tracing log info
   logger << endl;
@@ -382,6 +1034,55 @@ void ccruncher::MonteCarlo::run(unsigned char numthreads, size_t nhash, bool *st
   logger << "maximum number of iterations" << split << maxiterations << endl;
   logger << "antithetic mode" << split << antithetic << endl;
   logger << "block size" << split << blocksize << endl;
+  logger << "instruction set" << split << BlockKernel::toString(isa) << endl;
+  logger << "inverse function" << split << (invtables?"lut":"spline") << endl;
+  if (invtables) {
+    double err = 0.0;
+    for(const Inverse &inverse : inverses) {
+      if (inverse.getTableSize() > 0) err = std::max(err, inverse.getTableError());
+    }
+    logger << "inverse table max error (days)" << split << err << endl;
+  }
+  logger << "quasi-Monte Carlo" << split << qmc << endl;
+  if (!sobols.empty()) {
+    logger << "quasi-Monte Carlo replicates" << split << sobols.size() << endl;
+  }
+  logger << "importance sampling" << split << importance << endl;
+  if (importance) {
+    double norm = sqrt(inner_product(ishift.begin(), ishift.end(), ishift.begin(), 0.0));
+    logger << "importance sampling level" << split << importanceLevel << endl;
+    logger << "importance sampling shift (norm)" << split << norm << endl;
+  }
+  if (poolminsize > 1) {
+    size_t numpools = portfolio.getNumPools();
+    size_t numpooled = 0;
+    for(uint32_t num : portfolio.poolSizes) {
+      if (num > 1) numpooled += num;
+    }
+    logger << "obligor pools (minimum size)" << split << poolminsize << endl;
+    logger << "number of obligor pools" << split << numpools << endl;
+    logger << "number of pooled obligors" << split << numpooled << endl;
+  }
+  logger << "base segmentations" << split << portfolio.baseSegmentations.size() << endl;
+  logger << "precomputed loss tables" << split << (portfolio.getValuesKind() == FlatPortfolio::ValuesKind::Fixed) << endl;
+  logger << "streaming statistics" << split << stats << endl;
+  if (convergence != nullptr) {
+    logger << "convergence segmentation" << split << stopSegmentation << endl;
+    logger << "convergence VaR level" << split << stopLevel << endl;
+    logger << "convergence VaR relative std. error" << split << stopPrecision << endl;
+    logger << "convergence batch size" << split << convergence->getBatchSize() << endl;
+  }
+  logger << "output buffer size" << split << Utils::bytesToString(mBufferSize) << endl;
+  if (mCheckpoint > 0) {
+    logger << "checkpoint period (seconds)" << split << mCheckpoint << endl;
+  }
+  if (mShard.count > 1) {
+    logger << "shard" << split << to_string(mShard.index+1) + "/" + to_string(mShard.count) << endl;
+    logger << "shard simulations range" << split << to_string(mShard.first) + "-" + to_string(mShard.last) << endl;
+  }
+  if (mResumed > 0) {
+    logger << "resumed simulations" << split << mResumed << endl;
+  }
   logger << "number of threads" << split << int(numthreads) << endl;
   if (mHash != 0)  {
     logger << "running Monte Carlo";
@@ -390,30 +1091,77 @@ void ccruncher::MonteCarlo::run(unsigned char numthreads, size_t nhash, bool *st
   }
   logger << indent(+1);
 
+  // launching output writer
+  size_t maxrows = 0;
+  if (maxiterations > 0) {
+    maxrows = (maxiterations > mResumed ? maxiterations-mResumed : 1);
+  }
+  writer = new WriterThread(aggregators, numSegmentsBySegmentation, mBufferSize, maxrows, statistics);
+  writer->start();
+
   // creating and launching simulation threads
+  mInstrumentation = Instrumentation();
   t1 = steady_clock::now();
-  nfthreads = numthreads;
-  numiterations = 0UL;
+  mLastCheckpoint = t1;
+  numiterations = mResumed;
+  mMore = true;
+  mNumBlocks = mShard.getFirstBlock(blocksize) + mResumed/blocksize;
+  mMaxBlocks = (maxiterations > 0 ? mShard.getFirstBlock(blocksize) + (maxiterations+blocksize-1)/blocksize : 0);
   threads.assign(numthreads, nullptr);
   for(unsigned char i=0; i<numthreads; i++)
   {
-    threads[i] = new SimulationThread(*this, seed+i);
-    if (numthreads == 1) {
-      threads[i]->run();
-    }
-    else {
-      threads[i]->start();
-    }
+    threads[i] = new SimulationThread(*this, seed);
+    threads[i]->start();
   }
 
+  // consuming simulated blocks
+  drain();
+
   // awaiting threads
   for(unsigned char i=0; i<numthreads; i++) {
     threads[i]->join();
+    mInstrumentation.merge(threads[i]->getInstrumentation());
     delete threads[i];
     threads[i] = nullptr;
   }
   threads.clear();
 
+  // writing pending data
+  try {
+    writer->close();
+  }
+  catch(Exception &e) {
+    if (mStatus != status::error) {
+      logger << "error: " << e << endl;
+      mStatus = status::error;
+    }
+  }
+  mInstrumentation.merge(writer->getInstrumentation());
+  delete writer;
+  writer = nullptr;
+
+  // writing statistics summary
+  if (statistics != nullptr && mStatus != status::error) {
+    try {
+      statistics->write();
+    }
+    catch(Exception &e) {
+      logger << "error: " << e << endl;
+      mStatus = status::error;
+    }
+  }
+
+  // saving final state (only at block boundaries)
+  if (mCheckpoint > 0 && mStatus != status::error && numiterations%blocksize == 0) {
+    try {
+      saveCheckpoint();
+    }
+    catch(Exception &e) {
+      logger << "error: " << e << endl;
+      mStatus = status::error;
+    }
+  }
+
   // closing aggregators
   for(size_t i=0; i<aggregators.size(); i++) {
     delete aggregators[i];
@@ -425,8 +1173,14 @@ void ccruncher::MonteCarlo::run(unsigned char numthreads, size_t nhash, bool *st
   logger << indent(-1);
   if (nhash > 0) logger << endl;
   logger << "simulations realized" << split << numiterations << endl;
+  if (convergence != nullptr) {
+    logger << "VaR estimate (batch means)" << split << convergence->getVaR() << endl;
+    logger << "VaR relative std. error" << split << convergence->getRelErr() << endl;
+    logger << "convergence achieved" << split << convergence->isConverged() << endl;
+  }
   auto t2 = steady_clock::now();
   long millis = duration_cast<milliseconds>(t2-t1).count();
+  mInstrumentation.setRun(numthreads, millis/1000.0);
   logger << "elapsed time" << split << Utils::millisToString(millis) << endl;
   logger << indent(-1) << endl;
 
@@ -439,40 +1193,91 @@ void ccruncher::MonteCarlo::run(unsigned char numthreads, size_t nhash, bool *st
 }
 
 /**************************************************************************//**
- * @param[in] losses Simulated data. It is a matrix where each row contains
- *            the losses of one simulation. Rows have the following
- *            structure: S1, S2, ..., Sm where Si are the segments
+ * @details Consumes the blocks published by the simulation threads until
+ *          all of them have finished. Blocks are appended in block index
+ *          order while the stop criteria are not achieved, the remaining
+ *          ones are discarded. Each thread claims increasing indexes, so
+ *          the next block to append is always at the front of a ring
+ *          buffer. Simulation results are handed over to the writer thread.
+ */
+void ccruncher::MonteCarlo::drain()
+{
+  bool finished = false;
+  size_t next = mShard.getFirstBlock(blocksize) + mResumed/blocksize;
+
+  INSTRUMENT_START(mInstrumentation);
+
+  while(!finished)
+  {
+    bool idle = true;
+    finished = true;
+
+    for(SimulationThread *thread : threads)
+    {
+      // flag read before draining to not lose the last blocks
+      bool done = thread->isFinished();
+
+      RingBuffer<SimulationThread::Block> &blocks = thread->getBlocks();
+      SimulationThread::Block *block = nullptr;
+      while((block = blocks.front()) != nullptr) {
+        if (mMore && block->id != next) {
+          break;
+        }
+        INSTRUMENT_LAP(mInstrumentation, DrainWait);
+        if (mMore && !append(block->losses)) {
+          mMore = false;
+        }
+        INSTRUMENT_LAP(mInstrumentation, Append);
+        blocks.pop();
+        next++;
+        idle = false;
+      }
+
+      if (!done) {
+        finished = false;
+      }
+      else if (!thread->getMsgErr().empty() && mStatus != status::error) {
+        logger << "error: " << thread->getMsgErr() << endl;
+        mStatus = status::error;
+        mMore = false;
+      }
+    }
+
+    if (!idle) {
+      // blocks appended in this pass can unlock blocks of previous threads
+      finished = false;
+    }
+    else if (!finished) {
+      this_thread::sleep_for(microseconds(100));
+      INSTRUMENT_LAP(mInstrumentation, DrainWait);
+    }
+  }
+}
+
+/**************************************************************************//**
+ * @param[in] losses Simulated block. It is a row-major matrix where each
+ *            row contains the losses of one simulation. Rows have the
+ *            following structure: S1, S2, ..., Sm where Si are the segments
  *            losses of the i-th segmentation (m=number of segmentations).
  *            Finally, Si has the following structure: L1, L2, ..., Ln where
  *            Li is the simulated loss of the i-th segment (n = number of
  *            segments of the segmentation).
+ * @return true=continue simulating, false=stop criterion achieved.
  */
-bool ccruncher::MonteCarlo::append(const vector<vector<double>> &losses) noexcept
+bool ccruncher::MonteCarlo::append(const vector<double> &losses) noexcept
 {
-  assert(losses.size() == blocksize);
-  assert(!aggregators.empty());
-  assert(aggregators.size() == numSegmentsBySegmentation.size());
-  assert(nfthreads > 0);
+  assert(losses.size() == blocksize*numsegments);
+  assert(writer != nullptr);
 
-  lock_guard<mutex> lock(mMutex);
   bool more = true;
 
-  // if another thread has crashed
-  if (mStatus == status::error) {
-    goto mcExecErr;
-  }
-
   try
   {
-    for(size_t iblock=0; iblock<losses.size(); iblock++)
+    const double *plosses = losses.data();
+    for(size_t iblock=0; iblock<blocksize; iblock++)
     {
       // aggregating simulation result
-      assert(losses[iblock].size() == numsegments);
-      const double *plosses = losses[iblock].data();
-      for(size_t i=0; i<aggregators.size(); i++) {
-        aggregators[i]->append(plosses);
-        plosses += numSegmentsBySegmentation[i];
-      }
+      writer->append(plosses);
 
       // counter increment
       numiterations++;
@@ -482,8 +1287,19 @@ bool ccruncher::MonteCarlo::append(const vector<vector<double>> &losses) noexcep
         logger << '.' << flush;
       }
 
+      // checking convergence stop criterion
+      if (convergence != nullptr) {
+        double loss = accumulate(plosses+stopOffset, plosses+stopOffset+stopSize, 0.0);
+        double weight = (importance ? plosses[numsegments-1] : 1.0);
+        if (convergence->append(loss, weight)) {
+          more = false;
+          break;
+        }
+      }
+      plosses += numsegments;
+
       // checking maximum number of iterations stop criterion
-      if (maxiterations > 0 && numiterations + (nfthreads-1)*blocksize >= maxiterations) {
+      if (maxiterations > 0 && numiterations >= maxiterations) {
         more = false;
         break;
       }
@@ -503,19 +1319,32 @@ bool ccruncher::MonteCarlo::append(const vector<vector<double>> &losses) noexcep
     }
   }
 
+  // saving periodic checkpoint (complete block appended)
+  if (more && mCheckpoint > 0 && mStatus != status::error) {
+    long secs = duration_cast<seconds>(steady_clock::now()-mLastCheckpoint).count();
+    if (secs >= static_cast<long>(mCheckpoint)) {
+      INSTRUMENT_LAP(mInstrumentation, Append);
+      try {
+        saveCheckpoint();
+      }
+      catch(Exception &e) {
+        logger << "error: " << e << endl;
+        mStatus = status::error;
+      }
+      INSTRUMENT_LAP(mInstrumentation, Checkpoint);
+    }
+  }
+
   // checking stop requested by user
   if (mStop != nullptr && *mStop) {
     more = false;
   }
 
-mcExecErr:
   // if error or previous error
   if (mStatus == status::error) {
     more = false;
   }
 
-  // exit function
-  if (!more) nfthreads--;
   return(more);
 }
 
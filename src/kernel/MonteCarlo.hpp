@@ -22,30 +22,45 @@
 
 #pragma once
 
-#include <mutex>
+#include <atomic>
+#include <chrono>
 #include <string>
 #include <vector>
 #include <streambuf>
 #include <gsl/gsl_matrix.h>
+#include "kernel/Aggregator.hpp"
+#include "kernel/BlockKernel.hpp"
+#include "kernel/Convergence.hpp"
+#include "kernel/FlatPortfolio.hpp"
 #include "kernel/Input.hpp"
+#include "kernel/Instrumentation.hpp"
 #include "kernel/Inverse.hpp"
+#include "kernel/Shard.hpp"
+#include "kernel/Statistics.hpp"
 #include "params/CDF.hpp"
 #include "params/Segmentation.hpp"
 #include "portfolio/Obligor.hpp"
+#include "utils/Checkpoint.hpp"
 #include "utils/Date.hpp"
 #include "utils/Logger.hpp"
+#include "utils/Sobol.hpp"
 
 namespace ccruncher {
 
 // forward declarations
 class SimulationThread;
-class Aggregator;
+class WriterThread;
 
 /**************************************************************************//**
  * @brief Monte Carlo simulation.
  *
  * @details This object manages the Monte Carlo simulation. Efective
  *          simulation steps are done in the SimulationThread objects.
+ *          Each thread publishes its simulated blocks in its own ring
+ *          buffer. The calling thread drains these buffers in block index
+ *          order, checks the stop criteria and feeds the output writer
+ *          thread. Given a seed, output is the same whatever the number
+ *          of threads.
  *          Input object used to initialize this class can be removed just
  *          after this class initialization.
  *
@@ -70,14 +85,50 @@ class MonteCarlo
 
     //! Logger
     Logger logger;
-    //! List of simulated obligors
+    //! List of obligors (released after initialization)
     std::vector<Obligor> obligors;
+    //! Simulated portfolio
+    FlatPortfolio portfolio;
     //! Number of segments for each segmentation
     std::vector<unsigned short> numSegmentsBySegmentation;
     //! Total number of segments (included in all segmentations)
     size_t numsegments;
     //! List of aggregators
     std::vector<Aggregator *> aggregators;
+    //! Output writer
+    WriterThread *writer;
+    //! Streaming statistics (null if disabled)
+    Statistics *statistics;
+    //! Streaming statistics mode (none, summary, only)
+    std::string stats;
+    //! Confidence levels of streaming statistics
+    std::vector<double> statsLevels;
+    //! Convergence criterion (null if disabled)
+    Convergence *convergence;
+    //! Segmentation checked by the convergence criterion
+    std::string stopSegmentation;
+    //! VaR confidence level checked by the convergence criterion
+    double stopLevel;
+    //! VaR relative standard error targeted (0 = disabled)
+    double stopPrecision;
+    //! First column of the segmentation checked by the convergence criterion
+    size_t stopOffset;
+    //! Number of segments of the segmentation checked by the convergence criterion
+    size_t stopSize;
+    //! Output buffer size (in bytes)
+    size_t mBufferSize;
+    //! Seconds between checkpoints (0 = disabled)
+    size_t mCheckpoint;
+    //! Checkpoint file name
+    std::string mCheckpointFile;
+    //! Last checkpoint time
+    std::chrono::steady_clock::time_point mLastCheckpoint;
+    //! Number of simulations restored from checkpoint
+    size_t mResumed;
+    //! Digest of the simulated input (see getDigest())
+    unsigned long mDigest;
+    //! Simulated shard (whole run if count is 1)
+    Shard mShard;
     //! Maximum number of iterations
     size_t maxiterations;
     //! Maximum execution time
@@ -92,6 +143,8 @@ class MonteCarlo
     std::vector<CDF> dprobs;
     //! Inverse functions
     std::vector<Inverse> inverses;
+    //! Inverse functions use lookup tables
+    bool invtables;
     //! Cholesky matrix (factor correlations)
     gsl_matrix *chol;
     //! Factor loadings (w_i)
@@ -102,22 +155,44 @@ class MonteCarlo
     bool antithetic;
     //! Block size
     unsigned short blocksize;
+    //! Instruction set used by simulation kernel
+    BlockKernel::Isa isa;
     //! RNG seed
     unsigned long seed;
+    //! Quasi-Monte Carlo mode (none, factors, all)
+    std::string qmc;
+    //! Number of quasi-Monte Carlo replicates
+    unsigned short qmcreplicates;
+    //! Scrambled Sobol sequences by replicate (empty if qmc=none)
+    std::vector<Sobol> sobols;
+    //! Importance sampling of factors
+    bool importance;
+    //! Confidence level targeted by importance sampling
+    double importanceLevel;
+    //! Importance sampling shift of the independent factors (empty if disabled)
+    std::vector<double> ishift;
+    //! Minimum size of obligor pools (0 = disabled)
+    size_t poolminsize;
     //! Hash (0=non show hashes) (default=0)
     size_t mHash;
+    //! Number of threads used by the last run
+    unsigned char mNumThreads;
     //! Simulation starting time
     std::chrono::steady_clock::time_point t1;
     //! Simulation threads
     std::vector<SimulationThread*> threads;
     //! Number of iterations done
     size_t numiterations;
-    //! Number of finished threads
-    size_t nfthreads;
-    //! Ensures data consistence
-    std::mutex mMutex;
+    //! Simulation threads continue while true
+    std::atomic<bool> mMore;
+    //! Number of claimed blocks (next block index)
+    std::atomic<size_t> mNumBlocks;
+    //! Maximum number of blocks (0 = no limit)
+    size_t mMaxBlocks;
     //! Stop flag
     bool *mStop;
+    //! Timers and counters of the last run (see INSTRUMENTATION)
+    Instrumentation mInstrumentation;
     //! Object status
     status mStatus;
 
@@ -136,13 +211,26 @@ class MonteCarlo
     //! Set obligors' portfolio
     void setObligors(std::vector<Obligor> &obligors, const std::vector<Segmentation> &segmentations);
     //! Set segmentations
-    void setSegmentations(const std::vector<Segmentation> &segmentations, const std::string &path, char mode);
+    void setSegmentations(const std::vector<Segmentation> &segmentations, const std::string &path,
+                          char mode, Aggregator::Format format, Checkpoint &checkpoint);
+    //! Digest of the input values that determine the simulated losses
+    unsigned long getDigest() const;
+    //! Restore simulation settings from checkpoint
+    void setResume(Checkpoint &checkpoint);
+    //! Save simulation state to checkpoint file
+    void saveCheckpoint();
+    //! Create scrambled Sobol sequences
+    void setSobols();
+    //! Compute the importance sampling shift
+    void setImportance();
     //! Create Finv(t(x)) spline functions
     void setInverses();
+    //! Compile obligors to the simulated portfolio
+    void setPortfolio();
+    //! Drain simulation threads' ring buffers
+    void drain();
     //! Append simulation result
-    bool append(const std::vector<std::vector<double>> &losses) noexcept;
-    //! Computes the Cholesky matrix
-    gsl_matrix* cholesky(const std::vector<std::vector<double>> &M);
+    bool append(const std::vector<double> &losses) noexcept;
     //! Averaged exposures by segment
     std::vector<double> getExposures(unsigned short isegmentation);
 
@@ -158,7 +246,14 @@ class MonteCarlo
     ~MonteCarlo();
 
     //! Initiliaze this class
-    void init(Input &data, const std::string &path, char mode);
+    void init(Input &data, const std::string &path, char mode,
+              Aggregator::Format format=Aggregator::Format::Csv);
+    //! Set the output buffer size
+    void setBufferSize(size_t numbytes);
+    //! Set the checkpoint period
+    void setCheckpoint(size_t secs);
+    //! Set the simulated shard
+    void setShard(size_t index, size_t count);
     //! Execute Monte Carlo
     void run(unsigned char numthreads, size_t nhash=0, bool *stop=nullptr);
 
@@ -166,11 +261,19 @@ class MonteCarlo
     size_t getNumIterations() const;
     //! Returns maximum number of iterations to do
     size_t getMaxIterations() const;
+    //! Returns the number of threads used by the last run
+    unsigned char getNumThreads() const { return mNumThreads; }
+    //! Returns timers and counters of the last run
+    const Instrumentation& getInstrumentation() const { return mInstrumentation; }
+    //! Computes the Cholesky matrix
+    static gsl_matrix* cholesky(const std::vector<std::vector<double>> &M);
 
   public:
   
     //! Friend class
     friend class SimulationThread;
+    //! Friend class
+    friend class Benchmark;
 
 };
 
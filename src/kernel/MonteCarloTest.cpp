@@ -0,0 +1,434 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#include <map>
+#include <cmath>
+#include <numeric>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "kernel/MonteCarlo.hpp"
+#include "kernel/ShardMerger.hpp"
+#include "kernel/XmlInputData.hpp"
+#include "kernel/MonteCarloTest.hpp"
+#include "utils/CsvFile.hpp"
+#include "utils/Utils.hpp"
+
+using namespace std;
+using namespace ccruncher;
+
+//===========================================================================
+// input file
+//===========================================================================
+static const char *xmlcontent = R"XMLCONTENT(<?xml version='1.0' encoding='UTF-8'?>
+<ccruncher>
+  <title>montecarlo test</title>
+  <description>montecarlo test</description>
+  <parameters>
+    <parameter name='time.0' value='01/01/2020'/>
+    <parameter name='time.T' value='01/01/2023'/>
+    <parameter name='maxiterations' value='$numsims'/>
+    <parameter name='copula' value='t(5)'/>
+    <parameter name='rng.seed' value='1234'/>
+    <parameter name='antithetic' value='true'/>
+    <parameter name='blocksize' value='16'/>
+    <parameter name='stats' value='$stats'/>
+    <parameter name='stop.segmentation' value='portfolio'/>
+    <parameter name='stop.level' value='0.9'/>
+    <parameter name='stop.precision' value='$precision'/>
+  </parameters>
+  <interest type='compound'>
+    <rate t='0D' r='0%'/>
+    <rate t='5Y' r='3%'/>
+  </interest>
+  <ratings>
+    <rating name='A' description='good'/>
+    <rating name='B' description='bad'/>
+    <rating name='D' description='in default'/>
+  </ratings>
+  <dprobs>
+    <dprob rating='A' t='0M' value='0%'/>
+    <dprob rating='A' t='3Y' value='10%'/>
+    <dprob rating='B' t='0M' value='0%'/>
+    <dprob rating='B' t='1Y' value='20%'/>
+    <dprob rating='B' t='3Y' value='45%'/>
+    <dprob rating='D' t='0M' value='100%'/>
+    <dprob rating='D' t='3Y' value='100%'/>
+  </dprobs>
+  <factors>
+    <factor name='S1' loading='25%'/>
+    <factor name='S2' loading='30%'/>
+  </factors>
+  <correlations>
+    <correlation factor1='S1' factor2='S2' value='10%'/>
+  </correlations>
+  <segmentations>
+    <segmentation name='portfolio'/>
+    <segmentation name='sectors'>
+      <segment name='S1'/>
+      <segment name='S2'/>
+    </segmentation>
+  </segmentations>
+  <portfolio>
+    <obligor rating='A' factor='S1' id='o1' lgd='beta(2,3)'>
+      <belongs-to segmentation='sectors' segment='S1'/>
+      <asset id='a1' date='01/01/2019'>
+        <data>
+          <values t='01/01/2021' ead='100.0'/>
+          <values t='01/01/2022' ead='lognormal(4,0.5)'/>
+        </data>
+      </asset>
+    </obligor>
+    <obligor rating='B' factor='S2' id='o2'>
+      <belongs-to segmentation='sectors' segment='S2'/>
+      <asset id='a2' date='01/01/2019'>
+        <data>
+          <values t='01/07/2021' ead='200.0' lgd='uniform(0.2,0.8)'/>
+          <values t='01/07/2022' ead='150.0' lgd='30%'/>
+        </data>
+      </asset>
+    </obligor>
+    <obligor rating='B' factor='S1' id='o3' lgd='40%'>
+      <belongs-to segmentation='sectors' segment='S1'/>
+      <asset id='a3' date='01/01/2019'>
+        <data>
+          <values t='01/01/2023' ead='300.0'/>
+        </data>
+      </asset>
+    </obligor>
+  </portfolio>
+</ccruncher>
+)XMLCONTENT";
+
+//===========================================================================
+// setUp
+//===========================================================================
+void ccruncher_test::MonteCarloTest::setUp()
+{
+  workdir = Utils::makeTempDir("ccruncher-montecarlotest.");
+}
+
+//===========================================================================
+// tearDown
+//===========================================================================
+void ccruncher_test::MonteCarloTest::tearDown()
+{
+  Utils::removeDir(workdir);
+}
+
+//===========================================================================
+// reads a file content
+//===========================================================================
+static string read(const string &filename)
+{
+  ifstream file(filename);
+  return string(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+}
+
+//===========================================================================
+// runs the simulation and returns the simulated values
+//===========================================================================
+static void simulate(const string &workdir, size_t numsims, unsigned char numthreads,
+                     vector<vector<double>> &values, const string &stats="none",
+                     const string &precision="0")
+{
+  map<string,string> defines;
+  defines["numsims"] = to_string(numsims);
+  defines["stats"] = stats;
+  defines["precision"] = precision;
+  XmlInputData input(nullptr);
+  input.readString(xmlcontent, defines);
+
+  MonteCarlo montecarlo(nullptr);
+  montecarlo.init(input, workdir, 'w');
+  montecarlo.run(numthreads, 0);
+
+  values.clear();
+  for(const char *name : {"portfolio", "sectors"}) {
+    CsvFile csv(workdir + Utils::pathSeparator + name + ".csv");
+    vector<vector<double>> columns;
+    csv.getColumns(columns);
+    values.insert(values.end(), columns.begin(), columns.end());
+    csv.close();
+  }
+}
+
+//===========================================================================
+// returns a value of the summary file
+//===========================================================================
+static double getSummaryValue(const string &workdir, const string &prefix)
+{
+  ifstream file(workdir + Utils::pathSeparator + "summary.csv");
+  string line;
+  while(getline(file, line)) {
+    if (line.compare(0, prefix.size(), prefix) == 0) {
+      return stod(line.substr(prefix.size()));
+    }
+  }
+  return NAN;
+}
+
+//===========================================================================
+// test1 (exact number of simulations and thread-independent results)
+//===========================================================================
+void ccruncher_test::MonteCarloTest::test1()
+{
+  // 1001 simulations = 62 blocks of 16 + 9
+  vector<vector<double>> values1;
+  ASSERT_NO_THROW(simulate(workdir, 1001, 1, values1));
+  ASSERT_EQUALS((size_t)3, values1.size());
+  for(size_t i=0; i<values1.size(); i++) {
+    ASSERT_EQUALS((size_t)1001, values1[i].size());
+  }
+
+  vector<vector<double>> values3;
+  ASSERT_NO_THROW(simulate(workdir, 1001, 3, values3));
+  ASSERT_EQUALS(values1.size(), values3.size());
+  for(size_t i=0; i<values1.size(); i++) {
+    ASSERT_EQUALS(values1[i].size(), values3[i].size());
+    for(size_t j=0; j<values1[i].size(); j++) {
+      ASSERT_EQUALS(values1[i][j], values3[i][j]);
+    }
+  }
+
+  // some simulations have losses
+  double sum = 0.0;
+  for(double x : values1[0]) sum += x;
+  ASSERT(sum > 0.0);
+}
+
+//===========================================================================
+// test2 (streaming statistics)
+//===========================================================================
+void ccruncher_test::MonteCarloTest::test2()
+{
+  vector<vector<double>> values;
+  ASSERT_NO_THROW(simulate(workdir, 1000, 2, values, "summary"));
+  ASSERT_EQUALS((size_t)3, values.size());
+
+  double mean = 0.0;
+  double maxloss = 0.0;
+  for(double x : values[0]) {
+    mean += x/values[0].size();
+    maxloss = std::max(maxloss, x);
+  }
+
+  // segmentation files values are rounded to 2 decimals
+  ASSERT_EQUALS_EPSILON(mean, getSummaryValue(workdir, "\"portfolio\", \"portfolio\", \"mean\", , "), 0.005);
+  ASSERT_EQUALS_EPSILON(maxloss, getSummaryValue(workdir, "\"portfolio\", \"portfolio\", \"max\", , "), 0.005);
+  ASSERT(getSummaryValue(workdir, "\"sectors\", \"S2\", \"VaR\", 0.99, ") > 0.0);
+  ASSERT(std::isnan(getSummaryValue(workdir, "\"portfolio\", \"portfolio\", \"stderr\", , ")));
+
+  // quasi-Monte Carlo replicates (block b belongs to replicate b%4)
+  map<string,string> defines;
+  defines["numsims"] = "1024";
+  defines["stats"] = "summary";
+  defines["precision"] = "0";
+  string content = xmlcontent;
+  content.replace(content.find("<parameter name='blocksize'"), 0,
+    "<parameter name='qmc' value='factors'/><parameter name='qmc.replicates' value='4'/>");
+  XmlInputData input(nullptr);
+  input.readString(content, defines);
+  MonteCarlo montecarlo(nullptr);
+  ASSERT_NO_THROW(montecarlo.init(input, workdir, 'w'));
+  ASSERT_NO_THROW(montecarlo.run(2, 0));
+
+  CsvFile csv(workdir + Utils::pathSeparator + "portfolio.csv");
+  vector<double> losses;
+  csv.getColumn(0, losses);
+  ASSERT_EQUALS((size_t)1024, losses.size());
+  vector<double> means(4, 0.0);
+  for(size_t i=0; i<losses.size(); i++) {
+    means[(i/16)%4] += losses[i]/256.0;
+  }
+  double qmean = accumulate(means.begin(), means.end(), 0.0)/4.0;
+  double var = 0.0;
+  for(double x : means) var += (x-qmean)*(x-qmean)/3.0;
+  ASSERT_EQUALS_EPSILON(sqrt(var/4.0), getSummaryValue(workdir, "\"portfolio\", \"portfolio\", \"stderr\", , "), 0.005);
+}
+
+//===========================================================================
+// test3 (convergence stop criterion)
+//===========================================================================
+void ccruncher_test::MonteCarloTest::test3()
+{
+  // VaR(90%) relative std. error below 5% (batches of 1000 simulations)
+  vector<vector<double>> values1;
+  ASSERT_NO_THROW(simulate(workdir, 100000, 1, values1, "none", "0.05"));
+  size_t numsims = values1[0].size();
+  ASSERT(numsims >= 20000);
+  ASSERT(numsims < 100000);
+  ASSERT_EQUALS((size_t)0, numsims%1000);
+
+  // same stop point whatever the number of threads
+  vector<vector<double>> values3;
+  ASSERT_NO_THROW(simulate(workdir, 100000, 3, values3, "none", "0.05"));
+  ASSERT_EQUALS(values1.size(), values3.size());
+  for(size_t i=0; i<values1.size(); i++) {
+    ASSERT_EQUALS(values1[i].size(), values3[i].size());
+  }
+}
+
+//===========================================================================
+// test4 (checkpoint and resume)
+//===========================================================================
+void ccruncher_test::MonteCarloTest::test4()
+{
+  map<string,string> defines;
+  defines["stats"] = "summary";
+  defines["precision"] = "0";
+
+  const string &path = workdir;
+  auto run = [&defines,&path](size_t numsims, char mode, size_t checkpoint) {
+    defines["numsims"] = to_string(numsims);
+    XmlInputData input(nullptr);
+    input.readString(xmlcontent, defines);
+    MonteCarlo montecarlo(nullptr);
+    montecarlo.init(input, path, mode);
+    montecarlo.setCheckpoint(checkpoint);
+    montecarlo.run(2, 0);
+  };
+
+  string portfolio = workdir + Utils::pathSeparator + "portfolio.csv";
+  string sectors = workdir + Utils::pathSeparator + "sectors.csv";
+  string summary = workdir + Utils::pathSeparator + "summary.csv";
+
+  // reference run (1008 simulations = 63 blocks of 16)
+  ASSERT_NO_THROW(run(1008, 'w', 0));
+  string portfolio1 = read(portfolio);
+  string sectors1 = read(sectors);
+  string summary1 = read(summary);
+
+  // first 480 simulations, interrupted after writing some extra rows
+  ASSERT_NO_THROW(run(480, 'w', 3600));
+  ASSERT(read(portfolio) != portfolio1);
+  ofstream(portfolio, ios::app) << "1.00\n2.00\n";
+
+  // resumed up to 1008 simulations
+  ASSERT_NO_THROW(run(1008, 'r', 3600));
+  ASSERT(read(portfolio) == portfolio1);
+  ASSERT(read(sectors) == sectors1);
+  ASSERT(read(summary) == summary1);
+
+  // resume with a modified portfolio fails (output files are preserved)
+  string content = xmlcontent;
+  content.replace(content.find("ead='300.0'"), 11, "ead='310.0'");
+  XmlInputData input(nullptr);
+  input.readString(content, defines);
+  MonteCarlo montecarlo(nullptr);
+  ASSERT_THROW(montecarlo.init(input, workdir, 'r'));
+  ASSERT(read(portfolio) == portfolio1);
+
+  // resume with a distinct stop.level fails
+  content = xmlcontent;
+  content.replace(content.find("value='0.9'"), 11, "value='0.8'");
+  XmlInputData input2(nullptr);
+  input2.readString(content, defines);
+  MonteCarlo montecarlo2(nullptr);
+  ASSERT_THROW(montecarlo2.init(input2, workdir, 'r'));
+  ASSERT(read(portfolio) == portfolio1);
+}
+
+//===========================================================================
+// test5 (shards)
+//===========================================================================
+void ccruncher_test::MonteCarloTest::test5()
+{
+  map<string,string> defines;
+  defines["numsims"] = "1001";
+  defines["stats"] = "none";
+  defines["precision"] = "0";
+
+  const string &path = workdir;
+  auto run = [&defines,&path](size_t index, size_t count) {
+    XmlInputData input(nullptr);
+    input.readString(xmlcontent, defines);
+    MonteCarlo montecarlo(nullptr);
+    montecarlo.setShard(index, count);
+    montecarlo.init(input, path, 'w');
+    montecarlo.run(2, 0);
+  };
+
+  string portfolio = workdir + Utils::pathSeparator + "portfolio.csv";
+  string sector = workdir + Utils::pathSeparator + "sectors.csv";
+
+  // reference run (1001 simulations = 62 blocks of 16 + 9)
+  ASSERT_NO_THROW(run(0, 1));
+  string portfolio1 = read(portfolio);
+  string sectors1 = read(sector);
+
+  // 3 shards (21+21+21 blocks, last one incomplete)
+  vector<string> portfolios, sectors;
+  for(size_t i=0; i<3; i++) {
+    ASSERT_NO_THROW(run(i, 3));
+    portfolios.push_back(workdir + Utils::pathSeparator + "portfolio-" + to_string(i) + ".csv");
+    sectors.push_back(workdir + Utils::pathSeparator + "sectors-" + to_string(i) + ".csv");
+    rename(portfolio.c_str(), portfolios.back().c_str());
+    rename(sector.c_str(), sectors.back().c_str());
+  }
+  ASSERT(read(portfolios[0]).find("# shard: 1/3, seed: 1234, range: 0-336\n") != string::npos);
+  ASSERT(read(portfolios[2]).find("# shard: 3/3, seed: 1234, range: 672-1001\n") != string::npos);
+
+  // merged files are identical to the reference run ones
+  ShardMerger merger1({portfolios[2], portfolios[0], portfolios[1]});
+  ASSERT_EQUALS((size_t)1001, merger1.getNumRows());
+  ASSERT_NO_THROW(merger1.write(portfolio, 'w'));
+  ASSERT(read(portfolio) == portfolio1);
+  ASSERT_NO_THROW(ShardMerger(sectors).write(sector, 'w'));
+  ASSERT(read(sector) == sectors1);
+
+  // shards require a fixed number of iterations
+  defines["numsims"] = "0";
+  ASSERT_THROW(run(0, 3));
+}
+
+//===========================================================================
+// test6 (reserved weights file)
+//===========================================================================
+void ccruncher_test::MonteCarloTest::test6()
+{
+  map<string,string> defines;
+  defines["numsims"] = "100";
+  defines["stats"] = "none";
+  defines["precision"] = "0";
+
+  // stale weights file removed when overwriting without importance sampling
+  string weights = workdir + Utils::pathSeparator + "weights.csv";
+  ofstream(weights) << "\"weight\"\n1.0\n2.0\n";
+  XmlInputData input(nullptr);
+  input.readString(xmlcontent, defines);
+  MonteCarlo montecarlo(nullptr);
+  ASSERT_NO_THROW(montecarlo.init(input, workdir, 'w'));
+  ASSERT(!ifstream(weights).good());
+
+  // segmentation name 'weights' is always reserved
+  string content = xmlcontent;
+  for(size_t pos=content.find("'sectors'"); pos!=string::npos; pos=content.find("'sectors'")) {
+    content.replace(pos, 9, "'weights'");
+  }
+  XmlInputData input2(nullptr);
+  input2.readString(content, defines);
+  MonteCarlo montecarlo2(nullptr);
+  ASSERT_THROW(montecarlo2.init(input2, workdir, 'w'));
+}
@@ -0,0 +1,689 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#include <map>
+#include <cmath>
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+#include <cassert>
+#include <gsl/gsl_cdf.h>
+#include <gsl/gsl_fft_halfcomplex.h>
+#include "kernel/SemiAnalytic.hpp"
+#include "kernel/MonteCarlo.hpp"
+#include "portfolio/Asset.hpp"
+#include "portfolio/DateValues.hpp"
+#include "params/Params.hpp"
+#include "utils/BatchRng.hpp"
+#include "utils/Utils.hpp"
+#include "utils/Exception.hpp"
+
+// number of scenarios by chunk
+#define CHUNK_SIZE 256
+// number of chunks computed between stop criteria checks
+#define CHUNKS_BY_ROUND 16
+// random stream id of scenarios values (factors, chi-square)
+#define STREAM_FACTORS 0
+
+using namespace std;
+using namespace std::chrono;
+using namespace ccruncher;
+
+/**************************************************************************//**
+ * @details Computes x^n using binary exponentiation (avoids the log(0)
+ *          issue of std::pow).
+ * @param[in] x Base.
+ * @param[in] n Exponent.
+ * @return x^n.
+ */
+static inline complex<double> ipow(complex<double> x, uint32_t n)
+{
+  complex<double> ret = 1.0;
+  while(n > 0) {
+    if (n & 1u) ret *= x;
+    x *= x;
+    n >>= 1;
+  }
+  return ret;
+}
+
+/**************************************************************************//**
+ * @param[in] s Streambuf where the trace will be written.
+ */
+ccruncher::SemiAnalytic::SemiAnalytic(std::streambuf *s) : logger(s), chol(nullptr)
+{
+  numsegments = 0;
+  numbins = 0;
+  ndf = NAN;
+  antithetic = false;
+  seed = 0UL;
+  maxiterations = 0;
+  maxseconds = 0;
+  numiterations = 0;
+  mMode = 'c';
+  mFormat = Aggregator::Format::Csv;
+}
+
+/**************************************************************************/
+ccruncher::SemiAnalytic::~SemiAnalytic()
+{
+  freeMemory();
+}
+
+/**************************************************************************/
+void ccruncher::SemiAnalytic::freeMemory()
+{
+  gsl_matrix_free(chol);
+  chol = nullptr;
+  groups.clear();
+  segmentations.clear();
+  steps.clear();
+  exposures.clear();
+  offsets.clear();
+  floadings2.clear();
+  cfs.clear();
+}
+
+/**************************************************************************//**
+ * @details Checks that portfolio has fixed EADs and LGDs, and creates the
+ *          obligors groups. Input object can be removed after calling
+ *          this method (portfolio is released).
+ * @param[in] data Data read from xml input file.
+ * @param[in] path Directory where the output files will be placed.
+ * @param[in] mode Output files creation mode: w (overwrite), c (create).
+ * @param[in] format Output files format.
+ * @throw Exception Error initializing object.
+ */
+void ccruncher::SemiAnalytic::init(Input &data, const string &path, char mode, Aggregator::Format format)
+{
+  try
+  {
+    logger << "semi-analytic initialization" << flood('*') << endl;
+    logger << indent(+1);
+    auto t1 = steady_clock::now();
+
+    if (mode == 'a') {
+      throw Exception("append mode not supported by the semi-analytic engine");
+    }
+    mPath = path;
+    mMode = mode;
+    mFormat = format;
+
+    const Params &params = data.getParams();
+    setParams(params);
+    Input::validateCDFs(data.getCDFs(), true);
+    setFactors(data.getFactorLoadings(), data.getCorrelations());
+    setSegmentations(data.getSegmentations());
+    setGroups(data.getPortfolio(), data.getCDFs(), params.getTime0(), params.getTimeT());
+
+    logger << "number of bins" << split << numbins << endl;
+    logger << "number of obligor groups" << split << getNumGroups() << endl;
+    long millis = duration_cast<milliseconds>(steady_clock::now()-t1).count();
+    logger << "elapsed time" << split << Utils::millisToString(millis) << endl;
+    logger << indent(-1) << endl;
+  }
+  catch(std::exception &e)
+  {
+    freeMemory();
+    throw Exception(e, "error initializing semi-analytic engine");
+  }
+}
+
+/**************************************************************************//**
+ * @see http://www.ccruncher.net/ifileref.html#parameters
+ * @param[in] params List of parameters.
+ * @throw Exception Invalid parameters.
+ */
+void ccruncher::SemiAnalytic::setParams(const Params &params)
+{
+  params.isValid(true);
+
+  maxseconds = params.getMaxSeconds();
+  maxiterations = params.getMaxIterations();
+  antithetic = params.getAntithetic();
+  ndf = params.getNdf();
+  seed = params.getRngSeed();
+  numbins = params.getAnalyticBins();
+
+  // seed based on clock (if not set)
+  if (seed == 0UL) {
+    seed = Utils::trand();
+  }
+}
+
+/**************************************************************************//**
+ * @param[in] loadings Factor loadings.
+ * @param[in] correlations Factor correlation matrix.
+ * @throw Exception Invalid factors.
+ */
+void ccruncher::SemiAnalytic::setFactors(const vector<double> &loadings,
+    const vector<vector<double>> &correlations)
+{
+  Input::validateFactorLoadings(loadings, true);
+  Input::validateCorrelations(correlations, true);
+  if (correlations.size() != loadings.size()) {
+    throw Exception("invalid correlation matrix dim");
+  }
+
+  floadings2 = loadings;
+  for(size_t i=0; i<floadings2.size(); i++) {
+    floadings2[i] = sqrt(1.0 - loadings[i]*loadings[i]);
+  }
+
+  // chol contains w·chol (see MonteCarlo::setCorrelations())
+  gsl_matrix_free(chol);
+  chol = nullptr;
+  chol = MonteCarlo::cholesky(correlations);
+  for(size_t i=0; i<chol->size1; i++) {
+    for(size_t j=0; j<chol->size2; j++) {
+      gsl_matrix_set(chol, i, j, gsl_matrix_get(chol, i, j)*loadings[i]);
+    }
+  }
+}
+
+/**************************************************************************//**
+ * @param[in] list List of segmentations.
+ * @throw Exception Invalid segmentations.
+ */
+void ccruncher::SemiAnalytic::setSegmentations(const vector<Segmentation> &list)
+{
+  Input::validateSegmentations(list, true);
+  segmentations = list;
+  offsets.assign(segmentations.size(), 0);
+  numsegments = 0;
+  for(size_t i=0; i<segmentations.size(); i++) {
+    offsets[i] = numsegments;
+    numsegments += segmentations[i].size();
+  }
+}
+
+/**************************************************************************//**
+ * @details Default time intervals of an obligor are delimited by the
+ *          dates of its assets (and timeT). The obligor loss is constant
+ *          in each interval (see SimulationThread::simuleObligorLoss()),
+ *          and the interval (t1,t2] has conditional probability
+ *          Phi((q2/s-z)/w) - Phi((q1/s-z)/w), where q is the latent
+ *          threshold tinv(dprob(t)). Losses are discretized preserving
+ *          the mean (the probability is split between the two closest
+ *          grid points). Because each obligor can be rounded up by one
+ *          grid point, the grid step reserves a headroom of
+ *          min(n, 4·sqrt(n)) points (n = number of obligors of the
+ *          segment) so that the sum of losses doesn't wrap around the
+ *          circular FFT (Hoeffding's inequality bounds the wrapped mass
+ *          by exp(-32)). The headroom is not reserved when all losses
+ *          lie on the grid. Obligors are released.
+ * @param[in] obligors List of obligors.
+ * @param[in] dprobs Default probabilities by rating.
+ * @param[in] time0 Starting date.
+ * @param[in] timeT Ending date.
+ * @throw Exception Non-fixed EAD or LGD.
+ */
+void ccruncher::SemiAnalytic::setGroups(vector<Obligor> &obligors, const vector<CDF> &dprobs,
+    const Date &time0, const Date &timeT)
+{
+  Input::validatePortfolio(obligors, chol->size1, dprobs.size(), segmentations, time0, timeT, true);
+
+  // latent threshold by rating and date
+  map<pair<unsigned char,long>,double> cache;
+  auto threshold = [&](unsigned char irating, const Date &date) -> double {
+    pair<unsigned char,long> key(irating, date-time0);
+    auto it = cache.find(key);
+    if (it != cache.end()) return it->second;
+    double u = dprobs[irating].evalue(static_cast<double>(key.second));
+    double q = 0.0;
+    if (u <= 0.0) q = -INFINITY;
+    else if (u >= 1.0) q = +INFINITY;
+    else if (std::isinf(ndf)) q = gsl_cdf_ugaussian_Pinv(u);
+    else q = gsl_cdf_tdist_Pinv(u, ndf);
+    cache[key] = q;
+    return q;
+  };
+
+  // losses by obligor, interval and segment
+  struct Loss { size_t isegment; double qlo; double qhi; double value; };
+  vector<vector<Loss>> losses(obligors.size());
+  vector<double> maxlosses(numsegments, 0.0);
+  vector<size_t> numobligors(numsegments, 0);
+  exposures.assign(numsegments, 0.0);
+  double numdays = timeT - time0;
+
+  for(size_t iobligor=0; iobligor<obligors.size(); iobligor++)
+  {
+    const Obligor &obligor = obligors[iobligor];
+
+    // interval limits
+    vector<Date> nodes(1, timeT);
+    for(const Asset &asset : obligor.assets) {
+      for(const DateValues &values : asset.values) {
+        if (time0 < values.date && values.date < timeT) nodes.push_back(values.date);
+        if (values.ead.getType() != EAD::Type::Fixed ||
+            (LGD::isValid(values.lgd) && values.lgd.getType() != LGD::Type::Fixed) ||
+            (!LGD::isValid(values.lgd) && obligor.lgd.getType() != LGD::Type::Fixed)) {
+          throw Exception("semi-analytic engine requires fixed EAD and LGD values");
+        }
+      }
+    }
+    sort(nodes.begin(), nodes.end());
+    nodes.erase(unique(nodes.begin(), nodes.end()), nodes.end());
+
+    // obligor loss by interval and segment
+    vector<double> maxloss(numsegments, 0.0);
+    double qlo = -INFINITY;
+    for(const Date &node : nodes)
+    {
+      double qhi = threshold(obligor.irating, node);
+      map<size_t,double> values;
+      for(const Asset &asset : obligor.assets) {
+        auto it = lower_bound(asset.values.begin(), asset.values.end(), node,
+                              [](const DateValues &a, const Date &b) { return a.date < b; });
+        if (it == asset.values.end()) continue;
+        const LGD &lgd = (LGD::isValid(it->lgd) ? it->lgd : obligor.lgd);
+        double loss = it->ead.getValue() * lgd.getValue();
+        for(size_t i=0; i<segmentations.size(); i++) {
+          values[offsets[i]+asset.segments[i]] += loss;
+        }
+      }
+      for(const auto &value : values) {
+        if (value.second <= 0.0) continue;
+        losses[iobligor].push_back(Loss{value.first, qlo, qhi, value.second});
+        maxloss[value.first] = std::max(maxloss[value.first], value.second);
+      }
+      qlo = qhi;
+    }
+    for(size_t i=0; i<numsegments; i++) {
+      maxlosses[i] += maxloss[i];
+      if (maxloss[i] > 0.0) numobligors[i]++;
+    }
+
+    // exposures (see MonteCarlo::getExposures())
+    for(const Asset &asset : obligor.assets) {
+      Date prevt = time0;
+      for(const DateValues &values : asset.values) {
+        double weight = (std::min(values.date,timeT) - prevt)/numdays;
+        for(size_t i=0; i<segmentations.size(); i++) {
+          exposures[offsets[i]+asset.segments[i]] += weight * values.ead.getExpected();
+        }
+        prevt = values.date;
+      }
+    }
+  }
+
+  // grid step by segmentation
+  steps.assign(segmentations.size(), 1.0);
+  for(size_t i=0; i<segmentations.size(); i++) {
+    double maxloss = 0.0;
+    for(size_t j=offsets[i]; j<offsets[i]+segmentations[i].size(); j++) {
+      maxloss = std::max(maxloss, maxlosses[j]);
+    }
+    if (maxloss <= 0.0) continue;
+    steps[i] = maxloss/(numbins-1);
+
+    // losses on the grid are never rounded up
+    bool exact = true;
+    for(size_t k=0; k<losses.size() && exact; k++) {
+      for(const Loss &loss : losses[k]) {
+        if (loss.isegment < offsets[i] || offsets[i]+segmentations[i].size() <= loss.isegment) continue;
+        double x = loss.value/steps[i];
+        if (x != floor(x)) { exact = false; break; }
+      }
+    }
+    if (exact) continue;
+
+    for(size_t j=offsets[i]; j<offsets[i]+segmentations[i].size(); j++) {
+      double n = static_cast<double>(numobligors[j]);
+      double headroom = std::min({n, ceil(4.0*sqrt(n)), floor((numbins-1)/2.0)});
+      steps[i] = std::max(steps[i], maxlosses[j]/(numbins-1-headroom));
+    }
+  }
+  vector<double> stepBySegment(numsegments, 1.0);
+  for(size_t i=0; i<segmentations.size(); i++) {
+    fill(stepBySegment.begin()+offsets[i], stepBySegment.begin()+offsets[i]+segmentations[i].size(), steps[i]);
+  }
+
+  // grouping obligors by factor and discretized losses
+  auto bits = [](double x) -> uint64_t { uint64_t ret; memcpy(&ret, &x, sizeof(double)); return ret; };
+  map<vector<uint64_t>,size_t> keys;
+  groups.assign(numsegments, vector<Group>());
+  for(size_t iobligor=0; iobligor<obligors.size(); iobligor++)
+  {
+    vector<Loss> &list = losses[iobligor];
+    stable_sort(list.begin(), list.end(),
+                [](const Loss &a, const Loss &b) { return a.isegment < b.isegment; });
+    for(size_t k=0; k<list.size(); )
+    {
+      size_t isegment = list[k].isegment;
+      Group group{obligors[iobligor].ifactor, 1, vector<Term>()};
+      vector<uint64_t> key = { isegment, group.ifactor };
+      for(; k<list.size() && list[k].isegment == isegment; k++) {
+        double x = list[k].value/stepBySegment[isegment];
+        double unit = std::min(floor(x), double(numbins-1));
+        double frac = (unit < numbins-1 ? x - unit : 0.0);
+        group.terms.push_back(Term{list[k].qlo, list[k].qhi, static_cast<uint32_t>(unit), frac});
+        key.insert(key.end(), {bits(list[k].qlo), bits(list[k].qhi), static_cast<uint64_t>(unit), bits(frac)});
+      }
+      auto it = keys.find(key);
+      if (it == keys.end()) {
+        keys[key] = groups[isegment].size();
+        groups[isegment].push_back(group);
+      }
+      else {
+        groups[isegment][it->second].num++;
+      }
+    }
+    vector<Loss>().swap(list);
+  }
+
+  vector<Obligor>().swap(obligors);
+}
+
+/**************************************************************************/
+size_t ccruncher::SemiAnalytic::getNumGroups() const
+{
+  size_t ret = 0;
+  for(const vector<Group> &list : groups) {
+    ret += list.size();
+  }
+  return ret;
+}
+
+/**************************************************************************//**
+ * @details Scenarios are computed by chunks of CHUNK_SIZE in parallel
+ *          (OpenMP). Chunks CFs are added in chunk order, so results
+ *          don't depend on the number of threads. Stop criteria are
+ *          checked every CHUNKS_BY_ROUND chunks.
+ * @param[in] numthreads Number of threads (0 = number of cores).
+ * @param[in] nhash Number of scenarios per hash (0 = no hashes).
+ * @param[in] stop Stop flag (can be nullptr).
+ * @throw Exception Error computing distributions.
+ */
+void ccruncher::SemiAnalytic::run(unsigned char numthreads, size_t nhash, bool *stop)
+{
+  if (groups.empty()) {
+    throw Exception("semi-analytic engine not initialized");
+  }
+
+  if (numthreads == 0) {
+    numthreads = Utils::getNumCores();
+  }
+
+  logger << "semi-analytic engine" << flood('*') << endl;
+  logger << indent(+1);
+  logger << "seed used to initialize RNG" << split << seed << endl;
+  logger << "maximum execution time (seconds)" << split << maxseconds << endl;
+  logger << "maximum number of scenarios" << split << maxiterations << endl;
+  logger << "antithetic mode" << split << antithetic << endl;
+  logger << "number of threads" << split << int(numthreads) << endl;
+  if (nhash != 0)  {
+    logger << "computing scenarios";
+    logger << " [" << to_string(nhash) << " scenarios per hash]";
+    logger << flood('-') << endl;
+  }
+  logger << indent(+1);
+
+  auto t1 = steady_clock::now();
+  size_t len = numbins/2 + 1;
+  size_t numsims = (antithetic ? 2 : 1);
+  size_t maxdraws = (maxiterations > 0 ? (maxiterations+numsims-1)/numsims : 0);
+  vector<vector<complex<double>>> sums(CHUNKS_BY_ROUND, vector<complex<double>>(numsegments*len));
+  cfs.assign(numsegments*len, 0.0);
+  numiterations = 0;
+  size_t numdraws = 0;
+  bool more = true;
+
+  while(more)
+  {
+    // number of chunks of this round
+    int numchunks = CHUNKS_BY_ROUND;
+    if (maxdraws > 0) {
+      size_t remaining = maxdraws - numdraws;
+      numchunks = static_cast<int>(std::min(size_t(CHUNKS_BY_ROUND), (remaining+CHUNK_SIZE-1)/CHUNK_SIZE));
+    }
+
+    #pragma omp parallel for schedule(dynamic) num_threads(numthreads)
+    for(int ichunk=0; ichunk<numchunks; ichunk++) {
+      size_t first = numdraws + ichunk*CHUNK_SIZE;
+      size_t last = first + CHUNK_SIZE;
+      if (maxdraws > 0) last = std::min(last, maxdraws);
+      fill(sums[ichunk].begin(), sums[ichunk].end(), 0.0);
+      simulate(first, last, sums[ichunk].data());
+    }
+
+    // adding chunks in order
+    for(int ichunk=0; ichunk<numchunks; ichunk++) {
+      for(size_t i=0; i<cfs.size(); i++) {
+        cfs[i] += sums[ichunk][i];
+      }
+      size_t num = std::min(size_t(CHUNK_SIZE), (maxdraws>0 ? maxdraws-numdraws : size_t(CHUNK_SIZE)));
+      for(size_t i=0; i<num*numsims; i++) {
+        numiterations++;
+        if (nhash > 0 && numiterations%nhash == 0) {
+          logger << '.' << flush;
+        }
+      }
+      numdraws += num;
+    }
+
+    // checking stop criteria
+    if (maxdraws > 0 && numdraws >= maxdraws) {
+      more = false;
+    }
+    if (maxseconds > 0) {
+      long secs = duration_cast<seconds>(steady_clock::now()-t1).count();
+      if (secs >= static_cast<long>(maxseconds)) more = false;
+    }
+    if (stop != nullptr && *stop) {
+      more = false;
+    }
+  }
+
+  logger << indent(-1);
+  if (nhash > 0) logger << endl;
+  logger << "scenarios realized" << split << numiterations << endl;
+  long millis = duration_cast<milliseconds>(steady_clock::now()-t1).count();
+  logger << "elapsed time" << split << Utils::millisToString(millis) << endl;
+  logger << indent(-1) << endl;
+
+  // writing distributions
+  write();
+}
+
+/**************************************************************************//**
+ * @details Scenario i draws its values from the random stream
+ *          (i, STREAM_FACTORS). When antithetic, the scenario -z is
+ *          also computed.
+ * @param[in] first First scenario index.
+ * @param[in] last Last scenario index (not included).
+ * @param[in,out] sums Accumulated CFs (numsegments x (numbins/2+1)).
+ */
+void ccruncher::SemiAnalytic::simulate(size_t first, size_t last, complex<double> *sums) const
+{
+  size_t numfactors = chol->size1;
+  BatchRng random(seed);
+  vector<double> x(numfactors, 0.0);
+  vector<double> z(numfactors, 0.0);
+  vector<complex<double>> cf(numbins/2+1);
+
+  // roots of unity: exp(-2·pi·i·k/numbins)
+  vector<complex<double>> roots(numbins);
+  for(size_t k=0; k<numbins; k++) {
+    roots[k] = polar(1.0, -2.0*M_PI*double(k)/double(numbins));
+  }
+
+  for(size_t n=first; n<last; n++)
+  {
+    random.setStream(n, STREAM_FACTORS);
+    random.gaussian(x.data(), numfactors);
+
+    double s = 1.0;
+    if (std::isfinite(ndf)) {
+      double chisq = 0.0;
+      random.chisq(ndf, &chisq, 1);
+      if (chisq < 1e-14) chisq = 1e-14; //avoid division by 0
+      s = sqrt(ndf/chisq);
+    }
+
+    for(size_t i=0; i<numfactors; i++) {
+      z[i] = 0.0;
+      for(size_t j=0; j<=i; j++) {
+        z[i] += gsl_matrix_get(chol, i, j) * x[j];
+      }
+    }
+
+    scenario(z, s, roots, cf, sums);
+
+    if (antithetic) {
+      for(double &val : z) val = -val;
+      scenario(z, s, roots, cf, sums);
+    }
+  }
+}
+
+/**************************************************************************//**
+ * @details The CF of an obligor at frequency j is
+ *          1 + sum_k p_k·((1-f_k)·r^(a_k·j) + f_k·r^((a_k+1)·j) - 1),
+ *          where r = exp(-2·pi·i/numbins), p_k is the conditional
+ *          probability of the k-th interval, and a_k, f_k its discretized
+ *          loss. The CF of a segment is the product of the CFs of its
+ *          obligors. Only the frequencies [0,numbins/2] are computed
+ *          (losses are real values).
+ * @param[in] z Factors (multiplied by the factor loadings).
+ * @param[in] s t-student scaling (1 if gaussian).
+ * @param[in] roots Roots of unity (numbins values).
+ * @param[in] cf Auxiliar vector (numbins/2+1 values).
+ * @param[in,out] sums Accumulated CFs (numsegments x (numbins/2+1)).
+ */
+void ccruncher::SemiAnalytic::scenario(const vector<double> &z, double s, const vector<complex<double>> &roots,
+    vector<complex<double>> &cf, complex<double> *sums) const
+{
+  size_t len = cf.size();
+  vector<double> probs;
+
+  auto phi = [&](double q, unsigned char ifactor) -> double {
+    double w = floadings2[ifactor];
+    if (w > 0.0) return gsl_cdf_ugaussian_P((q/s - z[ifactor])/w);
+    else return (s*z[ifactor] <= q ? 1.0 : 0.0);
+  };
+
+  for(size_t isegment=0; isegment<numsegments; isegment++)
+  {
+    fill(cf.begin(), cf.end(), 1.0);
+
+    for(const Group &group : groups[isegment])
+    {
+      // conditional probabilities of default intervals
+      probs.resize(group.terms.size());
+      double sum = 0.0;
+      for(size_t k=0; k<group.terms.size(); k++) {
+        const Term &term = group.terms[k];
+        probs[k] = phi(term.qhi, group.ifactor) - (term.qlo == -INFINITY ? 0.0 : phi(term.qlo, group.ifactor));
+        sum += probs[k];
+      }
+      if (sum <= 0.0) {
+        continue;
+      }
+
+      for(size_t j=0; j<len; j++) {
+        complex<double> val = 1.0;
+        for(size_t k=0; k<group.terms.size(); k++) {
+          const Term &term = group.terms[k];
+          complex<double> rj = roots[(term.unit*j)%numbins];
+          val += probs[k] * (rj*((1.0-term.frac) + term.frac*roots[j]) - 1.0);
+        }
+        cf[j] *= (group.num == 1 ? val : ipow(val, group.num));
+      }
+    }
+
+    complex<double> *ptr = sums + isegment*len;
+    for(size_t j=0; j<len; j++) {
+      ptr[j] += cf[j];
+    }
+  }
+}
+
+/**************************************************************************//**
+ * @details Writes one file per segmentation named segmentation-dist. Each
+ *          row contains the loss value of a grid point followed by the
+ *          probabilities of each segment to have this loss. Probabilities
+ *          are obtained by the inverse FFT of the averaged CFs. Negative
+ *          values due to rounding errors are set to 0.
+ * @throw Exception Error writing files.
+ */
+void ccruncher::SemiAnalytic::write()
+{
+  size_t len = numbins/2 + 1;
+  vector<double> data(numbins, 0.0);
+  vector<vector<double>> pdfs(numsegments, vector<double>(numbins, 0.0));
+
+  for(size_t isegment=0; isegment<numsegments && numiterations>0; isegment++)
+  {
+    // halfcomplex packing (see gsl_fft_halfcomplex_radix2_inverse)
+    const complex<double> *cf = cfs.data() + isegment*len;
+    data[0] = cf[0].real()/numiterations;
+    for(size_t j=1; j<len; j++) {
+      data[j] = cf[j].real()/numiterations;
+      if (j < numbins-j) data[numbins-j] = cf[j].imag()/numiterations;
+    }
+    gsl_fft_halfcomplex_radix2_inverse(data.data(), 1, numbins);
+
+    double sum = 0.0;
+    for(size_t j=0; j<numbins; j++) {
+      pdfs[isegment][j] = std::max(data[j], 0.0);
+      sum += pdfs[isegment][j];
+    }
+    for(size_t j=0; j<numbins && sum>0.0; j++) {
+      pdfs[isegment][j] /= sum;
+    }
+  }
+
+  logger << "output files" << flood('*') << endl;
+  logger << indent(+1);
+  logger << "directory" << split << "[" + Utils::realpath(mPath) + "]" << endl;
+  vector<double> row;
+  for(size_t i=0; i<segmentations.size(); i++)
+  {
+    const Segmentation &segmentation = segmentations[i];
+    Segmentation header(segmentation.getName(), true, false);
+    header.addSegment("loss");
+    for(unsigned short k=0; k<segmentation.size(); k++) {
+      header.addSegment(segmentation.getSegment(k));
+    }
+
+    string filename = segmentation.getFilename(mPath, "-dist" + Aggregator::getExtension(mFormat));
+    Aggregator aggregator(filename, mMode, header.size(), mFormat);
+    vector<double> hexposures(1, 0.0);
+    hexposures.insert(hexposures.end(), exposures.begin()+offsets[i], exposures.begin()+offsets[i]+segmentation.size());
+    aggregator.printHeader(header, hexposures);
+    aggregator.setPrecision(17);
+
+    row.assign(header.size(), 0.0);
+    for(size_t j=0; j<numbins; j++) {
+      row[0] = j*steps[i];
+      for(unsigned short k=0; k<segmentation.size(); k++) {
+        row[k+1] = pdfs[offsets[i]+k][j];
+      }
+      aggregator.append(row.data());
+    }
+    aggregator.flush();
+    logger << "segmentation" << split << "[" + filename + "]" << endl;
+  }
+  logger << indent(-1) << endl;
+}
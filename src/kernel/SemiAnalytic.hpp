@@ -0,0 +1,177 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <complex>
+#include <cstdint>
+#include <streambuf>
+#include <gsl/gsl_matrix.h>
+#include "kernel/Aggregator.hpp"
+#include "kernel/Input.hpp"
+#include "params/CDF.hpp"
+#include "params/Segmentation.hpp"
+#include "portfolio/Obligor.hpp"
+#include "utils/Date.hpp"
+#include "utils/Logger.hpp"
+
+namespace ccruncher {
+
+/**************************************************************************//**
+ * @brief Semi-analytic loss distribution.
+ *
+ * @details Alternative to MonteCarlo when EADs and LGDs are fixed values.
+ *          Given the factors (and the t-student scaling), obligors default
+ *          independently, so the loss of a segment is a sum of independent
+ *          discrete variables. This engine only simulates the systematic
+ *          factors. For each scenario it computes the characteristic
+ *          function (CF) of each segment loss discretized in a grid of
+ *          numbins points. The mixture of the conditional distributions is
+ *          the average of the conditional CFs, and the loss distribution
+ *          of each segment is obtained by an inverse FFT at the end.
+ *          Obligors with the same factor, default thresholds and
+ *          discretized losses are grouped (CF^n), so the cost of a
+ *          scenario depends on the number of groups, not obligors.
+ *          Scenarios are processed in chunks combined in a fixed order,
+ *          so output doesn't depend on the number of threads.
+ *
+ * @see MonteCarlo
+ */
+class SemiAnalytic
+{
+
+  private:
+
+    //! Loss of an obligor in a default time interval
+    struct Term
+    {
+      //! Latent threshold at interval start (-inf at first interval)
+      double qlo;
+      //! Latent threshold at interval end
+      double qhi;
+      //! Discretized loss (grid point)
+      uint32_t unit;
+      //! Fraction of probability assigned to grid point unit+1
+      double frac;
+    };
+
+    //! Exchangeable obligors of a segment
+    struct Group
+    {
+      //! Factor index
+      unsigned char ifactor;
+      //! Number of obligors
+      uint32_t num;
+      //! Losses by default time interval
+      std::vector<Term> terms;
+    };
+
+  private:
+
+    //! Logger
+    Logger logger;
+    //! Groups by segment (global segment index)
+    std::vector<std::vector<Group>> groups;
+    //! Segmentations
+    std::vector<Segmentation> segmentations;
+    //! Grid step by segmentation
+    std::vector<double> steps;
+    //! Exposures by segment (global segment index)
+    std::vector<double> exposures;
+    //! First segment of each segmentation (global segment index)
+    std::vector<size_t> offsets;
+    //! Total number of segments
+    size_t numsegments;
+    //! Number of grid points (power of 2)
+    size_t numbins;
+    //! Cholesky matrix (multiplied by factor loadings)
+    gsl_matrix *chol;
+    //! Factor loadings (sqrt(1-w_i^2))
+    std::vector<double> floadings2;
+    //! Degrees of freedom
+    double ndf;
+    //! Antithetic method flag
+    bool antithetic;
+    //! RNG seed
+    unsigned long seed;
+    //! Maximum number of scenarios
+    size_t maxiterations;
+    //! Maximum execution time
+    size_t maxseconds;
+    //! Number of scenarios done
+    size_t numiterations;
+    //! Averaged CFs (numsegments x (numbins/2+1) values)
+    std::vector<std::complex<double>> cfs;
+    //! Output directory
+    std::string mPath;
+    //! File creation mode
+    char mMode;
+    //! Output files format
+    Aggregator::Format mFormat;
+
+  private:
+
+    //! Deallocate memory
+    void freeMemory();
+    //! Set parameters
+    void setParams(const Params &params);
+    //! Set factors
+    void setFactors(const std::vector<double> &loadings, const std::vector<std::vector<double>> &correlations);
+    //! Set segmentations
+    void setSegmentations(const std::vector<Segmentation> &segmentations);
+    //! Create obligors groups
+    void setGroups(std::vector<Obligor> &obligors, const std::vector<CDF> &dprobs,
+                   const Date &time0, const Date &timeT);
+    //! Adds the CFs of the given scenarios
+    void simulate(size_t first, size_t last, std::complex<double> *sums) const;
+    //! Adds the CFs of a scenario
+    void scenario(const std::vector<double> &z, double s, const std::vector<std::complex<double>> &roots,
+                  std::vector<std::complex<double>> &cf, std::complex<double> *sums) const;
+    //! Writes the loss distributions
+    void write();
+
+  public:
+
+    //! Constructor
+    SemiAnalytic(std::streambuf *s=nullptr);
+    //! Non-copyable class
+    SemiAnalytic(const SemiAnalytic &) = delete;
+    //! Non-copyable class
+    SemiAnalytic & operator=(const SemiAnalytic &) = delete;
+    //! Destructor
+    ~SemiAnalytic();
+
+    //! Initialize this class
+    void init(Input &data, const std::string &path, char mode,
+              Aggregator::Format format=Aggregator::Format::Csv);
+    //! Computes the loss distributions
+    void run(unsigned char numthreads, size_t nhash=0, bool *stop=nullptr);
+    //! Returns number of scenarios done
+    size_t getNumIterations() const { return numiterations; }
+    //! Returns the number of obligors groups
+    size_t getNumGroups() const;
+
+};
+
+} // namespace
@@ -0,0 +1,214 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#include <map>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <gsl/gsl_randist.h>
+#include "kernel/SemiAnalytic.hpp"
+#include "kernel/XmlInputData.hpp"
+#include "kernel/SemiAnalyticTest.hpp"
+#include "utils/CsvFile.hpp"
+#include "utils/Utils.hpp"
+
+#define EPSILON 1e-12
+
+using namespace std;
+using namespace ccruncher;
+
+//===========================================================================
+// input file (15 obligors with ead=$ead, lgd=100%, pd=$pd)
+//===========================================================================
+static string getXmlContent()
+{
+  string ret = R"XMLCONTENT(<?xml version='1.0' encoding='UTF-8'?>
+<ccruncher>
+  <title>semi-analytic test</title>
+  <description>semi-analytic test</description>
+  <parameters>
+    <parameter name='time.0' value='01/01/2021'/>
+    <parameter name='time.T' value='01/01/2022'/>
+    <parameter name='maxiterations' value='$numsims'/>
+    <parameter name='copula' value='$copula'/>
+    <parameter name='rng.seed' value='1234'/>
+    <parameter name='antithetic' value='true'/>
+    <parameter name='analytic.bins' value='$bins'/>
+  </parameters>
+  <interest type='compound'>
+    <rate t='0D' r='0%'/>
+    <rate t='1Y' r='0%'/>
+  </interest>
+  <ratings>
+    <rating name='A' description='good'/>
+    <rating name='D' description='in default'/>
+  </ratings>
+  <dprobs>
+    <dprob rating='A' t='0M' value='0%'/>
+    <dprob rating='A' t='1Y' value='$pd'/>
+    <dprob rating='D' t='0M' value='100%'/>
+    <dprob rating='D' t='1Y' value='100%'/>
+  </dprobs>
+  <factors>
+    <factor name='S1' loading='$loading'/>
+  </factors>
+  <segmentations>
+    <segmentation name='portfolio'/>
+  </segmentations>
+  <portfolio>
+)XMLCONTENT";
+
+  for(int i=1; i<=15; i++) {
+    string id = to_string(i);
+    ret += "    <obligor rating='A' factor='S1' id='o" + id + "'>\n";
+    ret += "      <asset id='a" + id + "' date='01/01/2020'>\n";
+    ret += "        <data>\n";
+    ret += "          <values t='01/01/2022' ead='$ead'/>\n";
+    ret += "        </data>\n";
+    ret += "      </asset>\n";
+    ret += "    </obligor>\n";
+  }
+
+  ret += "  </portfolio>\n</ccruncher>\n";
+  return ret;
+}
+
+//===========================================================================
+// setUp
+//===========================================================================
+void ccruncher_test::SemiAnalyticTest::setUp()
+{
+  workdir = Utils::makeTempDir("ccruncher-semianalytictest.");
+}
+
+//===========================================================================
+// tearDown
+//===========================================================================
+void ccruncher_test::SemiAnalyticTest::tearDown()
+{
+  Utils::removeDir(workdir);
+}
+
+//===========================================================================
+// computes the distribution and returns the file columns (loss, prob)
+//===========================================================================
+static void compute(const string &workdir, const string &ead, const string &loading,
+                    const string &copula, unsigned char numthreads,
+                    vector<vector<double>> &values, const string &pd="10%",
+                    const string &bins="16")
+{
+  map<string,string> defines;
+  defines["numsims"] = "1000";
+  defines["pd"] = pd;
+  defines["bins"] = bins;
+  defines["ead"] = ead;
+  defines["loading"] = loading;
+  defines["copula"] = copula;
+  XmlInputData input(nullptr);
+  input.readString(getXmlContent(), defines);
+
+  SemiAnalytic analytic(nullptr);
+  analytic.init(input, workdir, 'w');
+  analytic.run(numthreads, 0);
+
+  CsvFile csv(workdir + Utils::pathSeparator + "portfolio-dist.csv");
+  csv.getColumns(values);
+  csv.close();
+}
+
+//===========================================================================
+// test1 (independent obligors = binomial distribution)
+//===========================================================================
+void ccruncher_test::SemiAnalyticTest::test1()
+{
+  vector<vector<double>> values;
+  ASSERT_NO_THROW(compute(workdir, "1", "0%", "gaussian", 1, values));
+  ASSERT_EQUALS((size_t)2, values.size());
+  ASSERT_EQUALS((size_t)16, values[0].size());
+  ASSERT_EQUALS((size_t)16, values[1].size());
+
+  for(unsigned int k=0; k<16; k++) {
+    ASSERT_EQUALS_EPSILON((double)k, values[0][k], EPSILON);
+    double p = gsl_ran_binomial_pdf(k, 0.1, 15);
+    ASSERT_EQUALS_EPSILON(p, values[1][k], EPSILON);
+  }
+}
+
+//===========================================================================
+// test2 (correlated obligors, results don't depend on number of threads)
+//===========================================================================
+void ccruncher_test::SemiAnalyticTest::test2()
+{
+  vector<vector<double>> values1;
+  ASSERT_NO_THROW(compute(workdir, "1", "30%", "t(5)", 1, values1));
+  vector<vector<double>> values4;
+  ASSERT_NO_THROW(compute(workdir, "1", "30%", "t(5)", 4, values4));
+
+  ASSERT_EQUALS((size_t)2, values1.size());
+  ASSERT_EQUALS(values1.size(), values4.size());
+  double sum = 0.0;
+  double mean = 0.0;
+  for(size_t k=0; k<values1[1].size(); k++) {
+    ASSERT_EQUALS(values1[1][k], values4[1][k]);
+    sum += values1[1][k];
+    mean += values1[0][k] * values1[1][k];
+  }
+  ASSERT_EQUALS_EPSILON(1.0, sum, 1e-9);
+  // expected loss = 15 x 10% (up to Monte Carlo error)
+  ASSERT_EQUALS_EPSILON(1.5, mean, 0.1);
+  // correlation fattens the tail
+  ASSERT(values1[1][15] > gsl_ran_binomial_pdf(15, 0.1, 15));
+}
+
+//===========================================================================
+// test3 (stochastic EADs are not supported)
+//===========================================================================
+void ccruncher_test::SemiAnalyticTest::test3()
+{
+  vector<vector<double>> values;
+  ASSERT_THROW(compute(workdir, "lognormal(0,1)", "0%", "gaussian", 1, values));
+}
+
+//===========================================================================
+// test4 (all obligors default, losses don't wrap around the grid)
+//===========================================================================
+void ccruncher_test::SemiAnalyticTest::test4()
+{
+  vector<vector<double>> values;
+  ASSERT_NO_THROW(compute(workdir, "1.3", "0%", "gaussian", 1, values, "99.99%", "64"));
+  ASSERT_EQUALS((size_t)2, values.size());
+  ASSERT_EQUALS((size_t)64, values[1].size());
+
+  // 15 obligors x 1.3 = 19.5 fits in the grid (with headroom)
+  ASSERT(values[0][63] >= 19.5);
+
+  double sum = 0.0;
+  double mean = 0.0;
+  for(size_t k=0; k<values[1].size(); k++) {
+    sum += values[1][k];
+    mean += values[0][k] * values[1][k];
+  }
+  ASSERT_EQUALS_EPSILON(1.0, sum, 1e-9);
+  ASSERT_EQUALS_EPSILON(15*1.3*0.9999, mean, 1e-9);
+  // P(loss=0) = 0.0001^15
+  ASSERT_EQUALS_EPSILON(0.0, values[1][0], 1e-12);
+}
@@ -0,0 +1,101 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#include <cstdio>
+#include <algorithm>
+#include "kernel/Shard.hpp"
+#include "utils/Exception.hpp"
+
+using namespace std;
+using namespace ccruncher;
+
+/**************************************************************************//**
+ * @param[in] i Shard index (0-based).
+ * @param[in] n Number of shards.
+ * @throw Exception Invalid index or count.
+ */
+ccruncher::Shard::Shard(size_t i, size_t n) :
+    index(i), count(n), seed(0UL), first(0UL), last(0UL)
+{
+  if (count == 0 || index >= count) {
+    throw Exception("invalid shard " + to_string(index+1) + "/" + to_string(count));
+  }
+}
+
+/**************************************************************************//**
+ * @details The run has B=ceil(maxiterations/blocksize) blocks. The i-th
+ *          shard simulates the blocks [i·B/count, (i+1)·B/count). The
+ *          last block of the run can be incomplete.
+ * @param[in] maxiterations Number of simulations of the whole run.
+ * @param[in] blocksize Simulation block size.
+ * @throw Exception Number of shards greater than number of blocks.
+ */
+void ccruncher::Shard::setRange(size_t maxiterations, unsigned short blocksize)
+{
+  if (maxiterations == 0 || blocksize == 0) {
+    throw Exception("shards require a maximum number of iterations");
+  }
+  size_t numblocks = (maxiterations+blocksize-1)/blocksize;
+  if (numblocks < count) {
+    throw Exception("number of shards (" + to_string(count) + ") greater than "
+                    "number of blocks (" + to_string(numblocks) + ")");
+  }
+  first = (index*numblocks/count)*blocksize;
+  last = std::min(((index+1)*numblocks/count)*blocksize, maxiterations);
+}
+
+/**************************************************************************//**
+ * @details Description format is 'shard: i/n, seed: s, range: a-b' where
+ *          i is the 1-based shard index and [a,b) the simulations range.
+ * @return Shard description.
+ */
+string ccruncher::Shard::toString() const
+{
+  return "shard: " + to_string(index+1) + "/" + to_string(count) +
+         ", seed: " + to_string(seed) +
+         ", range: " + to_string(first) + "-" + to_string(last);
+}
+
+/**************************************************************************//**
+ * @param[in] str Shard description (see toString()).
+ * @param[out] shard Parsed shard (unchanged if invalid description).
+ * @return true=valid description, false=otherwise.
+ */
+bool ccruncher::Shard::parse(const std::string &str, Shard &shard)
+{
+  size_t i = 0, n = 0, a = 0, b = 0;
+  unsigned long s = 0UL;
+  int len = 0;
+  int rc = sscanf(str.c_str(), "shard: %zu/%zu, seed: %lu, range: %zu-%zu%n", &i, &n, &s, &a, &b, &len);
+  if (rc != 5 || static_cast<size_t>(len) != str.size()) {
+    return false;
+  }
+  if (n == 0 || i == 0 || i > n || a > b) {
+    return false;
+  }
+  shard.index = i-1;
+  shard.count = n;
+  shard.seed = s;
+  shard.first = a;
+  shard.last = b;
+  return true;
+}
@@ -0,0 +1,76 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#pragma once
+
+#include <string>
+
+namespace ccruncher {
+
+/**************************************************************************//**
+ * @brief Fraction of a Monte Carlo run simulated by a process.
+ *
+ * @details A run of maxiterations simulations can be split in count
+ *          shards simulated by independent processes (eg. in distinct
+ *          hosts). Random values depend only on the seed and the block
+ *          index, so each shard simulates a contiguous range of blocks
+ *          using the same seed. The concatenation of the shards' output
+ *          files in shard order is identical to the output of a single
+ *          process (see ShardMerger). Shard description is written in the
+ *          output files header, and is used to validate the merge.
+ *
+ * @see http://ccruncher.net/ofileref.html#shards
+ */
+class Shard
+{
+
+  public:
+
+    //! Shard index (0-based)
+    size_t index;
+    //! Number of shards
+    size_t count;
+    //! RNG seed
+    unsigned long seed;
+    //! First simulation (included)
+    size_t first;
+    //! Last simulation (not included)
+    size_t last;
+
+  public:
+
+    //! Constructor
+    Shard(size_t i=0, size_t n=1);
+    //! Set the simulations range
+    void setRange(size_t maxiterations, unsigned short blocksize);
+    //! Returns the first block index
+    size_t getFirstBlock(unsigned short blocksize) const { return first/blocksize; }
+    //! Returns the number of simulations
+    size_t size() const { return last - first; }
+    //! Returns the shard description
+    std::string toString() const;
+    //! Parse a shard description
+    static bool parse(const std::string &str, Shard &shard);
+
+};
+
+} // namespace
@@ -0,0 +1,322 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <unistd.h>
+#include "kernel/ShardMerger.hpp"
+#include "utils/CsvFile.hpp"
+#include "utils/Exception.hpp"
+#include "utils/Utils.hpp"
+
+// shard description prefix in CSV headers
+#define CSV_SHARD_PREFIX "# shard: "
+// shard description separator in binary generator field
+#define BINARY_SHARD_SEPARATOR "; "
+// copy buffer size (in bytes)
+#define COPY_BUFFER_SIZE (1024*1024)
+
+using namespace std;
+using namespace ccruncher;
+
+/**************************************************************************//**
+ * @details Reads and validates the headers of the given files. The number
+ *          of rows of each file is checked against its simulations range.
+ * @param[in] filenames Shard files of a segmentation (in any order).
+ * @throw Exception Invalid files or shards don't match.
+ */
+ccruncher::ShardMerger::ShardMerger(const vector<string> &filenames) :
+    mRowSize(0), mNumRows(0)
+{
+  if (filenames.empty()) {
+    throw Exception("no shard files to merge");
+  }
+
+  for(size_t i=0; i<filenames.size(); i++)
+  {
+    Part part;
+    part.filename = filenames[i];
+    part.size = Utils::filesize(part.filename);
+
+    string header;
+    size_t rowsize = 0;
+    try {
+      ifstream file;
+      file.exceptions(ios::badbit);
+      file.open(part.filename.c_str(), ios::in|ios::binary);
+      if (!file.is_open()) {
+        throw Exception("can't open file");
+      }
+      char magic[sizeof(CsvFile::BINARY_MAGIC)] = {0};
+      file.read(magic, sizeof(magic));
+      if (file.gcount() == sizeof(magic) && memcmp(magic, CsvFile::BINARY_MAGIC, sizeof(magic)) == 0) {
+        header = readBinaryHeader(file, part, rowsize);
+      }
+      else {
+        file.clear();
+        file.seekg(0);
+        header = readCsvHeader(file, part);
+      }
+    }
+    catch(std::exception &e) {
+      throw Exception(e, "error reading file '" + part.filename + "'");
+    }
+
+    if (i == 0) {
+      mHeader = header;
+      mRowSize = rowsize;
+    }
+    else if (rowsize != mRowSize) {
+      throw Exception("file '" + part.filename + "' has a distinct format");
+    }
+    else if (header != mHeader) {
+      throw Exception("file '" + part.filename + "' has a distinct header (segments or exposures)");
+    }
+    else if (part.shard.count != mParts.front().shard.count) {
+      throw Exception("file '" + part.filename + "' has a distinct number of shards");
+    }
+    else if (part.shard.seed != mParts.front().shard.seed) {
+      throw Exception("file '" + part.filename + "' has a distinct seed");
+    }
+
+    mParts.push_back(part);
+  }
+
+  // sorting by shard index
+  sort(mParts.begin(), mParts.end(),
+    [](const Part &a, const Part &b) -> bool {
+      return a.shard.index < b.shard.index;
+    });
+
+  // checking that the shards cover the whole run
+  if (mParts.size() != mParts.front().shard.count) {
+    throw Exception("found " + to_string(mParts.size()) + " files but run has " +
+                    to_string(mParts.front().shard.count) + " shards");
+  }
+  for(size_t i=0; i<mParts.size(); i++)
+  {
+    const Part &part = mParts[i];
+    if (part.shard.index != i) {
+      throw Exception("shard " + to_string(part.shard.index+1) + " found twice ('" + part.filename + "')");
+    }
+    if (part.shard.first != (i==0 ? 0 : mParts[i-1].shard.last)) {
+      throw Exception("file '" + part.filename + "' has a non contiguous simulations range");
+    }
+    size_t numrows = getNumRows(part);
+    if (numrows != part.shard.size()) {
+      throw Exception("file '" + part.filename + "' is incomplete (" + to_string(numrows) +
+                      " of " + to_string(part.shard.size()) + " simulations)");
+    }
+    mNumRows += numrows;
+  }
+}
+
+/**************************************************************************//**
+ * @details CSV header is composed by comment lines and the column names
+ *          line. The shard description is a comment line that is not
+ *          included in the merged header.
+ * @param[in] file Input file (at beginning).
+ * @param[in,out] part Shard file (shard and offset are set).
+ * @return Header without shard description.
+ * @throw Exception Invalid header.
+ */
+string ccruncher::ShardMerger::readCsvHeader(ifstream &file, Part &part)
+{
+  string header, line;
+  bool found = false;
+
+  while(getline(file, line))
+  {
+    if (line.compare(0, strlen(CSV_SHARD_PREFIX), CSV_SHARD_PREFIX) == 0) {
+      if (found || !Shard::parse(Utils::trim(line.substr(2)), part.shard)) {
+        throw Exception("invalid shard description");
+      }
+      found = true;
+    }
+    else if (!line.empty() && line[0] == '#') {
+      header += line + "\n";
+    }
+    else {
+      header += line + "\n";
+      part.offset = static_cast<size_t>(file.tellg());
+      if (!found) {
+        throw Exception("file is not a shard");
+      }
+      return header;
+    }
+  }
+
+  throw Exception("invalid CSV header");
+}
+
+/**************************************************************************//**
+ * @details Binary header layout is described in Aggregator. The shard
+ *          description is appended to the generator field. The merged
+ *          header has the same layout without the shard description.
+ * @param[in] file Input file (after the magic number).
+ * @param[in,out] part Shard file (shard and offset are set).
+ * @param[out] rowsize Row size (in bytes).
+ * @return Header without shard description.
+ * @throw Exception Invalid header.
+ */
+string ccruncher::ShardMerger::readBinaryHeader(ifstream &file, Part &part, size_t &rowsize)
+{
+  uint32_t values[5];
+  file.read(reinterpret_cast<char*>(values), sizeof(values));
+  if (file.gcount() != sizeof(values)) {
+    throw Exception("invalid binary header");
+  }
+  if (!Utils::isLittleEndian()) {
+    Utils::swapBytes(values, sizeof(uint32_t), 5);
+  }
+
+  size_t len0 = sizeof(CsvFile::BINARY_MAGIC) + sizeof(values);
+  if (values[0] != CsvFile::BINARY_VERSION) {
+    throw Exception("unsupported binary version");
+  }
+  if (values[1] != sizeof(float) && values[1] != sizeof(double)) {
+    throw Exception("invalid value size");
+  }
+  if (values[2] == 0 || values[3] > part.size || values[3] < len0 + values[4]) {
+    throw Exception("invalid binary header");
+  }
+
+  // generator and segments (names and exposures)
+  string generator(values[4], '\0');
+  string segments(values[3] - len0 - values[4], '\0');
+  file.read(&generator[0], generator.size());
+  file.read(&segments[0], segments.size());
+  if (!file) {
+    throw Exception("invalid binary header");
+  }
+
+  size_t pos = generator.find(BINARY_SHARD_SEPARATOR "shard: ");
+  if (pos == string::npos) {
+    throw Exception("file is not a shard");
+  }
+  if (!Shard::parse(generator.substr(pos+strlen(BINARY_SHARD_SEPARATOR)), part.shard)) {
+    throw Exception("invalid shard description");
+  }
+  generator.erase(pos);
+
+  part.offset = values[3];
+  rowsize = static_cast<size_t>(values[1])*values[2];
+
+  values[3] = len0 + generator.size() + segments.size();
+  values[4] = generator.size();
+  if (!Utils::isLittleEndian()) {
+    Utils::swapBytes(values, sizeof(uint32_t), 5);
+  }
+
+  string header(CsvFile::BINARY_MAGIC, sizeof(CsvFile::BINARY_MAGIC));
+  header.append(reinterpret_cast<const char*>(values), sizeof(values));
+  return header + generator + segments;
+}
+
+/**************************************************************************//**
+ * @details CSV rows are counted reading the file. The last row must be
+ *          complete.
+ * @param[in] part Shard file.
+ * @return Number of rows.
+ * @throw Exception Incomplete row.
+ */
+size_t ccruncher::ShardMerger::getNumRows(const Part &part) const
+{
+  size_t datasize = part.size - part.offset;
+
+  if (mRowSize > 0) {
+    if (datasize%mRowSize != 0) {
+      throw Exception("file '" + part.filename + "' has an incomplete row");
+    }
+    return datasize/mRowSize;
+  }
+
+  size_t numrows = 0;
+  char last = '\n';
+  vector<char> buffer(COPY_BUFFER_SIZE);
+  ifstream file(part.filename.c_str(), ios::in|ios::binary);
+  file.seekg(part.offset);
+  while(file.read(buffer.data(), buffer.size()) || file.gcount() > 0) {
+    size_t len = file.gcount();
+    numrows += count(buffer.begin(), buffer.begin()+len, '\n');
+    last = buffer[len-1];
+  }
+  if (last != '\n') {
+    throw Exception("file '" + part.filename + "' has an incomplete row");
+  }
+  return numrows;
+}
+
+/**************************************************************************//**
+ * @details Writes the merged header followed by the rows of each shard.
+ * @param[in] filename Merged file name (can't be a shard file).
+ * @param[in] mode File creation mode: w (overwrite), c (create, fails if
+ *            file exist).
+ * @throw Exception Error writing file.
+ */
+void ccruncher::ShardMerger::write(const string &filename, char mode) const
+{
+  if (mode != 'w' && mode != 'c') {
+    throw Exception("invalid file mode");
+  }
+  if (access(filename.c_str(), F_OK) == 0) {
+    if (mode == 'c') {
+      throw Exception("file '" + filename + "' already exist");
+    }
+    string path = Utils::realpath(filename);
+    for(const Part &part : mParts) {
+      if (path == Utils::realpath(part.filename)) {
+        throw Exception("merged file can't be a shard file ('" + filename + "')");
+      }
+    }
+  }
+
+  try
+  {
+    ofstream ofile;
+    ofile.exceptions(ios::failbit | ios::badbit);
+    ofile.open(filename.c_str(), ios::out|ios::trunc|ios::binary);
+    ofile.write(mHeader.data(), mHeader.size());
+
+    vector<char> buffer(COPY_BUFFER_SIZE);
+    for(const Part &part : mParts)
+    {
+      ifstream ifile(part.filename.c_str(), ios::in|ios::binary);
+      ifile.seekg(part.offset);
+      size_t pending = part.size - part.offset;
+      while(pending > 0) {
+        size_t len = std::min(pending, buffer.size());
+        if (!ifile.read(buffer.data(), len)) {
+          throw Exception("error reading file '" + part.filename + "'");
+        }
+        ofile.write(buffer.data(), len);
+        pending -= len;
+      }
+    }
+
+    ofile.close();
+  }
+  catch(std::exception &e) {
+    throw Exception(e, "error writing file '" + filename + "'");
+  }
+}
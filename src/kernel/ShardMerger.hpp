@@ -0,0 +1,100 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include "kernel/Shard.hpp"
+
+namespace ccruncher {
+
+/**************************************************************************//**
+ * @brief Merges the shards of a segmentation file.
+ *
+ * @details Combines the output files of a segmentation (CSV or binary)
+ *          simulated by the shards of a run (see Shard). Files are
+ *          validated before writing anything: they must have the same
+ *          format, header (segments, exposures, version) and seed, the
+ *          shards must be complete (each file contains all the
+ *          simulations of its range) and all the shards of the run must
+ *          be present. The merged file has the header of a single process
+ *          run (without shard description) followed by the rows of each
+ *          shard in shard order.
+ *
+ * @see http://ccruncher.net/ofileref.html#shards
+ */
+class ShardMerger
+{
+
+  private:
+
+    //! Shard file
+    struct Part
+    {
+      //! File name
+      std::string filename;
+      //! Shard description
+      Shard shard;
+      //! Data offset (in bytes)
+      size_t offset;
+      //! File size (in bytes)
+      size_t size;
+    };
+
+  private:
+
+    //! Shard files (in shard order)
+    std::vector<Part> mParts;
+    //! Header of the merged file
+    std::string mHeader;
+    //! Row size in bytes (0 = CSV file)
+    size_t mRowSize;
+    //! Number of rows of the merged file
+    size_t mNumRows;
+
+  private:
+
+    //! Read the header of a CSV file
+    std::string readCsvHeader(std::ifstream &file, Part &part);
+    //! Read the header of a binary file
+    std::string readBinaryHeader(std::ifstream &file, Part &part, size_t &rowsize);
+    //! Returns the number of rows of a shard file
+    size_t getNumRows(const Part &part) const;
+
+  public:
+
+    //! Constructor
+    ShardMerger(const std::vector<std::string> &filenames);
+    //! Write the merged file
+    void write(const std::string &filename, char mode='c') const;
+    //! Returns the number of shards
+    size_t getNumShards() const { return mParts.size(); }
+    //! Returns the number of rows of the merged file
+    size_t getNumRows() const { return mNumRows; }
+    //! Returns the seed of the run
+    unsigned long getSeed() const { return mParts.front().shard.seed; }
+
+};
+
+} // namespace
@@ -0,0 +1,212 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#include <vector>
+#include "kernel/ShardMerger.hpp"
+#include "kernel/ShardMergerTest.hpp"
+#include "params/Segmentation.hpp"
+#include "utils/CsvFile.hpp"
+#include "utils/Utils.hpp"
+
+#define FILENAME "ccruncher-shardmergertest"
+
+using namespace std;
+using namespace ccruncher;
+
+//===========================================================================
+// setUp
+//===========================================================================
+void ccruncher_test::ShardMergerTest::setUp()
+{
+  workdir = Utils::makeTempDir("ccruncher-shardmergertest.");
+}
+
+//===========================================================================
+// tearDown
+//===========================================================================
+void ccruncher_test::ShardMergerTest::tearDown()
+{
+  Utils::removeDir(workdir);
+}
+
+//===========================================================================
+// write
+// writes the file of a shard (row i has values i, 2*i)
+//===========================================================================
+string ccruncher_test::ShardMergerTest::write(const Shard &shard, size_t numrows,
+    Aggregator::Format format, const string &segment)
+{
+  string filename = workdir + Utils::pathSeparator + FILENAME + "-" +
+                    to_string(shard.index) + Aggregator::getExtension(format);
+
+  Segmentation segmentation("sectors", true, false);
+  segmentation.addSegment(segment);
+  segmentation.addSegment("S2");
+  vector<double> exposures = { 100.0, 200.0 };
+
+  Aggregator aggregator(filename, 'w', segmentation.size(), format);
+  aggregator.printHeader(segmentation, exposures, shard.toString());
+  for(size_t i=shard.first; i<shard.first+numrows; i++) {
+    vector<double> losses = { double(i), 2.0*i };
+    aggregator.append(losses.data());
+  }
+  return filename;
+}
+
+//===========================================================================
+// check
+// merges 3 shards and reads the merged file using CsvFile
+//===========================================================================
+void ccruncher_test::ShardMergerTest::check(Aggregator::Format format)
+{
+  string filename = workdir + Utils::pathSeparator + FILENAME + Aggregator::getExtension(format);
+
+  vector<string> filenames;
+  for(size_t i=0; i<3; i++) {
+    Shard shard(i, 3);
+    shard.seed = 1234UL;
+    shard.setRange(100, 8);
+    filenames.push_back(write(shard, shard.size(), format));
+  }
+
+  ShardMerger merger({filenames[1], filenames[2], filenames[0]});
+  ASSERT_EQUALS((size_t)3, merger.getNumShards());
+  ASSERT_EQUALS((size_t)100, merger.getNumRows());
+  ASSERT_EQUALS(1234UL, merger.getSeed());
+  ASSERT_NO_THROW(merger.write(filename, 'c'));
+  ASSERT_THROW(merger.write(filename, 'c'));
+  ASSERT_THROW(merger.write(filenames[0], 'w'));
+
+  CsvFile csv(filename);
+  const vector<string> &headers = csv.getHeaders();
+  ASSERT_EQUALS((size_t)2, headers.size());
+  ASSERT_EQUALS(string("S1"), headers[0]);
+  vector<double> values;
+  csv.getColumn(1, values);
+  ASSERT_EQUALS((size_t)100, values.size());
+  for(size_t i=0; i<values.size(); i++) {
+    ASSERT_EQUALS_EPSILON(2.0*i, values[i], 1e-12);
+  }
+  csv.close();
+
+  // merged file isn't a shard
+  ASSERT_THROW(ShardMerger({filename}));
+}
+
+//===========================================================================
+// test1. shard ranges and descriptions
+//===========================================================================
+void ccruncher_test::ShardMergerTest::test1()
+{
+  ASSERT_THROW(Shard(0, 0));
+  ASSERT_THROW(Shard(3, 3));
+
+  // 100 simulations = 12 blocks of 8 + 4 (shard 3 has blocks 8 to 12)
+  Shard shard(2, 3);
+  ASSERT_THROW(shard.setRange(0, 8));
+  ASSERT_NO_THROW(shard.setRange(100, 8));
+  ASSERT_EQUALS((size_t)64, shard.first);
+  ASSERT_EQUALS((size_t)100, shard.last);
+  ASSERT_EQUALS((size_t)8, shard.getFirstBlock(8));
+  ASSERT_EQUALS((size_t)36, shard.size());
+
+  // shards cover the whole run
+  size_t last = 0;
+  for(size_t i=0; i<5; i++) {
+    Shard aux(i, 5);
+    aux.setRange(1001, 16);
+    ASSERT_EQUALS(last, aux.first);
+    ASSERT_EQUALS((size_t)0, aux.first%16);
+    last = aux.last;
+  }
+  ASSERT_EQUALS((size_t)1001, last);
+
+  // more shards than blocks
+  ASSERT_THROW(Shard(0, 20).setRange(100, 8));
+
+  shard.seed = 1234UL;
+  ASSERT_EQUALS(string("shard: 3/3, seed: 1234, range: 64-100"), shard.toString());
+  Shard other;
+  ASSERT(Shard::parse(shard.toString(), other));
+  ASSERT_EQUALS(shard.toString(), other.toString());
+  ASSERT(!Shard::parse("shard: 4/3, seed: 1234, range: 72-100", other));
+  ASSERT(!Shard::parse("shard: 3/3, seed: 1234", other));
+  ASSERT(!Shard::parse("shard: 3/3, seed: 1234, range: 72-100 ", other));
+}
+
+//===========================================================================
+// test2. csv format
+//===========================================================================
+void ccruncher_test::ShardMergerTest::test2()
+{
+  check(Aggregator::Format::Csv);
+}
+
+//===========================================================================
+// test3. binary format
+//===========================================================================
+void ccruncher_test::ShardMergerTest::test3()
+{
+  check(Aggregator::Format::Float64);
+}
+
+//===========================================================================
+// test4. invalid shards
+//===========================================================================
+void ccruncher_test::ShardMergerTest::test4()
+{
+  vector<Shard> shards;
+  for(size_t i=0; i<2; i++) {
+    shards.push_back(Shard(i, 2));
+    shards.back().seed = 1234UL;
+    shards.back().setRange(100, 8);
+  }
+
+  // missing shard
+  string file0 = write(shards[0], shards[0].size(), Aggregator::Format::Csv);
+  ASSERT_THROW(ShardMerger({file0}));
+
+  // incomplete shard
+  string file1 = write(shards[1], shards[1].size()-1, Aggregator::Format::Csv);
+  ASSERT_THROW(ShardMerger({file0, file1}));
+
+  // distinct segments
+  file1 = write(shards[1], shards[1].size(), Aggregator::Format::Csv, "S3");
+  ASSERT_THROW(ShardMerger({file0, file1}));
+
+  // distinct seed
+  shards[1].seed = 4321UL;
+  file1 = write(shards[1], shards[1].size(), Aggregator::Format::Csv);
+  ASSERT_THROW(ShardMerger({file0, file1}));
+
+  // distinct format
+  shards[1].seed = 1234UL;
+  string file2 = write(shards[1], shards[1].size(), Aggregator::Format::Float64);
+  ASSERT_THROW(ShardMerger({file0, file2}));
+
+  // duplicated shard
+  ASSERT_THROW(ShardMerger({file0, file0}));
+
+  // valid shards
+  file1 = write(shards[1], shards[1].size(), Aggregator::Format::Csv);
+  ASSERT_NO_THROW(ShardMerger({file0, file1}));
+}
@@ -21,27 +21,39 @@
 //===========================================================================
 
 #include <cmath>
+#include <chrono>
+#include <thread>
 #include <numeric>
 #include <algorithm>
 #include <cassert>
 #include <gsl/gsl_cdf.h>
 #include <gsl/gsl_blas.h>
+#include <gsl/gsl_randist.h>
 #include "kernel/SimulationThread.hpp"
 #include "portfolio/DateValues.hpp"
 
+// number of blocks in the ring buffer
+#define NUMBLOCKS 4
+// number of block indexes claimed at once (<= NUMBLOCKS)
+#define BLOCKS_PER_CLAIM 2
+// random stream of block values (factors, chi-square)
+#define STREAM_BLOCK 0
+
 using namespace std;
 using namespace ccruncher;
 
 /**************************************************************************//**
  * @param[in] mc MonteCarlo manager.
- * @param[in] seed RNG seed.
+ * @param[in] seed RNG seed (same for all threads).
  */
 ccruncher::SimulationThread::SimulationThread(MonteCarlo &mc, unsigned long seed) :
-  Thread(), montecarlo(mc), obligors(mc.obligors), numSegmentsBySegmentation(mc.numSegmentsBySegmentation), 
+  Thread(), montecarlo(mc), portfolio(mc.portfolio),
   chol(mc.chol), floadings2(mc.floadings2), inverses(mc.inverses),
   numfactors(mc.chol->size1), ndf(mc.ndf), time0(mc.time0), timeT(mc.timeT),
   antithetic(mc.antithetic), numsegments(mc.numsegments),
-  blocksize(mc.blocksize), rng(nullptr), vec(nullptr)
+  blocksize(mc.blocksize), sobols(mc.sobols), ishift(mc.ishift), kernel(mc.isa), random(seed),
+  mBlocks(NUMBLOCKS, Block{0, vector<double>(mc.blocksize*mc.numsegments, 0.0)}),
+  mFinished(false)
 {
   assert(blocksize > 0);
   assert(numfactors > 0);
@@ -51,105 +63,266 @@ ccruncher::SimulationThread::SimulationThread(MonteCarlo &mc, unsigned long seed
   assert(numfactors == floadings2.size());
   assert(antithetic?(blocksize%2!=0?false:true):true);
 
-  vec = gsl_vector_alloc(numfactors);
-  rng = gsl_rng_alloc(gsl_rng_mt19937);
-  gsl_rng_set(rng, seed);
+  thresholds.resize(inverses.size());
+  for(size_t i=0; i<inverses.size(); i++) {
+    thresholds[i] = inverses[i].getThreshold();
+  }
+
+  if (!sobols.empty()) {
+    points.resize(sobols[0].size()*(blocksize/(antithetic?2:1)), 0.0);
+  }
+  if (!ishift.empty()) {
+    assert(ishift.size() == numfactors);
+    weights.resize(blocksize/(antithetic?2:1), 1.0);
+  }
+
+  assert(portfolio.getValuesKind() != FlatPortfolio::ValuesKind::Fixed ||
+         portfolio.stepOffsets.size() == portfolio.size()+1);
+
+  // selecting the specialized simulation loop
+  if (isfinite(ndf)) {
+    mSimulate = (antithetic ? getSimulate<true,true>() : getSimulate<true,false>());
+  }
+  else {
+    mSimulate = (antithetic ? getSimulate<false,true>() : getSimulate<false,false>());
+  }
+}
+
+/**************************************************************************//**
+ * @details Returns the simulation loop instantiated for the given copula
+ *          and antithetic mode, and the portfolio values kind.
+ * @tparam TStudent T-Student copula (gaussian otherwise).
+ * @tparam Antithetic Antithetic mode.
+ * @return Simulation loop.
+ */
+template<bool TStudent, bool Antithetic>
+SimulationThread::SimulateFunc ccruncher::SimulationThread::getSimulate() const
+{
+  if (portfolio.getValuesKind() == FlatPortfolio::ValuesKind::Fixed) {
+    return &SimulationThread::simulate<TStudent,Antithetic,FlatPortfolio::ValuesKind::Fixed>;
+  }
+  else {
+    return &SimulationThread::simulate<TStudent,Antithetic,FlatPortfolio::ValuesKind::Random>;
+  }
 }
 
 /**************************************************************************/
 ccruncher::SimulationThread::~SimulationThread()
 {
-  gsl_rng_free(rng);
-  gsl_vector_free(vec);
+  // nothing to do
 }
 
 /**************************************************************************//**
- * @details Does simulations sending results to master until it indicates
- *          to stop.
+ * @details Does simulations publishing results in the ring buffer until
+ *          MonteCarlo indicates to stop. Errors are not propagated, they
+ *          are reported by SimulationThread::getMsgErr().
  * @see Thread::run()
  */
 void ccruncher::SimulationThread::run()
 {
-  vector<vector<double>> losses(blocksize, vector<double>(numsegments, 0.0));
-  vector<vector<double>> z(numfactors, vector<double>(blocksize/(antithetic?2:1), 0.0));
-  vector<double> s(blocksize/(antithetic?2:1), 1.0);
-  vector<double> x(blocksize/(antithetic?2:1), 0.0);
-  bool more = true;
+  try {
+    (this->*mSimulate)();
+  }
+  catch(std::exception &e) {
+    mMsgErr = e.what();
+    if (mMsgErr.empty()) mMsgErr = "simulation error";
+  }
+  catch(...) {
+    mMsgErr = "unexpected error";
+  }
+
+  if (!mMsgErr.empty()) {
+    montecarlo.mMore = false;
+  }
+  mFinished.store(true, memory_order_release);
+}
+
+/**************************************************************************//**
+ * @details Simulates blocks of blocksize simulations. Each simulated block
+ *          is published in the ring buffer. Ranges of BLOCKS_PER_CLAIM
+ *          block indexes are claimed from MonteCarlo once a free slot is
+ *          available. Claims lower or equal than the ring size ensure
+ *          that ordered draining never stalls the threads. Indexes above
+ *          the maximum number of blocks are not simulated, so exactly
+ *          maxiterations simulations are done (up to block rounding).
+ *          Random values of the i-th obligor are drawn from stream
+ *          (block index, i+1). Copula, antithetic mode and values kind
+ *          are template parameters, so the loop is compiled without
+ *          their runtime checks (see SimulationThread()).
+ * @tparam TStudent T-Student copula (gaussian otherwise).
+ * @tparam Antithetic Antithetic mode.
+ * @tparam Values Portfolio values kind.
+ */
+template<bool TStudent, bool Antithetic, FlatPortfolio::ValuesKind Values>
+void ccruncher::SimulationThread::simulate()
+{
+  assert(TStudent == std::isfinite(ndf));
+  assert(Antithetic == antithetic);
+  assert(Values == portfolio.getValuesKind());
+  size_t len = blocksize/(Antithetic?2:1);
+  vector<double> z(numfactors*len, 0.0);
+  vector<double> s(len, 1.0);
+  vector<double> x(len, 0.0);
+  vector<unsigned short> events(blocksize, 0);
+  vector<double> values(blocksize, 0.0);
+  Block *block = nullptr;
+  size_t nextid = 0;
+  size_t endid = 0;
 
-  while(more)
+  static_assert(BLOCKS_PER_CLAIM <= NUMBLOCKS, "claims greater than ring size");
+
+  INSTRUMENT_START(mInstrumentation);
+
+  while((block = getFreeBlock()) != nullptr)
   {
+    // claiming block indexes
+    if (nextid == endid) {
+      nextid = montecarlo.mNumBlocks.fetch_add(BLOCKS_PER_CLAIM, memory_order_relaxed);
+      endid = nextid + BLOCKS_PER_CLAIM;
+    }
+    block->id = nextid++;
+    if (montecarlo.mMaxBlocks > 0 && block->id >= montecarlo.mMaxBlocks) {
+      break;
+    }
+    INSTRUMENT_LAP(mInstrumentation, PublishWait);
+    INSTRUMENT_COUNT(mInstrumentation, Blocks, 1);
+
     // simulating latent variables
-    rchisq(s);
-    rmvnorm(z);
+    random.setStream(block->id, STREAM_BLOCK);
+    if (sobols.empty()) {
+      rchisq<TStudent>(s);
+      INSTRUMENT_LAP(mInstrumentation, ChiSquare);
+      rmvnorm(z);
+    }
+    else {
+      rqmc<TStudent>(block->id, s, z);
+    }
+    INSTRUMENT_LAP(mInstrumentation, Factors);
 
     // reset aggregated values
-    for(size_t i=0; i<losses.size(); i++) {
-      fill(losses[i].begin(), losses[i].end(), 0.0);
+    fill(block->losses.begin(), block->losses.end(), 0.0);
+    double *losses = block->losses.data();
+
+    // likelihood ratios (last column, same value for antithetic pairs)
+    if (!ishift.empty()) {
+      for(size_t j=0; j<blocksize; j++) {
+        losses[j*numsegments+numsegments-1] = weights[Antithetic?j/2:j];
+      }
     }
+    INSTRUMENT_LAP(mInstrumentation, Losses);
 
-    for(size_t iobligor=0; iobligor<obligors.size(); iobligor++)
+    for(size_t iobligor=0; iobligor<portfolio.size(); iobligor++)
     {
       // simulating iid N(0,1) values (epsilons)
-      for(size_t j=0; j<x.size(); j++) {
-        x[j] = gsl_ran_gaussian_ziggurat(rng, 1.0);
+      random.setStream(block->id, static_cast<uint32_t>(iobligor+1));
+      unsigned char ifactor = portfolio.ifactors[iobligor];
+      const double *zf = z.data() + ifactor*len;
+
+      // obligors pool (conditional binomial)
+      if (portfolio.poolSizes[iobligor] > 1) {
+        size_t numdefaults = simulePoolLoss<TStudent,Antithetic,Values>(iobligor, zf, s, losses);
+        INSTRUMENT_COUNT(mInstrumentation, Defaults, numdefaults);
+        INSTRUMENT_LAP(mInstrumentation, Pools);
+        continue;
       }
 
+      random.gaussian(x.data(), x.size());
+      INSTRUMENT_LAP(mInstrumentation, Epsilons);
+
       // simulating multi-variate t-student
-      unsigned char ifactor = obligors[iobligor].ifactor;
+      // factor values are already multiplied by w[ifactor] (see chol matrix creation)
+      kernel.latent(x.data(), zf, s.data(), floadings2[ifactor], x.size());
+
+      // detecting candidate defaults (sparse list of simulations)
+      unsigned char irating = portfolio.iratings[iobligor];
+      size_t numevents = kernel.events(x.data(), x.size(), Antithetic, thresholds[irating], events.data(), values.data());
+      INSTRUMENT_COUNT(mInstrumentation, Candidates, numevents);
+      INSTRUMENT_LAP(mInstrumentation, Latent);
 
-      for(size_t j=0; j<x.size(); j++) {
-        // z[ifactor] values are already multiplied by w[ifactor] (see chol matrix creation)
-        x[j] = s[j] * (z[ifactor][j] + floadings2[ifactor]*x[j]);
+      // simulating default times (days from time0)
+      for(size_t k=0; k<numevents; k++) {
+        values[k] = inverses[irating].evalue(values[k]);
       }
+      INSTRUMENT_LAP(mInstrumentation, Inverse);
 
       // simulating obligor loss
-      for(size_t j=0; j<blocksize; j++)
+      for(size_t k=0; k<numevents; k++)
       {
-        double val = getValue(x, j);
-        unsigned char irating = obligors[iobligor].irating;
-        double days = inverses[irating].evalue(val);
-        Date timeDefault = time0 + (long)ceil(days);
+        size_t j = events[k];
+        Date timeDefault = time0 + (long)ceil(values[k]);
 
         if (timeDefault <= timeT) {
-          simuleObligorLoss(obligors[iobligor], timeDefault, losses[j]);
+          simuleObligorLoss<Values>(iobligor, timeDefault, losses + j*numsegments);
+          INSTRUMENT_COUNT(mInstrumentation, Defaults, 1);
         }
       }
+      INSTRUMENT_LAP(mInstrumentation, Losses);
     }
 
+    // derived segmentations
+    reduce(losses);
+    INSTRUMENT_LAP(mInstrumentation, Losses);
+
     // data transfer
-    more = montecarlo.append(losses);
+    mBlocks.push();
   }
 }
 
 /**************************************************************************//**
- * @param[in] x Vector of simulated t-student values (only iobligor component).
- * @param[in] j Index of the simulation into the block.
- * @return t-Student component.
+ * @details Computes the losses of the derived segmentations adding the
+ *          losses of the base segments to the corresponding derived
+ *          segment (see FlatPortfolio::initHierarchy()). Asset losses
+ *          are only aggregated in the base segmentations, so each
+ *          simulated default updates fewer columns.
+ * @param[in,out] losses Block simulated losses (blocksize·numsegments).
  */
-inline double ccruncher::SimulationThread::getValue(const vector<double> &x, size_t j)
+void ccruncher::SimulationThread::reduce(double *losses) const
 {
-  if (!antithetic) {
-    return x[j];
-  }
-  else {
-    if (j%2) {
-      return +x[j/2];
+  size_t numreductions = portfolio.reduceSources.size();
+  if (numreductions == 0) return;
+
+  const uint32_t *sources = portfolio.reduceSources.data();
+  const uint32_t *targets = portfolio.reduceTargets.data();
+  for(size_t j=0; j<blocksize; j++) {
+    double *row = losses + j*numsegments;
+    for(size_t k=0; k<numreductions; k++) {
+      assert(targets[k] < numsegments);
+      row[targets[k]] += row[sources[k]];
     }
-    else {
-      return -x[j/2];
+  }
+}
+
+/**************************************************************************//**
+ * @details If ring buffer is full (consumer is slower than producer) then
+ *          waits until a slot is released.
+ * @return Block to fill, nullptr if simulation must stop.
+ */
+SimulationThread::Block* ccruncher::SimulationThread::getFreeBlock()
+{
+  while(montecarlo.mMore.load(memory_order_acquire))
+  {
+    Block *block = mBlocks.back();
+    if (block != nullptr) {
+      return block;
     }
+    this_thread::sleep_for(chrono::microseconds(100));
   }
+  return nullptr;
 }
 
 /**************************************************************************//**
- * @details Fill the vector s with random chi-square values.
+ * @details Fill the vector s with random chi-square values. Does nothing
+ *          if copula is gaussian (s values are 1).
+ * @tparam TStudent T-Student copula (gaussian otherwise).
  * @param[out] s Vector to fill.
  */
+template<bool TStudent>
 void ccruncher::SimulationThread::rchisq(vector<double> &s)
 {
-  if (isfinite(ndf)) {
+  if (TStudent) {
+    random.chisq(ndf, s.data(), s.size());
     for(size_t n=0; n<s.size(); n++) {
-      double chisq = gsl_ran_chisq(rng, ndf);
+      double chisq = s[n];
       if (chisq < 1e-14) chisq = 1e-14; //avoid division by 0
       s[n] = sqrt(ndf/chisq);
     }
@@ -158,47 +331,229 @@ void ccruncher::SimulationThread::rchisq(vector<double> &s)
 
 /**************************************************************************//**
  * @details Fill the matrix z with random multivariate Gaussian values.
- * @param[out] z Vector to fill.
+ *          Independent gaussian values are drawn directly in z.
+ * @param[out] z Factors values (numfactors x len, factor-major).
+ */
+void ccruncher::SimulationThread::rmvnorm(vector<double> &z)
+{
+  random.gaussian(z.data(), z.size());
+  shiftFactors(z);
+  correlate(z);
+}
+
+/**************************************************************************//**
+ * @details Fill the matrix z and the vector s using the scrambled Sobol
+ *          sequence. Replicates are assigned to blocks cyclically, and
+ *          the k-th block of a replicate uses the points [k·len,(k+1)·len)
+ *          where len is the number of non-antithetic simulations. Points
+ *          are transformed using the inverse of the gaussian and
+ *          chi-square distributions. If chi-square is not included in the
+ *          sequence then it is simulated using pseudo-random values.
+ * @tparam TStudent T-Student copula (gaussian otherwise).
+ * @param[in] iblock Block index.
+ * @param[out] s Vector to fill.
+ * @param[out] z Factors values (numfactors x len, factor-major).
+ * @throw Exception Sobol sequence exhausted.
  */
-void ccruncher::SimulationThread::rmvnorm(vector<vector<double>> &z)
+template<bool TStudent>
+void ccruncher::SimulationThread::rqmc(size_t iblock, vector<double> &s, vector<double> &z)
 {
-  size_t len = z[0].size();
+  size_t len = s.size();
+  const Sobol &sobol = sobols[iblock%sobols.size()];
+  size_t dim = sobol.size();
+  assert(points.size() == len*dim);
+  sobol.getPoints((iblock/sobols.size())*len, len, points.data());
+
+  if (TStudent && dim > numfactors) {
+    for(size_t n=0; n<len; n++) {
+      double chisq = gsl_cdf_chisq_Pinv(points[n*dim+numfactors], ndf);
+      if (chisq < 1e-14) chisq = 1e-14; //avoid division by 0
+      s[n] = sqrt(ndf/chisq);
+    }
+  }
+  else {
+    rchisq<TStudent>(s);
+  }
+
+  assert(z.size() == numfactors*len);
   for(size_t n=0; n<len; n++) {
-    //TODO: use gsl_ran_multivariate_gaussian() new in gsl-2.2
     for(size_t i=0; i<numfactors; i++) {
-      gsl_vector_set(vec, i, gsl_ran_gaussian_ziggurat(rng, 1.0));
+      z[i*len+n] = gsl_cdf_ugaussian_Pinv(points[n*dim+i]);
     }
-    gsl_blas_dtrmv(CblasLower, CblasNoTrans, CblasNonUnit, chol, vec);
-    for(size_t i=0; i<numfactors; i++) {
-      z[i][n] = gsl_vector_get(vec, i);
+  }
+  shiftFactors(z);
+  correlate(z);
+}
+
+/**************************************************************************//**
+ * @details Adds the importance sampling shift, mu, to the independent
+ *          gaussian values of each simulation, e, and computes the
+ *          likelihood ratio of the shifted values, x=e+mu, respect to the
+ *          original distribution: w = exp(-mu·x+mu·mu/2) = exp(-mu·e-mu·mu/2).
+ *          The antithetic simulation, -x, has the same likelihood ratio.
+ *          Does nothing if importance sampling is disabled.
+ * @param[in,out] z Independent gaussian values (numfactors x len, factor-major).
+ */
+void ccruncher::SimulationThread::shiftFactors(vector<double> &z)
+{
+  if (ishift.empty()) return;
+  size_t len = weights.size();
+  assert(z.size() == len*numfactors);
+  double mu2 = inner_product(ishift.begin(), ishift.end(), ishift.begin(), 0.0);
+  fill(weights.begin(), weights.end(), 0.0);
+  for(size_t i=0; i<numfactors; i++) {
+    double *e = z.data() + i*len;
+    for(size_t n=0; n<len; n++) {
+      weights[n] += ishift[i]*e[n];
+      e[n] += ishift[i];
     }
   }
+  for(size_t n=0; n<len; n++) {
+    weights[n] = exp(-weights[n] - 0.5*mu2);
+  }
+}
+
+/**************************************************************************//**
+ * @details Multiplies the gaussian values of all the block simulations
+ *          by the Cholesky matrix using a single triangular matrix-matrix
+ *          product (BLAS-3), Z = L·Z, in place. Each column of z is a
+ *          simulation, so the result is already in the factor-major
+ *          layout used by the obligors loop.
+ * @param[in,out] z Factors values (numfactors x len, factor-major).
+ */
+void ccruncher::SimulationThread::correlate(vector<double> &z)
+{
+  assert(z.size()%numfactors == 0);
+  gsl_matrix_view mat = gsl_matrix_view_array(z.data(), numfactors, z.size()/numfactors);
+  gsl_blas_dtrmm(CblasLeft, CblasLower, CblasNoTrans, CblasNonUnit, 1.0, chol, &mat.matrix);
+}
+
+/**************************************************************************//**
+ * @details Simulates the losses of a pool of n exchangeable obligors.
+ *          Given the factor, z, and the t-student scaling, s, obligors'
+ *          latent values are x = s·(z + w·e), where e is N(0,1). An
+ *          obligor is a default candidate if x <= threshold, that is,
+ *          e <= c = (threshold/s - z)/w. Then, the number of candidates
+ *          is a Binomial(n, Phi(c)) and the latent value of each one is
+ *          obtained from e = Phiinv(u·Phi(c)), where u is U(0,1). When
+ *          antithetic, the 2i-th simulation uses -z (same distribution
+ *          of e). Cost doesn't depend on the pool size but on the number
+ *          of defaults.
+ * @tparam TStudent T-Student copula (gaussian otherwise).
+ * @tparam Antithetic Antithetic mode.
+ * @tparam Values Portfolio values kind.
+ * @param[in] iobligor Index of the pool representative obligor.
+ * @param[in] z Factor values (already multiplied by the factor loading, s.size() values).
+ * @param[in] s t-student scaling values (1 if gaussian).
+ * @param[out] losses Block simulated losses (blocksize·numsegments).
+ * @return Number of defaults.
+ */
+template<bool TStudent, bool Antithetic, FlatPortfolio::ValuesKind Values>
+size_t ccruncher::SimulationThread::simulePoolLoss(size_t iobligor, const double *z,
+    const vector<double> &s, double *losses) const
+{
+  size_t numdefaults = 0;
+  const gsl_rng *rng = random.getRng();
+  unsigned int num = portfolio.poolSizes[iobligor];
+  unsigned char irating = portfolio.iratings[iobligor];
+  double w = floadings2[portfolio.ifactors[iobligor]];
+  double threshold = thresholds[irating];
+
+  for(size_t j=0; j<s.size(); j++)
+  {
+    double sj = (TStudent ? s[j] : 1.0);
+
+    for(int k=(Antithetic?0:1); k<2; k++)
+    {
+      double zj = (k == 0 ? -z[j] : z[j]);
+      size_t isim = (Antithetic ? 2*j+k : j);
+
+      // conditional default probability
+      double p = 0.0;
+      if (w > 0.0) {
+        p = gsl_cdf_ugaussian_P((threshold/sj - zj)/w);
+      }
+      else {
+        p = (sj*zj <= threshold ? 1.0 : 0.0);
+      }
+      if (p <= 0.0) {
+        continue;
+      }
+
+      // number of candidates
+      unsigned int numevents = (p < 1.0 ? gsl_ran_binomial(rng, p, num) : num);
+
+      for(unsigned int n=0; n<numevents; n++)
+      {
+        double e = (w > 0.0 ? gsl_cdf_ugaussian_Pinv(p*gsl_rng_uniform_pos(rng)) : 0.0);
+        double days = inverses[irating].evalue(sj*(zj + w*e));
+        Date timeDefault = time0 + (long)ceil(days);
+
+        if (timeDefault <= timeT) {
+          simuleObligorLoss<Values>(iobligor, timeDefault, losses + isim*numsegments);
+          numdefaults++;
+        }
+      }
+    }
+  }
+
+  return numdefaults;
 }
 
 /**************************************************************************//**
  * @details Given a default time simulates obligors losses and aggregates
- *          them in the corresponding segmentation-segment.
- * @param[in] obligor Obligor to simulate.
+ *          them in the corresponding segmentation-segment. When values
+ *          kind is fixed, losses are the entries of the obligor's loss
+ *          table step containing the default day (see
+ *          FlatPortfolio::initLossTables()), and no random values are
+ *          drawn.
+ * @tparam Values Portfolio values kind.
+ * @param[in] iobligor Index of the obligor to simulate.
  * @param[in] dtime Default time.
- * @param[out] losses Cumulated losses by segmentation-segment.
+ * @param[out] losses Cumulated losses by segmentation-segment (numsegments).
  */
-void ccruncher::SimulationThread::simuleObligorLoss(const Obligor &obligor, Date dtime, vector<double> &losses) const noexcept
+template<FlatPortfolio::ValuesKind Values>
+void ccruncher::SimulationThread::simuleObligorLoss(size_t iobligor, Date dtime, double *losses) const noexcept
 {
+  if (Values == FlatPortfolio::ValuesKind::Fixed)
+  {
+    // step containing the default day
+    const int32_t *first = portfolio.stepDays.data() + portfolio.stepOffsets[iobligor];
+    const int32_t *last = portfolio.stepDays.data() + portfolio.stepOffsets[iobligor+1];
+    const int32_t *step = lower_bound(first, last, dtime - time0);
+    if (step == last) return;
+
+    // aggregate step losses
+    size_t istep = step - portfolio.stepDays.data();
+    const uint32_t *columns = portfolio.entryColumns.data();
+    const double *values = portfolio.entryLosses.data();
+    for(size_t k=portfolio.entryOffsets[istep]; k<portfolio.entryOffsets[istep+1]; k++) {
+      assert(columns[k] < numsegments);
+      losses[columns[k]] += values[k];
+    }
+    return;
+  }
+
   double obligor_lgd = NAN;
+  size_t numsegmentations = portfolio.getNumSegmentations();
+  const uint32_t *valueOffsets = portfolio.valueOffsets.data();
+  const Date *dates = portfolio.dates.data();
 
-  for(const Asset &asset : obligor.assets)
+  for(size_t iasset=portfolio.assetOffsets[iobligor]; iasset<portfolio.assetOffsets[iobligor+1]; iasset++)
   {
     // evalue asset loss
-    if (dtime <= asset.values.back().date)
+    const Date *first = dates + valueOffsets[iasset];
+    const Date *last = dates + valueOffsets[iasset+1];
+    if (dtime <= *(last-1))
     {
-      auto item = lower_bound(asset.values.begin(), asset.values.end(), dtime);
-      double ead = item->ead.getValue(rng);
-      double lgd = item->lgd.getValue(rng);
+      size_t ivalue = lower_bound(first, last, dtime) - dates;
+      double ead = portfolio.eads[ivalue].getValue(random.getRng());
+      double lgd = portfolio.lgds[ivalue].getValue(random.getRng());
 
       // non-lgd means that is inherited from obligor
       if (std::isnan(lgd)) {
         if (std::isnan(obligor_lgd)) {
-          obligor_lgd = obligor.lgd.getValue(rng);
+          obligor_lgd = portfolio.obligorLgds[iobligor].getValue(random.getRng());
         }
         lgd = obligor_lgd;
       }
@@ -207,16 +562,16 @@ void ccruncher::SimulationThread::simuleObligorLoss(const Obligor &obligor, Date
       double loss = ead * lgd;
       assert(std::isfinite(loss));
 
-      // aggregate asset loss in the correspondent segment loss
-      double *plosses = losses.data();
-      for(size_t iSegmentation=0; iSegmentation<numSegmentsBySegmentation.size(); iSegmentation++)
-      {
-        unsigned short isegment = asset.segments[iSegmentation];
-        assert(isegment < numSegmentsBySegmentation[iSegmentation]);
-        plosses[isegment] += loss;
-        plosses += numSegmentsBySegmentation[iSegmentation];
+      // aggregate asset loss in the correspondent segment loss (base segmentations)
+      const uint32_t *columns = portfolio.columns.data() + iasset*numsegmentations;
+      for(uint32_t iSegmentation : portfolio.baseSegmentations) {
+        assert(columns[iSegmentation] < numsegments);
+        losses[columns[iSegmentation]] += loss;
       }
     }
   }
 }
 
+// explicit instantiation (used by Benchmark)
+template void ccruncher::SimulationThread::simuleObligorLoss<FlatPortfolio::ValuesKind::Fixed>(size_t, Date, double *) const noexcept;
+template void ccruncher::SimulationThread::simuleObligorLoss<FlatPortfolio::ValuesKind::Random>(size_t, Date, double *) const noexcept;
@@ -22,14 +22,22 @@
 
 #pragma once
 
+#include <atomic>
+#include <string>
 #include <vector>
 #include <gsl/gsl_vector.h>
 #include <gsl/gsl_matrix.h>
 #include <gsl/gsl_rng.h>
+#include "kernel/BlockKernel.hpp"
+#include "kernel/FlatPortfolio.hpp"
+#include "kernel/Instrumentation.hpp"
 #include "kernel/Inverse.hpp"
 #include "kernel/MonteCarlo.hpp"
+#include "utils/BatchRng.hpp"
 #include "utils/Date.hpp"
+#include "utils/Sobol.hpp"
 #include "utils/Thread.hpp"
+#include "utils/RingBuffer.hpp"
 #include "utils/Exception.hpp"
 
 namespace ccruncher {
@@ -43,25 +51,60 @@ class MonteCarlo;
  * @details This class does the following tasks:
  *          - Blocksize (simultaneous simulations, performance reasons)
  *          - Antithetic management
- *          - Simulate obligors default times
+ *          - Block factors correlated with a single BLAS-3 product
+ *          - Vectorized latent values (see BlockKernel)
+ *          - Simulate obligors default times (values above the
+ *            rating threshold are rejected without inverse evaluation)
  *          - Simulate asset losses
- *          - Losses aggregation (by segmentation)
+ *          - Losses aggregation (by base segmentation)
+ *          - Derived segmentations reduction (once per block)
+ *          - Publishes simulated blocks in its own ring buffer
  *          Simulation parameters are constants and shared with other
- *          threads.
+ *          threads. Finished blocks are consumed by MonteCarlo (single
+ *          consumer), so this thread never waits for I/O. Block indexes
+ *          are claimed from MonteCarlo, and random values of a block
+ *          depend only on (seed, block index, obligor), so simulated
+ *          values don't depend on the number of threads. When quasi-Monte
+ *          Carlo is enabled, factors (and chi-square) of block b are
+ *          consecutive points of the Sobol replicate b%R. When
+ *          importance sampling is enabled, factors are shifted and the
+ *          likelihood ratio of each simulation is reported in the last
+ *          column of the simulated losses. Obligors pools are simulated
+ *          drawing the number of defaults from the conditional binomial
+ *          distribution. Hot-path timers and counters are collected if
+ *          compiled with instrumentation (see Instrumentation).
+ *          The simulation loop is a template on the copula type, the
+ *          antithetic mode and the portfolio values kind. The
+ *          instantiation is selected once in the constructor, so these
+ *          flags are not checked in the hot loop.
  *
  * @see MonteCarlo
  */
 class SimulationThread : public Thread
 {
 
+  public:
+
+    //! Simulated block
+    struct Block
+    {
+      //! Block index
+      size_t id;
+      //! Simulated losses (row-major blocksize x numsegments matrix)
+      std::vector<double> losses;
+    };
+
+  private:
+
+    //! Simulation loop type
+    typedef void (SimulationThread::*SimulateFunc)();
+
   private:
 
     //! Monte Carlo parent
     MonteCarlo &montecarlo;
-    //! List of simulated obligors
-    const std::vector<Obligor> &obligors;
-    //! Number of segments for each segmentation
-    const std::vector<unsigned short> &numSegmentsBySegmentation;
+    //! Simulated portfolio
+    const FlatPortfolio &portfolio;
     //! Cholesky matrix (see MonteCarlo::initModel())
     const gsl_matrix *chol;
     //! Factor loadings [sqrt(1-w_i^2)]
@@ -82,22 +125,63 @@ class SimulationThread : public Thread
     const size_t &numsegments;
     //! Block size
     const unsigned short &blocksize;
+    //! Scrambled Sobol sequences by replicate (empty if no qmc)
+    const std::vector<Sobol> &sobols;
+    //! Importance sampling shift of the factors (empty if disabled)
+    const std::vector<double> &ishift;
+    //! Non-default thresholds by rating (see Inverse::getThreshold())
+    std::vector<double> thresholds;
+    //! Block operations (vectorized)
+    BlockKernel kernel;
 
     //! Random number generator
-    gsl_rng *rng;
-    //! Auxiliar vector
-    gsl_vector *vec;
+    BatchRng random;
+    //! Auxiliar vector (quasi-random points)
+    std::vector<double> points;
+    //! Auxiliar vector (importance sampling likelihood ratios)
+    std::vector<double> weights;
+    //! Simulated blocks
+    RingBuffer<Block> mBlocks;
+    //! Thread has finished
+    std::atomic<bool> mFinished;
+    //! Error message (empty if no error)
+    std::string mMsgErr;
+    //! Timers and counters (see INSTRUMENTATION)
+    Instrumentation mInstrumentation;
+    //! Specialized simulation loop
+    SimulateFunc mSimulate;
 
   private:
 
-    //! Returns the j-th component of x taking into account the antithetic mode
-    double getValue(const std::vector<double> &x, size_t j);
     //! Simule obligor
-    void simuleObligorLoss(const Obligor &obligor, Date dtime, std::vector<double> &losses) const noexcept;
+    template<FlatPortfolio::ValuesKind Values>
+    void simuleObligorLoss(size_t iobligor, Date dtime, double *losses) const noexcept;
+    //! Simule obligors pool
+    template<bool TStudent, bool Antithetic, FlatPortfolio::ValuesKind Values>
+    size_t simulePoolLoss(size_t iobligor, const double *z,
+                          const std::vector<double> &s, double *losses) const;
+    //! Derived segmentations losses
+    void reduce(double *losses) const;
+    //! Returns a free block (waits while ring is full)
+    Block* getFreeBlock();
+    //! Simulation loop
+    template<bool TStudent, bool Antithetic, FlatPortfolio::ValuesKind Values>
+    void simulate();
+    //! Simulation loop instantiation
+    template<bool TStudent, bool Antithetic>
+    SimulateFunc getSimulate() const;
     //! Chi-square random generation
+    template<bool TStudent>
     void rchisq(std::vector<double> &s);
     //! Factors random generation
-    void rmvnorm(std::vector<std::vector<double>> &z);
+    void rmvnorm(std::vector<double> &z);
+    //! Factors and chi-square quasi-random generation
+    template<bool TStudent>
+    void rqmc(size_t iblock, std::vector<double> &s, std::vector<double> &z);
+    //! Shifts the factors gaussian values (importance sampling)
+    void shiftFactors(std::vector<double> &z);
+    //! Correlates the factors gaussian values
+    void correlate(std::vector<double> &z);
 
   public:
 
@@ -111,6 +195,19 @@ class SimulationThread : public Thread
     virtual ~SimulationThread() override;
     //! Thread main function
     virtual void run() override;
+    //! Simulated blocks
+    RingBuffer<Block>& getBlocks() { return mBlocks; }
+    //! Indicates if thread has finished
+    bool isFinished() const { return mFinished.load(std::memory_order_acquire); }
+    //! Error message (empty if no error)
+    const std::string& getMsgErr() const { return mMsgErr; }
+    //! Timers and counters
+    const Instrumentation& getInstrumentation() const { return mInstrumentation; }
+
+  public:
+
+    //! Friend class
+    friend class Benchmark;
 
 };
 
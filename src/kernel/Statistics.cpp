@@ -0,0 +1,337 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#include <cmath>
+#include <cassert>
+#include <unistd.h>
+#include "kernel/Statistics.hpp"
+#include "utils/Exception.hpp"
+#include "utils/config.h"
+
+// t-digest compression factor
+#define COMPRESSION 500.0
+// number of histogram bins per octave (bin upper bounds are 2^(k/BINS_PER_OCTAVE))
+#define BINS_PER_OCTAVE 4
+
+using namespace std;
+using namespace ccruncher;
+
+/**************************************************************************//**
+ * @details The file is created at construction time, so errors are
+ *          reported before the simulation starts. File creation mode:
+ *          - 'c': Create. Fails if file exist.
+ *          - 'w', 'a': overwrites previous file content (if exist). The
+ *            summary only covers the current execution.
+ * @param[in] filename Filename.
+ * @param[in] mode a=append, w=overwrite, c=create
+ * @param[in] segmentations List of segmentations.
+ * @param[in] exposures Segments exposures by segmentation.
+ * @param[in] weighted Rows contain the importance sampling weight.
+ * @param[in] levels VaR and ES confidence levels.
+ * @throw Exception Error creating file.
+ */
+ccruncher::Statistics::Statistics(const std::string &filename, char mode,
+    const std::vector<Segmentation> &segmentations, const std::vector<std::vector<double>> &exposures,
+    bool weighted, const std::vector<double> &levels) : mWeighted(weighted), mLevels(levels), mNumRows(0),
+    mBlockSize(1), mFirstBlock(0)
+{
+  assert(segmentations.size() == exposures.size());
+
+  for(size_t i=0; i<segmentations.size(); i++) {
+    assert(segmentations[i].size() == exposures[i].size());
+    for(unsigned short j=0; j<segmentations[i].size(); j++) {
+      mSegmentations.push_back(segmentations[i].getName());
+      mNames.push_back(segmentations[i].getSegment(j));
+      mExposures.push_back(exposures[i][j]);
+    }
+  }
+
+  if (mNames.empty()) {
+    throw Exception("trying to summarize 0 segments");
+  }
+  mSegments.resize(mNames.size(), Segment{KahanSum(), KahanSum(), TDigest(COMPRESSION), 0.0, {}, {}});
+
+  if (mode != 'a' && mode != 'w' && mode != 'c') {
+    throw Exception("invalid file mode");
+  }
+  if (mode == 'c' && access(filename.c_str(), W_OK) == 0) {
+    throw Exception("file '" + filename + "' already exist");
+  }
+
+  try {
+    mFile.exceptions(ios::failbit | ios::badbit);
+    mFile.open(filename.c_str(), ios::out|ios::trunc);
+    mFile.precision(12);
+    mFilename = filename;
+  }
+  catch(std::exception &e) {
+    throw Exception(e, "error opening file '" + filename + "'");
+  }
+}
+
+/**************************************************************************//**
+ * @details Quasi-Monte Carlo replicates are assigned to blocks cyclically
+ *          (see SimulationThread::rqmc()), so the i-th row belongs to the
+ *          replicate ((firstblock+i/blocksize) % numreplicates). Must be
+ *          called before appending rows.
+ * @param[in] numreplicates Number of replicates (1 means no replicates).
+ * @param[in] blocksize Number of rows by block.
+ * @param[in] firstblock Index of the first block (shards).
+ */
+void ccruncher::Statistics::setReplicates(unsigned short numreplicates, unsigned short blocksize, size_t firstblock)
+{
+  assert(mNumRows == 0);
+  assert(blocksize > 0);
+  mBlockSize = blocksize;
+  mFirstBlock = firstblock;
+  mReplicateRows.assign(numreplicates > 1 ? numreplicates : 0, 0);
+  for(Segment &segment : mSegments) {
+    segment.replicates.assign(mReplicateRows.size(), KahanSum());
+  }
+}
+
+/**************************************************************************//**
+ * @param[in] losses Simulated row. Segment losses of all segmentations
+ *            followed by the importance sampling weight (if weighted).
+ */
+void ccruncher::Statistics::append(const double *losses)
+{
+  assert(losses != nullptr);
+  double w = (mWeighted ? losses[mSegments.size()] : 1.0);
+  size_t ireplicate = 0;
+  if (!mReplicateRows.empty()) {
+    ireplicate = (mFirstBlock + mNumRows/mBlockSize) % mReplicateRows.size();
+    mReplicateRows[ireplicate]++;
+  }
+
+  for(size_t i=0; i<mSegments.size(); i++)
+  {
+    Segment &segment = mSegments[i];
+    double x = losses[i];
+    segment.sumx.add(w*x);
+    segment.sumx2.add(w*x*x);
+    segment.digest.add(x, w);
+    if (x <= 0.0) {
+      segment.zeros += w;
+    }
+    else {
+      int k = static_cast<int>(ceil(BINS_PER_OCTAVE*log2(x)));
+      segment.histogram[k] += w;
+    }
+    if (!segment.replicates.empty()) {
+      segment.replicates[ireplicate].add(w*x);
+    }
+  }
+
+  mNumRows++;
+}
+
+/**************************************************************************//**
+ * @details Importance sampling estimator (sum of weighted losses divided
+ *          by the number of simulations).
+ * @param[in] isegment Segment index.
+ * @return Expected loss.
+ */
+double ccruncher::Statistics::getMean(size_t isegment) const
+{
+  assert(isegment < mSegments.size());
+  if (mNumRows == 0) return NAN;
+  return mSegments[isegment].sumx.sum / mNumRows;
+}
+
+/**************************************************************************//**
+ * @details Standard deviation of the replicates expected losses divided
+ *          by the square root of the number of replicates.
+ * @param[in] isegment Segment index.
+ * @return Standard error of the expected loss (NaN if there are less
+ *         than 2 replicates or a replicate has no rows).
+ */
+double ccruncher::Statistics::getMeanStdErr(size_t isegment) const
+{
+  assert(isegment < mSegments.size());
+  size_t numreplicates = mReplicateRows.size();
+  if (numreplicates < 2) return NAN;
+
+  vector<double> means(numreplicates, 0.0);
+  double mean = 0.0;
+  for(size_t r=0; r<numreplicates; r++) {
+    if (mReplicateRows[r] == 0) return NAN;
+    means[r] = mSegments[isegment].replicates[r].sum / mReplicateRows[r];
+    mean += means[r] / numreplicates;
+  }
+
+  double var = 0.0;
+  for(double x : means) {
+    var += (x-mean)*(x-mean);
+  }
+  var /= (numreplicates-1);
+  return sqrt(var/numreplicates);
+}
+
+/**************************************************************************//**
+ * @param[in] isegment Segment index.
+ * @return Standard deviation of the loss.
+ */
+double ccruncher::Statistics::getStdDev(size_t isegment) const
+{
+  assert(isegment < mSegments.size());
+  if (mNumRows == 0) return NAN;
+  double mean = getMean(isegment);
+  double var = mSegments[isegment].sumx2.sum / mNumRows - mean*mean;
+  return sqrt(std::max(var, 0.0));
+}
+
+/**************************************************************************//**
+ * @details When weighted, the VaR is the loss whose exceedance weight
+ *          divided by the number of simulations is 1-level.
+ * @param[in] isegment Segment index.
+ * @param[in] level Confidence level.
+ * @return Value at Risk.
+ */
+double ccruncher::Statistics::getVaR(size_t isegment, double level) const
+{
+  assert(isegment < mSegments.size());
+  const TDigest &digest = mSegments[isegment].digest;
+  if (mNumRows == 0 || digest.getWeight() <= 0.0) return NAN;
+  double p = 1.0 - (1.0-level)*mNumRows/digest.getWeight();
+  return digest.quantile(std::max(p, 0.0));
+}
+
+/**************************************************************************//**
+ * @param[in] isegment Segment index.
+ * @param[in] level Confidence level.
+ * @return Expected Shortfall (mean of losses above the VaR).
+ */
+double ccruncher::Statistics::getES(size_t isegment, double level) const
+{
+  assert(isegment < mSegments.size());
+  const TDigest &digest = mSegments[isegment].digest;
+  if (mNumRows == 0 || digest.getWeight() <= 0.0) return NAN;
+  double p = 1.0 - (1.0-level)*mNumRows/digest.getWeight();
+  return digest.tailMean(std::max(p, 0.0));
+}
+
+/**************************************************************************//**
+ * @details Each row contains the segmentation name, the segment name, the
+ *          statistic name, its parameter (confidence level or histogram
+ *          bin upper bound, empty if none) and its value. Histogram values
+ *          are probabilities.
+ * @see http://ccruncher.net/ofileref.html#summary
+ * @throw Exception Error writing file.
+ */
+void ccruncher::Statistics::write()
+{
+  try
+  {
+    mFile << "#==========================================================" << endl;
+    mFile << "# file generated by ccruncher-" << PACKAGE_VERSION << endl;
+    mFile << "# simulations: " << mNumRows << endl;
+    mFile << "#==========================================================" << endl;
+    mFile << "\"segmentation\", \"segment\", \"statistic\", \"param\", \"value\"" << endl;
+
+    for(size_t i=0; i<mSegments.size(); i++)
+    {
+      const Segment &segment = mSegments[i];
+      string prefix = "\"" + mSegmentations[i] + "\", \"" + mNames[i] + "\", ";
+
+      mFile << prefix << "\"exposure\", , " << mExposures[i] << endl;
+      mFile << prefix << "\"mean\", , " << getMean(i) << endl;
+      if (!mReplicateRows.empty()) {
+        mFile << prefix << "\"stderr\", , " << getMeanStdErr(i) << endl;
+      }
+      mFile << prefix << "\"stddev\", , " << getStdDev(i) << endl;
+      mFile << prefix << "\"min\", , " << segment.digest.getMin() << endl;
+      mFile << prefix << "\"max\", , " << segment.digest.getMax() << endl;
+      for(double level : mLevels) {
+        mFile << prefix << "\"VaR\", " << level << ", " << getVaR(i, level) << endl;
+      }
+      for(double level : mLevels) {
+        mFile << prefix << "\"ES\", " << level << ", " << getES(i, level) << endl;
+      }
+      if (mNumRows > 0) {
+        mFile << prefix << "\"histogram\", 0, " << segment.zeros/mNumRows << endl;
+        for(const auto &bin : segment.histogram) {
+          double upper = exp2(double(bin.first)/BINS_PER_OCTAVE);
+          mFile << prefix << "\"histogram\", " << upper << ", " << bin.second/mNumRows << endl;
+        }
+      }
+    }
+
+    mFile.flush();
+  }
+  catch(std::exception &e) {
+    throw Exception(e, "error writing file '" + mFilename + "'");
+  }
+}
+
+/**************************************************************************//**
+ * @param[in,out] checkpoint Archive where the state is appended.
+ */
+void ccruncher::Statistics::save(Checkpoint &checkpoint) const
+{
+  checkpoint.put(static_cast<uint64_t>(mSegments.size()));
+  checkpoint.put(static_cast<uint64_t>(mNumRows));
+  checkpoint.put(vector<uint64_t>(mReplicateRows.begin(), mReplicateRows.end()));
+  for(const Segment &segment : mSegments) {
+    checkpoint.put(segment.sumx);
+    checkpoint.put(segment.sumx2);
+    checkpoint.put(segment.zeros);
+    checkpoint.put(vector<pair<int,double>>(segment.histogram.begin(), segment.histogram.end()));
+    checkpoint.put(segment.replicates);
+    segment.digest.save(checkpoint);
+  }
+}
+
+/**************************************************************************//**
+ * @param[in,out] checkpoint Archive where the state is read from.
+ * @throw Exception Invalid state.
+ */
+void ccruncher::Statistics::restore(Checkpoint &checkpoint)
+{
+  uint64_t numsegments = 0;
+  uint64_t numrows = 0;
+  checkpoint.get(numsegments);
+  if (numsegments != mSegments.size()) {
+    throw Exception("statistics number of segments mismatch");
+  }
+  checkpoint.get(numrows);
+  mNumRows = numrows;
+  vector<uint64_t> replicateRows;
+  checkpoint.get(replicateRows);
+  if (replicateRows.size() != mReplicateRows.size()) {
+    throw Exception("statistics number of replicates mismatch");
+  }
+  mReplicateRows.assign(replicateRows.begin(), replicateRows.end());
+  for(Segment &segment : mSegments) {
+    vector<pair<int,double>> histogram;
+    checkpoint.get(segment.sumx);
+    checkpoint.get(segment.sumx2);
+    checkpoint.get(segment.zeros);
+    checkpoint.get(histogram);
+    segment.histogram = map<int,double>(histogram.begin(), histogram.end());
+    checkpoint.get(segment.replicates);
+    if (segment.replicates.size() != mReplicateRows.size()) {
+      throw Exception("statistics number of replicates mismatch");
+    }
+    segment.digest.restore(checkpoint);
+  }
+}
@@ -0,0 +1,149 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include <fstream>
+#include "params/Segmentation.hpp"
+#include "utils/Checkpoint.hpp"
+#include "utils/TDigest.hpp"
+
+namespace ccruncher {
+
+/**************************************************************************//**
+ * @brief Streaming risk statistics of the simulated losses.
+ *
+ * @details Consumes the simulated rows (same layout as the aggregators)
+ *          and keeps, for each segment, compensated (Kahan) sums to
+ *          compute the expected loss and the standard deviation, a
+ *          t-digest to compute the VaR and ES at the requested levels,
+ *          and a log-scale histogram. Memory doesn't depend on the
+ *          number of simulations. When the rows contain the importance
+ *          sampling weight (last column), statistics are weighted by it.
+ *          When quasi-Monte Carlo replicates are set, the expected loss
+ *          is also computed by replicate to estimate its standard error.
+ *          At the end, the summary file is written in CSV format (one
+ *          row per segment and statistic).
+ *
+ * @see http://ccruncher.net/ofileref.html#summary
+ */
+class Statistics
+{
+
+  private:
+
+    //! Kahan compensated sum
+    struct KahanSum
+    {
+      //! Accumulated sum
+      double sum = 0.0;
+      //! Lost low-order bits
+      double c = 0.0;
+      //! Adds a value
+      void add(double x) { double y = x - c; double t = sum + y; c = (t - sum) - y; sum = t; }
+    };
+
+    //! Statistics of a segment
+    struct Segment
+    {
+      //! Sum of weighted losses
+      KahanSum sumx;
+      //! Sum of weighted squared losses
+      KahanSum sumx2;
+      //! Quantile sketch
+      TDigest digest;
+      //! Weight of zero losses
+      double zeros = 0.0;
+      //! Histogram (bin index, weight)
+      std::map<int,double> histogram;
+      //! Sum of weighted losses by replicate
+      std::vector<KahanSum> replicates;
+    };
+
+  private:
+
+    //! File name
+    std::string mFilename;
+    //! Output file stream
+    std::ofstream mFile;
+    //! Segmentation name of each segment
+    std::vector<std::string> mSegmentations;
+    //! Segment names
+    std::vector<std::string> mNames;
+    //! Segment exposures
+    std::vector<double> mExposures;
+    //! Statistics by segment
+    std::vector<Segment> mSegments;
+    //! Rows contain importance sampling weight (last column)
+    bool mWeighted;
+    //! VaR and ES confidence levels
+    std::vector<double> mLevels;
+    //! Number of rows
+    size_t mNumRows;
+    //! Number of rows by replicate (empty if no replicates)
+    std::vector<size_t> mReplicateRows;
+    //! Number of rows by block
+    unsigned short mBlockSize;
+    //! Index of the first block
+    size_t mFirstBlock;
+
+  public:
+
+    //! Constructor
+    Statistics(const std::string &filename, char mode, const std::vector<Segmentation> &segmentations,
+               const std::vector<std::vector<double>> &exposures, bool weighted,
+               const std::vector<double> &levels);
+    //! Non-copyable class
+    Statistics(const Statistics &) = delete;
+    //! Non-copyable class
+    Statistics & operator=(const Statistics &) = delete;
+    //! Set the quasi-Monte Carlo replicates
+    void setReplicates(unsigned short numreplicates, unsigned short blocksize, size_t firstblock=0);
+    //! Append a simulated row
+    void append(const double *losses);
+    //! Write the summary file
+    void write();
+    //! Return file name
+    const std::string &getFilename() const { return mFilename; }
+    //! Returns the number of rows
+    size_t getNumRows() const { return mNumRows; }
+    //! Returns the expected loss of a segment
+    double getMean(size_t isegment) const;
+    //! Returns the standard error of the expected loss of a segment
+    double getMeanStdErr(size_t isegment) const;
+    //! Returns the standard deviation of a segment
+    double getStdDev(size_t isegment) const;
+    //! Returns the VaR of a segment
+    double getVaR(size_t isegment, double level) const;
+    //! Returns the ES of a segment
+    double getES(size_t isegment, double level) const;
+    //! Save the statistics state
+    void save(Checkpoint &checkpoint) const;
+    //! Restore the statistics state
+    void restore(Checkpoint &checkpoint);
+
+};
+
+} // namespace
@@ -0,0 +1,194 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#include <cmath>
+#include <string>
+#include <vector>
+#include <fstream>
+#include "kernel/Statistics.hpp"
+#include "kernel/StatisticsTest.hpp"
+#include "params/Segmentation.hpp"
+#include "utils/Utils.hpp"
+
+#define EPSILON 1E-9
+
+using namespace std;
+using namespace ccruncher;
+
+//===========================================================================
+// setUp
+//===========================================================================
+void ccruncher_test::StatisticsTest::setUp()
+{
+  workdir = Utils::makeTempDir("ccruncher-statisticstest.");
+}
+
+//===========================================================================
+// tearDown
+//===========================================================================
+void ccruncher_test::StatisticsTest::tearDown()
+{
+  Utils::removeDir(workdir);
+}
+
+//===========================================================================
+// test1 (unweighted statistics)
+//===========================================================================
+void ccruncher_test::StatisticsTest::test1()
+{
+  string filename = workdir + Utils::pathSeparator + "summary-test.csv";
+  vector<Segmentation> segmentations;
+  segmentations.push_back(Segmentation("portfolio"));
+  segmentations.push_back(Segmentation("sectors", true, false));
+  segmentations[1].addSegment("S1");
+  segmentations[1].addSegment("S2");
+  vector<vector<double>> exposures = {{1000.0}, {600.0, 400.0}};
+
+  Statistics stats(filename, 'w', segmentations, exposures, false, {0.9, 0.99});
+
+  // losses 1..1000 (S1 = 1, S2 = x-1)
+  double sum = 0.0;
+  double sum2 = 0.0;
+  for(size_t i=0; i<1000; i++) {
+    double x = double((i*7919)%1000 + 1);
+    double row[3] = {x, 1.0, x-1.0};
+    stats.append(row);
+    sum += x;
+    sum2 += x*x;
+  }
+
+  ASSERT_EQUALS((size_t)1000, stats.getNumRows());
+  ASSERT_EQUALS_EPSILON(sum/1000.0, stats.getMean(0), EPSILON);
+  ASSERT_EQUALS_EPSILON(sqrt(sum2/1000.0 - (sum/1000.0)*(sum/1000.0)), stats.getStdDev(0), EPSILON);
+  ASSERT_EQUALS_EPSILON(1.0, stats.getMean(1), EPSILON);
+  ASSERT_EQUALS_EPSILON(0.0, stats.getStdDev(1), EPSILON);
+  ASSERT_EQUALS_EPSILON(sum/1000.0-1.0, stats.getMean(2), EPSILON);
+  ASSERT_EQUALS_EPSILON(900.0, stats.getVaR(0, 0.9), 2.0);
+  ASSERT_EQUALS_EPSILON(990.0, stats.getVaR(0, 0.99), 1.0);
+  ASSERT_EQUALS_EPSILON(950.5, stats.getES(0, 0.9), 2.0);
+  ASSERT_EQUALS_EPSILON(995.5, stats.getES(0, 0.99), 1.0);
+  ASSERT_EQUALS_EPSILON(1.0, stats.getVaR(1, 0.99), EPSILON);
+
+  ASSERT_NO_THROW(stats.write());
+
+  // checking file content
+  ifstream file(filename);
+  string line;
+  size_t numlines = 0;
+  bool found = false;
+  while(getline(file, line)) {
+    if (line.empty() || line[0] == '#') continue;
+    numlines++;
+    if (line == "\"sectors\", \"S1\", \"mean\", , 1") found = true;
+  }
+  ASSERT(found);
+  ASSERT(numlines > 1 + 3*9);
+  file.close();
+}
+
+//===========================================================================
+// test2 (weighted statistics)
+//===========================================================================
+void ccruncher_test::StatisticsTest::test2()
+{
+  string filename = workdir + Utils::pathSeparator + "summary-test.csv";
+  vector<Segmentation> segmentations(1, Segmentation("portfolio"));
+  vector<vector<double>> exposures = {{100.0}};
+  Statistics stats(filename, 'w', segmentations, exposures, true, {0.99});
+
+  // loss 100 sampled 50% of times with likelihood ratio 0.02 (true prob = 1%)
+  for(size_t i=0; i<1000; i++) {
+    double row1[2] = {0.0, 1.98};
+    double row2[2] = {100.0, 0.02};
+    stats.append(row1);
+    stats.append(row2);
+  }
+
+  ASSERT_EQUALS_EPSILON(1.0, stats.getMean(0), EPSILON);
+  ASSERT_EQUALS_EPSILON(sqrt(100.0-1.0), stats.getStdDev(0), EPSILON);
+  ASSERT_EQUALS_EPSILON(100.0, stats.getVaR(0, 0.995), EPSILON);
+  ASSERT_EQUALS_EPSILON(100.0, stats.getES(0, 0.995), EPSILON);
+  ASSERT_EQUALS_EPSILON(0.0, stats.getVaR(0, 0.95), EPSILON);
+}
+
+//===========================================================================
+// test3 (file creation modes)
+//===========================================================================
+void ccruncher_test::StatisticsTest::test3()
+{
+  string filename = workdir + Utils::pathSeparator + "summary-test.csv";
+  vector<Segmentation> segmentations(1, Segmentation("portfolio"));
+  vector<vector<double>> exposures = {{100.0}};
+
+  ASSERT_NO_THROW(Statistics(filename, 'w', segmentations, exposures, false, {0.99}));
+  ASSERT_THROW(Statistics(filename, 'c', segmentations, exposures, false, {0.99}));
+  ASSERT_THROW(Statistics(filename, 'x', segmentations, exposures, false, {0.99}));
+  ASSERT_THROW(Statistics(filename, 'w', vector<Segmentation>(), vector<vector<double>>(), false, {0.99}));
+}
+
+//===========================================================================
+// test4 (quasi-Monte Carlo replicates)
+//===========================================================================
+void ccruncher_test::StatisticsTest::test4()
+{
+  string filename = workdir + Utils::pathSeparator + "summary-test.csv";
+  vector<Segmentation> segmentations(1, Segmentation("portfolio"));
+  vector<vector<double>> exposures = {{100.0}};
+  Statistics stats(filename, 'w', segmentations, exposures, false, {0.99});
+
+  // no replicates
+  ASSERT(std::isnan(stats.getMeanStdErr(0)));
+
+  // 4 replicates, blocks of 10 rows, first block is 1 (replicate 1)
+  stats.setReplicates(4, 10, 1);
+  for(size_t i=0; i<80; i++) {
+    double row[1] = {10.0*((1+i/10)%4)};
+    stats.append(row);
+  }
+
+  // replicate means are 0, 10, 20 and 30
+  double stderr4 = sqrt((225.0+25.0+25.0+225.0)/3.0/4.0);
+  ASSERT_EQUALS_EPSILON(15.0, stats.getMean(0), EPSILON);
+  ASSERT_EQUALS_EPSILON(stderr4, stats.getMeanStdErr(0), EPSILON);
+
+  // replicates are saved in the checkpoint
+  Checkpoint checkpoint;
+  stats.save(checkpoint);
+  Statistics stats2(filename, 'w', segmentations, exposures, false, {0.99});
+  stats2.setReplicates(4, 10, 1);
+  ASSERT_NO_THROW(stats2.restore(checkpoint));
+  ASSERT_EQUALS_EPSILON(stderr4, stats2.getMeanStdErr(0), EPSILON);
+  Statistics stats3(filename, 'w', segmentations, exposures, false, {0.99});
+  Checkpoint checkpoint3;
+  stats.save(checkpoint3);
+  ASSERT_THROW(stats3.restore(checkpoint3));
+
+  // standard error is written in the summary file
+  ASSERT_NO_THROW(stats.write());
+  ifstream file(filename);
+  string line;
+  bool found = false;
+  while(getline(file, line)) {
+    if (line.find("\"stderr\", , 6.45") != string::npos) found = true;
+  }
+  ASSERT(found);
+}
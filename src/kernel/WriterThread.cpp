@@ -0,0 +1,233 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#include <algorithm>
+#include <cassert>
+#include "kernel/WriterThread.hpp"
+#include "utils/Exception.hpp"
+
+using namespace std;
+using namespace ccruncher;
+
+/**************************************************************************//**
+ * @param[in] aggregators_ List of aggregators (one per segmentation).
+ * @param[in] nsegments Number of segments for each segmentation.
+ * @param[in] numbytes Memory budget (both buffers).
+ * @param[in] maxrows Maximum number of rows to write (0=unknown).
+ * @param[in] statistics_ Streaming statistics (can be null).
+ */
+ccruncher::WriterThread::WriterThread(const std::vector<Aggregator *> &aggregators_,
+    const std::vector<unsigned short> &nsegments, size_t numbytes, size_t maxrows,
+    Statistics *statistics_) : Thread(), aggregators(aggregators_), numSegmentsBySegmentation(nsegments),
+    statistics(statistics_), mFrontSize(0), mBackSize(0), mClosed(false)
+{
+  assert(aggregators.size() == numSegmentsBySegmentation.size());
+
+  numsegments = 0;
+  for(unsigned short num : numSegmentsBySegmentation) {
+    numsegments += num;
+  }
+  assert(numsegments > 0);
+
+  // buffer size doesn't exceed the number of rows to write
+  mCapacity = std::max(numbytes/(2*numsegments*sizeof(double)), size_t(1));
+  if (maxrows > 0) {
+    mCapacity = std::min(mCapacity, maxrows);
+  }
+
+  mFront.resize(mCapacity*numsegments);
+  mBack.resize(mCapacity*numsegments);
+}
+
+/**************************************************************************/
+ccruncher::WriterThread::~WriterThread()
+{
+  try {
+    close();
+  }
+  catch(...) {
+    // destructor can't throw exceptions
+  }
+}
+
+/**************************************************************************//**
+ * @details Copies the simulated losses to the front buffer. If it is full
+ *          then the front buffer is handed over to the writer. Aggregators
+ *          are not accessed by the caller.
+ * @param[in] losses Simulated losses (numsegments values).
+ * @throw Exception Error writing data.
+ */
+void ccruncher::WriterThread::append(const double *losses)
+{
+  assert(losses != nullptr);
+  assert(!mClosed);
+
+  if (mFrontSize == mCapacity) {
+    swap();
+  }
+
+  copy(losses, losses+numsegments, mFront.begin()+mFrontSize*numsegments);
+  mFrontSize++;
+}
+
+/**************************************************************************//**
+ * @details Waits until the back buffer has been written (backpressure),
+ *          then swaps buffers and notifies the writer.
+ * @throw Exception Error writing data.
+ */
+void ccruncher::WriterThread::swap()
+{
+  unique_lock<mutex> lock(mMutex);
+  {
+    INSTRUMENT_SCOPE(mInstrumentation, WriterWait);
+    mCondition.wait(lock, [this]{ return (mBackSize == 0 || !mMsgErr.empty()); });
+  }
+
+  if (!mMsgErr.empty()) {
+    throw Exception(mMsgErr);
+  }
+
+  mFront.swap(mBack);
+  mBackSize = mFrontSize;
+  mFrontSize = 0;
+  mCondition.notify_all();
+}
+
+/**************************************************************************//**
+ * @details Hands over the pending rows and waits until all of them have
+ *          been written and the aggregators flushed. On return, the
+ *          writer is idle, so the caller can inspect the aggregated
+ *          files and the streaming statistics until the next append.
+ * @throw Exception Error writing data.
+ */
+void ccruncher::WriterThread::sync()
+{
+  assert(!mClosed);
+
+  if (mFrontSize > 0) {
+    swap();
+  }
+
+  {
+    unique_lock<mutex> lock(mMutex);
+    mCondition.wait(lock, [this]{ return (mBackSize == 0 || !mMsgErr.empty()); });
+    if (!mMsgErr.empty()) {
+      throw Exception(mMsgErr);
+    }
+  }
+
+  for(Aggregator *aggregator : aggregators) {
+    if (aggregator != nullptr) {
+      aggregator->flush();
+    }
+  }
+}
+
+/**************************************************************************//**
+ * @details Pending data is written before returning. This method can be
+ *          called multiple times.
+ * @throw Exception Error writing data.
+ */
+void ccruncher::WriterThread::close()
+{
+  if (!mClosed)
+  {
+    try {
+      if (mFrontSize > 0) {
+        swap();
+      }
+    }
+    catch(Exception &) {
+      // error reported below
+    }
+
+    {
+      lock_guard<mutex> lock(mMutex);
+      mClosed = true;
+      mCondition.notify_all();
+    }
+
+    join();
+
+    for(Aggregator *aggregator : aggregators) {
+      if (aggregator == nullptr) continue;
+      try {
+        aggregator->flush();
+      }
+      catch(Exception &e) {
+        if (mMsgErr.empty()) mMsgErr = e.toString();
+      }
+    }
+  }
+
+  if (!mMsgErr.empty()) {
+    throw Exception(mMsgErr);
+  }
+}
+
+/**************************************************************************//**
+ * @details Formats and writes every back buffer handed over by the caller
+ *          until there is no more data. On error, the remaining data is
+ *          discarded.
+ * @see Thread::run()
+ */
+void ccruncher::WriterThread::run()
+{
+  unique_lock<mutex> lock(mMutex);
+
+  while(true)
+  {
+    mCondition.wait(lock, [this]{ return (mBackSize > 0 || mClosed); });
+    if (mBackSize == 0) break;
+
+    lock.unlock();
+    INSTRUMENT_START(mInstrumentation);
+    string msgerr;
+    try {
+      const double *losses = mBack.data();
+      for(size_t irow=0; irow<mBackSize; irow++) {
+        if (statistics != nullptr) {
+          statistics->append(losses);
+        }
+        for(size_t i=0; i<aggregators.size(); i++) {
+          if (aggregators[i] != nullptr) {
+            aggregators[i]->append(losses);
+          }
+          losses += numSegmentsBySegmentation[i];
+        }
+      }
+    }
+    catch(std::exception &e) {
+      msgerr = e.what();
+      if (msgerr.empty()) msgerr = "error writing data";
+    }
+    INSTRUMENT_LAP(mInstrumentation, Output);
+    lock.lock();
+
+    mBackSize = 0;
+    mCondition.notify_all();
+    if (!msgerr.empty()) {
+      mMsgErr = msgerr;
+      break;
+    }
+  }
+}
@@ -0,0 +1,114 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <vector>
+#include <condition_variable>
+#include "kernel/Aggregator.hpp"
+#include "kernel/Instrumentation.hpp"
+#include "kernel/Statistics.hpp"
+#include "utils/Thread.hpp"
+
+namespace ccruncher {
+
+/**************************************************************************//**
+ * @brief Output writer stage.
+ *
+ * @details Background thread that owns the aggregators during the
+ *          simulation. Simulated rows are copied into the front buffer.
+ *          When it is full, buffers are swapped and this thread formats
+ *          and writes the back buffer while the front one is being
+ *          filled. Caller only waits when both buffers are full (the
+ *          memory budget is exhausted). Rows are also fed to the
+ *          streaming statistics (if any). Null aggregators are skipped
+ *          (segmentation not written).
+ *
+ * @see MonteCarlo
+ */
+class WriterThread : public Thread
+{
+
+  private:
+
+    //! List of aggregators
+    const std::vector<Aggregator *> &aggregators;
+    //! Number of segments for each segmentation
+    const std::vector<unsigned short> &numSegmentsBySegmentation;
+    //! Streaming statistics (can be null)
+    Statistics *statistics;
+    //! Total number of segments
+    size_t numsegments;
+    //! Buffer capacity (in rows)
+    size_t mCapacity;
+    //! Front buffer (filled by caller)
+    std::vector<double> mFront;
+    //! Back buffer (written by this thread)
+    std::vector<double> mBack;
+    //! Number of rows in front buffer
+    size_t mFrontSize;
+    //! Number of rows in back buffer
+    size_t mBackSize;
+    //! No more data flag
+    bool mClosed;
+    //! Error message (empty if no error)
+    std::string mMsgErr;
+    //! Ensures data consistence
+    std::mutex mMutex;
+    //! Buffer state changes
+    std::condition_variable mCondition;
+    //! Timers (see INSTRUMENTATION)
+    Instrumentation mInstrumentation;
+
+  private:
+
+    //! Hand over the front buffer to the writer
+    void swap();
+
+  public:
+
+    //! Constructor
+    WriterThread(const std::vector<Aggregator *> &aggregators,
+                 const std::vector<unsigned short> &numSegmentsBySegmentation,
+                 size_t numbytes, size_t maxrows=0, Statistics *statistics=nullptr);
+    //! Non-copyable class
+    WriterThread(const WriterThread &) = delete;
+    //! Non-copyable class
+    WriterThread & operator=(const WriterThread &) = delete;
+    //! Destructor
+    virtual ~WriterThread() override;
+    //! Thread main function
+    virtual void run() override;
+    //! Append a simulation result (numsegments values)
+    void append(const double *losses);
+    //! Write pending data and flush aggregators
+    void sync();
+    //! Write pending data and wait writer termination
+    void close();
+    //! Timers (caller waits and writer output)
+    const Instrumentation& getInstrumentation() const { return mInstrumentation; }
+
+};
+
+} // namespace
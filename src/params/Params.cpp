@@ -25,6 +25,7 @@
 #include "params/Params.hpp"
 #include "utils/Exception.hpp"
 #include "utils/Parser.hpp"
+#include "utils/Utils.hpp"
 
 #define TIME0 "time.0"
 #define TIMET "time.T"
@@ -34,6 +35,18 @@
 #define RNGSEED "rng.seed"
 #define ANTITHETIC "antithetic"
 #define BLOCKSIZE "blocksize"
+#define INVERSE "inverse"
+#define QMC "qmc"
+#define QMCREPLICATES "qmc.replicates"
+#define IMPORTANCE "importance"
+#define IMPORTANCELEVEL "importance.level"
+#define POOLMINSIZE "pool.minsize"
+#define ANALYTICBINS "analytic.bins"
+#define STATS "stats"
+#define STATSLEVELS "stats.levels"
+#define STOPSEGMENTATION "stop.segmentation"
+#define STOPLEVEL "stop.level"
+#define STOPPRECISION "stop.precision"
 
 using namespace std;
 using namespace ccruncher;
@@ -74,6 +87,53 @@ void ccruncher::Params::setParamValue(const string &name, const string &value)
   else if (name == ANTITHETIC) {
     setAntithetic(Parser::boolValue(value));
   }
+  else if (name == INVERSE) {
+    setInverse(value);
+  }
+  else if (name == QMC) {
+    setQmc(value);
+  }
+  else if (name == QMCREPLICATES) {
+    int num = Parser::intValue(value);
+    int max = numeric_limits<unsigned short>::max();
+    if (num <= 0 || max < num) {
+      throw Exception("parameter '" QMCREPLICATES "' out of range [1," + to_string(max) + "]");
+    }
+    setQmcReplicates(static_cast<unsigned short>(num));
+  }
+  else if (name == IMPORTANCE) {
+    setImportance(Parser::boolValue(value));
+  }
+  else if (name == IMPORTANCELEVEL) {
+    setImportanceLevel(Parser::doubleValue(value));
+  }
+  else if (name == POOLMINSIZE) {
+    setPoolMinSize(Parser::ulongValue(value));
+  }
+  else if (name == ANALYTICBINS) {
+    setAnalyticBins(Parser::ulongValue(value));
+  }
+  else if (name == STATS) {
+    setStats(value);
+  }
+  else if (name == STATSLEVELS) {
+    vector<string> tokens;
+    Utils::tokenize(value, tokens, ",", true);
+    vector<double> levels;
+    for(const string &token : tokens) {
+      levels.push_back(Parser::doubleValue(token));
+    }
+    setStatsLevels(levels);
+  }
+  else if (name == STOPSEGMENTATION) {
+    setStopSegmentation(value);
+  }
+  else if (name == STOPLEVEL) {
+    setStopLevel(Parser::doubleValue(value));
+  }
+  else if (name == STOPPRECISION) {
+    setStopPrecision(Parser::doubleValue(value));
+  }
   else {
     throw Exception("unexpected parameter '" + name + "'");
   }
@@ -129,6 +189,116 @@ void ccruncher::Params::setCopula(const string &str)
   getNdf();
 }
 
+/**************************************************************************//**
+ * @details Allowed methods are: 'spline' (cubic spline) and 'lut' (uniform
+ *          lookup table with linear interpolation).
+ * @param[in] str Inverse function evaluation method.
+ * @throw Exception Invalid method.
+ */
+void ccruncher::Params::setInverse(const string &str)
+{
+  if (str != "spline" && str != "lut") {
+    throw Exception("invalid " INVERSE " value '" + str + "'");
+  }
+  inverse = str;
+}
+
+/**************************************************************************//**
+ * @details Allowed modes are: 'none' (pseudo-random values), 'factors'
+ *          (scrambled Sobol sequence for factors) and 'all' (scrambled
+ *          Sobol sequence for factors and chi-square).
+ * @param[in] str Quasi-Monte Carlo mode.
+ * @throw Exception Invalid mode.
+ */
+void ccruncher::Params::setQmc(const string &str)
+{
+  if (str != "none" && str != "factors" && str != "all") {
+    throw Exception("invalid " QMC " value '" + str + "'");
+  }
+  qmc = str;
+}
+
+/**************************************************************************//**
+ * @param[in] val Confidence level targeted by importance sampling.
+ * @throw Exception Value out of range (0,1).
+ */
+void ccruncher::Params::setImportanceLevel(double val)
+{
+  if (!(0.0 < val && val < 1.0)) {
+    throw Exception("parameter '" IMPORTANCELEVEL "' out of range (0,1)");
+  }
+  importanceLevel = val;
+}
+
+/**************************************************************************//**
+ * @param[in] num Number of grid points of the semi-analytic engine.
+ * @throw Exception Value is not a power of 2 in [16,1048576].
+ */
+void ccruncher::Params::setAnalyticBins(size_t num)
+{
+  if (num < 16 || num > 1048576 || (num & (num-1)) != 0) {
+    throw Exception("parameter '" ANALYTICBINS "' is not a power of 2 in [16,1048576]");
+  }
+  analyticBins = num;
+}
+
+/**************************************************************************//**
+ * @details Allowed values are:
+ *          - "none": statistics are not computed.
+ *          - "summary": summary file is written besides the segmentation files.
+ *          - "only": summary file is written instead of the segmentation files.
+ * @param[in] str Statistics mode.
+ * @throw Exception Invalid value.
+ */
+void ccruncher::Params::setStats(const string &str)
+{
+  if (str != "none" && str != "summary" && str != "only") {
+    throw Exception("invalid " STATS " value '" + str + "'");
+  }
+  stats = str;
+}
+
+/**************************************************************************//**
+ * @param[in] levels VaR and ES confidence levels.
+ * @throw Exception Empty list or level out of range (0,1).
+ */
+void ccruncher::Params::setStatsLevels(const vector<double> &levels)
+{
+  if (levels.empty()) {
+    throw Exception("parameter '" STATSLEVELS "' is empty");
+  }
+  for(double level : levels) {
+    if (!(0.0 < level && level < 1.0)) {
+      throw Exception("parameter '" STATSLEVELS "' out of range (0,1)");
+    }
+  }
+  statsLevels = levels;
+}
+
+/**************************************************************************//**
+ * @param[in] val VaR confidence level checked by the convergence criterion.
+ * @throw Exception Value out of range (0,1).
+ */
+void ccruncher::Params::setStopLevel(double val)
+{
+  if (!(0.0 < val && val < 1.0)) {
+    throw Exception("parameter '" STOPLEVEL "' out of range (0,1)");
+  }
+  stopLevel = val;
+}
+
+/**************************************************************************//**
+ * @param[in] val VaR relative standard error targeted (0 = disabled).
+ * @throw Exception Value out of range [0,1).
+ */
+void ccruncher::Params::setStopPrecision(double val)
+{
+  if (!(0.0 <= val && val < 1.0)) {
+    throw Exception("parameter '" STOPPRECISION "' out of range [0,1)");
+  }
+  stopPrecision = val;
+}
+
 /**************************************************************************//**
  * @return Degrees of freedom of the t-copula (ndf>=2) or +INF if gaussian.
  * @throw Exception Invalid parameter value.
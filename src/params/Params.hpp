@@ -23,6 +23,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include "utils/Date.hpp"
 
 namespace ccruncher {
@@ -53,6 +54,30 @@ class Params
     bool antithetic = true;
     //! Simulation block size
     unsigned short blockSize = 128;
+    //! Inverse function evaluation method
+    std::string inverse = "spline";
+    //! Quasi-Monte Carlo mode
+    std::string qmc = "none";
+    //! Number of quasi-Monte Carlo replicates
+    unsigned short qmcReplicates = 16;
+    //! Importance sampling of factors
+    bool importance = false;
+    //! Confidence level targeted by importance sampling
+    double importanceLevel = 0.999;
+    //! Minimum size of obligor pools (0 = disabled)
+    size_t poolMinSize = 0;
+    //! Number of grid points of the semi-analytic engine
+    size_t analyticBins = 4096;
+    //! Streaming statistics mode
+    std::string stats = "none";
+    //! Confidence levels of streaming statistics
+    std::vector<double> statsLevels = {0.9, 0.95, 0.99, 0.995, 0.999, 0.9997};
+    //! Segmentation checked by the convergence criterion (empty = first one)
+    std::string stopSegmentation = "";
+    //! VaR confidence level checked by the convergence criterion
+    double stopLevel = 0.999;
+    //! VaR relative standard error targeted (0 = no convergence criterion)
+    double stopPrecision = 0.0;
 
   public:
 
@@ -90,6 +115,54 @@ class Params
     unsigned short getBlockSize() const { return blockSize; }
     //! Set simulation block size
     void setBlockSize(unsigned short num) { blockSize = num; }
+    //! Returns inverse function evaluation method
+    std::string getInverse() const { return inverse; }
+    //! Set inverse function evaluation method
+    void setInverse(const std::string &str);
+    //! Returns quasi-Monte Carlo mode
+    std::string getQmc() const { return qmc; }
+    //! Set quasi-Monte Carlo mode
+    void setQmc(const std::string &str);
+    //! Returns number of quasi-Monte Carlo replicates
+    unsigned short getQmcReplicates() const { return qmcReplicates; }
+    //! Set number of quasi-Monte Carlo replicates
+    void setQmcReplicates(unsigned short num) { qmcReplicates = num; }
+    //! Returns importance sampling flag
+    bool getImportance() const { return importance; }
+    //! Set importance sampling flag
+    void setImportance(bool val) { importance = val; }
+    //! Returns confidence level targeted by importance sampling
+    double getImportanceLevel() const { return importanceLevel; }
+    //! Set confidence level targeted by importance sampling
+    void setImportanceLevel(double val);
+    //! Returns minimum size of obligor pools
+    size_t getPoolMinSize() const { return poolMinSize; }
+    //! Set minimum size of obligor pools
+    void setPoolMinSize(size_t num) { poolMinSize = num; }
+    //! Returns number of grid points of the semi-analytic engine
+    size_t getAnalyticBins() const { return analyticBins; }
+    //! Set number of grid points of the semi-analytic engine
+    void setAnalyticBins(size_t num);
+    //! Returns streaming statistics mode
+    std::string getStats() const { return stats; }
+    //! Set streaming statistics mode
+    void setStats(const std::string &str);
+    //! Returns confidence levels of streaming statistics
+    const std::vector<double> & getStatsLevels() const { return statsLevels; }
+    //! Set confidence levels of streaming statistics
+    void setStatsLevels(const std::vector<double> &levels);
+    //! Returns segmentation checked by the convergence criterion
+    std::string getStopSegmentation() const { return stopSegmentation; }
+    //! Set segmentation checked by the convergence criterion
+    void setStopSegmentation(const std::string &str) { stopSegmentation = str; }
+    //! Returns VaR confidence level checked by the convergence criterion
+    double getStopLevel() const { return stopLevel; }
+    //! Set VaR confidence level checked by the convergence criterion
+    void setStopLevel(double val);
+    //! Returns VaR relative standard error targeted
+    double getStopPrecision() const { return stopPrecision; }
+    //! Set VaR relative standard error targeted
+    void setStopPrecision(double val);
 
     //! Set a parameter
     void setParamValue(const std::string &name, const std::string &value);
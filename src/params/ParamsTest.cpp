@@ -46,6 +46,18 @@ void ccruncher_test::ParamsTest::test1()
   ASSERT(Date("01/01/2017") == params.getTimeT());
   ASSERT(params.getAntithetic());
   ASSERT_EQUALS((unsigned short)128, params.getBlockSize());
+  ASSERT_EQUALS("spline", params.getInverse());
+  ASSERT_EQUALS("none", params.getQmc());
+  ASSERT_EQUALS((unsigned short)16, params.getQmcReplicates());
+  ASSERT(!params.getImportance());
+  ASSERT_EQUALS_EPSILON(0.999, params.getImportanceLevel(), EPSILON);
+  ASSERT_EQUALS((size_t)0, params.getPoolMinSize());
+  ASSERT_EQUALS((size_t)4096, params.getAnalyticBins());
+  ASSERT_EQUALS("none", params.getStats());
+  ASSERT_EQUALS((size_t)6, params.getStatsLevels().size());
+  ASSERT_EQUALS("", params.getStopSegmentation());
+  ASSERT_EQUALS_EPSILON(0.999, params.getStopLevel(), EPSILON);
+  ASSERT_EQUALS_EPSILON(0.0, params.getStopPrecision(), EPSILON);
   ASSERT_EQUALS("gaussian", params.getCopula());
   ASSERT(std::isinf(params.getNdf()));
   ASSERT_EQUALS((size_t)1000000, params.getMaxIterations());
@@ -68,6 +80,18 @@ void ccruncher_test::ParamsTest::test2()
   params.setMaxIterations(20000);
   params.setMaxSeconds(3600);
   params.setRngSeed(1234567);
+  params.setInverse("lut");
+  params.setQmc("factors");
+  params.setQmcReplicates(8);
+  params.setImportance(true);
+  params.setImportanceLevel(0.99);
+  params.setParamValue("pool.minsize", "100");
+  params.setParamValue("analytic.bins", "1024");
+  params.setParamValue("stats", "only");
+  params.setParamValue("stats.levels", "0.99, 0.999");
+  params.setParamValue("stop.segmentation", "sectors");
+  params.setParamValue("stop.level", "0.99");
+  params.setParamValue("stop.precision", "0.005");
 
   ASSERT(params.isValid());
   ASSERT_NO_THROW(params.isValid(true));
@@ -81,6 +105,19 @@ void ccruncher_test::ParamsTest::test2()
   ASSERT_EQUALS((size_t)20000, params.getMaxIterations());
   ASSERT_EQUALS((size_t)3600, params.getMaxSeconds());
   ASSERT_EQUALS(1234567UL, params.getRngSeed());
+  ASSERT_EQUALS("lut", params.getInverse());
+  ASSERT_EQUALS("factors", params.getQmc());
+  ASSERT_EQUALS((unsigned short)8, params.getQmcReplicates());
+  ASSERT(params.getImportance());
+  ASSERT_EQUALS_EPSILON(0.99, params.getImportanceLevel(), EPSILON);
+  ASSERT_EQUALS((size_t)100, params.getPoolMinSize());
+  ASSERT_EQUALS((size_t)1024, params.getAnalyticBins());
+  ASSERT_EQUALS("only", params.getStats());
+  ASSERT_EQUALS((size_t)2, params.getStatsLevels().size());
+  ASSERT_EQUALS_EPSILON(0.999, params.getStatsLevels()[1], EPSILON);
+  ASSERT_EQUALS("sectors", params.getStopSegmentation());
+  ASSERT_EQUALS_EPSILON(0.99, params.getStopLevel(), EPSILON);
+  ASSERT_EQUALS_EPSILON(0.005, params.getStopPrecision(), EPSILON);
 }
 
 //===========================================================================
@@ -106,6 +143,18 @@ void ccruncher_test::ParamsTest::test3()
   params4.setTime0(Date("01/01/2015"));
   params4.setTimeT(Date("01/01/2016"));
   ASSERT_THROW(params4.setCopula("XXX"));
+  ASSERT_THROW(params4.setInverse("XXX"));
+  ASSERT_THROW(params4.setQmc("XXX"));
+  ASSERT_THROW(params4.setParamValue("qmc.replicates", "0"));
+  ASSERT_THROW(params4.setImportanceLevel(0.0));
+  ASSERT_THROW(params4.setImportanceLevel(1.0));
+  ASSERT_THROW(params4.setAnalyticBins(1000));
+  ASSERT_THROW(params4.setAnalyticBins(8));
+  ASSERT_THROW(params4.setStats("all"));
+  ASSERT_THROW(params4.setParamValue("stats.levels", "0.99, 1.5"));
+  ASSERT_THROW(params4.setStatsLevels(vector<double>()));
+  ASSERT_THROW(params4.setParamValue("stop.level", "1.0"));
+  ASSERT_THROW(params4.setStopPrecision(-0.01));
 
   Params params5;
   params5.setTime0(Date("01/01/2015"));
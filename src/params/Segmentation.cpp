@@ -157,12 +157,13 @@ const std::string& ccruncher::Segmentation::getSegment(unsigned short i) const
 }
 
 /**************************************************************************//**
- * @details Create filename concatenating path/name.csv.
+ * @details Create filename concatenating path/name.ext.
  * @param[in] path Dir path.
+ * @param[in] ext File extension (including the dot).
  * @return File path.
  */
-string ccruncher::Segmentation::getFilename(const string &path) const
+string ccruncher::Segmentation::getFilename(const string &path, const string &ext) const
 {
-  return Utils::realpath(path) + Utils::pathSeparator + mName + ".csv";
+  return Utils::realpath(path) + Utils::pathSeparator + mName + ext;
 }
 
@@ -77,7 +77,7 @@ class Segmentation
     //! Return the index of the given segment
     unsigned short indexOfSegment(const char *segment) const;
     //! Return the filename where segmentation simulation values are placed
-    std::string getFilename(const std::string &path) const;
+    std::string getFilename(const std::string &path, const std::string &ext=".csv") const;
 
 };
 
@@ -179,6 +179,33 @@ void ccruncher::LGD::init(Type t, double a, double b)
   mValue2 = b;
 }
 
+/**************************************************************************//**
+ * @details If lgd is a fixed value, mean coincides with this value,
+ *          but if lgd is a distribution, then it return the mean
+ *          of this distribution.
+ * @return Lgd expected value.
+ */
+double ccruncher::LGD::getExpected() const
+{
+  switch(mType)
+  {
+    case Type::Fixed:
+      return mValue1;
+
+    case Type::Beta:
+      // http://en.wikipedia.org/wiki/Beta_distribution
+      return mValue1/(mValue1+mValue2);
+
+    case Type::Uniform:
+      // http://en.wikipedia.org/wiki/Uniform_distribution_%28continuous%29
+      return (mValue1+mValue2)/2.0;
+
+    default:
+      assert(false);
+      return NAN;
+  }
+}
+
 /**************************************************************************//**
  * @param[in] x LGD check.
  * @return true=valid, false=invalid.
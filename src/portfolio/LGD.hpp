@@ -108,6 +108,8 @@ class LGD
     double getValue2() const {return mValue2; }
     //! Returns lgd
     double getValue(const gsl_rng *rng=nullptr) const;
+    //! Returns the mean of the lgd
+    double getExpected() const;
 
   public:
 
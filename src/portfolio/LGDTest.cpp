@@ -60,6 +60,7 @@ void ccruncher_test::LGDTest::test1()
     ASSERT(r4.getType() == LGD::Type::Fixed);
     ASSERT_EQUALS_EPSILON(r4.getValue1(), 0.35, EPSILON);
     ASSERT(std::isnan(r4.getValue2()));
+    ASSERT_EQUALS_EPSILON(r4.getExpected(), 0.35, EPSILON);
   }
 
   // uniform distribution
@@ -73,6 +74,7 @@ void ccruncher_test::LGDTest::test1()
     ASSERT(r1.getType() == LGD::Type::Uniform);
     ASSERT_EQUALS_EPSILON(r1.getValue1(), 0.25, EPSILON);
     ASSERT_EQUALS_EPSILON(r1.getValue2(), 0.5, EPSILON);
+    ASSERT_EQUALS_EPSILON(r1.getExpected(), 0.375, EPSILON);
 
     LGD r2("uniform(0.2,0.3)");
     ASSERT(r2.getType() == LGD::Type::Uniform);
@@ -91,6 +93,7 @@ void ccruncher_test::LGDTest::test1()
     ASSERT(r0.getType() == LGD::Type::Beta);
     ASSERT_EQUALS_EPSILON(r0.getValue1(), 0.5, EPSILON);
     ASSERT_EQUALS_EPSILON(r0.getValue2(), 0.25, EPSILON);
+    ASSERT_EQUALS_EPSILON(r0.getExpected(), 2.0/3.0, EPSILON);
   
     LGD r1(LGD::Type::Beta, 0.5, 0.25);
     ASSERT(r1.getType() == LGD::Type::Beta);
@@ -0,0 +1,295 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#include <cmath>
+#include <cassert>
+#include "utils/BatchRng.hpp"
+#include "utils/Exception.hpp"
+
+// gaussian values generated at once
+#define CHUNK_SIZE 256
+// 2^-53
+#define TWO_POW_M53 (1.0/9007199254740992.0)
+// Philox4x32 constants
+#define PHILOX_M0 0xD2511F53u
+#define PHILOX_M1 0xCD9E8D57u
+#define PHILOX_W0 0x9E3779B9u
+#define PHILOX_W1 0xBB67AE85u
+#define PHILOX_ROUNDS 10
+
+using namespace std;
+using namespace ccruncher;
+
+/**************************************************************************//**
+ * @details gsl_rng state is a pointer to the BatchRng object.
+ */
+static void rngSet(void *, unsigned long)
+{
+  // nothing to do (stream is set by BatchRng)
+}
+
+/**************************************************************************/
+static double rngGetDouble(void *state)
+{
+  BatchRng *rng = *static_cast<BatchRng**>(state);
+  return rng->getUniform();
+}
+
+/**************************************************************************/
+static unsigned long rngGet(void *state)
+{
+  return static_cast<unsigned long>(rngGetDouble(state) * 4294967296.0);
+}
+
+//! gsl_rng adapter type
+static const gsl_rng_type rngType = {
+  "ccruncher-philox4x32",
+  0xFFFFFFFFUL,
+  0UL,
+  sizeof(BatchRng*),
+  &rngSet,
+  &rngGet,
+  &rngGetDouble
+};
+
+/**************************************************************************//**
+ * @param[in] seed Seed used to initialize generators.
+ * @throw Exception Error allocating gsl_rng.
+ */
+ccruncher::BatchRng::BatchRng(uint64_t seed)
+{
+  mRng = gsl_rng_alloc(&rngType);
+  if (mRng == nullptr) {
+    throw Exception("error allocating rng");
+  }
+  *static_cast<BatchRng**>(gsl_rng_state(mRng)) = this;
+  setSeed(seed);
+}
+
+/**************************************************************************/
+ccruncher::BatchRng::~BatchRng()
+{
+  gsl_rng_free(mRng);
+}
+
+/**************************************************************************//**
+ * @details The seed is the Philox key. Current stream is set to (0,0).
+ * @param[in] seed Seed used to initialize generators.
+ */
+void ccruncher::BatchRng::setSeed(uint64_t seed)
+{
+  mKey[0] = static_cast<uint32_t>(seed);
+  mKey[1] = static_cast<uint32_t>(seed >> 32);
+  setStream(0, 0);
+}
+
+/**************************************************************************//**
+ * @details Values drawn after this call depend only on (seed, block, id).
+ *          Values pools are discarded.
+ * @param[in] block Block index.
+ * @param[in] id Stream identifier into the block.
+ */
+void ccruncher::BatchRng::setStream(uint64_t block, uint32_t id)
+{
+  mCounter[0] = 0;
+  mCounter[1] = id;
+  mCounter[2] = static_cast<uint32_t>(block);
+  mCounter[3] = static_cast<uint32_t>(block >> 32);
+  mGaussianPos = POOLSIZE;
+  mUniformPos = POOLSIZE;
+}
+
+/**************************************************************************//**
+ * @param[in] ctr Counter.
+ * @param[in] key Key.
+ * @param[out] out Random values.
+ */
+void ccruncher::BatchRng::philox(const uint32_t ctr[4], const uint32_t key[2], uint32_t out[4])
+{
+  uint32_t c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3];
+  uint32_t k0 = key[0], k1 = key[1];
+  for(int r=0; r<PHILOX_ROUNDS; r++) {
+    uint64_t p0 = static_cast<uint64_t>(PHILOX_M0) * c0;
+    uint64_t p1 = static_cast<uint64_t>(PHILOX_M1) * c2;
+    c0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ k0;
+    c2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ k1;
+    c1 = static_cast<uint32_t>(p1);
+    c3 = static_cast<uint32_t>(p0);
+    k0 += PHILOX_W0;
+    k1 += PHILOX_W1;
+  }
+  out[0] = c0; out[1] = c1; out[2] = c2; out[3] = c3;
+}
+
+/**************************************************************************//**
+ * @details Evaluates NUMLANES consecutive counters. Each counter gives two
+ *          53-bit uniform values in (0,1). Loops over lanes are
+ *          vectorizable.
+ * @param[out] out Generated values (2*NUMLANES).
+ */
+inline void ccruncher::BatchRng::next(double *out)
+{
+  uint32_t c0[NUMLANES], c1[NUMLANES], c2[NUMLANES], c3[NUMLANES];
+  for(size_t l=0; l<NUMLANES; l++) {
+    c0[l] = mCounter[0] + static_cast<uint32_t>(l);
+    c1[l] = mCounter[1];
+    c2[l] = mCounter[2];
+    c3[l] = mCounter[3];
+  }
+  mCounter[0] += static_cast<uint32_t>(NUMLANES);
+  assert(mCounter[0] != 0); // stream exhausted
+
+  uint32_t k0 = mKey[0], k1 = mKey[1];
+  for(int r=0; r<PHILOX_ROUNDS; r++) {
+    for(size_t l=0; l<NUMLANES; l++) {
+      uint64_t p0 = static_cast<uint64_t>(PHILOX_M0) * c0[l];
+      uint64_t p1 = static_cast<uint64_t>(PHILOX_M1) * c2[l];
+      c0[l] = static_cast<uint32_t>(p1 >> 32) ^ c1[l] ^ k0;
+      c2[l] = static_cast<uint32_t>(p0 >> 32) ^ c3[l] ^ k1;
+      c1[l] = static_cast<uint32_t>(p1);
+      c3[l] = static_cast<uint32_t>(p0);
+    }
+    k0 += PHILOX_W0;
+    k1 += PHILOX_W1;
+  }
+
+  for(size_t l=0; l<NUMLANES; l++) {
+    uint64_t u0 = (static_cast<uint64_t>(c0[l]) << 21) ^ (c1[l] >> 11);
+    uint64_t u1 = (static_cast<uint64_t>(c2[l]) << 21) ^ (c3[l] >> 11);
+    out[2*l] = (static_cast<double>(u0) + 0.5) * TWO_POW_M53;
+    out[2*l+1] = (static_cast<double>(u1) + 0.5) * TWO_POW_M53;
+  }
+}
+
+/**************************************************************************//**
+ * @details Values are in the open interval (0,1), avoiding log(0) in
+ *          transformations. Values are taken from the current stream
+ *          in groups of 2*NUMLANES (remaining ones are discarded).
+ * @param[out] x Array to fill.
+ * @param[in] n Number of values.
+ */
+void ccruncher::BatchRng::uniform(double *x, size_t n)
+{
+  size_t i = 0;
+  for(; i+POOLSIZE<=n; i+=POOLSIZE) {
+    next(x+i);
+  }
+  if (i < n) {
+    double buf[POOLSIZE];
+    next(buf);
+    for(size_t k=0; i+k<n; k++) {
+      x[i+k] = buf[k];
+    }
+  }
+}
+
+/**************************************************************************//**
+ * @return Uniform value in (0,1).
+ */
+double ccruncher::BatchRng::getUniform()
+{
+  if (mUniformPos >= POOLSIZE) {
+    next(mUniforms);
+    mUniformPos = 0;
+  }
+  return mUniforms[mUniformPos++];
+}
+
+/**************************************************************************//**
+ * @details Box-Muller transform applied to batches of uniform values.
+ *          If n is odd the last sine value is discarded.
+ * @param[out] x Array to fill.
+ * @param[in] n Number of values.
+ */
+void ccruncher::BatchRng::gaussian(double *x, size_t n)
+{
+  double u[CHUNK_SIZE];
+  for(size_t i=0; i<n; i+=CHUNK_SIZE) {
+    size_t m = (n-i < CHUNK_SIZE ? n-i : CHUNK_SIZE);
+    size_t m2 = m + m%2;
+    uniform(u, m2);
+    for(size_t k=0; k<m2; k+=2) {
+      double r = sqrt(-2.0*log(u[k]));
+      double theta = 2.0 * M_PI * u[k+1];
+      x[i+k] = r * cos(theta);
+      if (k+1 < m) {
+        x[i+k+1] = r * sin(theta);
+      }
+    }
+  }
+}
+
+/**************************************************************************//**
+ * @return Standard normal value.
+ */
+inline double ccruncher::BatchRng::getGaussian()
+{
+  if (mGaussianPos >= POOLSIZE) {
+    gaussian(mGaussians, POOLSIZE);
+    mGaussianPos = 0;
+  }
+  return mGaussians[mGaussianPos++];
+}
+
+/**************************************************************************//**
+ * @details Marsaglia-Tsang method (acceptance rate > 95%). If a < 1 uses
+ *          gamma(a) = gamma(a+1)·U^(1/a).
+ * @param[in] a Shape parameter (a > 0).
+ * @return Gamma(a,1) value.
+ */
+double ccruncher::BatchRng::gamma(double a)
+{
+  assert(a > 0.0);
+
+  if (a < 1.0) {
+    double u = getUniform();
+    return gamma(a + 1.0) * pow(u, 1.0/a);
+  }
+
+  double d = a - 1.0/3.0;
+  double c = 1.0 / sqrt(9.0*d);
+  while(true)
+  {
+    double z = getGaussian();
+    double v = 1.0 + c*z;
+    if (v <= 0.0) continue;
+    v = v*v*v;
+    double u = getUniform();
+    double z2 = z*z;
+    if (u < 1.0 - 0.0331*z2*z2) return d*v;
+    if (log(u) < 0.5*z2 + d*(1.0 - v + log(v))) return d*v;
+  }
+}
+
+/**************************************************************************//**
+ * @details chisq(ndf) = 2·gamma(ndf/2).
+ * @param[in] ndf Degrees of freedom (ndf > 0).
+ * @param[out] x Array to fill.
+ * @param[in] n Number of values.
+ */
+void ccruncher::BatchRng::chisq(double ndf, double *x, size_t n)
+{
+  assert(ndf > 0.0);
+  for(size_t i=0; i<n; i++) {
+    x[i] = 2.0 * gamma(0.5*ndf);
+  }
+}
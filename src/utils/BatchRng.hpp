@@ -0,0 +1,121 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <gsl/gsl_rng.h>
+
+namespace ccruncher {
+
+/**************************************************************************//**
+ * @brief Batched counter-based random number generator.
+ *
+ * @details Fills whole arrays of uniform, gaussian and chi-square variates
+ *          avoiding the per-variate function pointer call of gsl_rng.
+ *          Uniforms are generated by the Philox4x32-10 counter-based
+ *          generator: the i-th value of a stream is a function of (key,
+ *          counter) only. The key is the seed and the counter is composed
+ *          by the stream identifier (block, id) and the draw index. This
+ *          allows to reproduce any stream without generating the previous
+ *          ones (eg. same results whatever the number of threads).
+ *          NUMLANES counters are processed at once as structure of arrays
+ *          using vectorizable integer operations. Gaussians are obtained by
+ *          the Box-Muller transform, and chi-squares by the Marsaglia-Tsang
+ *          gamma method. A gsl_rng adapter drawing values from the current
+ *          stream is provided to be used with the GSL distributions. Each
+ *          instance is intended to be used by a single thread.
+ *
+ * @see Salmon, Moraes, Dror, Shaw. Parallel random numbers: as easy as
+ *      1, 2, 3. SC'11 Proceedings, 2011.
+ * @see Marsaglia, Tsang. A simple method for generating gamma variables.
+ *      ACM Transactions on Mathematical Software, 26(3), 2000.
+ */
+class BatchRng
+{
+
+  public:
+
+    //! Number of counters processed at once
+    static const size_t NUMLANES = 8;
+    //! Values pools size
+    static const size_t POOLSIZE = 2*NUMLANES;
+
+  private:
+
+    //! Philox key (seed)
+    uint32_t mKey[2];
+    //! Philox counter (draw index, id, block low, block high)
+    uint32_t mCounter[4];
+    //! Gaussian values pool (used by rejection methods)
+    double mGaussians[POOLSIZE];
+    //! Uniform values pool (used by rejection methods)
+    double mUniforms[POOLSIZE];
+    //! Next unused gaussian value
+    size_t mGaussianPos;
+    //! Next unused uniform value
+    size_t mUniformPos;
+    //! GSL adapter
+    gsl_rng *mRng;
+
+  private:
+
+    //! Generates 2*NUMLANES uniform values
+    void next(double *out);
+    //! Returns a gaussian value from pool
+    double getGaussian();
+    //! Gamma random variate
+    double gamma(double a);
+
+  public:
+
+    //! Constructor
+    BatchRng(uint64_t seed=0);
+    //! Non-copyable class
+    BatchRng(const BatchRng &) = delete;
+    //! Non-copyable class
+    BatchRng & operator=(const BatchRng &) = delete;
+    //! Destructor
+    ~BatchRng();
+    //! Set seed (and stream 0,0)
+    void setSeed(uint64_t seed);
+    //! Set current stream
+    void setStream(uint64_t block, uint32_t id);
+    //! Uniform values in (0,1)
+    void uniform(double *x, size_t n);
+    //! Returns a uniform value in (0,1)
+    double getUniform();
+    //! Standard normal values
+    void gaussian(double *x, size_t n);
+    //! Chi-square values with ndf degrees of freedom
+    void chisq(double ndf, double *x, size_t n);
+    //! GSL adapter (draws values from current stream)
+    const gsl_rng* getRng() const { return mRng; }
+
+    //! Philox4x32-10 function
+    static void philox(const uint32_t ctr[4], const uint32_t key[2], uint32_t out[4]);
+
+};
+
+} // namespace
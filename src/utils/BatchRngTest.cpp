@@ -0,0 +1,196 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <gsl/gsl_rng.h>
+#include "utils/BatchRng.hpp"
+#include "utils/BatchRngTest.hpp"
+
+#define NUMVALUES 1000000
+
+using namespace std;
+using namespace ccruncher;
+
+//===========================================================================
+// mean and variance
+//===========================================================================
+static void moments(const vector<double> &x, double &mean, double &var)
+{
+  mean = 0.0;
+  for(double v : x) mean += v;
+  mean /= x.size();
+  var = 0.0;
+  for(double v : x) var += (v-mean)*(v-mean);
+  var /= (x.size()-1);
+}
+
+//===========================================================================
+// test1 (uniform)
+//===========================================================================
+void ccruncher_test::BatchRngTest::test1()
+{
+  double mean, var;
+  vector<double> x(NUMVALUES);
+  BatchRng rng(1234UL);
+  rng.uniform(x.data(), x.size());
+
+  for(double v : x) {
+    ASSERT(0.0 < v && v < 1.0);
+  }
+  moments(x, mean, var);
+  ASSERT_EQUALS_EPSILON(0.5, mean, 0.002);
+  ASSERT_EQUALS_EPSILON(1.0/12.0, var, 0.001);
+
+  // same seed, same values (whatever the batch sizes)
+  vector<double> y(NUMVALUES);
+  rng.setSeed(1234UL);
+  for(size_t i=0; i<y.size(); i+=BatchRng::POOLSIZE*3) {
+    rng.uniform(y.data()+i, std::min(BatchRng::POOLSIZE*3, y.size()-i));
+  }
+  for(size_t i=0; i<x.size(); i++) {
+    ASSERT_EQUALS(x[i], y[i]);
+  }
+
+  // distinct seeds, distinct values
+  BatchRng rng2(1235UL);
+  rng2.uniform(y.data(), y.size());
+  size_t numequals = 0;
+  for(size_t i=0; i<x.size(); i++) {
+    if (x[i] == y[i]) numequals++;
+  }
+  ASSERT(numequals < 10);
+}
+
+//===========================================================================
+// test2 (gaussian)
+//===========================================================================
+void ccruncher_test::BatchRngTest::test2()
+{
+  double mean, var;
+  vector<double> x(NUMVALUES+1);
+  BatchRng rng(4321UL);
+  rng.gaussian(x.data(), x.size());
+
+  moments(x, mean, var);
+  ASSERT_EQUALS_EPSILON(0.0, mean, 0.005);
+  ASSERT_EQUALS_EPSILON(1.0, var, 0.005);
+
+  // tail probability P(X < -2) = 0.02275
+  size_t num = 0;
+  for(double v : x) {
+    if (v < -2.0) num++;
+  }
+  ASSERT_EQUALS_EPSILON(0.02275, double(num)/x.size(), 0.001);
+}
+
+//===========================================================================
+// test3 (chi-square)
+//===========================================================================
+void ccruncher_test::BatchRngTest::test3()
+{
+  double mean, var;
+  vector<double> x(NUMVALUES);
+  BatchRng rng(9876UL);
+
+  for(double ndf : {0.7, 2.0, 4.0, 13.5})
+  {
+    rng.chisq(ndf, x.data(), x.size());
+    for(double v : x) {
+      ASSERT(v >= 0.0);
+    }
+    moments(x, mean, var);
+    ASSERT_EQUALS_EPSILON(ndf, mean, 0.01*ndf);
+    ASSERT_EQUALS_EPSILON(2.0*ndf, var, 0.02*2.0*ndf);
+  }
+}
+
+//===========================================================================
+// test4 (Philox4x32-10 known answer tests)
+//===========================================================================
+void ccruncher_test::BatchRngTest::test4()
+{
+  uint32_t out[4];
+
+  uint32_t ctr1[4] = { 0x00000000, 0x00000000, 0x00000000, 0x00000000 };
+  uint32_t key1[2] = { 0x00000000, 0x00000000 };
+  BatchRng::philox(ctr1, key1, out);
+  ASSERT_EQUALS(0x6627e8d5u, out[0]);
+  ASSERT_EQUALS(0xe169c58du, out[1]);
+  ASSERT_EQUALS(0xbc57ac4cu, out[2]);
+  ASSERT_EQUALS(0x9b00dbd8u, out[3]);
+
+  uint32_t ctr2[4] = { 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff };
+  uint32_t key2[2] = { 0xffffffff, 0xffffffff };
+  BatchRng::philox(ctr2, key2, out);
+  ASSERT_EQUALS(0x408f276du, out[0]);
+  ASSERT_EQUALS(0x41c83b0eu, out[1]);
+  ASSERT_EQUALS(0xa20bc7c6u, out[2]);
+  ASSERT_EQUALS(0x6d5451fdu, out[3]);
+
+  uint32_t ctr3[4] = { 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344 };
+  uint32_t key3[2] = { 0xa4093822, 0x299f31d0 };
+  BatchRng::philox(ctr3, key3, out);
+  ASSERT_EQUALS(0xd16cfe09u, out[0]);
+  ASSERT_EQUALS(0x94fdccebu, out[1]);
+  ASSERT_EQUALS(0x5001e420u, out[2]);
+  ASSERT_EQUALS(0x24126ea1u, out[3]);
+}
+
+//===========================================================================
+// test5 (streams)
+//===========================================================================
+void ccruncher_test::BatchRngTest::test5()
+{
+  BatchRng rng1(777UL);
+  BatchRng rng2(777UL);
+  vector<double> x(100), y(100);
+
+  // stream values don't depend on previous usage
+  rng1.setStream(5, 3);
+  rng1.gaussian(x.data(), x.size());
+  rng2.setStream(4, 3);
+  rng2.uniform(y.data(), y.size());
+  rng2.setStream(5, 3);
+  rng2.gaussian(y.data(), y.size());
+  for(size_t i=0; i<x.size(); i++) {
+    ASSERT_EQUALS(x[i], y[i]);
+  }
+
+  // distinct streams give distinct values
+  rng2.setStream(5, 4);
+  rng2.gaussian(y.data(), y.size());
+  ASSERT(x[0] != y[0]);
+  rng2.setStream(6, 3);
+  rng2.gaussian(y.data(), y.size());
+  ASSERT(x[0] != y[0]);
+
+  // gsl adapter draws from current stream
+  rng1.setStream(1, 2);
+  rng2.setStream(1, 2);
+  for(size_t i=0; i<100; i++) {
+    double u = gsl_rng_uniform(rng1.getRng());
+    ASSERT(0.0 < u && u < 1.0);
+    ASSERT_EQUALS(rng2.getUniform(), u);
+  }
+}
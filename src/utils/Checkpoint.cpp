@@ -0,0 +1,181 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#include <cstdio>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <zlib.h>
+#include "utils/Checkpoint.hpp"
+
+// file signature
+#define MAGIC "CCRCKP\r\n"
+// file format version
+#define VERSION 1
+// byte order mark
+#define BOM 0x01020304u
+
+using namespace std;
+using namespace ccruncher;
+
+/**************************************************************************//**
+ * @param[in] ptr Bytes to append.
+ * @param[in] size Number of bytes.
+ */
+void ccruncher::Checkpoint::write(const void *ptr, size_t size)
+{
+  const char *bytes = static_cast<const char *>(ptr);
+  mData.insert(mData.end(), bytes, bytes+size);
+}
+
+/**************************************************************************//**
+ * @param[out] ptr Destination.
+ * @param[in] size Number of bytes.
+ * @throw Exception Unexpected end of archive.
+ */
+void ccruncher::Checkpoint::read(void *ptr, size_t size)
+{
+  if (size > mData.size()-mPos) {
+    throw Exception("unexpected end of checkpoint data");
+  }
+  memcpy(ptr, mData.data()+mPos, size);
+  mPos += size;
+}
+
+/**************************************************************************//**
+ * @param[in] str String to append (length and content).
+ */
+void ccruncher::Checkpoint::put(const string &str)
+{
+  put(vector<char>(str.begin(), str.end()));
+}
+
+/**************************************************************************//**
+ * @param[out] str String read.
+ * @throw Exception Unexpected end of archive.
+ */
+void ccruncher::Checkpoint::get(string &str)
+{
+  vector<char> aux;
+  get(aux);
+  str.assign(aux.begin(), aux.end());
+}
+
+/**************************************************************************//**
+ * @details File content: signature, version, byte order mark, data size
+ *          and data. Data is written to filename.tmp, which is renamed
+ *          to filename once completed.
+ * @param[in] filename File name.
+ * @throw Exception Error writing file.
+ */
+void ccruncher::Checkpoint::save(const string &filename) const
+{
+  string tmpname = filename + ".tmp";
+
+  try {
+    uint32_t version = VERSION;
+    uint32_t bom = BOM;
+    uint64_t size = mData.size();
+    ofstream file;
+    file.exceptions(ios::failbit | ios::badbit);
+    file.open(tmpname.c_str(), ios::out|ios::trunc|ios::binary);
+    file.write(MAGIC, strlen(MAGIC));
+    file.write(reinterpret_cast<const char *>(&version), sizeof(version));
+    file.write(reinterpret_cast<const char *>(&bom), sizeof(bom));
+    file.write(reinterpret_cast<const char *>(&size), sizeof(size));
+    file.write(mData.data(), mData.size());
+    file.close();
+  }
+  catch(std::exception &e) {
+    remove(tmpname.c_str());
+    throw Exception(e, "error writing file '" + tmpname + "'");
+  }
+
+#ifdef _WIN32
+  remove(filename.c_str());
+#endif
+  if (rename(tmpname.c_str(), filename.c_str()) != 0) {
+    throw Exception("error renaming file '" + tmpname + "'");
+  }
+}
+
+/**************************************************************************//**
+ * @details Previous content is discarded and the read position is reset.
+ * @param[in] filename File name.
+ * @throw Exception Error reading file or invalid file.
+ */
+void ccruncher::Checkpoint::load(const string &filename)
+{
+  vector<char> content;
+
+  try {
+    ifstream file;
+    file.exceptions(ios::badbit);
+    file.open(filename.c_str(), ios::in|ios::binary);
+    if (!file.is_open()) {
+      throw Exception("file not found");
+    }
+    content.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+  }
+  catch(std::exception &e) {
+    throw Exception(e, "error reading file '" + filename + "'");
+  }
+
+  size_t offset = strlen(MAGIC) + 2*sizeof(uint32_t) + sizeof(uint64_t);
+  if (content.size() < offset || memcmp(content.data(), MAGIC, strlen(MAGIC)) != 0) {
+    throw Exception("file '" + filename + "' is not a checkpoint");
+  }
+
+  uint32_t version = 0;
+  uint32_t bom = 0;
+  uint64_t size = 0;
+  const char *ptr = content.data() + strlen(MAGIC);
+  memcpy(&version, ptr, sizeof(version));
+  memcpy(&bom, ptr+sizeof(version), sizeof(bom));
+  memcpy(&size, ptr+2*sizeof(version), sizeof(size));
+
+  if (bom != BOM) {
+    throw Exception("checkpoint '" + filename + "' created in a host with distinct byte order");
+  }
+  if (version != VERSION) {
+    throw Exception("checkpoint '" + filename + "' has an unsupported version");
+  }
+  if (size != content.size()-offset) {
+    throw Exception("checkpoint '" + filename + "' is truncated");
+  }
+
+  mData.assign(content.begin()+offset, content.end());
+  mPos = 0;
+}
+
+/**************************************************************************//**
+ * @details Used to compare archives without storing them.
+ * @return Checksum (crc32) of the archive content.
+ */
+unsigned long ccruncher::Checkpoint::getChecksum() const
+{
+  unsigned long ret = crc32(0L, Z_NULL, 0);
+  if (!mData.empty()) {
+    ret = crc32(ret, reinterpret_cast<const Bytef*>(mData.data()), static_cast<uInt>(mData.size()));
+  }
+  return ret;
+}
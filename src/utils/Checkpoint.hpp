@@ -0,0 +1,147 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include "utils/Exception.hpp"
+
+namespace ccruncher {
+
+/**************************************************************************//**
+ * @brief Binary archive used to save and restore a simulation state.
+ *
+ * @details Values are appended to an in-memory buffer using put() and
+ *          read back in the same order using get(). Only plain values
+ *          (numbers, simple structs and pairs), strings and vectors of
+ *          plain values are supported.
+ *          Values are stored in host byte order, so a checkpoint can only
+ *          be restored in a host with the same architecture. The file is
+ *          first written to a temporary file and then renamed, so a
+ *          failure while saving doesn't destroy the previous checkpoint.
+ */
+class Checkpoint
+{
+
+  private:
+
+    //! Serialized values
+    std::vector<char> mData;
+    //! Read position
+    size_t mPos;
+
+  private:
+
+    //! Indicates if a type can be copied byte by byte
+    template<class T> static constexpr bool isPlain() {
+      return std::is_trivially_copy_constructible<T>::value && std::is_trivially_destructible<T>::value;
+    }
+    //! Append raw bytes
+    void write(const void *ptr, size_t size);
+    //! Read raw bytes
+    void read(void *ptr, size_t size);
+
+  public:
+
+    //! Constructor
+    Checkpoint() : mPos(0) {}
+    //! Append a value
+    template<class T> void put(const T &val);
+    //! Append a string
+    void put(const std::string &str);
+    //! Append a vector of values
+    template<class T> void put(const std::vector<T> &values);
+    //! Read a value
+    template<class T> void get(T &val);
+    //! Read a string
+    void get(std::string &str);
+    //! Read a vector of values
+    template<class T> void get(std::vector<T> &values);
+    //! Write the archive to a file
+    void save(const std::string &filename) const;
+    //! Read the archive from a file
+    void load(const std::string &filename);
+    //! Returns the archive size (in bytes)
+    size_t size() const { return mData.size(); }
+    //! Returns the archive checksum (crc32)
+    unsigned long getChecksum() const;
+
+};
+
+/**************************************************************************//**
+ * @param[in] val Value to append.
+ */
+template<class T>
+void ccruncher::Checkpoint::put(const T &val)
+{
+  static_assert(isPlain<T>(), "non plain type");
+  write(&val, sizeof(T));
+}
+
+/**************************************************************************//**
+ * @param[in] values Values to append (size and content).
+ */
+template<class T>
+void ccruncher::Checkpoint::put(const std::vector<T> &values)
+{
+  static_assert(isPlain<T>(), "non plain type");
+  put(static_cast<uint64_t>(values.size()));
+  if (!values.empty()) {
+    write(values.data(), values.size()*sizeof(T));
+  }
+}
+
+/**************************************************************************//**
+ * @param[out] val Value read.
+ * @throw Exception Unexpected end of archive.
+ */
+template<class T>
+void ccruncher::Checkpoint::get(T &val)
+{
+  static_assert(isPlain<T>(), "non plain type");
+  read(&val, sizeof(T));
+}
+
+/**************************************************************************//**
+ * @param[out] values Values read.
+ * @throw Exception Unexpected end of archive.
+ */
+template<class T>
+void ccruncher::Checkpoint::get(std::vector<T> &values)
+{
+  static_assert(isPlain<T>(), "non plain type");
+  uint64_t num = 0;
+  get(num);
+  if (num > (mData.size()-mPos)/sizeof(T)) {
+    throw Exception("unexpected end of checkpoint data");
+  }
+  values.resize(num);
+  if (num > 0) {
+    read(values.data(), num*sizeof(T));
+  }
+}
+
+} // namespace
@@ -0,0 +1,143 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iterator>
+#include "utils/Checkpoint.hpp"
+#include "utils/CheckpointTest.hpp"
+#include "utils/TDigest.hpp"
+#include "utils/Utils.hpp"
+
+using namespace std;
+using namespace ccruncher;
+
+//===========================================================================
+// setUp
+//===========================================================================
+void ccruncher_test::CheckpointTest::setUp()
+{
+  workdir = Utils::makeTempDir("ccruncher-checkpointtest.");
+}
+
+//===========================================================================
+// tearDown
+//===========================================================================
+void ccruncher_test::CheckpointTest::tearDown()
+{
+  Utils::removeDir(workdir);
+}
+
+//===========================================================================
+// test1 (save and load)
+//===========================================================================
+void ccruncher_test::CheckpointTest::test1()
+{
+  string filename = workdir + Utils::pathSeparator + "checkpoint-test.ckp";
+  Checkpoint checkpoint1;
+  checkpoint1.put(123456789UL);
+  checkpoint1.put(true);
+  checkpoint1.put(string("sectors.csv"));
+  checkpoint1.put(vector<double>{1.5, -numeric_limits<double>::infinity(), 0.1});
+  checkpoint1.put(vector<pair<int,double>>{{-3, 0.25}, {7, 0.75}});
+  checkpoint1.put(string());
+  ASSERT_NO_THROW(checkpoint1.save(filename));
+
+  Checkpoint checkpoint2;
+  ASSERT_NO_THROW(checkpoint2.load(filename));
+  ASSERT_EQUALS(checkpoint1.size(), checkpoint2.size());
+  ASSERT_EQUALS(checkpoint1.getChecksum(), checkpoint2.getChecksum());
+  ASSERT(checkpoint1.getChecksum() != Checkpoint().getChecksum());
+
+  unsigned long num = 0;
+  bool flag = false;
+  string str = "x";
+  vector<double> values;
+  vector<pair<int,double>> pairs;
+  checkpoint2.get(num);
+  checkpoint2.get(flag);
+  checkpoint2.get(str);
+  checkpoint2.get(values);
+  checkpoint2.get(pairs);
+  ASSERT_EQUALS(123456789UL, num);
+  ASSERT(flag);
+  ASSERT_EQUALS("sectors.csv", str);
+  ASSERT_EQUALS((size_t)3, values.size());
+  ASSERT_EQUALS(1.5, values[0]);
+  ASSERT(std::isinf(values[1]) && values[1] < 0.0);
+  ASSERT_EQUALS(0.1, values[2]);
+  ASSERT_EQUALS((size_t)2, pairs.size());
+  ASSERT_EQUALS(-3, pairs[0].first);
+  ASSERT_EQUALS(0.75, pairs[1].second);
+  checkpoint2.get(str);
+  ASSERT_EQUALS("", str);
+
+  // no more data
+  ASSERT_THROW(checkpoint2.get(num));
+
+  // t-digest state
+  TDigest digest1(50.0);
+  TDigest digest2(50.0);
+  for(int i=0; i<1000; i++) digest1.add((i*7919)%1000);
+  Checkpoint checkpoint3;
+  digest1.save(checkpoint3);
+  digest2.restore(checkpoint3);
+  for(int i=0; i<333; i++) {
+    digest1.add(i*0.5);
+    digest2.add(i*0.5);
+  }
+  ASSERT_EQUALS(digest1.size(), digest2.size());
+  ASSERT_EQUALS(digest1.getWeight(), digest2.getWeight());
+  ASSERT_EQUALS(digest1.quantile(0.99), digest2.quantile(0.99));
+  ASSERT_EQUALS(digest1.tailMean(0.9), digest2.tailMean(0.9));
+  TDigest digest3(100.0);
+  ASSERT_THROW(digest3.restore(checkpoint3));
+}
+
+//===========================================================================
+// test2 (invalid files)
+//===========================================================================
+void ccruncher_test::CheckpointTest::test2()
+{
+  string filename = workdir + Utils::pathSeparator + "checkpoint-test.ckp";
+  Checkpoint checkpoint;
+  ASSERT_THROW(checkpoint.load(filename));
+
+  // not a checkpoint
+  ofstream(filename) << "this is not a checkpoint file";
+  ASSERT_THROW(checkpoint.load(filename));
+
+  // truncated file
+  Checkpoint checkpoint1;
+  checkpoint1.put(vector<double>(100, 1.0));
+  ASSERT_NO_THROW(checkpoint1.save(filename));
+  string content;
+  {
+    ifstream file(filename, ios::binary);
+    content.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+  }
+  ofstream(filename, ios::binary|ios::trunc) << content.substr(0, content.size()-8);
+  ASSERT_THROW(checkpoint.load(filename));
+}
@@ -25,7 +25,9 @@
 #include <cctype>
 #include <cerrno>
 #include <cassert>
+#include <algorithm>
 #include "utils/CsvFile.hpp"
+#include "utils/Utils.hpp"
 
 using namespace std;
 
@@ -34,12 +36,15 @@ using namespace std;
 #define FIELD_SEPARATOR ','
 #define COMMENT_CHAR '#'
 
+const char ccruncher::CsvFile::BINARY_MAGIC[8] = {'C','C','R','B','I','N','\r','\n'};
+const uint32_t ccruncher::CsvFile::BINARY_VERSION;
+
 /**************************************************************************//**
  * @param[in] fname CSV file path with read permission.
  * @throw Exception Error opening file.
  */
 ccruncher::CsvFile::CsvFile(const string &fname)
-    : filename(""), file(nullptr), filesize(0)
+    : filename(""), file(nullptr), filesize(0), valuesize(0), dataoffset(0)
 {
   if (fname != "") {
     open(fname);
@@ -63,7 +68,7 @@ void ccruncher::CsvFile::open(const string &fname)
 
   filename = fname;
 
-  file = fopen(fname.c_str(), "r");
+  file = fopen(fname.c_str(), "rb");
   if (file == nullptr) {
     throw Exception("error opening file " + fname);
   }
@@ -77,6 +82,114 @@ void ccruncher::CsvFile::open(const string &fname)
   fseek(file, 0, SEEK_END);
   filesize = ftell(file);
   fseek(file, pos0, SEEK_SET);
+
+  // checking binary format
+  char magic[sizeof(BINARY_MAGIC)];
+  if (fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+      memcmp(magic, BINARY_MAGIC, sizeof(magic)) == 0) {
+    readBinaryHeader();
+  }
+  else {
+    fseek(file, pos0, SEEK_SET);
+  }
+}
+
+/**************************************************************************//**
+ * @details Reads the binary header (see Aggregator::printBinaryHeader())
+ *          and sets headers and data offset. Magic number has been read.
+ * @throw Exception Invalid binary header.
+ */
+void ccruncher::CsvFile::readBinaryHeader()
+{
+  uint32_t values[5];
+  readBinaryValue(values, sizeof(uint32_t), 5);
+
+  if (values[0] != BINARY_VERSION) {
+    throw Exception("unsupported binary version in file " + filename);
+  }
+  if (values[1] != sizeof(float) && values[1] != sizeof(double)) {
+    throw Exception("invalid value size in file " + filename);
+  }
+  if (values[2] == 0 || values[3] > filesize) {
+    throw Exception("invalid binary header in file " + filename);
+  }
+
+  valuesize = values[1];
+  dataoffset = values[3];
+
+  // skipping generator
+  fseek(file, values[4], SEEK_CUR);
+
+  // reading segment names
+  headers.resize(values[2]);
+  for(size_t i=0; i<headers.size(); i++) {
+    uint32_t len = 0;
+    readBinaryValue(&len, sizeof(uint32_t));
+    if (len > MAX_FIELD_SIZE*1024) {
+      throw Exception("invalid binary header in file " + filename);
+    }
+    headers[i].resize(len);
+    if (len > 0 && fread(&(headers[i][0]), 1, len, file) != len) {
+      throw Exception("invalid binary header in file " + filename);
+    }
+  }
+
+  // exposures are skipped
+  fseek(file, dataoffset, SEEK_SET);
+}
+
+/**************************************************************************//**
+ * @param[out] ptr Values read (converted to host byte order).
+ * @param[in] size Size of each value (in bytes).
+ * @param[in] num Number of values.
+ * @throw Exception Unexpected end of file.
+ */
+void ccruncher::CsvFile::readBinaryValue(void *ptr, size_t size, size_t num)
+{
+  if (fread(ptr, size, num, file) != num) {
+    throw Exception("invalid binary header in file " + filename);
+  }
+  if (!Utils::isLittleEndian()) {
+    Utils::swapBytes(ptr, size, num);
+  }
+}
+
+/**************************************************************************//**
+ * @details Reads the next chunk of complete rows of a binary file. An
+ *          incomplete trailing row is not consumed (it can be in writing).
+ * @param[out] values Row-major values readed.
+ * @return Number of rows readed (0 = end of file).
+ */
+size_t ccruncher::CsvFile::getRows(vector<double> &values)
+{
+  assert(valuesize > 0);
+  size_t numcols = headers.size();
+  size_t rowsize = numcols*valuesize;
+  rows.resize(std::max(BUFFER_SIZE/rowsize, size_t(1))*rowsize);
+
+  size_t rc = fread(rows.data(), 1, rows.size(), file);
+  size_t numrows = rc/rowsize;
+  if (numrows*rowsize < rc) {
+    fseek(file, -static_cast<long>(rc-numrows*rowsize), SEEK_CUR);
+  }
+
+  size_t num = numrows*numcols;
+  if (!Utils::isLittleEndian()) {
+    Utils::swapBytes(rows.data(), valuesize, num);
+  }
+
+  values.resize(num);
+  if (valuesize == sizeof(double)) {
+    memcpy(values.data(), rows.data(), num*sizeof(double));
+  }
+  else {
+    const float *ptr = reinterpret_cast<const float *>(rows.data());
+    for(size_t i=0; i<num; i++) {
+      values[i] = ptr[i];
+    }
+  }
+
+  return numrows;
 }
 
 /**************************************************************************/
@@ -91,6 +204,8 @@ void ccruncher::CsvFile::close()
   ptr1 = nullptr;
   buffer[0] = 0;
   filesize = 0;
+  valuesize = 0;
+  dataoffset = 0;
 }
 
 /**************************************************************************//**
@@ -102,6 +217,7 @@ const vector<string>& ccruncher::CsvFile::getHeaders()
 
   headers.clear();
   open(filename);
+  if (valuesize > 0) return headers;
 
   int rc;
   do
@@ -296,6 +412,23 @@ void ccruncher::CsvFile::getColumn(int col, vector<double> &ret, bool *stop)
   ret.clear();
   open(filename);
 
+  if (valuesize > 0)
+  {
+    size_t numcols = headers.size();
+    if (static_cast<size_t>(col) >= numcols) {
+      throw Exception("value not found");
+    }
+    vector<double> values;
+    size_t numrows = 0;
+    while((numrows = getRows(values)) > 0) {
+      for(size_t i=0; i<numrows; i++) {
+        ret.push_back(values[i*numcols+col]);
+      }
+      if (stop != nullptr && *stop) break;
+    }
+    return;
+  }
+
   try
   {
     // skip headers
@@ -364,6 +497,25 @@ void ccruncher::CsvFile::getRowSums(vector<double> &ret, bool *stop)
   ret.clear();
   open(filename);
 
+  if (valuesize > 0)
+  {
+    vector<double> values;
+    size_t numrows = 0;
+    while((numrows = getRows(values)) > 0) {
+      const double *ptr = values.data();
+      for(size_t i=0; i<numrows; i++) {
+        double sum = 0.0;
+        for(size_t j=0; j<headers.size(); j++) {
+          sum += *ptr;
+          ptr++;
+        }
+        ret.push_back(sum);
+      }
+      if (stop != nullptr && *stop) break;
+    }
+    return;
+  }
+
   try
   {
     // skip headers
@@ -426,6 +578,24 @@ void ccruncher::CsvFile::getColumns(vector<vector<double>> &ret, bool *stop)
   ret.clear();
   open(filename);
 
+  if (valuesize > 0)
+  {
+    ret.resize(headers.size());
+    vector<double> values;
+    size_t numrows = 0;
+    while((numrows = getRows(values)) > 0) {
+      const double *ptr = values.data();
+      for(size_t i=0; i<numrows; i++) {
+        for(size_t j=0; j<ret.size(); j++) {
+          ret[j].push_back(*ptr);
+          ptr++;
+        }
+      }
+      if (stop != nullptr && *stop) break;
+    }
+    return;
+  }
+
   try
   {
     // skip headers
@@ -504,7 +674,8 @@ size_t ccruncher::CsvFile::getReadedSize() const
 }
 
 /**************************************************************************//**
- * @details Count the number of eol in the file.
+ * @details Count the number of eol in the file. In binary files returns
+ *          the number of complete rows plus one (the header).
  * @return Number of lines
  * @throw Exception If file can not be readed.
  */
@@ -515,6 +686,10 @@ size_t ccruncher::CsvFile::getNumLines()
 
   open(filename);
 
+  if (valuesize > 0) {
+    return (filesize-dataoffset)/(headers.size()*valuesize) + 1;
+  }
+
   do
   {
     rc = getChunk(nullptr);
@@ -25,6 +25,7 @@
 #include <string>
 #include <vector>
 #include <cstdio>
+#include <cstdint>
 #include <fstream>
 #include "utils/Exception.hpp"
 
@@ -40,12 +41,24 @@ namespace ccruncher {
  *          parsed lines (to compute the parsing progress). Observe
  *          that CSV can file simultaneously writed by another
  *          process/thread.
+ *          Binary files created by Aggregator are also supported. They
+ *          are identified by their magic number (see BINARY_MAGIC) and
+ *          have a header followed by raw little-endian rows (see
+ *          Aggregator::printBinaryHeader()). Trailing incomplete rows
+ *          are ignored.
  *
  * @see http://en.wikipedia.org/wiki/Comma-separated_values
  */
 class CsvFile
 {
 
+  public:
+
+    //! Binary file identifier
+    static const char BINARY_MAGIC[8];
+    //! Binary format version
+    static const uint32_t BINARY_VERSION = 1;
+
   private:
 
     //! File name
@@ -62,6 +75,12 @@ class CsvFile
     char *ptr1;
     //! File size (in bytes)
     size_t filesize;
+    //! Value size in bytes (0=text file)
+    size_t valuesize;
+    //! Data offset in bytes (binary file)
+    size_t dataoffset;
+    //! Binary rows buffer
+    std::vector<char> rows;
 
   private:
 
@@ -77,6 +96,12 @@ class CsvFile
     static char* trim(char *);
     //! Skip comments
     void skipComments();
+    //! Read binary header
+    void readBinaryHeader();
+    //! Read binary values
+    void readBinaryValue(void *ptr, size_t size, size_t num=1);
+    //! Read binary rows
+    size_t getRows(std::vector<double> &values);
 
   public:
 
@@ -100,6 +125,8 @@ class CsvFile
     size_t getReadedSize() const;
     //! Returns the number of lines
     size_t getNumLines();
+    //! Returns value size (0=text file)
+    size_t getValueSize() const { return valuesize; }
 
 };
 
@@ -0,0 +1,149 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <cassert>
+
+namespace ccruncher {
+
+/**************************************************************************//**
+ * @brief   Bounded single-producer single-consumer lock-free queue.
+ *
+ * @details Items are preallocated and recycled. The producer gets a
+ *          free slot calling RingBuffer::back(), fills it, and publishes
+ *          it calling RingBuffer::push(). The consumer reads the oldest
+ *          published slot calling RingBuffer::front() and releases it
+ *          calling RingBuffer::pop(). Only one thread can act as producer
+ *          and only one thread can act as consumer. No method blocks.
+ */
+template<class T>
+class RingBuffer
+{
+
+  private:
+
+    //! Preallocated items
+    std::vector<T> mItems;
+    //! Number of popped items (written by consumer)
+    std::atomic<size_t> mHead;
+    //! Padding to avoid false sharing between counters
+    char mPadding[64];
+    //! Number of pushed items (written by producer)
+    std::atomic<size_t> mTail;
+
+  public:
+
+    //! Constructor
+    RingBuffer(size_t capacity, const T &value=T());
+    //! Non-copyable class
+    RingBuffer(const RingBuffer &) = delete;
+    //! Non-copyable class
+    RingBuffer & operator=(const RingBuffer &) = delete;
+    //! Maximum number of items
+    size_t capacity() const { return mItems.size(); }
+    //! Number of published items
+    size_t size() const;
+    //! Indicates if there are no published items
+    bool empty() const { return (size() == 0); }
+    //! Returns the next free slot (producer)
+    T* back();
+    //! Publishes the slot returned by back() (producer)
+    void push();
+    //! Returns the oldest published item (consumer)
+    T* front();
+    //! Releases the item returned by front() (consumer)
+    void pop();
+
+};
+
+/**************************************************************************//**
+ * @param[in] capacity Maximum number of published items (>0).
+ * @param[in] value Initial value of items.
+ */
+template<class T>
+ccruncher::RingBuffer<T>::RingBuffer(size_t capacity, const T &value) :
+    mItems(capacity, value), mHead(0), mTail(0)
+{
+  assert(capacity > 0);
+}
+
+/**************************************************************************//**
+ * @return Number of published items not consumed yet.
+ */
+template<class T>
+size_t ccruncher::RingBuffer<T>::size() const
+{
+  return mTail.load(std::memory_order_acquire) - mHead.load(std::memory_order_acquire);
+}
+
+/**************************************************************************//**
+ * @return Slot to fill, nullptr if buffer is full.
+ */
+template<class T>
+inline T* ccruncher::RingBuffer<T>::back()
+{
+  size_t tail = mTail.load(std::memory_order_relaxed);
+  if (tail - mHead.load(std::memory_order_acquire) >= mItems.size()) {
+    return nullptr;
+  }
+  return &(mItems[tail%mItems.size()]);
+}
+
+/**************************************************************************//**
+ * @details Caller must have obtained a non-null slot using back().
+ */
+template<class T>
+inline void ccruncher::RingBuffer<T>::push()
+{
+  size_t tail = mTail.load(std::memory_order_relaxed);
+  assert(tail - mHead.load(std::memory_order_acquire) < mItems.size());
+  mTail.store(tail+1, std::memory_order_release);
+}
+
+/**************************************************************************//**
+ * @return Oldest published item, nullptr if buffer is empty.
+ */
+template<class T>
+inline T* ccruncher::RingBuffer<T>::front()
+{
+  size_t head = mHead.load(std::memory_order_relaxed);
+  if (head == mTail.load(std::memory_order_acquire)) {
+    return nullptr;
+  }
+  return &(mItems[head%mItems.size()]);
+}
+
+/**************************************************************************//**
+ * @details Caller must have obtained a non-null item using front().
+ */
+template<class T>
+inline void ccruncher::RingBuffer<T>::pop()
+{
+  size_t head = mHead.load(std::memory_order_relaxed);
+  assert(head != mTail.load(std::memory_order_acquire));
+  mHead.store(head+1, std::memory_order_release);
+}
+
+} // namespace
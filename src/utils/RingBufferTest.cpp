@@ -0,0 +1,108 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#include <thread>
+#include "utils/RingBuffer.hpp"
+#include "utils/RingBufferTest.hpp"
+
+using namespace std;
+using namespace ccruncher;
+
+//===========================================================================
+// test1
+//===========================================================================
+void ccruncher_test::RingBufferTest::test1()
+{
+  RingBuffer<int> ring(3, 0);
+
+  ASSERT_EQUALS((size_t)3, ring.capacity());
+  ASSERT(ring.empty());
+  ASSERT(ring.front() == nullptr);
+
+  // filling buffer
+  for(int i=1; i<=3; i++) {
+    int *item = ring.back();
+    ASSERT(item != nullptr);
+    *item = i;
+    ring.push();
+    ASSERT_EQUALS((size_t)i, ring.size());
+  }
+  ASSERT(ring.back() == nullptr);
+
+  // consuming one item
+  ASSERT_EQUALS(1, *(ring.front()));
+  ring.pop();
+  ASSERT_EQUALS((size_t)2, ring.size());
+
+  // slot reused (wrap-around)
+  int *item = ring.back();
+  ASSERT(item != nullptr);
+  *item = 4;
+  ring.push();
+
+  // items are consumed in order
+  for(int i=2; i<=4; i++) {
+    ASSERT(ring.front() != nullptr);
+    ASSERT_EQUALS(i, *(ring.front()));
+    ring.pop();
+  }
+  ASSERT(ring.empty());
+  ASSERT(ring.front() == nullptr);
+}
+
+//===========================================================================
+// test2
+// producer and consumer in distinct threads
+//===========================================================================
+void ccruncher_test::RingBufferTest::test2()
+{
+  const size_t num = 100000;
+  RingBuffer<size_t> ring(4, 0);
+
+  thread producer([&ring,num]() {
+    for(size_t i=0; i<num; i++) {
+      size_t *item = nullptr;
+      while((item = ring.back()) == nullptr) {
+        this_thread::yield();
+      }
+      *item = i;
+      ring.push();
+    }
+  });
+
+  size_t count = 0;
+  bool sorted = true;
+  while(count < num) {
+    size_t *item = ring.front();
+    if (item == nullptr) {
+      this_thread::yield();
+      continue;
+    }
+    if (*item != count) sorted = false;
+    ring.pop();
+    count++;
+  }
+  producer.join();
+
+  ASSERT(sorted);
+  ASSERT(ring.empty());
+}
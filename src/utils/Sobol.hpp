@@ -0,0 +1,83 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <gsl/gsl_rng.h>
+
+namespace ccruncher {
+
+/**************************************************************************//**
+ * @brief Scrambled Sobol low-discrepancy sequence.
+ *
+ * @details Generates the points of the Sobol sequence in gray code order
+ *          (Antonov-Saleev) using the Joe-Kuo direction numbers. The i-th
+ *          point is computed directly from its index, so any range of
+ *          points can be generated without generating the previous ones
+ *          (eg. each simulation block uses its own range). Points can be
+ *          randomized using a linear matrix scrambling followed by a
+ *          random digital shift. Randomized sequences keep the
+ *          stratification properties of the original one, and independent
+ *          randomizations (replicates) allow to estimate the error.
+ *          Direction numbers have 32 bits, so the sequence has 2^32 points.
+ *
+ * @see Joe, Kuo. Constructing Sobol sequences with better two-dimensional
+ *      projections. SIAM J. Sci. Comput. 30, 2635-2654, 2008.
+ * @see Matousek. On the L2-discrepancy for anchored boxes. Journal of
+ *      Complexity 14, 527-556, 1998.
+ */
+class Sobol
+{
+
+  public:
+
+    //! Number of bits of direction numbers
+    static const size_t NUMBITS = 32;
+    //! Maximum dimension supported
+    static const size_t MAXDIM = 257;
+
+  private:
+
+    //! Dimension
+    size_t mDim;
+    //! Direction numbers (NUMBITS x dim)
+    std::vector<uint32_t> mDirections;
+    //! Digital shift (dim)
+    std::vector<uint32_t> mShift;
+
+  public:
+
+    //! Constructor
+    Sobol(size_t dim=1);
+    //! Returns dimension
+    size_t size() const { return mDim; }
+    //! Randomizes the sequence
+    void scramble(const gsl_rng *rng);
+    //! Returns a range of points
+    void getPoints(size_t first, size_t num, double *u) const;
+
+};
+
+} // namespace
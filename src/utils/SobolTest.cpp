@@ -0,0 +1,140 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#include <cmath>
+#include <vector>
+#include "utils/BatchRng.hpp"
+#include "utils/Sobol.hpp"
+#include "utils/SobolTest.hpp"
+
+#define EPSILON 1E-9
+
+using namespace std;
+using namespace ccruncher;
+
+//===========================================================================
+// test1 (non-scrambled values)
+//===========================================================================
+void ccruncher_test::SobolTest::test1()
+{
+  // values obtained using scipy.stats.qmc.Sobol(6,scramble=False)
+  const double values[8][6] = {
+    {0.000, 0.000, 0.000, 0.000, 0.000, 0.000},
+    {0.500, 0.500, 0.500, 0.500, 0.500, 0.500},
+    {0.750, 0.250, 0.250, 0.250, 0.750, 0.750},
+    {0.250, 0.750, 0.750, 0.750, 0.250, 0.250},
+    {0.375, 0.375, 0.625, 0.875, 0.375, 0.125},
+    {0.875, 0.875, 0.125, 0.375, 0.875, 0.625},
+    {0.625, 0.125, 0.875, 0.625, 0.625, 0.875},
+    {0.125, 0.625, 0.375, 0.125, 0.125, 0.375}
+  };
+
+  Sobol sobol(6);
+  ASSERT_EQUALS((size_t)6, sobol.size());
+  vector<double> u(8*6);
+  sobol.getPoints(0, 8, u.data());
+  for(size_t i=0; i<8; i++) {
+    for(size_t j=0; j<6; j++) {
+      ASSERT_EQUALS_EPSILON(values[i][j], u[i*6+j], EPSILON);
+    }
+  }
+
+  // high dimensions (scipy.stats.qmc.Sobol(257,scramble=False))
+  Sobol sobol257(Sobol::MAXDIM);
+  u.resize(Sobol::MAXDIM);
+  sobol257.getPoints(1000, 1, u.data());
+  ASSERT_EQUALS_EPSILON(0.6259765625, u[256], EPSILON);
+  sobol257.getPoints(777, 1, u.data());
+  ASSERT_EQUALS_EPSILON(0.3505859375, u[37], EPSILON);
+  sobol257.getPoints(1023, 1, u.data());
+  ASSERT_EQUALS_EPSILON(0.2373046875, u[100], EPSILON);
+
+  ASSERT_THROW(Sobol(0));
+  ASSERT_THROW(Sobol(Sobol::MAXDIM+1));
+}
+
+//===========================================================================
+// test2 (scrambled sequences are stratified)
+//===========================================================================
+void ccruncher_test::SobolTest::test2()
+{
+  const size_t m = 10;
+  const size_t n = 1 << m;
+  BatchRng rng(4321UL);
+
+  for(size_t r=0; r<3; r++)
+  {
+    Sobol sobol(Sobol::MAXDIM);
+    size_t dim = sobol.size();
+    rng.setStream(r, 0);
+    sobol.scramble(rng.getRng());
+    vector<double> u(n*dim);
+    sobol.getPoints(0, n, u.data());
+
+    // one point by interval [k/n,(k+1)/n) in each dimension
+    for(size_t d=0; d<dim; d++) {
+      vector<size_t> counter(n, 0);
+      for(size_t i=0; i<n; i++) {
+        ASSERT(0.0 < u[i*dim+d] && u[i*dim+d] < 1.0);
+        counter[size_t(u[i*dim+d]*n)]++;
+      }
+      for(size_t k=0; k<n; k++) {
+        ASSERT_EQUALS((size_t)1, counter[k]);
+      }
+    }
+
+    // one point by square of side 2^(-m/2) in the first 2 dimensions
+    vector<size_t> counter(n, 0);
+    size_t side = 1 << (m/2);
+    for(size_t i=0; i<n; i++) {
+      size_t k1 = size_t(u[i*dim+0]*side);
+      size_t k2 = size_t(u[i*dim+1]*side);
+      counter[k1*side+k2]++;
+    }
+    for(size_t k=0; k<n; k++) {
+      ASSERT_EQUALS((size_t)1, counter[k]);
+    }
+  }
+}
+
+//===========================================================================
+// test3 (ranges)
+//===========================================================================
+void ccruncher_test::SobolTest::test3()
+{
+  BatchRng rng(1234UL);
+  Sobol sobol(7);
+  sobol.scramble(rng.getRng());
+
+  vector<double> u1(87*7);
+  sobol.getPoints(0, 87, u1.data());
+  vector<double> u2(50*7);
+  sobol.getPoints(37, 50, u2.data());
+  for(size_t i=0; i<u2.size(); i++) {
+    ASSERT_EQUALS(u1[37*7+i], u2[i]);
+  }
+
+  size_t last = (size_t(1) << Sobol::NUMBITS) - 1;
+  ASSERT_NO_THROW(sobol.getPoints(last, 1, u1.data()));
+  ASSERT_THROW(sobol.getPoints(last, 2, u1.data()));
+  ASSERT_THROW(sobol.getPoints(last+1, 1, u1.data()));
+}
@@ -0,0 +1,240 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#include <cmath>
+#include <limits>
+#include <cassert>
+#include <algorithm>
+#include "utils/TDigest.hpp"
+#include "utils/Exception.hpp"
+
+// number of buffered values by unit of compression
+#define BUFFER_FACTOR 5
+
+using namespace std;
+using namespace ccruncher;
+
+/**************************************************************************//**
+ * @details Upper limit of the quantile range covered by a centroid
+ *          starting at quantile q (arcsine scale function k1).
+ * @param[in] q Quantile where centroid starts.
+ * @param[in] compression Compression factor.
+ * @return Quantile where centroid ends.
+ */
+static inline double qlimit(double q, double compression)
+{
+  double k = compression*asin(2.0*q-1.0)/(2.0*M_PI) + 1.0;
+  if (k >= compression/4.0) return 1.0;
+  else return (sin(2.0*M_PI*k/compression) + 1.0)/2.0;
+}
+
+/**************************************************************************//**
+ * @param[in] compression Compression factor. Higher values are more
+ *            accurate and require more memory.
+ * @throw Exception Invalid compression factor.
+ */
+ccruncher::TDigest::TDigest(double compression) : mCompression(compression)
+{
+  if (!(compression >= 10.0)) {
+    throw Exception("invalid t-digest compression factor");
+  }
+  mBuffer.reserve(BUFFER_FACTOR*static_cast<size_t>(compression));
+  mWeight = 0.0;
+  mMin = +numeric_limits<double>::infinity();
+  mMax = -numeric_limits<double>::infinity();
+}
+
+/**************************************************************************//**
+ * @details Values with non-positive weight are ignored.
+ * @param[in] x Value.
+ * @param[in] w Weight.
+ */
+void ccruncher::TDigest::add(double x, double w)
+{
+  if (!(w > 0.0) || std::isnan(x)) {
+    return;
+  }
+  mBuffer.push_back(Centroid{x, w});
+  mWeight += w;
+  if (x < mMin) mMin = x;
+  if (x > mMax) mMax = x;
+  if (mBuffer.size() >= BUFFER_FACTOR*mCompression) {
+    compress();
+  }
+}
+
+/**************************************************************************//**
+ * @details Sorts buffered values and centroids, and merges consecutive
+ *          ones while the merged centroid doesn't exceed its quantile
+ *          range (see qlimit()).
+ */
+void ccruncher::TDigest::compress() const
+{
+  if (mBuffer.empty()) {
+    return;
+  }
+
+  mBuffer.insert(mBuffer.end(), mCentroids.begin(), mCentroids.end());
+  stable_sort(mBuffer.begin(), mBuffer.end(),
+              [](const Centroid &a, const Centroid &b) { return a.mean < b.mean; });
+
+  mCentroids.clear();
+  Centroid cur = mBuffer[0];
+  double wsofar = 0.0;
+  double wlimit = mWeight * qlimit(0.0, mCompression);
+
+  for(size_t i=1; i<mBuffer.size(); i++)
+  {
+    const Centroid &next = mBuffer[i];
+    if (wsofar + cur.weight + next.weight <= wlimit) {
+      cur.weight += next.weight;
+      cur.mean += (next.mean - cur.mean) * next.weight / cur.weight;
+    }
+    else {
+      wsofar += cur.weight;
+      mCentroids.push_back(cur);
+      wlimit = mWeight * qlimit(wsofar/mWeight, mCompression);
+      cur = next;
+    }
+  }
+
+  mCentroids.push_back(cur);
+  mBuffer.clear();
+}
+
+/**************************************************************************/
+size_t ccruncher::TDigest::size() const
+{
+  compress();
+  return mCentroids.size();
+}
+
+/**************************************************************************//**
+ * @details Interpolates linearly between the centroid midpoints. Below
+ *          the first one (above the last one) interpolates with the
+ *          minimum (maximum) value.
+ * @param[in] p Probability in [0,1].
+ * @return Quantile value (NaN if no values).
+ */
+double ccruncher::TDigest::quantile(double p) const
+{
+  compress();
+
+  if (mCentroids.empty()) {
+    return NAN;
+  }
+
+  double target = p * mWeight;
+  if (target <= 0.0) {
+    return mMin;
+  }
+  if (target >= mWeight) {
+    return mMax;
+  }
+
+  const Centroid &first = mCentroids.front();
+  if (target < first.weight/2.0) {
+    return mMin + (first.mean - mMin) * target / (first.weight/2.0);
+  }
+
+  double cum = 0.0;
+  for(size_t i=0; i+1<mCentroids.size(); i++)
+  {
+    const Centroid &c1 = mCentroids[i];
+    const Centroid &c2 = mCentroids[i+1];
+    double left = cum + c1.weight/2.0;
+    double right = cum + c1.weight + c2.weight/2.0;
+    if (target < right) {
+      return c1.mean + (c2.mean - c1.mean) * (target - left) / (right - left);
+    }
+    cum += c1.weight;
+  }
+
+  const Centroid &last = mCentroids.back();
+  double left = mWeight - last.weight/2.0;
+  return last.mean + (mMax - last.mean) * (target - left) / (mWeight - left);
+}
+
+/**************************************************************************//**
+ * @details Computes the weighted mean of the upper (1-p) fraction of
+ *          values. The centroid crossing the p-quantile contributes with
+ *          the fraction of its weight above it.
+ * @param[in] p Probability in [0,1).
+ * @return Tail mean (NaN if no values).
+ */
+double ccruncher::TDigest::tailMean(double p) const
+{
+  compress();
+
+  if (mCentroids.empty()) {
+    return NAN;
+  }
+
+  double tail = (1.0 - p) * mWeight;
+  if (tail <= 0.0) {
+    return mMax;
+  }
+
+  double sum = 0.0;
+  double weight = 0.0;
+  for(auto it=mCentroids.rbegin(); it!=mCentroids.rend() && weight<tail; ++it) {
+    double w = std::min(it->weight, tail - weight);
+    sum += w * it->mean;
+    weight += w;
+  }
+
+  return sum / weight;
+}
+
+/**************************************************************************//**
+ * @details Buffered values are saved as they are (not merged), so a
+ *          restored sketch evolves exactly as the original one.
+ * @param[in,out] checkpoint Archive where the state is appended.
+ */
+void ccruncher::TDigest::save(Checkpoint &checkpoint) const
+{
+  checkpoint.put(mCompression);
+  checkpoint.put(mWeight);
+  checkpoint.put(mMin);
+  checkpoint.put(mMax);
+  checkpoint.put(mCentroids);
+  checkpoint.put(mBuffer);
+}
+
+/**************************************************************************//**
+ * @param[in,out] checkpoint Archive where the state is read from.
+ * @throw Exception Invalid state.
+ */
+void ccruncher::TDigest::restore(Checkpoint &checkpoint)
+{
+  double compression = 0.0;
+  checkpoint.get(compression);
+  if (compression != mCompression) {
+    throw Exception("t-digest compression factor mismatch");
+  }
+  checkpoint.get(mWeight);
+  checkpoint.get(mMin);
+  checkpoint.get(mMax);
+  checkpoint.get(mCentroids);
+  checkpoint.get(mBuffer);
+  mBuffer.reserve(BUFFER_FACTOR*static_cast<size_t>(mCompression));
+}
@@ -0,0 +1,104 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include "utils/Checkpoint.hpp"
+
+namespace ccruncher {
+
+/**************************************************************************//**
+ * @brief Streaming quantile sketch (merging t-digest).
+ *
+ * @details Summarizes a stream of weighted values using a bounded number
+ *          of centroids (mean, weight). Incoming values are buffered and
+ *          periodically merged with the existing centroids. Centroid sizes
+ *          are limited by the arcsine scale function, so centroids are
+ *          small at both tails, providing accurate extreme quantiles
+ *          (eg. 99.97%) using a few KB of memory. Given the same values in
+ *          the same order, results are reproducible.
+ *
+ * @see Dunning, Ertl. Computing extremely accurate quantiles using
+ *      t-digests. arXiv:1902.04023, 2019.
+ */
+class TDigest
+{
+
+  private:
+
+    //! Cluster of values
+    struct Centroid
+    {
+      //! Mean of values
+      double mean;
+      //! Sum of weights
+      double weight;
+    };
+
+  private:
+
+    //! Compression factor (approx. maximum number of centroids)
+    double mCompression;
+    //! Merged centroids sorted by mean
+    mutable std::vector<Centroid> mCentroids;
+    //! Values not merged yet
+    mutable std::vector<Centroid> mBuffer;
+    //! Sum of weights
+    double mWeight;
+    //! Minimum value
+    double mMin;
+    //! Maximum value
+    double mMax;
+
+  private:
+
+    //! Merge buffered values into centroids
+    void compress() const;
+
+  public:
+
+    //! Constructor
+    TDigest(double compression=200.0);
+    //! Add a value
+    void add(double x, double w=1.0);
+    //! Returns the sum of weights
+    double getWeight() const { return mWeight; }
+    //! Returns the minimum value
+    double getMin() const { return mMin; }
+    //! Returns the maximum value
+    double getMax() const { return mMax; }
+    //! Returns the number of centroids
+    size_t size() const;
+    //! Returns the p-quantile
+    double quantile(double p) const;
+    //! Returns the mean of the values above the p-quantile
+    double tailMean(double p) const;
+    //! Save the sketch state
+    void save(Checkpoint &checkpoint) const;
+    //! Restore the sketch state
+    void restore(Checkpoint &checkpoint);
+
+};
+
+} // namespace
@@ -0,0 +1,104 @@
+
+//===========================================================================
+//
+// CCruncher - A portfolio credit risk valorator
+// Copyright (C) 2004-2025 Gerard Torrent
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+//
+//===========================================================================
+
+#include <cmath>
+#include "utils/TDigest.hpp"
+#include "utils/TDigestTest.hpp"
+
+#define EPSILON 1E-9
+
+using namespace std;
+using namespace ccruncher;
+
+//===========================================================================
+// test1 (permutation of 1..100000)
+//===========================================================================
+void ccruncher_test::TDigestTest::test1()
+{
+  TDigest digest(200.0);
+  for(size_t i=0; i<100000; i++) {
+    digest.add(double((i*7919)%100000 + 1));
+  }
+
+  ASSERT_EQUALS_EPSILON(100000.0, digest.getWeight(), EPSILON);
+  ASSERT_EQUALS_EPSILON(1.0, digest.getMin(), EPSILON);
+  ASSERT_EQUALS_EPSILON(100000.0, digest.getMax(), EPSILON);
+  ASSERT(digest.size() <= 200);
+
+  ASSERT_EQUALS_EPSILON(1.0, digest.quantile(0.0), EPSILON);
+  ASSERT_EQUALS_EPSILON(100000.0, digest.quantile(1.0), EPSILON);
+  ASSERT_EQUALS_EPSILON(50000.0, digest.quantile(0.5), 250.0);
+  ASSERT_EQUALS_EPSILON(99000.0, digest.quantile(0.99), 20.0);
+  ASSERT_EQUALS_EPSILON(99970.0, digest.quantile(0.9997), 2.0);
+  ASSERT_EQUALS_EPSILON(99500.5, digest.tailMean(0.99), 20.0);
+  ASSERT_EQUALS_EPSILON(50000.5, digest.tailMean(0.0), 1e-6);
+}
+
+//===========================================================================
+// test2 (weighted values)
+//===========================================================================
+void ccruncher_test::TDigestTest::test2()
+{
+  TDigest digest1(100.0);
+  TDigest digest2(100.0);
+  for(size_t i=0; i<10000; i++) {
+    double x = double((i*7919)%10000);
+    digest1.add(x, 2.0);
+    digest2.add(x);
+    digest2.add(x);
+  }
+
+  ASSERT_EQUALS_EPSILON(digest2.getWeight(), digest1.getWeight(), EPSILON);
+  for(double p : {0.1, 0.5, 0.9, 0.99, 0.999}) {
+    ASSERT_EQUALS_EPSILON(digest2.quantile(p), digest1.quantile(p), 10.0);
+    ASSERT_EQUALS_EPSILON(digest2.tailMean(p), digest1.tailMean(p), 10.0);
+  }
+
+  // non-positive weights are ignored
+  digest1.add(1e6, 0.0);
+  digest1.add(1e6, -1.0);
+  ASSERT_EQUALS_EPSILON(20000.0, digest1.getWeight(), EPSILON);
+  ASSERT_EQUALS_EPSILON(9999.0, digest1.getMax(), EPSILON);
+}
+
+//===========================================================================
+// test3 (degenerated cases)
+//===========================================================================
+void ccruncher_test::TDigestTest::test3()
+{
+  ASSERT_THROW(TDigest(1.0));
+
+  TDigest digest;
+  ASSERT(std::isnan(digest.quantile(0.5)));
+  ASSERT(std::isnan(digest.tailMean(0.5)));
+
+  // half of values are 0 (a centroid can mix both values)
+  for(size_t i=0; i<1000; i++) {
+    digest.add(0.0);
+    digest.add(5.0);
+  }
+  ASSERT_EQUALS_EPSILON(0.0, digest.quantile(0.25), EPSILON);
+  ASSERT_EQUALS_EPSILON(5.0, digest.quantile(0.75), EPSILON);
+  ASSERT_EQUALS_EPSILON(5.0, digest.tailMean(0.5), 0.1);
+  ASSERT_EQUALS_EPSILON(5.0, digest.tailMean(0.9), EPSILON);
+  ASSERT_EQUALS_EPSILON(2.5, digest.tailMean(0.0), EPSILON);
+}
@@ -35,6 +35,7 @@
 #include <fstream>
 #include <cerrno>
 #include <cstring>
+#include <cstdint>
 #include <iomanip>
 #include <sstream>
 #include <cassert>
@@ -43,6 +44,8 @@
 
 #ifdef _WIN32
   #include <windows.h>
+  #include <io.h>
+  #include <fcntl.h>
 #elif MACOS
   #include <sys/param.h>
   #include <sys/sysctl.h>
@@ -95,9 +98,10 @@ unsigned long ccruncher::Utils::trand()
  *          <ul>
  *            <li> debug. <code>\#define NDEBUG</code></li>
  *            <li> profiler. <code>\#define PROFILER</code></li>
+ *            <li> instrumentation. <code>\#define INSTRUMENTATION</code></li>
  *          </ul>.
  *          String is formated using this pattern:
- *          <code>'debug[enabled] | profiler[disabled]'</code>.
+ *          <code>'debug[enabled] | profiler[disabled] | instrumentation[disabled]'</code>.
  * @return A string with compilation options.
  */
 string ccruncher::Utils::getCompilationOptions()
@@ -115,6 +119,14 @@ string ccruncher::Utils::getCompilationOptions()
   // profiler option
   ret += "profiler";
 #ifdef PROFILER
+  ret += "[enabled] | ";
+#else
+  ret += "[disabled] | ";
+#endif
+
+  // instrumentation option
+  ret += "instrumentation";
+#ifdef INSTRUMENTATION
   ret += "[enabled] ";
 #else
   ret += "[disabled] ";
@@ -238,6 +250,39 @@ string ccruncher::Utils::lowercase(const string &str)
   return res;
 }
 
+/**************************************************************************//**
+ * @details Escapes quotes, backslashes and control characters. Other
+ *          characters (including UTF-8 sequences) are copied as is.
+ * @param[in] str String to be escaped (without the enclosing quotes).
+ * @return String escaped.
+ */
+string ccruncher::Utils::jsonEscape(const string &str)
+{
+  string res;
+  res.reserve(str.size());
+  for(char c : str) {
+    switch(c) {
+      case '"': res += "\\\""; break;
+      case '\\': res += "\\\\"; break;
+      case '\b': res += "\\b"; break;
+      case '\f': res += "\\f"; break;
+      case '\n': res += "\\n"; break;
+      case '\r': res += "\\r"; break;
+      case '\t': res += "\\t"; break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          char buf[8];
+          snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned int>(c));
+          res += buf;
+        }
+        else {
+          res += c;
+        }
+    }
+  }
+  return res;
+}
+
 /**************************************************************************//**
  * @details In windows replaces '/' by '\'.
  * @param[in] str File path to normalize.
@@ -256,6 +301,55 @@ string ccruncher::Utils::toNativeSeparators(const std::string &str)
 #endif
 }
 
+/**************************************************************************//**
+ * @details Creates a new directory with a unique name in the system
+ *          temporary directory (TMPDIR, TEMP or /tmp).
+ * @param[in] prefix Directory name prefix.
+ * @return Directory path.
+ * @throw Exception Error creating directory.
+ */
+string ccruncher::Utils::makeTempDir(const std::string &prefix)
+{
+#ifdef _WIN32
+  const char *tmpdir = getenv("TEMP");
+  string path = string(tmpdir!=nullptr&&tmpdir[0]!='\0'?tmpdir:".") + pathSeparator + prefix + "XXXXXX";
+  vector<char> buf(path.begin(), path.end());
+  buf.push_back('\0');
+  if (_mktemp_s(buf.data(), buf.size()) != 0) {
+    throw Exception("error creating temporary directory '" + path + "'");
+  }
+  makeDir(buf.data());
+#else
+  const char *tmpdir = getenv("TMPDIR");
+  string path = string(tmpdir!=nullptr&&tmpdir[0]!='\0'?tmpdir:"/tmp") + pathSeparator + prefix + "XXXXXX";
+  vector<char> buf(path.begin(), path.end());
+  buf.push_back('\0');
+  if (mkdtemp(buf.data()) == nullptr) {
+    throw Exception("error creating temporary directory '" + path + "'");
+  }
+#endif
+  return string(buf.data());
+}
+
+/**************************************************************************//**
+ * @details Removes the files of the directory and the directory itself.
+ *          Subdirectories are not removed (the directory is kept).
+ *          Errors are ignored.
+ * @param[in] path Directory path.
+ */
+void ccruncher::Utils::removeDir(const std::string &path)
+{
+  DIR *dir = opendir(path.c_str());
+  if (dir == nullptr) return;
+  struct dirent *entry = nullptr;
+  while((entry = readdir(dir)) != nullptr) {
+    if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+    remove((path + pathSeparator + entry->d_name).c_str());
+  }
+  closedir(dir);
+  rmdir(path.c_str());
+}
+
 /**************************************************************************//**
  * @todo Use function PathIsRelative in windows.h
  * @param[in] path File path to check.
@@ -481,6 +575,26 @@ size_t ccruncher::Utils::filesize(const string &filename)
   return static_cast<size_t>(f.tellg() - begin_pos);
 }
 
+/**************************************************************************//**
+ * @details Discards the file content beyond the given size.
+ * @param[in] filename File name.
+ * @param[in] size New file size (in bytes).
+ * @throw Exception Error truncating file.
+ */
+void ccruncher::Utils::truncate(const string &filename, size_t size)
+{
+#ifdef _WIN32
+  int fd = _open(filename.c_str(), _O_RDWR|_O_BINARY);
+  int rc = (fd < 0 ? -1 : _chsize_s(fd, static_cast<__int64>(size)));
+  if (fd >= 0) _close(fd);
+#else
+  int rc = ::truncate(filename.c_str(), static_cast<off_t>(size));
+#endif
+  if (rc != 0) {
+    throw Exception("error truncating file '" + filename + "'");
+  }
+}
+
 /**************************************************************************//**
  * @details Returns bytes as string (B, KB, MB, GB)
  * @param[in] val Input value.
@@ -533,3 +647,26 @@ string ccruncher::Utils::millisToString(long millis)
   return string(buf);
 }
 
+/**************************************************************************//**
+ * @return true if host is little-endian, false otherwise.
+ */
+bool ccruncher::Utils::isLittleEndian()
+{
+  const uint16_t val = 1;
+  return (*reinterpret_cast<const unsigned char *>(&val) == 1);
+}
+
+/**************************************************************************//**
+ * @details Converts values between little-endian and big-endian.
+ * @param[in,out] ptr Values to convert.
+ * @param[in] size Size of each value (in bytes).
+ * @param[in] num Number of values.
+ */
+void ccruncher::Utils::swapBytes(void *ptr, size_t size, size_t num)
+{
+  unsigned char *bytes = static_cast<unsigned char *>(ptr);
+  for(size_t i=0; i<num; i++) {
+    reverse(bytes, bytes+size);
+    bytes += size;
+  }
+}
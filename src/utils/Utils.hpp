@@ -62,6 +62,8 @@ class Utils
     static std::string uppercase(const std::string &str);
     //! Converts a string to lower case
     static std::string lowercase(const std::string &str);
+    //! Escapes a string to be written as a JSON string
+    static std::string jsonEscape(const std::string &str);
     //! Convert '/' separators to underlying OS separators
     static std::string toNativeSeparators(const std::string &str);
     //! Canonicalize absolute pathname
@@ -72,6 +74,10 @@ class Utils
     static bool existDir(const std::string &);
     //! Create a directory
     static void makeDir(const std::string &);
+    //! Create a unique temporary directory
+    static std::string makeTempDir(const std::string &prefix);
+    //! Remove a directory and its files
+    static void removeDir(const std::string &path);
     //! Indicates if a path is absolute
     static bool isAbsolutePath(const std::string &);
     //! Check rw file status
@@ -82,10 +88,16 @@ class Utils
     static std::string filename(const std::string &pathname);
     //! Return file size in bytes
     static size_t filesize(const std::string &filename);
+    //! Truncate a file to the given size
+    static void truncate(const std::string &filename, size_t size);
     //! Returns bytes as string (B, KB, MB)
     static std::string bytesToString(const size_t val);
     //! Format seconds in format hh:mm:ss.mmm
     static std::string millisToString(long millis);
+    //! Indicates if host byte order is little-endian
+    static bool isLittleEndian();
+    //! Reverse the byte order of a list of values
+    static void swapBytes(void *ptr, size_t size, size_t num=1);
 
 };
 
@@ -21,7 +21,9 @@
 //===========================================================================
 
 #include <iostream>
+#include <fstream>
 #include <ctime>
+#include <cstdint>
 #include "utils/Utils.hpp"
 #include "utils/UtilsTest.hpp"
 
@@ -139,3 +141,51 @@ void ccruncher_test::UtilsTest::test4()
   ASSERT(Utils::millisToString(1555000510) == string("431:56:40.510"));
 }
 
+//===========================================================================
+// test5. test byte order functions
+//===========================================================================
+void ccruncher_test::UtilsTest::test5()
+{
+  uint32_t val = 0x01020304;
+  unsigned char *bytes = reinterpret_cast<unsigned char *>(&val);
+  ASSERT_EQUALS(Utils::isLittleEndian(), bytes[0] == 0x04);
+
+  Utils::swapBytes(&val, sizeof(val));
+  ASSERT_EQUALS(0x04030201U, val);
+
+  double x[2] = { 3.14, -2.5 };
+  Utils::swapBytes(x, sizeof(double), 2);
+  Utils::swapBytes(x, sizeof(double), 2);
+  ASSERT_EQUALS(3.14, x[0]);
+  ASSERT_EQUALS(-2.5, x[1]);
+}
+
+//===========================================================================
+// test6. test temporary directory functions
+//===========================================================================
+void ccruncher_test::UtilsTest::test6()
+{
+  string path1 = Utils::makeTempDir("ccruncher-utilstest.");
+  string path2 = Utils::makeTempDir("ccruncher-utilstest.");
+  ASSERT(path1 != path2);
+  ASSERT(Utils::existDir(path1));
+  ASSERT(Utils::existDir(path2));
+
+  ofstream(path1 + Utils::pathSeparator + "file.txt") << "ccruncher\n";
+  Utils::removeDir(path1);
+  Utils::removeDir(path2);
+  ASSERT(!Utils::existDir(path1));
+  ASSERT(!Utils::existDir(path2));
+}
+
+//===========================================================================
+// test7. test json escape function
+//===========================================================================
+void ccruncher_test::UtilsTest::test7()
+{
+  ASSERT(Utils::jsonEscape("") == string(""));
+  ASSERT(Utils::jsonEscape("-O2 -g") == string("-O2 -g"));
+  ASSERT(Utils::jsonEscape("a\"b\\c") == string("a\\\"b\\\\c"));
+  ASSERT(Utils::jsonEscape("a\nb\tc") == string("a\\nb\\tc"));
+  ASSERT(Utils::jsonEscape(string("\x01", 1)) == string("\\u0001"));
+}
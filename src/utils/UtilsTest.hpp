@@ -35,6 +35,9 @@ class UtilsTest : public TestFixture<UtilsTest>
     void test2();
     void test3();
     void test4();
+    void test5();
+    void test6();
+    void test7();
 
 
   public:
@@ -45,6 +48,9 @@ class UtilsTest : public TestFixture<UtilsTest>
       TEST_CASE(test2);
       TEST_CASE(test3);
       TEST_CASE(test4);
+      TEST_CASE(test5);
+      TEST_CASE(test6);
+      TEST_CASE(test7);
     }
 
 };
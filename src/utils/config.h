@@ -109,6 +109,9 @@
 /* Define to 1 if the system has the type '_Bool'. */
 /* #undef HAVE__BOOL */
 
+/* Instrumentation timers and counters are added when this is defined. */
+/* #undef INSTRUMENTATION */
+
 /* Name of package */
 #define PACKAGE "ccruncher"
 